@@ -0,0 +1,116 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/bitvec.h"
+#include "tupperware/vector.h"
+
+#define LENGTH (64UL * 1000 * 1000)
+#define ROUNDS 10
+#define QUERIES (1000 * 1000)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *seed) {
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *seed = x;
+}
+
+// What bitsets used to be, a byte per bit through `vector_at`
+static double bytes_and_count(struct vector *res,
+        const struct vector *lhs, const struct vector *rhs, size_t *count) {
+    double start = now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        *count = 0;
+        for (size_t i = 0; i < LENGTH; ++i) {
+            char *x = vector_at(res, i);
+            *x = *(char *)vector_at(lhs, i) & *(char *)vector_at(rhs, i);
+            *count += *x;
+        }
+    }
+    return (now() - start) / ROUNDS * 1e3;
+}
+
+static double bitvec_and_count(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs, size_t *count) {
+    double start = now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        bitvec_and(res, lhs, rhs);
+        *count = bitvec_popcount(res);
+    }
+    return (now() - start) / ROUNDS * 1e3;
+}
+
+int main(void) {
+    struct vector vl;
+    struct vector vr;
+    struct vector vres;
+    struct bitvec bl;
+    struct bitvec br;
+    struct bitvec bres;
+    uint64_t seed = 42;
+
+    vector_with_cap(&vl, 1, LENGTH);
+    vector_with_cap(&vr, 1, LENGTH);
+    vector_with_cap(&vres, 1, LENGTH);
+    bitvec_with_cap(&bl, LENGTH);
+    bitvec_with_cap(&br, LENGTH);
+    bitvec_init(&bres);
+    for (size_t i = 0; i < LENGTH; ++i) {
+        char l = xorshift(&seed) % 2;
+        char r = xorshift(&seed) % 2;
+        vector_push_back(&vl, &l);
+        vector_push_back(&vr, &r);
+        vector_push_back(&vres, &l);
+        bitvec_push_back(&bl, l);
+        bitvec_push_back(&br, r);
+    }
+    bitvec_and(&bres, &bl, &br);
+
+    size_t vcount;
+    size_t bcount;
+    double bytes = bytes_and_count(&vres, &vl, &vr, &vcount);
+    double bits = bitvec_and_count(&bres, &bl, &br, &bcount);
+    printf("and + count ms  bytes %.2f  bitvec %.2f (%zu %zu)\n",
+            bytes, bits, vcount, bcount);
+
+    double start = now();
+    for (int r = 0; r < ROUNDS; ++r)
+        bcount = bitvec_popcount(&bl);
+    printf("popcount GB/s   %.2f (%zu)\n",
+            LENGTH / 8 * ROUNDS / (now() - start) / 1e9, bcount);
+
+    bitvec_build_index(&bl);
+    size_t sum = 0;
+    size_t x;
+    start = now();
+    for (size_t i = 0; i < QUERIES; ++i) {
+        bitvec_rank(&bl, xorshift(&seed) % LENGTH, &x);
+        sum += x;
+    }
+    double rank = (now() - start) / QUERIES * 1e9;
+    start = now();
+    for (size_t i = 0; i < QUERIES; ++i) {
+        bitvec_select(&bl, xorshift(&seed) % bcount, &x);
+        sum += x;
+    }
+    printf("rank ns %.1f  select ns %.1f (%zu)\n",
+            rank, (now() - start) / QUERIES * 1e9, sum);
+
+    vector_clear(&vl, NULL, NULL);
+    vector_clear(&vr, NULL, NULL);
+    vector_clear(&vres, NULL, NULL);
+    bitvec_clear(&bl);
+    bitvec_clear(&br);
+    bitvec_clear(&bres);
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/bloom.h"
+
+#define KEYS (1UL * 1000 * 1000)
+#define FPR 0.01
+
+struct node {
+    uint64_t key;
+    struct avl_node avl;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int node_cmp(const struct avl_node *lhs,
+        const struct avl_node *rhs, void *cookie) {
+    (void)cookie;
+    uint64_t l = CONTAINER_OF(struct node, avl, lhs)->key;
+    uint64_t r = CONTAINER_OF(struct node, avl, rhs)->key;
+    return (l > r) - (l < r);
+}
+
+static uint64_t node_hash(const struct avl_node *n, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct node, avl, n)->key;
+}
+
+// Present keys are even, absent ones odd
+static uint64_t key(uint64_t i) {
+    return (i * 0x9e3779b97f4a7c15) << 1;
+}
+
+int main(void) {
+    struct node *nodes = calloc(KEYS, sizeof(*nodes));
+    uint64_t *hashes = malloc(KEYS * sizeof(*hashes));
+    bool *found = malloc(KEYS * sizeof(*found));
+    struct bloom f;
+    struct bloom_avl b;
+
+    for (size_t i = 0; i < KEYS; ++i) {
+        nodes[i].key = key(i);
+        hashes[i] = key(i);
+    }
+    bloom_init(&f, KEYS, FPR);
+    bloom_avl_init(&b, node_cmp, node_hash, NULL, KEYS, FPR);
+
+    double start = now();
+    for (size_t i = 0; i < KEYS; ++i)
+        bloom_add(&f, hashes[i]);
+    double single = now() - start;
+    bloom_reset(&f);
+    start = now();
+    bloom_add_n(&f, hashes, KEYS);
+    double bulk = now() - start;
+    printf("add ns/key:       %6.1f single %6.1f bulk\n",
+            single / KEYS * 1e9, bulk / KEYS * 1e9);
+
+    for (size_t i = 0; i < KEYS; ++i)
+        hashes[i] = key(i) | 1;
+    size_t positives = 0;
+    start = now();
+    for (size_t i = 0; i < KEYS; ++i)
+        positives += bloom_contains(&f, hashes[i]);
+    single = now() - start;
+    start = now();
+    bloom_contains_n(&f, hashes, KEYS, found);
+    bulk = now() - start;
+    printf("contains ns/key:  %6.1f single %6.1f bulk\n",
+            single / KEYS * 1e9, bulk / KEYS * 1e9);
+    printf("bits/key %.1f, false positives %.4f (expected %.4f)\n",
+            bloom_bytes(&f) * 8.0 / KEYS, (double)positives / KEYS,
+            bloom_fpr(&f, KEYS));
+
+    for (size_t i = 0; i < KEYS; ++i)
+        bloom_avl_insert(&b, &nodes[i].avl, NULL);
+
+    struct node probe = { 0, AVL_NODE_INIT_VAL };
+    size_t hits = 0;
+    start = now();
+    for (size_t i = 0; i < KEYS; ++i) {
+        probe.key = hashes[i];
+        hits += avl_find(&b.tree, &probe.avl) != NULL;
+    }
+    double tree = now() - start;
+    start = now();
+    for (size_t i = 0; i < KEYS; ++i) {
+        probe.key = hashes[i];
+        hits += bloom_avl_find(&b, &probe.avl) != NULL;
+    }
+    double fronted = now() - start;
+    printf("absent find ns:   %6.1f avl %6.1f bloom_avl (%zu)\n",
+            tree / KEYS * 1e9, fronted / KEYS * 1e9, hits);
+
+    start = now();
+    for (size_t i = 0; i < KEYS; ++i) {
+        probe.key = key(i);
+        hits += bloom_avl_find(&b, &probe.avl) != NULL;
+    }
+    printf("present find ns:  %6.1f bloom_avl (%zu)\n",
+            (now() - start) / KEYS * 1e9, hits);
+
+    bloom_avl_clear(&b, NULL, NULL);
+    bloom_clear(&f);
+    free(nodes);
+    free(hashes);
+    free(found);
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/cache.h"
+
+#define KEYS (1UL * 1000 * 1000)
+#define ACCESSES (4UL * 1000 * 1000)
+#define CAP (KEYS / 100)
+
+struct entry {
+    uint64_t key;
+    struct cache_node node;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t entry_hash(const struct cache_node *n, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct entry, node, n)->key;
+}
+
+static bool entry_eq(const struct cache_node *lhs,
+        const struct cache_node *rhs, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct entry, node, lhs)->key
+        == CONTAINER_OF(struct entry, node, rhs)->key;
+}
+
+static uint64_t rng(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+// Power-law popularity, with one in four accesses part of a scan that never
+// comes back
+static uint64_t *workload(void) {
+    uint64_t *keys = malloc(ACCESSES * sizeof(*keys));
+    uint64_t s = 42;
+    uint64_t scan = KEYS / 2;
+
+    for (size_t i = 0; i < ACCESSES; ++i) {
+        if (i % 4 == 3) {
+            keys[i] = scan++ % KEYS;
+            continue;
+        }
+        double u = (rng(&s) >> 11) * 0x1p-53;
+        keys[i] = (uint64_t)(KEYS / 2 * u * u * u * u);
+    }
+
+    return keys;
+}
+
+static void run(const char *name, enum cache_policy policy,
+        struct entry *entries, const uint64_t *keys) {
+    struct cache c;
+    cache_init(&c, policy, CAP, entry_hash, entry_eq, NULL, NULL);
+    for (size_t i = 0; i < KEYS; ++i)
+        entries[i].node = CACHE_NODE_INIT_VAL;
+
+    struct entry probe = { 0, CACHE_NODE_INIT_VAL };
+    double start = now();
+    for (size_t i = 0; i < ACCESSES; ++i) {
+        probe.key = keys[i];
+        if (!cache_get(&c, &probe.node))
+            cache_put(&c, &entries[keys[i]].node);
+    }
+    double elapsed = now() - start;
+
+    printf("%-8s hit rate %5.1f%%  %6.1f ns/access\n", name,
+            cache_hit_rate(&c) * 100, elapsed / ACCESSES * 1e9);
+
+    cache_reset_stats(&c);
+    cache_set_timing(&c, true);
+    for (size_t i = 0; i < ACCESSES; ++i) {
+        probe.key = keys[i];
+        cache_get(&c, &probe.node);
+    }
+    printf("         get %6.1f ns mean %6llu ns worst\n",
+            (double)c.stats.get_ns / ACCESSES,
+            (unsigned long long)c.stats.get_max_ns);
+
+    cache_clear(&c, NULL, NULL);
+}
+
+int main(void) {
+    struct entry *entries = malloc(KEYS * sizeof(*entries));
+    uint64_t *keys = workload();
+    for (size_t i = 0; i < KEYS; ++i)
+        entries[i].key = i;
+
+    run("lru", CACHE_LRU, entries, keys);
+    run("clock", CACHE_CLOCK, entries, keys);
+    run("s3fifo", CACHE_S3FIFO, entries, keys);
+
+    free(entries);
+    free(keys);
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tupperware/chashmap.h"
+#include "tupperware/hashmap.h"
+
+#define KEYS (1UL * 1000 * 1000)
+#define LOOKUPS (2UL * 1000 * 1000)
+#define MAX_THREADS 64
+
+struct pair {
+    uint64_t key;
+    uint64_t val;
+};
+
+struct shared {
+    struct chashmap cmap;
+    struct hashmap map;
+    pthread_mutex_t lock;
+    // One write every `write_every` lookups, none if 0
+    unsigned write_every;
+    bool locked;
+};
+
+struct worker {
+    struct shared *s;
+    uint64_t seed;
+    uint64_t found;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static uint64_t pair_hash(const void *elem, void *cookie) {
+    (void)cookie;
+    return ((const struct pair *)elem)->key;
+}
+
+static bool pair_eq(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    return ((const struct pair *)lhs)->key == ((const struct pair *)rhs)->key;
+}
+
+static void *run(void *arg) {
+    struct worker *w = arg;
+    struct shared *s = w->s;
+
+    for (uint64_t i = 0; i < LOOKUPS; ++i) {
+        struct pair p = { xorshift(&w->seed) % KEYS, i };
+        bool write = s->write_every && i % s->write_every == 0;
+
+        if (s->locked) {
+            pthread_mutex_lock(&s->lock);
+            if (write) {
+                struct pair *old = hashmap_find(&s->map, &p);
+                if (old)
+                    *old = p;
+            } else {
+                w->found += hashmap_find(&s->map, &p) != NULL;
+            }
+            pthread_mutex_unlock(&s->lock);
+        } else if (write) {
+            chashmap_assign(&s->cmap, &p);
+        } else {
+            w->found += chashmap_find(&s->cmap, &p, &p);
+        }
+    }
+
+    return NULL;
+}
+
+// Returns the total throughput in Mops/s
+static double measure(struct shared *s, size_t nthreads) {
+    pthread_t threads[MAX_THREADS];
+    struct worker workers[MAX_THREADS];
+
+    double start = now();
+    for (size_t i = 0; i < nthreads; ++i) {
+        workers[i] = (struct worker){ s, i * 0x9e3779b97f4a7c15 + 1, 0 };
+        pthread_create(&threads[i], NULL, run, &workers[i]);
+    }
+    for (size_t i = 0; i < nthreads; ++i)
+        pthread_join(threads[i], NULL);
+    double elapsed = now() - start;
+
+    return nthreads * LOOKUPS / elapsed / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 1 ? (size_t)atoi(argv[1]) : 2 * (size_t)ncpus;
+    struct shared s = { .write_every = 0 };
+
+    if (max_threads > MAX_THREADS)
+        max_threads = MAX_THREADS;
+    chashmap_init(&s.cmap, sizeof(struct pair), pair_hash, pair_eq, NULL);
+    hashmap_init(&s.map, sizeof(struct pair), pair_hash, pair_eq, NULL);
+    pthread_mutex_init(&s.lock, NULL);
+    for (uint64_t i = 0; i < KEYS; ++i) {
+        struct pair p = { i, i };
+        chashmap_insert(&s.cmap, &p, NULL);
+        hashmap_insert(&s.map, &p, NULL);
+    }
+
+    printf("%ld CPUs, Mops/s\n", ncpus);
+    printf("threads   chashmap   mutex+hashmap   chashmap 10%% writes\n");
+    for (size_t n = 1; n <= max_threads; n *= 2) {
+        s.write_every = 0;
+        s.locked = false;
+        double lock_free = measure(&s, n);
+        s.locked = true;
+        double locked = measure(&s, n);
+        s.write_every = 10;
+        s.locked = false;
+        double mixed = measure(&s, n);
+        printf("%7zu %10.1f %15.1f %21.1f\n", n, lock_free, locked, mixed);
+    }
+
+    chashmap_clear(&s.cmap, NULL, NULL);
+    hashmap_clear(&s.map, NULL, NULL);
+    pthread_mutex_destroy(&s.lock);
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tupperware/cvector.h"
+#include "tupperware/vector.h"
+
+#define TOTAL_N (16UL * 1000 * 1000)
+
+struct record {
+    uint64_t id;
+    uint64_t payload[3];
+};
+
+struct bench {
+    struct cvector cv;
+    struct vector v;
+    pthread_mutex_t lock;
+    size_t per_thread;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *cvector_writer(void *arg) {
+    struct bench *b = arg;
+    struct record r = { 0 };
+
+    for (size_t i = 0; i < b->per_thread; ++i) {
+        r.id = i;
+        if (!cvector_push_back(&b->cv, &r))
+            abort();
+    }
+
+    return NULL;
+}
+
+static void *locked_writer(void *arg) {
+    struct bench *b = arg;
+    struct record r = { 0 };
+
+    for (size_t i = 0; i < b->per_thread; ++i) {
+        r.id = i;
+        pthread_mutex_lock(&b->lock);
+        bool ok = vector_push_back(&b->v, &r);
+        pthread_mutex_unlock(&b->lock);
+        if (!ok)
+            abort();
+    }
+
+    return NULL;
+}
+
+static double run(struct bench *b, size_t nthreads, void *(*fn)(void *)) {
+    pthread_t threads[nthreads];
+
+    b->per_thread = TOTAL_N / nthreads;
+    double start = now();
+    for (size_t i = 0; i < nthreads; ++i)
+        pthread_create(&threads[i], NULL, fn, b);
+    for (size_t i = 0; i < nthreads; ++i)
+        pthread_join(threads[i], NULL);
+
+    return b->per_thread * nthreads / (now() - start) / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 1 ? strtoul(argv[1], NULL, 10) : (size_t)cpus;
+    struct bench b;
+
+    pthread_mutex_init(&b.lock, NULL);
+    printf("threads  cvector Mops/s  locked vector Mops/s\n");
+    for (size_t n = 1; n <= max_threads; n *= 2) {
+        cvector_init(&b.cv, sizeof(struct record));
+        vector_init(&b.v, sizeof(struct record));
+
+        double concurrent = run(&b, n, cvector_writer);
+        double locked = run(&b, n, locked_writer);
+        printf("%7zu  %14.2f  %20.2f\n", n, concurrent, locked);
+
+        cvector_clear(&b.cv, NULL, NULL);
+        vector_clear(&b.v, NULL, NULL);
+    }
+    pthread_mutex_destroy(&b.lock);
+
+    return 0;
+}
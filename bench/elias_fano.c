@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/elias_fano.h"
+
+#define LENGTH (16UL * 1000 * 1000)
+#define QUERIES (1000 * 1000)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *seed) {
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *seed = x;
+}
+
+static size_t lower_bound(const uint64_t *arr, size_t n, uint64_t x) {
+    size_t lo = 0;
+    size_t hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (arr[mid] < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+int main(void) {
+    struct vector v;
+    struct vector res;
+    struct elias_fano ef;
+    uint64_t seed = 42;
+    uint64_t x = 0;
+
+    // Offsets of records of up to 1000 bytes
+    vector_with_cap(&v, sizeof(uint64_t), LENGTH);
+    for (size_t i = 0; i < LENGTH; ++i) {
+        x += xorshift(&seed) % 1000;
+        vector_push_back(&v, &x);
+    }
+    const uint64_t *arr = v.arr;
+    elias_fano_init(&ef, &v);
+    printf("bytes per element %.2f (vector %zu)\n",
+            (double)elias_fano_bytes(&ef) / LENGTH, sizeof(uint64_t));
+
+    vector_init(&res, sizeof(uint64_t));
+    elias_fano_decode(&ef, &res);
+    res.nmemb = 0;
+    double start = now();
+    elias_fano_decode(&ef, &res);
+    printf("decode elem/ns %.2f\n", LENGTH / (now() - start) / 1e9);
+
+    uint64_t sum = 0;
+    start = now();
+    for (size_t i = 0; i < QUERIES; ++i) {
+        elias_fano_at(&ef, xorshift(&seed) % LENGTH, &x);
+        sum += x;
+    }
+    double at = (now() - start) / QUERIES * 1e9;
+    start = now();
+    for (size_t i = 0; i < QUERIES; ++i)
+        sum += arr[xorshift(&seed) % LENGTH];
+    printf("at ns           %8.1f (vector %.1f)\n",
+            at, (now() - start) / QUERIES * 1e9);
+
+    size_t index;
+    start = now();
+    for (size_t i = 0; i < QUERIES; ++i) {
+        elias_fano_successor(&ef, xorshift(&seed) % arr[LENGTH - 1],
+                &index, NULL);
+        sum += index;
+    }
+    double successor = (now() - start) / QUERIES * 1e9;
+    start = now();
+    for (size_t i = 0; i < QUERIES; ++i)
+        sum += lower_bound(arr, LENGTH, xorshift(&seed) % arr[LENGTH - 1]);
+    printf("successor ns    %8.1f (vector %.1f) (%llu)\n", successor,
+            (now() - start) / QUERIES * 1e9, (unsigned long long)sum);
+
+    vector_clear(&v, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+    elias_fano_clear(&ef);
+
+    return 0;
+}
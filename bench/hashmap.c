@@ -0,0 +1,128 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/avl.h"
+#include "tupperware/hashmap.h"
+
+#define LENGTH (1000 * 1000)
+
+struct entry {
+    uint64_t key;
+    uint64_t val;
+};
+
+struct node {
+    struct entry e;
+    struct avl_node avl;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *seed) {
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *seed = x;
+}
+
+static uint64_t entry_hash(const void *elem, void *cookie) {
+    (void)cookie;
+    return ((const struct entry *)elem)->key;
+}
+
+static bool entry_eq(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    return ((const struct entry *)lhs)->key == ((const struct entry *)rhs)->key;
+}
+
+static int node_cmp(const struct avl_node *lhs,
+        const struct avl_node *rhs, void *cookie) {
+    (void)cookie;
+    uint64_t l = CONTAINER_OF(struct node, avl, lhs)->e.key;
+    uint64_t r = CONTAINER_OF(struct node, avl, rhs)->e.key;
+    return (l > r) - (l < r);
+}
+
+static void report(const char *op, double avl, double map) {
+    printf("%-12s %10.1f %10.1f\n", op,
+            avl / LENGTH * 1e9, map / LENGTH * 1e9);
+}
+
+int main(void) {
+    struct hashmap m;
+    struct avl tree;
+    struct node *nodes = calloc(LENGTH, sizeof(*nodes));
+    uint64_t *keys = malloc(LENGTH * sizeof(*keys));
+    uint64_t seed = 42;
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < LENGTH; ++i) {
+        keys[i] = xorshift(&seed);
+        nodes[i].e.key = keys[i];
+        nodes[i].e.val = i;
+    }
+    hashmap_init(&m, sizeof(struct entry), entry_hash, entry_eq, NULL);
+    avl_init(&tree, node_cmp, NULL);
+
+    printf("ns per op        avl    hashmap\n");
+    double start = now();
+    for (size_t i = 0; i < LENGTH; ++i)
+        avl_insert(&tree, &nodes[i].avl, NULL);
+    double avl = now() - start;
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i)
+        hashmap_insert(&m, &nodes[i].e, NULL);
+    report("insert", avl, now() - start);
+
+    // Hits in another order than inserted
+    struct node key;
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i) {
+        key.e.key = keys[(i * 7919) % LENGTH];
+        struct avl_node *n = avl_find(&tree, &key.avl);
+        sum += CONTAINER_OF(struct node, avl, n)->e.val;
+    }
+    avl = now() - start;
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i) {
+        key.e.key = keys[(i * 7919) % LENGTH];
+        sum += ((struct entry *)hashmap_find(&m, &key.e))->val;
+    }
+    report("find hit", avl, now() - start);
+
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i) {
+        key.e.key = xorshift(&seed);
+        sum += avl_find(&tree, &key.avl) != NULL;
+    }
+    avl = now() - start;
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i) {
+        key.e.key = xorshift(&seed);
+        sum += hashmap_find(&m, &key.e) != NULL;
+    }
+    report("find miss", avl, now() - start);
+
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i)
+        avl_remove_at(&tree, &nodes[i].avl);
+    avl = now() - start;
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i)
+        hashmap_remove(&m, &nodes[i].e, NULL);
+    report("remove", avl, now() - start);
+    printf("(%llu)\n", (unsigned long long)sum);
+
+    hashmap_clear(&m, NULL, NULL);
+    free(nodes);
+    free(keys);
+
+    return 0;
+}
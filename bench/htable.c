@@ -0,0 +1,129 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/avl.h"
+#include "tupperware/hashmap.h"
+#include "tupperware/htable.h"
+
+#define LENGTH (4UL * 1000 * 1000)
+
+struct node {
+    uint64_t key;
+    struct htable_node hnode;
+    struct avl_node avl;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t node_hash(const struct htable_node *n, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct node, hnode, n)->key;
+}
+
+static bool node_eq(const struct htable_node *lhs,
+        const struct htable_node *rhs, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct node, hnode, lhs)->key
+        == CONTAINER_OF(struct node, hnode, rhs)->key;
+}
+
+static int node_cmp(const struct avl_node *lhs,
+        const struct avl_node *rhs, void *cookie) {
+    (void)cookie;
+    uint64_t l = CONTAINER_OF(struct node, avl, lhs)->key;
+    uint64_t r = CONTAINER_OF(struct node, avl, rhs)->key;
+    return (l > r) - (l < r);
+}
+
+static uint64_t key_hash(const void *elem, void *cookie) {
+    (void)cookie;
+    return *(const uint64_t *)elem;
+}
+
+static bool key_eq(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    return *(const uint64_t *)lhs == *(const uint64_t *)rhs;
+}
+
+struct latency {
+    double *samples;
+    double total;
+};
+
+static void record(struct latency *l, size_t i, double start) {
+    double t = now() - start;
+    l->samples[i] = t;
+    l->total += t;
+}
+
+static int double_cmp(const void *lhs, const void *rhs) {
+    double l = *(const double *)lhs;
+    double r = *(const double *)rhs;
+    return (l > r) - (l < r);
+}
+
+// Timer and scheduler noise shows in the maximum, resizes in both
+static void report(const char *name, struct latency *l) {
+    qsort(l->samples, LENGTH, sizeof(*l->samples), double_cmp);
+    printf("%-8s %10.1f %12.1f %12.1f\n", name, l->total / LENGTH * 1e9,
+            l->samples[LENGTH - LENGTH / 100000] * 1e6,
+            l->samples[LENGTH - 1] * 1e6);
+    free(l->samples);
+}
+
+int main(void) {
+    struct node *nodes = calloc(LENGTH, sizeof(*nodes));
+    struct htable table;
+    struct hashmap map;
+    struct avl tree;
+    struct latency lt = { calloc(LENGTH, sizeof(double)), 0 };
+    struct latency lm = { calloc(LENGTH, sizeof(double)), 0 };
+    struct latency la = { calloc(LENGTH, sizeof(double)), 0 };
+
+    for (size_t i = 0; i < LENGTH; ++i)
+        nodes[i].key = i * 0x9e3779b97f4a7c15;
+    htable_init(&table, node_hash, node_eq, NULL);
+    hashmap_init(&map, sizeof(uint64_t), key_hash, key_eq, NULL);
+    avl_init(&tree, node_cmp, NULL);
+
+    // Growing the hash map rehashes every element in one insertion
+    for (size_t i = 0; i < LENGTH; ++i) {
+        double start = now();
+        htable_insert(&table, &nodes[i].hnode, NULL);
+        record(&lt, i, start);
+
+        start = now();
+        hashmap_insert(&map, &nodes[i].key, NULL);
+        record(&lm, i, start);
+
+        start = now();
+        avl_insert(&tree, &nodes[i].avl, NULL);
+        record(&la, i, start);
+    }
+
+    printf("insert      mean ns  p99.999 us     worst us\n");
+    report("htable", &lt);
+    report("hashmap", &lm);
+    report("avl", &la);
+
+    uint64_t found = 0;
+    double start = now();
+    for (size_t i = 0; i < LENGTH; ++i) {
+        struct node *n = &nodes[(i * 7919) % LENGTH];
+        found += htable_find(&table, &n->hnode) != NULL;
+    }
+    printf("htable find ns %.1f (%llu)\n", (now() - start) / LENGTH * 1e9,
+            (unsigned long long)found);
+
+    htable_clear(&table, NULL, NULL);
+    hashmap_clear(&map, NULL, NULL);
+    free(nodes);
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/list.h"
+
+#define NODES (1UL * 1000 * 1000)
+#define LISTS 64
+
+struct node {
+    unsigned key;
+    struct list_node list;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int node_cmp(const struct list_node *lhs,
+        const struct list_node *rhs, void *cookie) {
+    size_t *count = cookie;
+    unsigned l = CONTAINER_OF(struct node, list, lhs)->key;
+    unsigned r = CONTAINER_OF(struct node, list, rhs)->key;
+    ++*count;
+    return (l > r) - (l < r);
+}
+
+static void sort(struct node *nodes, size_t n) {
+    struct list l;
+    size_t count = 0;
+    list_init(&l);
+    for (size_t i = 0; i < n; ++i) {
+        nodes[i].key = rand();
+        list_push_back(&l, &nodes[i].list);
+    }
+
+    double start = now();
+    list_sort(&l, node_cmp, &count);
+    double elapsed = now() - start;
+    printf("sort %8zu nodes: %8.2f ms %6.1f cmp/node\n",
+            n, elapsed * 1e3, (double)count / n);
+}
+
+// Sorted runs of consecutive nodes, as left by per-thread sorts
+static void split(struct list *lists, struct node *nodes) {
+    size_t n = NODES / LISTS;
+    for (size_t i = 0; i < LISTS; ++i) {
+        list_init(&lists[i]);
+        for (size_t j = 0; j < n; ++j) {
+            nodes[i * n + j].key = rand();
+            list_push_back(&lists[i], &nodes[i * n + j].list);
+        }
+        size_t count = 0;
+        list_sort(&lists[i], node_cmp, &count);
+    }
+}
+
+static void merge(struct node *nodes) {
+    struct list lists[LISTS];
+    struct list res;
+    size_t count = 0;
+
+    split(lists, nodes);
+    double start = now();
+    for (size_t i = 1; i < LISTS; ++i)
+        list_merge_sorted(&lists[0], &lists[i], node_cmp, &count);
+    double elapsed = now() - start;
+    printf("merge %d x %zu pairwise: %8.2f ms %6.1f cmp/node\n",
+            LISTS, NODES / LISTS, elapsed * 1e3, (double)count / NODES);
+
+    split(lists, nodes);
+    list_init(&res);
+    count = 0;
+    start = now();
+    list_kway_merge(&res, lists, LISTS, node_cmp, &count);
+    elapsed = now() - start;
+    printf("merge %d x %zu kway:     %8.2f ms %6.1f cmp/node\n",
+            LISTS, NODES / LISTS, elapsed * 1e3, (double)count / NODES);
+}
+
+static void length(struct node *nodes) {
+    struct counted_list l;
+    counted_list_init(&l);
+    for (size_t i = 0; i < NODES; ++i)
+        counted_list_push_back(&l, &nodes[i].list);
+
+    size_t sum = 0;
+    double start = now();
+    for (size_t i = 0; i < 100; ++i)
+        sum += list_length(&l.list);
+    double walk = (now() - start) / 100;
+    start = now();
+    for (size_t i = 0; i < 100; ++i)
+        sum += counted_list_length(&l);
+    double counted = (now() - start) / 100;
+    printf("length %zu nodes: %8.3f ms walk %8.6f ms counted (%zu)\n",
+            NODES, walk * 1e3, counted * 1e3, sum);
+}
+
+int main(void) {
+    struct node *nodes = malloc(NODES * sizeof(*nodes));
+
+    for (size_t n = 1000; n <= NODES; n *= 10)
+        sort(nodes, n);
+    merge(nodes);
+    length(nodes);
+
+    free(nodes);
+
+    return 0;
+}
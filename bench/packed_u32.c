@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/packed_u32.h"
+#include "tupperware/vector_simd.h"
+
+#define LENGTH (16UL * 1000 * 1000)
+#define ROUNDS 10
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Strictly increasing, differences of up to `step`
+static void fill_set(struct vector *v, size_t n, uint32_t step) {
+    uint32_t x = 0;
+    vector_with_cap(v, sizeof(uint32_t), n);
+    for (size_t i = 0; i < n; ++i) {
+        x += 1 + rand() % step;
+        vector_push_back(v, &x);
+    }
+}
+
+static void intersect(const char *name, size_t nlhs, size_t nrhs) {
+    struct vector lhs;
+    struct vector rhs;
+    struct vector res;
+    struct packed_u32 plhs;
+    struct packed_u32 prhs;
+    fill_set(&lhs, nlhs, LENGTH / nlhs * 2);
+    fill_set(&rhs, nrhs, LENGTH / nrhs * 2);
+    packed_u32_init(&plhs, &lhs);
+    packed_u32_init(&prhs, &rhs);
+    vector_init(&res, sizeof(uint32_t));
+
+    double start = now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        res.nmemb = 0;
+        vector_simd_set_intersection_u32(&res, &lhs, &rhs);
+    }
+    double plain = (now() - start) / ROUNDS * 1e3;
+
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        res.nmemb = 0;
+        packed_u32_intersection(&res, &plhs, &prhs);
+    }
+    double packed = (now() - start) / ROUNDS * 1e3;
+
+    printf("%-12s %12.2f %12.2f\n", name, plain, packed);
+
+    vector_clear(&lhs, NULL, NULL);
+    vector_clear(&rhs, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+    packed_u32_clear(&plhs);
+    packed_u32_clear(&prhs);
+}
+
+int main(void) {
+    struct vector v;
+    struct vector res;
+    struct packed_u32 p;
+
+    printf("isa %s\n", vector_simd_isa());
+
+    // Differences of up to 6 bits
+    fill_set(&v, LENGTH, 63);
+    packed_u32_init(&p, &v);
+    printf("bytes per element %.2f\n", (double)packed_u32_bytes(&p) / LENGTH);
+
+    // Once before timing, for the page faults
+    vector_init(&res, sizeof(uint32_t));
+    packed_u32_decode(&p, &res);
+    double start = now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        res.nmemb = 0;
+        packed_u32_decode(&p, &res);
+    }
+    printf("decode elem/ns %.2f\n", LENGTH * ROUNDS / (now() - start) / 1e9);
+
+    struct packed_u32_iter it;
+    uint64_t sum = 0;
+    uint32_t x;
+    start = now();
+    packed_u32_iter_init(&it, &p);
+    while (packed_u32_next(&it, &x))
+        sum += x;
+    printf("iterate elem/ns %.2f (%llu)\n", LENGTH / (now() - start) / 1e9,
+            (unsigned long long)sum);
+
+    vector_clear(&v, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+    packed_u32_clear(&p);
+
+    printf("intersection  vector ms    packed ms\n");
+    intersect("1M x 1M", 1000 * 1000, 1000 * 1000);
+    intersect("10k x 1M", 10 * 1000, 1000 * 1000);
+    intersect("100 x 1M", 100, 1000 * 1000);
+
+    return 0;
+}
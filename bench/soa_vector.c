@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "tupperware/soa_vector.h"
+#include "tupperware/vector.h"
+
+#define LENGTH (4UL * 1000 * 1000)
+
+// 64 bytes, only `price` is scanned
+struct record {
+    uint64_t id;
+    double price;
+    uint64_t payload[6];
+};
+
+static const struct soa_field fields[] = {
+    SOA_FIELD(struct record, id),
+    SOA_FIELD(struct record, price),
+    SOA_FIELD(struct record, payload),
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int price_cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    double l = *(const double *)lhs;
+    double r = *(const double *)rhs;
+    return (l > r) - (l < r);
+}
+
+static int record_cmp(const void *lhs, const void *rhs, void *cookie) {
+    const struct record *l = lhs;
+    const struct record *r = rhs;
+    return price_cmp(&l->price, &r->price, cookie);
+}
+
+int main(void) {
+    struct vector aos;
+    struct soa_vector soa;
+    struct record r = { 0 };
+    double start;
+
+    vector_with_cap(&aos, sizeof(struct record), LENGTH);
+    soa_vector_init(&soa, fields, sizeof(fields) / sizeof(*fields));
+    soa_vector_reserve(&soa, LENGTH);
+    for (uint64_t i = 0; i < LENGTH; ++i) {
+        r.id = i;
+        r.price = (i * 2654435761u) % 100000 * 0.01;
+        vector_push_back(&aos, &r);
+        soa_vector_push_back(&soa, &r);
+    }
+
+    double aos_sum = 0;
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i)
+        aos_sum += ((struct record *)vector_at(&aos, i))->price;
+    double aos_scan = LENGTH / (now() - start) / 1e6;
+
+    double soa_sum = 0;
+    const double *prices = soa_vector_column(&soa, 1);
+    start = now();
+    for (size_t i = 0; i < LENGTH; ++i)
+        soa_sum += prices[i];
+    double soa_scan = LENGTH / (now() - start) / 1e6;
+
+    start = now();
+    vector_merge_sort(&aos, record_cmp, NULL);
+    double aos_sort = LENGTH / (now() - start) / 1e6;
+
+    start = now();
+    soa_vector_sort_by(&soa, 1, price_cmp, NULL);
+    double soa_sort = LENGTH / (now() - start) / 1e6;
+
+    printf("layout  scan Melem/s  sort Melem/s\n");
+    printf("aos     %12.2f  %12.2f\n", aos_scan, aos_sort);
+    printf("soa     %12.2f  %12.2f\n", soa_scan, soa_sort);
+    printf("(sums %.0f %.0f)\n", aos_sum, soa_sum);
+
+    soa_vector_clear(&soa);
+    vector_clear(&aos, NULL, NULL);
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/spsc_ring.h"
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+#define RING_CAP 1024
+#define BATCH 32
+#define THROUGHPUT_N (50UL * 1000 * 1000)
+#define PING_PONG_N (1UL * 1000 * 1000)
+
+struct bench {
+    struct spsc_ring ping;
+    struct spsc_ring pong;
+    int cpu;
+    size_t batch;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Spin for a while before yielding, in case both threads share a CPU
+static void backoff(unsigned *spins) {
+    if (++*spins % 1024 == 0)
+        sched_yield();
+}
+
+static void pin(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+        fprintf(stderr, "warning: could not pin thread to CPU %d\n", cpu);
+}
+
+static void *throughput_producer(void *arg) {
+    struct bench *b = arg;
+    uint64_t batch[BATCH];
+
+    pin(b->cpu);
+    for (uint64_t i = 0; i < THROUGHPUT_N;) {
+        size_t n = 0;
+        for (; n < b->batch && i + n < THROUGHPUT_N; ++n)
+            batch[n] = i + n;
+
+        size_t pushed = 0;
+        unsigned spins = 0;
+        while (pushed < n) {
+            size_t ret =
+                spsc_ring_push_n(&b->ping, batch + pushed, n - pushed);
+            if (!ret)
+                backoff(&spins);
+            pushed += ret;
+        }
+        i += n;
+    }
+
+    return NULL;
+}
+
+static void throughput(struct bench *b, size_t batch_size) {
+    uint64_t batch[BATCH];
+    uint64_t sum = 0;
+    pthread_t t;
+
+    b->batch = batch_size;
+    double start = now();
+    pthread_create(&t, NULL, throughput_producer, b);
+
+    unsigned spins = 0;
+    for (uint64_t i = 0; i < THROUGHPUT_N;) {
+        size_t n = spsc_ring_pop_n(&b->ping, batch, batch_size);
+        if (!n)
+            backoff(&spins);
+        for (size_t j = 0; j < n; ++j)
+            sum += batch[j];
+        i += n;
+    }
+
+    pthread_join(t, NULL);
+    double elapsed = now() - start;
+
+    if (sum != THROUGHPUT_N * (THROUGHPUT_N - 1) / 2)
+        fprintf(stderr, "error: checksum mismatch\n");
+    printf("throughput (batch %2zu): %8.2f Mops/s\n",
+            batch_size, THROUGHPUT_N / elapsed / 1e6);
+}
+
+static void *ping_pong_echo(void *arg) {
+    struct bench *b = arg;
+    uint64_t v;
+
+    pin(b->cpu);
+    for (uint64_t i = 0; i < PING_PONG_N; ++i) {
+        unsigned spins = 0;
+        while (!spsc_ring_pop(&b->ping, &v))
+            backoff(&spins);
+        while (!spsc_ring_push(&b->pong, &v))
+            backoff(&spins);
+    }
+
+    return NULL;
+}
+
+static void latency(struct bench *b) {
+    pthread_t t;
+
+    pthread_create(&t, NULL, ping_pong_echo, b);
+
+    double start = now();
+    for (uint64_t i = 0; i < PING_PONG_N; ++i) {
+        uint64_t v = i;
+        unsigned spins = 0;
+        while (!spsc_ring_push(&b->ping, &v))
+            backoff(&spins);
+        while (!spsc_ring_pop(&b->pong, &v))
+            backoff(&spins);
+    }
+    double elapsed = now() - start;
+
+    pthread_join(t, NULL);
+    printf("one-way latency: %8.1f ns\n", elapsed / PING_PONG_N / 2 * 1e9);
+}
+
+int main(int argc, char *argv[]) {
+    int producer_cpu = argc > 1 ? atoi(argv[1]) : 0;
+    int consumer_cpu = argc > 2 ? atoi(argv[2]) : 1;
+    struct bench b = { .cpu = producer_cpu };
+
+    if (!spsc_ring_init(&b.ping, sizeof(uint64_t), RING_CAP)
+            || !spsc_ring_init(&b.pong, sizeof(uint64_t), RING_CAP)) {
+        fprintf(stderr, "error: could not allocate rings\n");
+        return 1;
+    }
+
+    pin(consumer_cpu);
+
+    size_t batches[] = { 1, 8, BATCH };
+    for (size_t i = 0; i < ARR_SIZE(batches); ++i)
+        throughput(&b, batches[i]);
+    latency(&b);
+
+    spsc_ring_clear(&b.ping, NULL, NULL);
+    spsc_ring_clear(&b.pong, NULL, NULL);
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/unrolled_list.h"
+#include "tupperware/vector.h"
+
+#define ELEMS (8UL * 1000 * 1000)
+#define SCANS 5
+
+struct node {
+    uint64_t val;
+    struct list_node list;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void add(void *v, void *cookie) {
+    *(uint64_t *)cookie += *(uint64_t *)v;
+}
+
+static void report(const char *name, double elapsed, uint64_t sum) {
+    printf("%-22s %6.2f ns/elem (%llu)\n", name,
+            elapsed / (SCANS * ELEMS) * 1e9, (unsigned long long)sum);
+}
+
+int main(void) {
+    struct vector v;
+    struct unrolled_list u;
+    struct list l;
+    struct node *nodes = malloc(ELEMS * sizeof(*nodes));
+    size_t *order = malloc(ELEMS * sizeof(*order));
+
+    vector_init(&v, sizeof(uint64_t));
+    unrolled_list_init(&u, sizeof(uint64_t));
+    list_init(&l);
+
+    double start = now();
+    for (uint64_t i = 0; i < ELEMS; ++i)
+        vector_push_back(&v, &i);
+    printf("%-22s %6.2f ns/elem\n", "vector push_back",
+            (now() - start) / ELEMS * 1e9);
+    start = now();
+    for (uint64_t i = 0; i < ELEMS; ++i)
+        unrolled_list_push_back(&u, &i);
+    printf("%-22s %6.2f ns/elem\n", "unrolled push_back",
+            (now() - start) / ELEMS * 1e9);
+
+    // Nodes allocated over time end up all over the heap
+    for (size_t i = 0; i < ELEMS; ++i)
+        order[i] = i;
+    for (size_t i = ELEMS - 1; i > 0; --i) {
+        size_t j = rand() % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (size_t i = 0; i < ELEMS; ++i) {
+        nodes[order[i]].val = i;
+        list_push_back(&l, &nodes[order[i]].list);
+    }
+
+    uint64_t sum = 0;
+    start = now();
+    for (size_t s = 0; s < SCANS; ++s) {
+        const uint64_t *arr = v.arr;
+        for (size_t i = 0; i < v.nmemb; ++i)
+            sum += arr[i];
+    }
+    report("vector scan", now() - start, sum);
+
+    sum = 0;
+    start = now();
+    for (size_t s = 0; s < SCANS; ++s) {
+        UNROLLED_LIST_FOREACH_BLOCK (u, b) {
+            const uint64_t *arr = UNROLLED_BLOCK_BEGIN(u, b);
+            for (size_t i = 0; i < b->nmemb; ++i)
+                sum += arr[i];
+        }
+    }
+    report("unrolled scan", now() - start, sum);
+
+    sum = 0;
+    start = now();
+    for (size_t s = 0; s < SCANS; ++s)
+        unrolled_list_map(&u, add, &sum);
+    report("unrolled map", now() - start, sum);
+
+    sum = 0;
+    start = now();
+    for (size_t s = 0; s < SCANS; ++s)
+        LIST_FOREACH_ENTRY (struct node, list, l, it)
+            sum += it->val;
+    report("list scan", now() - start, sum);
+
+    vector_clear(&v, NULL, NULL);
+    unrolled_list_clear(&u, NULL, NULL);
+    free(nodes);
+    free(order);
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tupperware/vector_parallel.h"
+
+#define LENGTH (16UL * 1000 * 1000)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// A few dozen cycles of work per element
+static uint64_t mix(uint64_t x) {
+    for (int i = 0; i < 8; ++i) {
+        x ^= x >> 31;
+        x *= 0x7fb5d329728ea185ULL;
+    }
+    return x;
+}
+
+static void map(void *v, void *cookie) {
+    (void)cookie;
+    uint64_t *x = v;
+    *x = mix(*x);
+}
+
+static bool filter(void *v, void *cookie) {
+    (void)cookie;
+    return mix(*(uint64_t *)v) & 1;
+}
+
+static void reduce(void *acc, const void *v, void *cookie) {
+    (void)cookie;
+    *(uint64_t *)acc += mix(*(const uint64_t *)v);
+}
+
+static int cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    uint64_t l = *(const uint64_t *)lhs;
+    uint64_t r = *(const uint64_t *)rhs;
+    return (l > r) - (l < r);
+}
+
+static void fill(struct vector *v) {
+    vector_with_cap(v, sizeof(uint64_t), LENGTH);
+    for (uint64_t i = 0; i < LENGTH; ++i)
+        vector_push_back(v, &i);
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 1 ? strtoul(argv[1], NULL, 10) : (size_t)cpus;
+    struct vector v;
+    struct vector res;
+    uint64_t sum;
+    double start;
+
+    printf("threads  map Melem/s  filter Melem/s  reduce Melem/s"
+            "  sort Melem/s\n");
+    for (size_t n = 1; n <= max_threads; n *= 2) {
+        struct scheduler s;
+        scheduler_init(&s, n);
+        fill(&v);
+
+        start = now();
+        vector_parallel_map(&v, map, NULL, &s);
+        double mapped = LENGTH / (now() - start) / 1e6;
+
+        start = now();
+        vector_parallel_reduce(&v, &sum, reduce, NULL, &s);
+        double reduced = LENGTH / (now() - start) / 1e6;
+
+        vector_init(&res, sizeof(uint64_t));
+        start = now();
+        vector_parallel_filter(&res, &v, filter, NULL, &s);
+        double filtered = LENGTH / (now() - start) / 1e6;
+
+        start = now();
+        vector_parallel_merge_sort(&v, cmp, NULL, &s);
+        double sorted = vector_length(&v) / (now() - start) / 1e6;
+
+        printf("%7zu  %12.2f  %14.2f  %14.2f  %12.2f\n",
+                n, mapped, filtered, reduced, sorted);
+
+        vector_clear(&res, NULL, NULL);
+        vector_clear(&v, NULL, NULL);
+        scheduler_clear(&s);
+    }
+
+    return 0;
+}
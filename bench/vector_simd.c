@@ -0,0 +1,142 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/vector_simd.h"
+
+#define LENGTH (16UL * 1000 * 1000)
+#define ROUNDS 10
+// `vector_filter` pops matches one by one, it is quadratic
+#define FILTER_LENGTH (64UL * 1000)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill(struct vector *v, size_t n) {
+    vector_with_cap(v, sizeof(uint32_t), n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t x = rand();
+        vector_push_back(v, &x);
+    }
+}
+
+static bool below_half(void *v, void *cookie) {
+    (void)cookie;
+    return *(uint32_t *)v < RAND_MAX / 2;
+}
+
+static void affine(void *v, void *cookie) {
+    (void)cookie;
+    uint32_t *x = v;
+    *x = *x * 3 + 7;
+}
+
+static int u32_cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    uint32_t l = *(const uint32_t *)lhs;
+    uint32_t r = *(const uint32_t *)rhs;
+    return (l > r) - (l < r);
+}
+
+static void fill_set(struct vector *v, size_t n) {
+    uint32_t x = 0;
+    vector_with_cap(v, sizeof(uint32_t), n);
+    for (size_t i = 0; i < n; ++i) {
+        x += 1 + rand() % 3;
+        vector_push_back(v, &x);
+    }
+}
+
+// Elements per nanosecond
+static double rate(size_t n, double seconds) {
+    return n * ROUNDS / seconds / 1e9;
+}
+
+int main(void) {
+    struct vector v;
+    struct vector res;
+    double start;
+    uint64_t sum = 0;
+
+    printf("instruction set: %s\n", vector_simd_isa());
+    printf("kernel     generic elem/ns  simd elem/ns\n");
+
+    double generic = 0;
+    double simd = 0;
+    for (int i = 0; i < ROUNDS; ++i) {
+        fill(&v, FILTER_LENGTH);
+        vector_init(&res, sizeof(uint32_t));
+        start = now();
+        vector_filter(&res, &v, below_half, NULL);
+        generic += now() - start;
+        vector_clear(&res, NULL, NULL);
+        vector_clear(&v, NULL, NULL);
+
+        fill(&v, FILTER_LENGTH);
+        vector_init(&res, sizeof(uint32_t));
+        start = now();
+        vector_simd_filter_u32(&res, &v, VECTOR_SIMD_LT, RAND_MAX / 2);
+        simd += now() - start;
+        vector_clear(&res, NULL, NULL);
+        vector_clear(&v, NULL, NULL);
+    }
+    printf("filter  %15.2f  %12.2f\n",
+            rate(FILTER_LENGTH, generic), rate(FILTER_LENGTH, simd));
+
+    fill(&v, LENGTH);
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i)
+        vector_map(&v, affine, NULL);
+    generic = now() - start;
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i)
+        vector_simd_affine_u32(&v, 3, 7);
+    simd = now() - start;
+    printf("affine  %15.2f  %12.2f\n",
+            rate(LENGTH, generic), rate(LENGTH, simd));
+
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i)
+        for (size_t j = 0; j < LENGTH; ++j)
+            sum += *(uint32_t *)vector_at(&v, j);
+    generic = now() - start;
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        uint64_t s;
+        vector_simd_sum_u32(&v, &s);
+        sum -= s;
+    }
+    simd = now() - start;
+    printf("sum     %15.2f  %12.2f\n",
+            rate(LENGTH, generic), rate(LENGTH, simd));
+    vector_clear(&v, NULL, NULL);
+
+    struct vector lhs;
+    struct vector rhs;
+    fill_set(&lhs, LENGTH / 2);
+    fill_set(&rhs, LENGTH / 2);
+    vector_with_cap(&res, sizeof(uint32_t), LENGTH / 2 + 16);
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        res.nmemb = 0;
+        vector_set_intersection(&res, &lhs, &rhs, u32_cmp, NULL);
+    }
+    generic = now() - start;
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        res.nmemb = 0;
+        vector_simd_set_intersection_u32(&res, &lhs, &rhs);
+    }
+    simd = now() - start;
+    printf("inter   %15.2f  %12.2f\n",
+            rate(LENGTH, generic), rate(LENGTH, simd));
+    vector_clear(&lhs, NULL, NULL);
+    vector_clear(&rhs, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+
+    return sum != 0;
+}
@@ -0,0 +1,82 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tupperware/vector_stream.h"
+
+#define LENGTH (16UL * 1000 * 1000)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *seed) {
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *seed = x;
+}
+
+static void bench(const char *name, const struct vector *v,
+        enum vector_stream_codec codec) {
+    struct vector_stream_writer w;
+    struct vector_stream_reader r;
+    struct vector res;
+    double bytes = v->nmemb * v->size;
+    FILE *file = tmpfile();
+
+    double start = now();
+    vector_stream_writer_init(&w, file, v->size, codec);
+    vector_stream_write_vector(&w, v);
+    vector_stream_writer_finish(&w);
+    double written = bytes / (now() - start) / 1e6;
+    double ratio = bytes / ftell(file);
+    rewind(file);
+
+    vector_init(&res, v->size);
+    start = now();
+    vector_stream_reader_init(&r, file);
+    if (!vector_stream_read_vector(&r, &res))
+        abort();
+    double read = bytes / (now() - start) / 1e6;
+
+    printf("%-8s %-6s %12.2f %12.2f %8.2f\n",
+            name, codec == VECTOR_STREAM_RAW ? "raw"
+            : codec == VECTOR_STREAM_LZ ? "lz" : "delta",
+            written, read, ratio);
+
+    vector_stream_reader_clear(&r);
+    vector_clear(&res, NULL, NULL);
+    fclose(file);
+}
+
+int main(void) {
+    struct vector sorted;
+    struct vector random;
+    uint64_t seed = 42;
+    uint64_t x = 0;
+
+    vector_with_cap(&sorted, sizeof(uint64_t), LENGTH);
+    vector_with_cap(&random, sizeof(uint64_t), LENGTH);
+    for (size_t i = 0; i < LENGTH; ++i) {
+        x += xorshift(&seed) % 1000;
+        vector_push_back(&sorted, &x);
+        uint64_t y = xorshift(&seed);
+        vector_push_back(&random, &y);
+    }
+
+    printf("data     codec  write MB/s    read MB/s    ratio\n");
+    for (enum vector_stream_codec c = 0; c <= VECTOR_STREAM_DELTA; ++c)
+        bench("sorted", &sorted, c);
+    for (enum vector_stream_codec c = 0; c <= VECTOR_STREAM_DELTA; ++c)
+        bench("random", &random, c);
+
+    vector_clear(&sorted, NULL, NULL);
+    vector_clear(&random, NULL, NULL);
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef TUPPERWARE_AVL_PARALLEL_H
+#define TUPPERWARE_AVL_PARALLEL_H
+
+#include "tupperware/avl.h"
+#include "tupperware/scheduler.h"
+
+// Parallel versions of `avl_prefix_map` and `avl_clear`, splitting the tree
+// between the workers of `s`, or running on the calling thread if it is NULL.
+// Callbacks are called concurrently on disjoint subtrees.
+
+// Each node is mapped before any of its descendants
+void avl_parallel_map(struct avl *tree,
+        avl_map_f map, void *cookie, struct scheduler *s);
+// Each node is destroyed after all of its descendants
+void avl_parallel_clear(struct avl *tree,
+        void (*dtor)(struct avl_node *n, void *cookie), void *cookie,
+        struct scheduler *s);
+
+#endif /* !TUPPERWARE_AVL_PARALLEL_H */
@@ -0,0 +1,71 @@
+#ifndef TUPPERWARE_BITVEC_H
+#define TUPPERWARE_BITVEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Growable array of bits, stored in 64-bit words. Bits past `nbits` in the
+// last word are always zero.
+struct bitvec {
+    uint64_t *words;
+    size_t nbits;
+    // In bits, always a multiple of 64
+    size_t cap;
+
+    // Rank/select index, see `bitvec_build_index`. Dropped by any change.
+    size_t *supers;
+    uint16_t *blocks;
+    size_t *samples;
+    size_t ones;
+};
+
+bool bitvec_init(struct bitvec *b);
+bool bitvec_with_cap(struct bitvec *b, size_t cap);
+void bitvec_clear(struct bitvec *b);
+
+bool bitvec_reserve(struct bitvec *b, size_t cap);
+// New bits are unset
+bool bitvec_resize(struct bitvec *b, size_t nbits);
+
+size_t bitvec_length(const struct bitvec *b);
+size_t bitvec_capacity(const struct bitvec *b);
+bool bitvec_empty(const struct bitvec *b);
+
+bool bitvec_push_back(struct bitvec *b, bool bit);
+
+// Return false if `i` is out of bounds
+bool bitvec_set(struct bitvec *b, size_t i);
+bool bitvec_reset(struct bitvec *b, size_t i);
+bool bitvec_flip(struct bitvec *b, size_t i);
+bool bitvec_test(const struct bitvec *b, size_t i);
+bool bitvec_fill(struct bitvec *b, bool bit);
+
+// First set bit at or after `i`
+bool bitvec_next_set(const struct bitvec *b, size_t i, size_t *index);
+
+// Whole set operations on bit vectors of the same length, `res` is resized to
+// it and can be one of the operands. Use the widest instruction set available
+// at runtime.
+bool bitvec_and(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs);
+bool bitvec_or(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs);
+bool bitvec_xor(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs);
+// Bits set in `lhs` but not in `rhs`
+bool bitvec_andnot(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs);
+
+size_t bitvec_popcount(const struct bitvec *b);
+
+// Counts set bits per block of 512 and 4096, and samples every 4096th set bit,
+// about 5% on top of the bits. Must be built again after changes for rank and
+// select to succeed.
+bool bitvec_build_index(struct bitvec *b);
+// Number of set bits before `i`, `i` can be the length
+bool bitvec_rank(const struct bitvec *b, size_t i, size_t *output);
+// Position of the set bit of rank `k`
+bool bitvec_select(const struct bitvec *b, size_t k, size_t *output);
+
+#endif /* !TUPPERWARE_BITVEC_H */
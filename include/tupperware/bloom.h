@@ -0,0 +1,91 @@
+#ifndef TUPPERWARE_BLOOM_H
+#define TUPPERWARE_BLOOM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tupperware/avl.h"
+#include "tupperware/vector.h"
+
+// 32-bit words per block, a key sets one bit in each
+#define BLOOM_BLOCK_WORDS 8
+
+typedef uint64_t (*bloom_hash_f)(const void *elem, void *cookie);
+
+// Blocked Bloom filter over 64-bit hashes. A key only touches one block of
+// 256 bits, aligned so that it never straddles a cache line, and its bits are
+// probed with one vector compare when AVX2 is available. Filters are laid out
+// the same whatever the instruction set.
+struct bloom {
+    uint32_t *blocks;
+    size_t nblocks;
+};
+
+// Sized for a false positive rate of `fpr` once `n` keys are added
+bool bloom_init(struct bloom *f, size_t n, double fpr);
+void bloom_clear(struct bloom *f);
+// Forgets every key
+void bloom_reset(struct bloom *f);
+
+size_t bloom_bytes(const struct bloom *f);
+// Expected false positive rate with `n` keys
+double bloom_fpr(const struct bloom *f, size_t n);
+
+bool bloom_add(struct bloom *f, uint64_t hash);
+// Prefetch the blocks of the next keys while setting bits
+bool bloom_add_n(struct bloom *f, const uint64_t *hashes, size_t n);
+bool bloom_add_vector(struct bloom *f, const struct vector *v,
+        bloom_hash_f hash, void *cookie);
+
+bool bloom_contains(const struct bloom *f, uint64_t hash);
+// Sets `found[i]` for each hash, returns how many may be there
+size_t bloom_contains_n(const struct bloom *f,
+        const uint64_t *hashes, size_t n, bool *found);
+
+// Bloom filter with a 4-bit counter behind every bit, so that keys can be
+// removed. Counters stick once they reach 15. Lookups only read the bits.
+struct counting_bloom {
+    struct bloom filter;
+    uint8_t *counters;
+};
+
+bool counting_bloom_init(struct counting_bloom *c, size_t n, double fpr);
+void counting_bloom_clear(struct counting_bloom *c);
+
+bool counting_bloom_add(struct counting_bloom *c, uint64_t hash);
+// Returns false if `hash` was not added, which leaves the filter as it is
+bool counting_bloom_remove(struct counting_bloom *c, uint64_t hash);
+bool counting_bloom_contains(const struct counting_bloom *c, uint64_t hash);
+
+typedef uint64_t (*bloom_avl_hash_f)(const struct avl_node *n, void *cookie);
+
+// AVL tree fronted by a counting Bloom filter, so that looking up absent keys
+// rarely walks the tree. `hash` must agree with the tree comparison. The
+// filter is rebuilt twice as large when the tree outgrows it.
+//
+// The tree itself must only be changed through these functions.
+struct bloom_avl {
+    struct avl tree;
+    struct counting_bloom filter;
+    bloom_avl_hash_f hash;
+    size_t nmemb;
+    // Nodes the filter is sized for
+    size_t expected;
+    double fpr;
+};
+
+bool bloom_avl_init(struct bloom_avl *b, avl_cmp_f cmp, bloom_avl_hash_f hash,
+        void *cookie, size_t n, double fpr);
+void bloom_avl_clear(struct bloom_avl *b,
+        void (*dtor)(struct avl_node *n, void *cookie), void *cookie);
+
+bool bloom_avl_insert(struct bloom_avl *b,
+        struct avl_node *v, struct avl_node **inserted);
+struct avl_node *bloom_avl_remove(struct bloom_avl *b, struct avl_node *v);
+bool bloom_avl_remove_at(struct bloom_avl *b, struct avl_node *v);
+
+struct avl_node *bloom_avl_find(const struct bloom_avl *b,
+        const struct avl_node *v);
+
+#endif /* !TUPPERWARE_BLOOM_H */
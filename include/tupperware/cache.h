@@ -0,0 +1,118 @@
+#ifndef TUPPERWARE_CACHE_H
+#define TUPPERWARE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tupperware/hashmap.h"
+#include "tupperware/htable.h"
+#include "tupperware/list.h"
+
+enum cache_policy {
+    // Hits move the entry to the front of the list
+    CACHE_LRU,
+    // Hits set a reference bit, evictions sweep a hand around the list
+    // clearing them
+    CACHE_CLOCK,
+    // New entries go through a small FIFO queue, those hit there move to the
+    // main one, others leave and are remembered by a ghost queue of hashes
+    // that sends them straight to the main queue if they come back. Hits only
+    // bump a counter.
+    CACHE_S3FIFO,
+};
+
+struct cache_node {
+    struct htable_node hnode;
+    struct list_node lnode;
+    // Reference bit for CLOCK, hit count up to 3 for S3-FIFO
+    uint8_t freq;
+    // In the main queue of S3-FIFO
+    bool main;
+};
+
+typedef uint64_t (*cache_hash_f)(const struct cache_node *n, void *cookie);
+typedef bool (*cache_eq_f)(const struct cache_node *lhs,
+        const struct cache_node *rhs, void *cookie);
+typedef void (*cache_evict_f)(struct cache_node *n, void *cookie);
+
+struct cache_ghost {
+    uint64_t hash;
+    // Tells a stale ring slot from a hash that came back since
+    uint64_t seq;
+};
+
+struct cache_stats {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    // Only counted with `cache_set_timing`
+    uint64_t get_ns;
+    uint64_t get_max_ns;
+};
+
+// Bounded intrusive cache: an intrusive hash table indexes entries that also
+// sit on a list ordered by the policy. Every operation is O(1), the evicted
+// entries are given to `evict`.
+struct cache {
+    struct htable index;
+    // The whole list for LRU and CLOCK, the small queue for S3-FIFO. Lists
+    // are newest first.
+    struct list small;
+    struct list main;
+    struct cache_node *hand;
+    size_t nsmall;
+    size_t nmain;
+    size_t cap;
+    enum cache_policy policy;
+    cache_hash_f hash;
+    cache_eq_f eq;
+    cache_evict_f evict;
+    void *cookie;
+
+    // S3-FIFO ghost queue, a ring of hashes and the set of those still there
+    struct cache_ghost *ghosts;
+    size_t ghost_head;
+    size_t nghosts;
+    uint64_t ghost_seq;
+    struct hashmap ghost_set;
+
+    struct cache_stats stats;
+    bool timed;
+};
+
+#define CACHE_NODE_INIT_VAL \
+    ((struct cache_node){ \
+        .hnode = HTABLE_NODE_INIT_VAL, \
+        .lnode = LIST_NODE_INIT_VAL, \
+        .freq = 0, \
+        .main = false, \
+    })
+
+bool cache_init(struct cache *c, enum cache_policy policy, size_t cap,
+        cache_hash_f hash, cache_eq_f eq, cache_evict_f evict, void *cookie);
+void cache_clear(struct cache *c,
+        void (*dtor)(struct cache_node *n, void *cookie), void *cookie);
+
+size_t cache_length(const struct cache *c);
+size_t cache_capacity(const struct cache *c);
+bool cache_empty(const struct cache *c);
+
+// Entry equal to `key`, counted as a hit or a miss
+struct cache_node *cache_get(struct cache *c, const struct cache_node *key);
+// Like `cache_get` without touching the entry or the statistics
+struct cache_node *cache_peek(const struct cache *c,
+        const struct cache_node *key);
+
+// Returns the entry replaced, or `n` itself if it could not be inserted.
+// Inserting may evict another entry.
+struct cache_node *cache_put(struct cache *c, struct cache_node *n);
+// Removes without calling `evict`
+struct cache_node *cache_remove(struct cache *c, const struct cache_node *key);
+
+// Measures the latency of `cache_get`
+void cache_set_timing(struct cache *c, bool timed);
+double cache_hit_rate(const struct cache *c);
+void cache_reset_stats(struct cache *c);
+
+#endif /* !TUPPERWARE_CACHE_H */
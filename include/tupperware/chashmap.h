@@ -0,0 +1,85 @@
+#ifndef TUPPERWARE_CHASHMAP_H
+#define TUPPERWARE_CHASHMAP_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tupperware/vector.h"
+
+#define CHASHMAP_CACHE_LINE 64
+// Writers lock the stripe of the bucket they change, `hash % STRIPES`
+#define CHASHMAP_STRIPES 64
+// Reader counters, threads beyond this many share them
+#define CHASHMAP_READERS 64
+
+// Both only look at the key part of the elements
+typedef uint64_t (*chashmap_hash_f)(const void *elem, void *cookie);
+typedef bool (*chashmap_eq_f)(const void *lhs, const void *rhs, void *cookie);
+
+struct chashmap_stripe {
+    pthread_mutex_t lock;
+    size_t nmemb;
+    char pad[CHASHMAP_CACHE_LINE];
+};
+
+// Readers inside a lookup, by parity of the epoch they entered in
+struct chashmap_reader {
+    size_t active[2];
+    char pad[CHASHMAP_CACHE_LINE];
+};
+
+struct chashmap_table;
+
+// Chained hash table of fixed size elements shared by any number of threads.
+// Lookups take no lock and copy the element out, writers lock one of
+// CHASHMAP_STRIPES stripes, all of them to grow the table.
+//
+// Removed elements and outgrown tables are freed once no lookup can still
+// see them: writers flip an epoch and wait for the readers counted under the
+// previous one to leave, a batch of removals at a time.
+//
+// `hash` and `eq` must not call back into the map.
+struct chashmap {
+    size_t size;
+    chashmap_hash_f hash;
+    chashmap_eq_f eq;
+    void *cookie;
+    struct chashmap_table *table;
+    unsigned epoch;
+    char pad_shared[CHASHMAP_CACHE_LINE];
+    struct chashmap_stripe stripes[CHASHMAP_STRIPES];
+    struct chashmap_reader readers[CHASHMAP_READERS];
+    pthread_mutex_t retire_lock;
+    struct vector retired_nodes;
+    struct vector retired_tables;
+    // Serializes epoch flips
+    pthread_mutex_t sync_lock;
+};
+
+bool chashmap_init(struct chashmap *m, size_t size,
+        chashmap_hash_f hash, chashmap_eq_f eq, void *cookie);
+// Not thread-safe, the map must be initialized again to be reused
+void chashmap_clear(struct chashmap *m,
+        void (*dtor)(void *elem, void *cookie), void *cookie);
+
+// Exact only while no writer runs
+size_t chashmap_length(const struct chashmap *m);
+bool chashmap_empty(const struct chashmap *m);
+
+// Copies the element equal to `key` to `output` when not NULL
+bool chashmap_find(struct chashmap *m, const void *key, void *output);
+
+// Copies `elem` unless an equal one is there, which is then copied to
+// `output` when not NULL. Returns false if not inserted.
+bool chashmap_insert(struct chashmap *m, const void *elem, void *output);
+// Inserts `elem` or replaces the element equal to it
+bool chashmap_assign(struct chashmap *m, const void *elem);
+// Copies the removed element to `output` when not NULL
+bool chashmap_remove(struct chashmap *m, const void *key, void *output);
+
+// Waits for the readers and frees everything removed so far
+void chashmap_reclaim(struct chashmap *m);
+
+#endif /* !TUPPERWARE_CHASHMAP_H */
@@ -0,0 +1,42 @@
+#ifndef TUPPERWARE_CVECTOR_H
+#define TUPPERWARE_CVECTOR_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CVECTOR_CACHE_LINE 64
+#define CVECTOR_FIRST_SEGMENT_LOG2 5
+#define CVECTOR_SEGMENTS \
+    (sizeof(size_t) * CHAR_BIT - CVECTOR_FIRST_SEGMENT_LOG2)
+
+// Append-only vector, `cvector_push_back` may be called from any number of
+// threads concurrently with readers. Segment `i` holds twice as many elements
+// as segment `i - 1`, so elements are never moved once written.
+struct cvector {
+    size_t size;
+    void *segments[CVECTOR_SEGMENTS];
+    char pad_shared[CVECTOR_CACHE_LINE];
+    // Number of slots handed out to writers
+    size_t reserved;
+    char pad_reserved[CVECTOR_CACHE_LINE];
+    // Length of the fully written prefix, visible to readers
+    size_t published;
+    char pad_published[CVECTOR_CACHE_LINE];
+};
+
+bool cvector_init(struct cvector *v, size_t size);
+void cvector_clear(struct cvector *v,
+        void (*dtor)(void *v, void *cookie), void *cookie);
+
+bool cvector_reserve(struct cvector *v, size_t cap);
+
+size_t cvector_length(const struct cvector *v);
+size_t cvector_elem_size(const struct cvector *v);
+bool cvector_empty(const struct cvector *v);
+
+void *cvector_at(const struct cvector *v, size_t i);
+
+bool cvector_push_back(struct cvector *v, void *elem);
+
+#endif /* !TUPPERWARE_CVECTOR_H */
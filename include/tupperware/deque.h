@@ -0,0 +1,39 @@
+#ifndef TUPPERWARE_DEQUE_H
+#define TUPPERWARE_DEQUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tupperware/vector.h"
+
+// Circular buffer using `vec.arr` as storage, `vec.nmemb` elements are stored
+// starting at index `head`, wrapping around at `vec.cap`
+struct deque {
+    struct vector vec;
+    size_t head;
+};
+
+bool deque_init(struct deque *d, size_t size);
+bool deque_with_cap(struct deque *d, size_t size, size_t cap);
+void deque_clear(struct deque *d,
+        void (*dtor)(void *v, void *cookie), void *cookie);
+
+bool deque_reserve(struct deque *d, size_t cap);
+
+size_t deque_length(const struct deque *d);
+size_t deque_capacity(const struct deque *d);
+size_t deque_elem_size(const struct deque *d);
+bool deque_empty(const struct deque *d);
+
+void *deque_at(const struct deque *d, size_t i);
+
+bool deque_push_back(struct deque *d, void *elem);
+bool deque_push_front(struct deque *d, void *elem);
+
+bool deque_pop_back(struct deque *d, void *output);
+bool deque_pop_front(struct deque *d, void *output);
+
+bool deque_push_back_n(struct deque *d, void *elems, size_t n);
+size_t deque_pop_front_n(struct deque *d, void *output, size_t n);
+
+#endif /* !TUPPERWARE_DEQUE_H */
@@ -0,0 +1,45 @@
+#ifndef TUPPERWARE_ELIAS_FANO_H
+#define TUPPERWARE_ELIAS_FANO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tupperware/vector.h"
+
+// Every `ELIAS_FANO_SAMPLE`th set and unset bit of the upper bits is indexed
+#define ELIAS_FANO_SAMPLE 256
+
+// Read only sorted sequence of `uint64_t`, using about `2 + log2(u / n)` bits
+// per element for `n` elements up to `u`. The lower bits of each element are
+// packed as is, the upper ones are stored as a unary coded difference.
+struct elias_fano {
+    uint64_t *lower;
+    uint64_t *upper;
+    // Positions in `upper` of sampled set bits, then of sampled unset bits
+    size_t *ones;
+    size_t *zeros;
+    size_t nmemb;
+    size_t upper_bits;
+    unsigned lower_bits;
+};
+
+// `v` holds `uint64_t` in non decreasing order
+bool elias_fano_init(struct elias_fano *ef, const struct vector *v);
+void elias_fano_clear(struct elias_fano *ef);
+
+size_t elias_fano_length(const struct elias_fano *ef);
+// Including the indices
+size_t elias_fano_bytes(const struct elias_fano *ef);
+
+bool elias_fano_at(const struct elias_fano *ef, size_t i, uint64_t *output);
+// Appends every element to `res`
+bool elias_fano_decode(const struct elias_fano *ef, struct vector *res);
+
+// Number of elements less than `x`
+size_t elias_fano_rank(const struct elias_fano *ef, uint64_t x);
+// First element not less than `x` and its index, either output can be NULL
+bool elias_fano_successor(const struct elias_fano *ef, uint64_t x,
+        size_t *index, uint64_t *output);
+
+#endif /* !TUPPERWARE_ELIAS_FANO_H */
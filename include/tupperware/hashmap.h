@@ -0,0 +1,59 @@
+#ifndef TUPPERWARE_HASHMAP_H
+#define TUPPERWARE_HASHMAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Control bytes are matched `HASHMAP_GROUP` at a time
+#define HASHMAP_GROUP 16
+
+// Both only look at the key part of the elements
+typedef uint64_t (*hashmap_hash_f)(const void *elem, void *cookie);
+typedef bool (*hashmap_eq_f)(const void *lhs, const void *rhs, void *cookie);
+
+// Open addressing hash table of fixed size elements, stored inline like in
+// struct vector. A control byte per slot holds 7 bits of the hash of its
+// element, or marks it empty. Lookups compare a group of control bytes at
+// once, SSE2 when available. Linear probing lets removals shift the following
+// elements back instead of leaving tombstones.
+//
+// Pointers to elements are invalidated by insertions and removals.
+struct hashmap {
+    uint8_t *ctrl;
+    void *slots;
+    // Low bits of the hash of each element, which give its home slot without
+    // calling `hash` again
+    uint32_t *homes;
+    size_t size;
+    size_t nmemb;
+    // Number of slots, 0 or a power of two
+    size_t cap;
+    hashmap_hash_f hash;
+    hashmap_eq_f eq;
+    void *cookie;
+};
+
+bool hashmap_init(struct hashmap *m, size_t size,
+        hashmap_hash_f hash, hashmap_eq_f eq, void *cookie);
+void hashmap_clear(struct hashmap *m,
+        void (*dtor)(void *elem, void *cookie), void *cookie);
+
+// Room for `n` elements without rehashing
+bool hashmap_reserve(struct hashmap *m, size_t n);
+
+size_t hashmap_length(const struct hashmap *m);
+size_t hashmap_capacity(const struct hashmap *m);
+bool hashmap_empty(const struct hashmap *m);
+
+void *hashmap_find(const struct hashmap *m, const void *key);
+// Copies `elem` unless an equal one is there. `inserted` points to the copy
+// or to the one already there, NULL if allocation failed.
+bool hashmap_insert(struct hashmap *m, const void *elem, void **inserted);
+// Copies the removed element to `output` when not NULL
+bool hashmap_remove(struct hashmap *m, const void *key, void *output);
+
+// Element after position `*pos`, starting from 0, in no particular order
+void *hashmap_next(const struct hashmap *m, size_t *pos);
+
+#endif /* !TUPPERWARE_HASHMAP_H */
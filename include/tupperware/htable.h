@@ -0,0 +1,74 @@
+#ifndef TUPPERWARE_HTABLE_H
+#define TUPPERWARE_HTABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct htable_node {
+    struct htable_node *next;
+    // Mixed hash, kept to move the node without hashing it again
+    uint64_t hash;
+};
+
+typedef uint64_t (*htable_hash_f)(const struct htable_node *n, void *cookie);
+typedef bool (*htable_eq_f)(const struct htable_node *lhs,
+        const struct htable_node *rhs, void *cookie);
+typedef void (*htable_map_f)(struct htable_node *n, void *cookie);
+
+// Intrusive chained hash table. Growing is incremental: the previous bucket
+// array is kept and a few of its buckets move to the new one at each
+// insertion or removal, so that no single operation rehashes every node.
+struct htable {
+    htable_hash_f hash;
+    htable_eq_f eq;
+    void *cookie;
+    struct htable_node **buckets;
+    size_t nbuckets;
+    // Buckets of `old` below `migrated` are already moved
+    struct htable_node **old;
+    size_t nold;
+    size_t migrated;
+    size_t nmemb;
+};
+
+#define CONTAINER_OF(Type, Field, Ptr) \
+      ((Type*)((char*)(Ptr) - offsetof(Type, Field)))
+
+#define HTABLE_NODE_INIT_VAL \
+    ((struct htable_node){ \
+        .next = NULL, \
+        .hash = 0, \
+    })
+
+void htable_init(struct htable *table,
+        htable_hash_f hash, htable_eq_f eq, void *cookie);
+void htable_clear(struct htable *table,
+        void (*dtor)(struct htable_node *n, void *cookie), void *cookie);
+
+// Insertions only fail if the first bucket array cannot be allocated, later
+// ones just keep chains longer until growing succeeds
+bool htable_insert(struct htable *table,
+        struct htable_node *v, struct htable_node **inserted);
+// Returns the node replaced, or `v` itself if it could not be inserted
+struct htable_node *htable_insert_or_update(struct htable *table,
+        struct htable_node *v);
+bool htable_insert_multi(struct htable *table, struct htable_node *v);
+
+struct htable_node *htable_remove(struct htable *table, struct htable_node *v);
+bool htable_remove_at(struct htable *table, struct htable_node *v);
+
+struct htable_node *htable_find(const struct htable *table,
+        const struct htable_node *v);
+
+bool htable_empty(const struct htable *table);
+size_t htable_size(const struct htable *table);
+
+void htable_merge(struct htable *table, struct htable *more);
+void htable_update(struct htable *table, struct htable *more);
+void htable_merge_all(struct htable *table, struct htable *more);
+
+// In no particular order, `map` must not change the table
+void htable_map(struct htable *table, htable_map_f map, void *cookie);
+
+#endif /* !TUPPERWARE_HTABLE_H */
@@ -13,6 +13,13 @@ struct list {
     struct list_node *head;
 };
 
+// List that knows its length, its `list` must only be changed through the
+// counted_list functions
+struct counted_list {
+    struct list list;
+    size_t length;
+};
+
 #define CONTAINER_OF(Type, Field, Ptr) \
       ((Type*)((char*)(Ptr) - offsetof(Type, Field)))
 
@@ -70,6 +77,12 @@ size_t list_length(const struct list *list);
 void list_node_concat(struct list_node *begin, struct list_node *end);
 void list_concat(struct list *begin, struct list *end);
 
+// Moves all of `other` before `at`, or at the end when `at` is NULL. Inserting
+// before the head makes `other` the front of the list.
+void list_splice(struct list *list, struct list_node *at, struct list *other);
+// Moves the nodes from index `pos` on to `tail`, whatever it held is dropped
+void list_split_at(struct list *list, size_t pos, struct list *tail);
+
 void list_insert_sorted(struct list *list,
         struct list_node *n, list_cmp_f cmp, void *cookie);
 
@@ -77,8 +90,47 @@ void list_sort(struct list *list, list_cmp_f cmp, void *cookie);
 void list_merge_sorted(struct list *lhs,
         struct list *rhs, list_cmp_f cmp, void *cookie);
 
+// Merges the `k` sorted `lists` at the end of `res` with a tournament tree,
+// ties go to the list that comes first. The lists are left empty. Only fails
+// when the O(k) workspace cannot be allocated.
+bool list_kway_merge(struct list *res,
+        struct list *lists, size_t k, list_cmp_f cmp, void *cookie);
+
 void list_map(struct list *list, list_map_f map, void *cookie);
 void list_filter(struct list *res,
         struct list *list, list_filter_f filter, void *cookie);
 
+void counted_list_init(struct counted_list *list);
+void counted_list_clear(struct counted_list *list,
+        void (*dtor)(struct list_node *n, void *cookie), void *cookie);
+
+void counted_list_push_back(struct counted_list *list, struct list_node *n);
+void counted_list_push_front(struct counted_list *list, struct list_node *n);
+
+struct list_node *counted_list_pop_front(struct counted_list *list);
+struct list_node *counted_list_pop_back(struct counted_list *list);
+// `n` must be in `list`
+struct list_node *counted_list_detach(struct counted_list *list,
+        struct list_node *n);
+
+bool counted_list_empty(const struct counted_list *list);
+size_t counted_list_length(const struct counted_list *list);
+
+void counted_list_concat(struct counted_list *begin,
+        struct counted_list *end);
+void counted_list_splice(struct counted_list *list,
+        struct list_node *at, struct counted_list *other);
+// Walks from the closest end
+void counted_list_split_at(struct counted_list *list,
+        size_t pos, struct counted_list *tail);
+
+void counted_list_insert_sorted(struct counted_list *list,
+        struct list_node *n, list_cmp_f cmp, void *cookie);
+void counted_list_sort(struct counted_list *list,
+        list_cmp_f cmp, void *cookie);
+void counted_list_merge_sorted(struct counted_list *lhs,
+        struct counted_list *rhs, list_cmp_f cmp, void *cookie);
+void counted_list_filter(struct counted_list *res,
+        struct counted_list *list, list_filter_f filter, void *cookie);
+
 #endif /* !TUPPERWARE_LIST_H */
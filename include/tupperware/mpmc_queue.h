@@ -0,0 +1,51 @@
+#ifndef TUPPERWARE_MPMC_QUEUE_H
+#define TUPPERWARE_MPMC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MPMC_QUEUE_CACHE_LINE 64
+
+// Bounded array queue safe for any number of producers and consumers. Each
+// cell carries a sequence number telling which lap of the ring it is ready for.
+struct mpmc_queue {
+    void *cells;
+    size_t size;
+    size_t stride;
+    size_t mask;
+    char pad_shared[MPMC_QUEUE_CACHE_LINE];
+    size_t enqueue_pos;
+    char pad_enqueue[MPMC_QUEUE_CACHE_LINE];
+    size_t dequeue_pos;
+    char pad_dequeue[MPMC_QUEUE_CACHE_LINE];
+    // Bumped to wake up threads blocked on an empty or full queue
+    uint32_t not_empty;
+    uint32_t empty_waiters;
+    uint32_t not_full;
+    uint32_t full_waiters;
+    char pad_wait[MPMC_QUEUE_CACHE_LINE];
+};
+
+bool mpmc_queue_init(struct mpmc_queue *q, size_t size, size_t cap);
+void mpmc_queue_clear(struct mpmc_queue *q,
+        void (*dtor)(void *v, void *cookie), void *cookie);
+
+size_t mpmc_queue_length(const struct mpmc_queue *q);
+size_t mpmc_queue_capacity(const struct mpmc_queue *q);
+size_t mpmc_queue_elem_size(const struct mpmc_queue *q);
+bool mpmc_queue_empty(const struct mpmc_queue *q);
+
+bool mpmc_queue_try_push(struct mpmc_queue *q, void *elem);
+bool mpmc_queue_try_pop(struct mpmc_queue *q, void *output);
+
+size_t mpmc_queue_try_push_n(struct mpmc_queue *q, void *elems, size_t n);
+size_t mpmc_queue_try_pop_n(struct mpmc_queue *q, void *output, size_t n);
+
+bool mpmc_queue_push(struct mpmc_queue *q, void *elem);
+bool mpmc_queue_pop(struct mpmc_queue *q, void *output);
+
+bool mpmc_queue_push_n(struct mpmc_queue *q, void *elems, size_t n);
+size_t mpmc_queue_pop_n(struct mpmc_queue *q, void *output, size_t n);
+
+#endif /* !TUPPERWARE_MPMC_QUEUE_H */
@@ -0,0 +1,29 @@
+#ifndef TUPPERWARE_MPSC_QUEUE_H
+#define TUPPERWARE_MPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tupperware/list.h"
+
+#define MPSC_QUEUE_CACHE_LINE 64
+
+// Intrusive unbounded queue, any thread may push but only one may pop. Queued
+// nodes are chained through their `next` field, `prev` is only restored when
+// popping them.
+struct mpsc_queue {
+    struct list_node *head;
+    char pad_producer[MPSC_QUEUE_CACHE_LINE];
+    struct list_node *tail;
+    struct list_node stub;
+};
+
+void mpsc_queue_init(struct mpsc_queue *q);
+
+bool mpsc_queue_empty(const struct mpsc_queue *q);
+
+void mpsc_queue_push(struct mpsc_queue *q, struct list_node *n);
+struct list_node *mpsc_queue_pop(struct mpsc_queue *q);
+void mpsc_queue_drain(struct mpsc_queue *q, struct list *res);
+
+#endif /* !TUPPERWARE_MPSC_QUEUE_H */
@@ -0,0 +1,63 @@
+#ifndef TUPPERWARE_PACKED_U32_H
+#define TUPPERWARE_PACKED_U32_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tupperware/vector.h"
+
+#define PACKED_U32_BLOCK 128
+
+// Index entry, blocks can be skipped over without decoding them
+struct packed_u32_block {
+    uint32_t first;
+    uint32_t width;
+    size_t offset;
+};
+
+// Read only sorted sequence of `uint32_t`, stored as the differences between
+// consecutive elements, bit packed in blocks of `PACKED_U32_BLOCK`. Blocks are
+// decoded with SSE2 when available.
+struct packed_u32 {
+    uint32_t *words;
+    struct packed_u32_block *blocks;
+    size_t nblocks;
+    size_t nmemb;
+};
+
+// Forward iterator, holding the current block decoded
+struct packed_u32_iter {
+    const struct packed_u32 *p;
+    size_t block;
+    // Index of the next element in the sequence
+    size_t pos;
+    uint32_t values[PACKED_U32_BLOCK];
+};
+
+// `v` holds `uint32_t` in non decreasing order
+bool packed_u32_init(struct packed_u32 *p, const struct vector *v);
+void packed_u32_clear(struct packed_u32 *p);
+
+size_t packed_u32_length(const struct packed_u32 *p);
+// Including the index
+size_t packed_u32_bytes(const struct packed_u32 *p);
+
+bool packed_u32_at(const struct packed_u32 *p, size_t i, uint32_t *output);
+// Appends every element to `res`
+bool packed_u32_decode(const struct packed_u32 *p, struct vector *res);
+
+void packed_u32_iter_init(struct packed_u32_iter *it,
+        const struct packed_u32 *p);
+bool packed_u32_next(struct packed_u32_iter *it, uint32_t *output);
+// Moves forward to the first element not less than `target` and returns it,
+// as `packed_u32_next` would. Only the block it is in is decoded.
+bool packed_u32_seek(struct packed_u32_iter *it,
+        uint32_t target, uint32_t *output);
+
+// Same result as `vector_set_intersection`, skipping over blocks that cannot
+// match
+bool packed_u32_intersection(struct vector *res,
+        const struct packed_u32 *lhs, const struct packed_u32 *rhs);
+
+#endif /* !TUPPERWARE_PACKED_U32_H */
@@ -0,0 +1,76 @@
+#ifndef TUPPERWARE_SCHEDULER_H
+#define TUPPERWARE_SCHEDULER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tupperware/list.h"
+
+#define SCHEDULER_CACHE_LINE 64
+// Jobs spawned while a worker's deque is full are run inline
+#define SCHEDULER_DEQUE_SIZE 1024
+
+struct scheduler;
+
+typedef void (*scheduler_job_f)(struct scheduler *s, void *cookie);
+typedef void (*scheduler_range_f)(size_t begin, size_t end, void *cookie);
+
+// Owned by the caller, must stay alive until `scheduler_join` returns
+struct scheduler_job {
+    scheduler_job_f fn;
+    void *cookie;
+    // Non zero once the job has run, also a futex for its joiner
+    uint32_t done;
+    struct list_node list;
+};
+
+// Chase-Lev deque, the owner pushes and pops at `bottom`, thieves take from
+// `top`
+struct scheduler_worker {
+    int64_t top;
+    char pad_top[SCHEDULER_CACHE_LINE];
+    int64_t bottom;
+    char pad_bottom[SCHEDULER_CACHE_LINE];
+    struct scheduler_job *jobs[SCHEDULER_DEQUE_SIZE];
+    struct scheduler *s;
+    pthread_t thread;
+    uint32_t seed;
+};
+
+// Jobs spawned by threads outside of the pool go through the `injected` list
+struct scheduler {
+    struct scheduler_worker *workers;
+    size_t nworkers;
+    pthread_mutex_t lock;
+    struct list injected;
+    size_t ninjected;
+    bool stop;
+    char pad_shared[SCHEDULER_CACHE_LINE];
+    // Bumped to wake up idle workers
+    uint32_t epoch;
+    uint32_t sleepers;
+    char pad_wait[SCHEDULER_CACHE_LINE];
+};
+
+// One worker per CPU if `nthreads` is 0
+bool scheduler_init(struct scheduler *s, size_t nthreads);
+// Every spawned job must have been joined
+void scheduler_clear(struct scheduler *s);
+
+size_t scheduler_threads(const struct scheduler *s);
+
+// Jobs are run inline if `s` is NULL
+void scheduler_spawn(struct scheduler *s,
+        struct scheduler_job *job, scheduler_job_f fn, void *cookie);
+// Runs other jobs until `job` is done
+void scheduler_join(struct scheduler *s, struct scheduler_job *job);
+
+// Calls `fn` on disjoint subranges of at most `grain` elements covering
+// `[begin, end)`, returns once all of them are done. Runs on the calling thread
+// if `s` is NULL.
+void scheduler_parallel_for(struct scheduler *s, size_t begin, size_t end,
+        size_t grain, scheduler_range_f fn, void *cookie);
+
+#endif /* !TUPPERWARE_SCHEDULER_H */
@@ -0,0 +1,101 @@
+#ifndef TUPPERWARE_SLIST_H
+#define TUPPERWARE_SLIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct slist_node {
+    struct slist_node *next;
+};
+
+// NULL-terminated singly-linked list, a stack with O(1) push and pop at the
+// front
+struct slist {
+    struct slist_node *head;
+};
+
+// Same with the last node kept around to append in O(1), a FIFO queue
+struct slist_queue {
+    struct slist_node *head;
+    struct slist_node *tail;
+};
+
+// Lock-free stack, `head` and `tag` are swapped together by a double-width
+// compare and swap. Every change bumps `tag`, so a pop never succeeds on a
+// head that was popped and pushed back since it was read (ABA). Popped nodes
+// may still be read by concurrent pops: they must stay mapped while the stack
+// is in use, as with free lists.
+struct treiber_stack {
+    struct slist_node *head;
+    uintptr_t tag;
+} __attribute__((aligned(2 * sizeof(void *))));
+
+#define CONTAINER_OF(Type, Field, Ptr) \
+      ((Type*)((char*)(Ptr) - offsetof(Type, Field)))
+
+#define SLIST_FOREACH(List, Cur) \
+    for (struct slist_node *Cur = (List).head; (Cur); (Cur) = (Cur)->next)
+
+#define SLIST_FOREACH_CONST(List, Cur) \
+    for (const struct slist_node *Cur = (List).head; \
+        (Cur); \
+        (Cur) = (Cur)->next)
+
+#define SLIST_FOREACH_ENTRY(Type, Field, List, Cur) \
+    for (Type *Cur = (List).head == NULL \
+            ? NULL \
+            : CONTAINER_OF(Type, Field, (List).head); \
+        (Cur); \
+        (Cur) = ((Cur)->Field.next == NULL \
+                ? NULL \
+                : CONTAINER_OF(Type, Field, (Cur)->Field.next)))
+
+#define SLIST_NODE_INIT_VAL \
+    ((struct slist_node){ \
+        .next = NULL, \
+    })
+
+void slist_init(struct slist *list);
+void slist_clear(struct slist *list,
+        void (*dtor)(struct slist_node *n, void *cookie), void *cookie);
+
+void slist_push(struct slist *list, struct slist_node *n);
+struct slist_node *slist_pop(struct slist *list);
+struct slist_node *slist_peek(const struct slist *list);
+
+void slist_insert_next(struct slist_node *at, struct slist_node *n);
+struct slist_node *slist_remove_next(struct slist *list,
+        struct slist_node *at);
+// O(n), finds the node before `n`
+bool slist_remove(struct slist *list, struct slist_node *n);
+
+bool slist_empty(const struct slist *list);
+size_t slist_length(const struct slist *list);
+void slist_reverse(struct slist *list);
+
+void slist_queue_init(struct slist_queue *q);
+void slist_queue_clear(struct slist_queue *q,
+        void (*dtor)(struct slist_node *n, void *cookie), void *cookie);
+
+void slist_queue_push_back(struct slist_queue *q, struct slist_node *n);
+void slist_queue_push_front(struct slist_queue *q, struct slist_node *n);
+struct slist_node *slist_queue_pop_front(struct slist_queue *q);
+
+bool slist_queue_empty(const struct slist_queue *q);
+size_t slist_queue_length(const struct slist_queue *q);
+// Appends all of `end` to `begin`
+void slist_queue_concat(struct slist_queue *begin, struct slist_queue *end);
+
+void treiber_stack_init(struct treiber_stack *s);
+bool treiber_stack_empty(const struct treiber_stack *s);
+
+void treiber_stack_push(struct treiber_stack *s, struct slist_node *n);
+struct slist_node *treiber_stack_pop(struct treiber_stack *s);
+// Pushes the whole of `list` with a single compare and swap, its head ends
+// up on top
+void treiber_stack_push_list(struct treiber_stack *s, struct slist *list);
+// Takes every node at once, the top of the stack first
+void treiber_stack_pop_all(struct treiber_stack *s, struct slist *res);
+
+#endif /* !TUPPERWARE_SLIST_H */
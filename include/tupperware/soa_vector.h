@@ -0,0 +1,59 @@
+#ifndef TUPPERWARE_SOA_VECTOR_H
+#define TUPPERWARE_SOA_VECTOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tupperware/vector.h"
+
+// Where a field lives in the records pushed to and popped from the vector
+struct soa_field {
+    size_t offset;
+    size_t size;
+};
+
+#define SOA_FIELD(Type, Field) \
+    { offsetof(Type, Field), sizeof(((Type *)0)->Field) }
+
+// Each field is stored in its own column, all columns have the same length
+struct soa_vector {
+    struct vector *columns;
+    struct soa_field *fields;
+    size_t nfields;
+};
+
+bool soa_vector_init(struct soa_vector *v,
+        const struct soa_field *fields, size_t nfields);
+void soa_vector_clear(struct soa_vector *v);
+
+bool soa_vector_reserve(struct soa_vector *v, size_t cap);
+
+size_t soa_vector_length(const struct soa_vector *v);
+size_t soa_vector_fields(const struct soa_vector *v);
+bool soa_vector_empty(const struct soa_vector *v);
+
+// Contiguous array of the values of `field`, valid until the next insertion
+void *soa_vector_column(const struct soa_vector *v, size_t field);
+void *soa_vector_at(const struct soa_vector *v, size_t field, size_t i);
+// Gathers the fields of the `i`th record into `record`
+bool soa_vector_get(const struct soa_vector *v, void *record, size_t i);
+
+bool soa_vector_push_back(struct soa_vector *v, const void *record);
+bool soa_vector_insert_at(struct soa_vector *v, const void *record, size_t i);
+
+bool soa_vector_pop_back(struct soa_vector *v, void *record);
+bool soa_vector_pop_at(struct soa_vector *v, void *record, size_t i);
+
+// Stable, `cmp` is called on values of `field`, all columns are permuted the
+// same way
+bool soa_vector_sort_by(struct soa_vector *v,
+        size_t field, vector_cmp_f cmp, void *cookie);
+
+void soa_vector_map(struct soa_vector *v,
+        size_t field, vector_map_f map, void *cookie);
+// Moves the records for which `filter` holds on `field` to `res`, which must
+// be a distinct vector with the same fields, like `vector_filter` does
+bool soa_vector_filter(struct soa_vector *res, struct soa_vector *v,
+        size_t field, vector_filter_f filter, void *cookie);
+
+#endif /* !TUPPERWARE_SOA_VECTOR_H */
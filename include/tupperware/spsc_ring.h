@@ -0,0 +1,42 @@
+#ifndef TUPPERWARE_SPSC_RING_H
+#define TUPPERWARE_SPSC_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SPSC_RING_CACHE_LINE 64
+
+// Bounded lock-free ring, safe to use with exactly one producer thread and one
+// consumer thread. Each side caches the last index it has seen from the other
+// to avoid touching its cache line on every operation.
+struct spsc_ring {
+    void *arr;
+    size_t size;
+    size_t mask;
+    char pad_shared[SPSC_RING_CACHE_LINE];
+    // Written by the producer
+    size_t tail;
+    size_t cached_head;
+    char pad_producer[SPSC_RING_CACHE_LINE];
+    // Written by the consumer
+    size_t head;
+    size_t cached_tail;
+    char pad_consumer[SPSC_RING_CACHE_LINE];
+};
+
+bool spsc_ring_init(struct spsc_ring *r, size_t size, size_t cap);
+void spsc_ring_clear(struct spsc_ring *r,
+        void (*dtor)(void *v, void *cookie), void *cookie);
+
+size_t spsc_ring_length(const struct spsc_ring *r);
+size_t spsc_ring_capacity(const struct spsc_ring *r);
+size_t spsc_ring_elem_size(const struct spsc_ring *r);
+bool spsc_ring_empty(const struct spsc_ring *r);
+
+bool spsc_ring_push(struct spsc_ring *r, void *elem);
+bool spsc_ring_pop(struct spsc_ring *r, void *output);
+
+size_t spsc_ring_push_n(struct spsc_ring *r, void *elems, size_t n);
+size_t spsc_ring_pop_n(struct spsc_ring *r, void *output, size_t n);
+
+#endif /* !TUPPERWARE_SPSC_RING_H */
@@ -0,0 +1,69 @@
+#ifndef TUPPERWARE_UNROLLED_LIST_H
+#define TUPPERWARE_UNROLLED_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tupperware/list.h"
+
+// Default size of a block with its header, a page
+#define UNROLLED_LIST_BLOCK_BYTES 4096
+
+// Elements `head` to `head + nmemb` of `data` are in use. Blocks fill towards
+// the end of the list from the back and towards the front from the front.
+struct unrolled_block {
+    struct list_node node;
+    size_t head;
+    size_t nmemb;
+    unsigned char data[];
+};
+
+// List of blocks of `per_block` elements, scanning it is mostly sequential
+// memory accesses. Pushing and popping at both ends is O(1), inserting and
+// erasing elsewhere moves elements inside one block only, splitting it when
+// full and merging it with its neighbour when both are under half full.
+struct unrolled_list {
+    struct list blocks;
+    // Kept when a block empties so that going back and forth over a block
+    // boundary does not allocate
+    struct unrolled_block *spare;
+    size_t size;
+    size_t per_block;
+    size_t nmemb;
+};
+
+#define UNROLLED_LIST_FOREACH_BLOCK(List, Cur) \
+    LIST_FOREACH_ENTRY (struct unrolled_block, node, (List).blocks, Cur)
+
+// First element in use of `Block`
+#define UNROLLED_BLOCK_BEGIN(List, Block) \
+    ((void *)((Block)->data + (Block)->head * (List).size))
+
+typedef void (*unrolled_list_map_f)(void *v, void *cookie);
+
+bool unrolled_list_init(struct unrolled_list *l, size_t size);
+bool unrolled_list_with_block(struct unrolled_list *l,
+        size_t size, size_t per_block);
+void unrolled_list_clear(struct unrolled_list *l,
+        void (*dtor)(void *v, void *cookie), void *cookie);
+
+size_t unrolled_list_length(const struct unrolled_list *l);
+size_t unrolled_list_elem_size(const struct unrolled_list *l);
+bool unrolled_list_empty(const struct unrolled_list *l);
+
+// Walks the blocks from the closest end
+void *unrolled_list_at(const struct unrolled_list *l, size_t i);
+
+bool unrolled_list_push_back(struct unrolled_list *l, void *elem);
+bool unrolled_list_push_front(struct unrolled_list *l, void *elem);
+
+bool unrolled_list_pop_back(struct unrolled_list *l, void *output);
+bool unrolled_list_pop_front(struct unrolled_list *l, void *output);
+
+bool unrolled_list_insert_at(struct unrolled_list *l, void *elem, size_t i);
+bool unrolled_list_pop_at(struct unrolled_list *l, void *output, size_t i);
+
+void unrolled_list_map(struct unrolled_list *l,
+        unrolled_list_map_f map, void *cookie);
+
+#endif /* !TUPPERWARE_UNROLLED_LIST_H */
@@ -46,11 +46,29 @@ bool vector_heap_sort(struct vector *v, vector_cmp_f cmp, void *cookie);
 bool vector_merge_sort(struct vector *v, vector_cmp_f cmp, void *cookie);
 bool vector_sort(struct vector *v, vector_cmp_f cmp, void *cookie);
 
+// Operations on sorted vectors, duplicates are handled like in a multiset.
+// Results are appended to `res`, which must be a distinct vector.
+bool vector_unique(struct vector *v, vector_cmp_f cmp, void *cookie);
+bool vector_set_union(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie);
+bool vector_set_intersection(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie);
+bool vector_set_difference(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie);
+bool vector_set_symmetric_difference(struct vector *res,
+        const struct vector *lhs, const struct vector *rhs,
+        vector_cmp_f cmp, void *cookie);
+
 typedef void (*vector_map_f)(void *v, void *cookie);
 typedef bool (*vector_filter_f)(void *v, void *cookie);
+// Folds `v` into `acc`
+typedef void (*vector_reduce_f)(void *acc, const void *v, void *cookie);
 
 bool vector_filter(struct vector *res,
         struct vector *v, vector_filter_f filter, void *cookie);
 void vector_map(struct vector *v, vector_map_f map, void *cookie);
+// `output` starts as a copy of the first element, false if there is none
+bool vector_reduce(const struct vector *v,
+        void *output, vector_reduce_f reduce, void *cookie);
 
 #endif /* !TUPPERWARE_VECTOR_H */
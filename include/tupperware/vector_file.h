@@ -0,0 +1,36 @@
+#ifndef TUPPERWARE_VECTOR_FILE_H
+#define TUPPERWARE_VECTOR_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tupperware/vector.h"
+
+enum vector_file_flags {
+    // Check the checksum of the elements, which reads the whole file
+    VECTOR_FILE_VERIFY = 1 << 0,
+    // Copy on write mapping, changes to the elements are not saved
+    VECTOR_FILE_PRIVATE = 1 << 1,
+    // Read the whole file when loading rather than on first access
+    VECTOR_FILE_POPULATE = 1 << 2,
+};
+
+// Elements of a saved vector, mapped in memory. The mapping is read only and
+// shared with other processes loading the same file unless it is private.
+// `v` cannot be grown or cleared, only closing the file releases it.
+struct vector_file {
+    struct vector v;
+    void *map;
+    size_t map_size;
+};
+
+// Elements are saved as is, the file can only be loaded on a machine with the
+// same endianness. The file is replaced atomically.
+bool vector_file_save(const struct vector *v, const char *path);
+
+bool vector_file_load(struct vector_file *f, const char *path, int flags);
+void vector_file_close(struct vector_file *f);
+
+const struct vector *vector_file_vector(const struct vector_file *f);
+
+#endif /* !TUPPERWARE_VECTOR_FILE_H */
@@ -0,0 +1,27 @@
+#ifndef TUPPERWARE_VECTOR_PARALLEL_H
+#define TUPPERWARE_VECTOR_PARALLEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tupperware/scheduler.h"
+#include "tupperware/vector.h"
+
+// Parallel versions of `vector_map`, `vector_filter`, `vector_reduce` and
+// `vector_merge_sort`, running on the workers of `s`, or on the calling thread
+// if it is NULL. Callbacks are called concurrently, and in any order.
+
+void vector_parallel_map(struct vector *v,
+        vector_map_f map, void *cookie, struct scheduler *s);
+// Called exactly once per element, both vectors end up in the same state as
+// with `vector_filter`, but `v` gets a new array
+bool vector_parallel_filter(struct vector *res, struct vector *v,
+        vector_filter_f filter, void *cookie, struct scheduler *s);
+// Same result as `vector_reduce` as long as `reduce` is associative
+bool vector_parallel_reduce(const struct vector *v, void *output,
+        vector_reduce_f reduce, void *cookie, struct scheduler *s);
+// Stable
+bool vector_parallel_merge_sort(struct vector *v,
+        vector_cmp_f cmp, void *cookie, struct scheduler *s);
+
+#endif /* !TUPPERWARE_VECTOR_PARALLEL_H */
@@ -0,0 +1,53 @@
+#ifndef TUPPERWARE_VECTOR_SIMD_H
+#define TUPPERWARE_VECTOR_SIMD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tupperware/vector.h"
+
+// Kernels for vectors of `uint32_t` or `float`, picking the widest instruction
+// set available at runtime. All return false if the element size does not
+// match the type they operate on.
+
+enum vector_simd_cmp {
+    VECTOR_SIMD_EQ,
+    VECTOR_SIMD_NE,
+    VECTOR_SIMD_LT,
+    VECTOR_SIMD_LE,
+    VECTOR_SIMD_GT,
+    VECTOR_SIMD_GE,
+};
+
+const char *vector_simd_isa(void);
+
+// Same semantics as `vector_filter`, keeping elements that compare to `val`
+bool vector_simd_filter_u32(struct vector *res,
+        struct vector *v, enum vector_simd_cmp cmp, uint32_t val);
+bool vector_simd_filter_f32(struct vector *res,
+        struct vector *v, enum vector_simd_cmp cmp, float val);
+
+// Replace each element `x` by `x * mul + add`
+bool vector_simd_affine_u32(struct vector *v, uint32_t mul, uint32_t add);
+bool vector_simd_affine_f32(struct vector *v, float mul, float add);
+
+// The order of float additions depends on the instruction set
+bool vector_simd_sum_u32(const struct vector *v, uint64_t *output);
+bool vector_simd_sum_f32(const struct vector *v, double *output);
+
+// Return false on empty vectors, results are unspecified in presence of NaN
+bool vector_simd_min_u32(const struct vector *v, uint32_t *output);
+bool vector_simd_max_u32(const struct vector *v, uint32_t *output);
+bool vector_simd_min_f32(const struct vector *v, float *output);
+bool vector_simd_max_f32(const struct vector *v, float *output);
+
+// Return false if no element is equal to `val`
+bool vector_simd_find_u32(const struct vector *v, uint32_t val, size_t *index);
+bool vector_simd_find_f32(const struct vector *v, float val, size_t *index);
+
+// Same as `vector_set_intersection`, for strictly increasing vectors
+bool vector_simd_set_intersection_u32(struct vector *res,
+        const struct vector *lhs, const struct vector *rhs);
+
+#endif /* !TUPPERWARE_VECTOR_SIMD_H */
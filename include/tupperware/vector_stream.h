@@ -0,0 +1,76 @@
+#ifndef TUPPERWARE_VECTOR_STREAM_H
+#define TUPPERWARE_VECTOR_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "tupperware/vector.h"
+
+// Elements are streamed in chunks of at most this many bytes, which bounds
+// the memory used by writers and readers
+#define VECTOR_STREAM_CHUNK_BYTES (256 * 1024)
+
+enum vector_stream_codec {
+    VECTOR_STREAM_RAW,
+    // Byte oriented LZ77, for elements with repeated contents
+    VECTOR_STREAM_LZ,
+    // Differences between consecutive elements, bit packed in blocks of 128.
+    // Elements must be 4 or 8 bytes unsigned integers, sorted ones compress
+    // best.
+    VECTOR_STREAM_DELTA,
+};
+
+// Chunks that do not compress are stored raw. Each chunk carries a checksum,
+// and the stream ends with the total number of elements so that truncated
+// streams are detected.
+struct vector_stream_writer {
+    FILE *file;
+    size_t size;
+    enum vector_stream_codec codec;
+    size_t chunk;
+    // Elements waiting for a full chunk
+    char *pending;
+    size_t npending;
+    char *encoded;
+    uint64_t nmemb;
+    // Set once writing fails, the stream cannot be finished anymore
+    bool failed;
+};
+
+struct vector_stream_reader {
+    FILE *file;
+    size_t size;
+    size_t chunk;
+    char *encoded;
+    uint64_t nmemb;
+    bool end;
+};
+
+// Streams to `file`, which is left open
+bool vector_stream_writer_init(struct vector_stream_writer *w,
+        FILE *file, size_t size, enum vector_stream_codec codec);
+bool vector_stream_write(struct vector_stream_writer *w,
+        const void *elems, size_t nmemb);
+bool vector_stream_write_vector(struct vector_stream_writer *w,
+        const struct vector *v);
+// Writes the last chunk and the end of the stream, `w` is cleared either way
+bool vector_stream_writer_finish(struct vector_stream_writer *w);
+
+bool vector_stream_reader_init(struct vector_stream_reader *r, FILE *file);
+void vector_stream_reader_clear(struct vector_stream_reader *r);
+
+size_t vector_stream_elem_size(const struct vector_stream_reader *r);
+// Whether the end of the stream has been read and checked
+bool vector_stream_reader_end(const struct vector_stream_reader *r);
+
+// Appends the elements of the next chunk to `v`, false at the end of the
+// stream or if it is invalid, which `vector_stream_reader_end` tells apart
+bool vector_stream_read_chunk(struct vector_stream_reader *r,
+        struct vector *v);
+// Appends every remaining element to `v`
+bool vector_stream_read_vector(struct vector_stream_reader *r,
+        struct vector *v);
+
+#endif /* !TUPPERWARE_VECTOR_STREAM_H */
@@ -213,12 +213,12 @@ static int avl_remove_min(struct avl_node **r, struct avl_node **target) {
 static int avl_remove_max(struct avl_node **r, struct avl_node **target) {
     if ((*r)->right == NULL) {
         *target = *r;
-        *r = (*target)->right;
+        *r = (*target)->left;
         return 1;
     }
     if (avl_remove_max(&((*r)->right), target) == 0)
         return 0;
-    (*r)->balance -= 1;
+    (*r)->balance += 1;
     int bal = rebalance(r);
     return 1 - bal * bal;
 }
@@ -0,0 +1,93 @@
+#include "tupperware/avl_parallel.h"
+
+// Subtrees handed out per worker, to balance trees that are not full
+#define SPLITS_PER_WORKER 8
+
+struct task {
+    avl_map_f fn;
+    void *cookie;
+    // Calls `fn` on a node after its descendants rather than before
+    bool post;
+};
+
+struct walk {
+    const struct task *t;
+    struct avl_node *n;
+    // Levels left to split between jobs
+    unsigned depth;
+};
+
+static void walk_serial(const struct task *t, struct avl_node *n) {
+    if (!n)
+        return;
+
+    // Read before `fn`, which may destroy the node
+    struct avl_node *left = n->left;
+    struct avl_node *right = n->right;
+
+    if (!t->post)
+        t->fn(n, t->cookie);
+    walk_serial(t, left);
+    walk_serial(t, right);
+    if (t->post) {
+        n->left = NULL;
+        n->right = NULL;
+        t->fn(n, t->cookie);
+    }
+}
+
+static void walk(struct scheduler *s, void *cookie) {
+    struct walk *w = cookie;
+    struct avl_node *n = w->n;
+    if (!n || !w->depth) {
+        walk_serial(w->t, n);
+        return;
+    }
+
+    struct walk left = { w->t, n->left, w->depth - 1 };
+    struct walk right = { w->t, n->right, w->depth - 1 };
+
+    if (!w->t->post)
+        w->t->fn(n, w->t->cookie);
+
+    struct scheduler_job job;
+    scheduler_spawn(s, &job, walk, &left);
+    walk(s, &right);
+    scheduler_join(s, &job);
+
+    if (w->t->post) {
+        n->left = NULL;
+        n->right = NULL;
+        w->t->fn(n, w->t->cookie);
+    }
+}
+
+static void run(struct avl *tree, const struct task *t, struct scheduler *s) {
+    // Enough levels for every worker to get several subtrees
+    unsigned depth = 0;
+    size_t splits = scheduler_threads(s) * SPLITS_PER_WORKER;
+    while (s && ((size_t)1 << depth) < splits)
+        ++depth;
+
+    struct walk w = { t, tree->root, depth };
+    walk(s, &w);
+}
+
+void avl_parallel_map(struct avl *tree,
+        avl_map_f map, void *cookie, struct scheduler *s) {
+    if (!tree || !map)
+        return;
+
+    struct task t = { map, cookie, false };
+    run(tree, &t, s);
+}
+
+void avl_parallel_clear(struct avl *tree,
+        void (*dtor)(struct avl_node *n, void *cookie), void *cookie,
+        struct scheduler *s) {
+    if (!tree || !dtor)
+        return;
+
+    struct task t = { dtor, cookie, true };
+    run(tree, &t, s);
+}
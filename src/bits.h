@@ -0,0 +1,42 @@
+#ifndef TUPPERWARE_BITS_H
+#define TUPPERWARE_BITS_H
+
+#include <stdint.h>
+
+// Without `-mpopcnt` the builtin is a library call, slower than this
+static inline unsigned bits_popcount(uint64_t w) {
+    w -= (w >> 1) & UINT64_C(0x5555555555555555);
+    w = (w & UINT64_C(0x3333333333333333))
+        + ((w >> 2) & UINT64_C(0x3333333333333333));
+    w = (w + (w >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+    return (w * UINT64_C(0x0101010101010101)) >> 56;
+}
+
+#define BITS_ONES_STEP_8 UINT64_C(0x0101010101010101)
+#define BITS_MSBS_STEP_8 UINT64_C(0x8080808080808080)
+
+// Position of the set bit of rank `k` in `w`, which has more than `k` set.
+// Finds the byte with the byte counts added up in one multiply, then the bit
+// within the byte.
+static inline unsigned bits_select(uint64_t w, unsigned k) {
+    uint64_t s = w - ((w >> 1) & UINT64_C(0x5555555555555555));
+    s = (s & UINT64_C(0x3333333333333333))
+        + ((s >> 2) & UINT64_C(0x3333333333333333));
+    s = (s + (s >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+    // Byte `i` counts the set bits of bytes up to `i`
+    uint64_t sums = s * BITS_ONES_STEP_8;
+
+    // Bytes whose sum is at most `k` come before the one holding the bit
+    uint64_t le = ((k * BITS_ONES_STEP_8 | BITS_MSBS_STEP_8) - sums)
+        & BITS_MSBS_STEP_8;
+    unsigned byte = ((le >> 7) * BITS_ONES_STEP_8 >> 56) * 8;
+
+    k -= (sums << 8 >> byte) & 0xff;
+    unsigned x = (w >> byte) & 0xff;
+    while (k--)
+        x &= x - 1;
+
+    return byte + __builtin_ctz(x);
+}
+
+#endif /* !TUPPERWARE_BITS_H */
@@ -0,0 +1,520 @@
+#include "tupperware/bitvec.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bits.h"
+#include "cpu.h"
+
+#ifdef TUPPERWARE_X86
+#include <immintrin.h>
+#endif
+
+// Rank index granularity, in words
+#define BLOCK_WORDS 8
+#define SUPER_WORDS 64
+// Select samples, in set bits
+#define SAMPLE (SUPER_WORDS * 64)
+
+enum op {
+    OP_AND,
+    OP_OR,
+    OP_XOR,
+    OP_ANDNOT,
+};
+
+struct kernels {
+    // `dst` can be `lhs` or `rhs`
+    void (*binary)(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs,
+            size_t n, enum op op);
+    size_t (*popcount)(const uint64_t *words, size_t n);
+};
+
+static void binary_scalar(uint64_t *dst, const uint64_t *lhs,
+        const uint64_t *rhs, size_t n, enum op op) {
+    switch (op) {
+    case OP_AND:
+        for (size_t i = 0; i < n; ++i)
+            dst[i] = lhs[i] & rhs[i];
+        break;
+    case OP_OR:
+        for (size_t i = 0; i < n; ++i)
+            dst[i] = lhs[i] | rhs[i];
+        break;
+    case OP_XOR:
+        for (size_t i = 0; i < n; ++i)
+            dst[i] = lhs[i] ^ rhs[i];
+        break;
+    case OP_ANDNOT:
+        for (size_t i = 0; i < n; ++i)
+            dst[i] = lhs[i] & ~rhs[i];
+        break;
+    }
+}
+
+static size_t popcount_scalar(const uint64_t *words, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i)
+        count += bits_popcount(words[i]);
+    return count;
+}
+
+static const struct kernels scalar_kernels = {
+    .binary = binary_scalar,
+    .popcount = popcount_scalar,
+};
+
+#ifdef TUPPERWARE_X86
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+#define AVX512 __attribute__((target("avx512f")))
+
+SSE2 static inline __m128i apply_sse2(__m128i l, __m128i r, enum op op) {
+    switch (op) {
+    case OP_AND: return _mm_and_si128(l, r);
+    case OP_OR: return _mm_or_si128(l, r);
+    case OP_XOR: return _mm_xor_si128(l, r);
+    case OP_ANDNOT: return _mm_andnot_si128(r, l);
+    }
+    return l;
+}
+
+SSE2 static void binary_sse2(uint64_t *dst, const uint64_t *lhs,
+        const uint64_t *rhs, size_t n, enum op op) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i l = _mm_loadu_si128((const __m128i *)(lhs + i));
+        __m128i r = _mm_loadu_si128((const __m128i *)(rhs + i));
+        _mm_storeu_si128((__m128i *)(dst + i), apply_sse2(l, r, op));
+    }
+    binary_scalar(dst + i, lhs + i, rhs + i, n - i, op);
+}
+
+static const struct kernels sse2_kernels = {
+    .binary = binary_sse2,
+    .popcount = popcount_scalar,
+};
+
+AVX2 static inline __m256i apply_avx2(__m256i l, __m256i r, enum op op) {
+    switch (op) {
+    case OP_AND: return _mm256_and_si256(l, r);
+    case OP_OR: return _mm256_or_si256(l, r);
+    case OP_XOR: return _mm256_xor_si256(l, r);
+    case OP_ANDNOT: return _mm256_andnot_si256(r, l);
+    }
+    return l;
+}
+
+AVX2 static void binary_avx2(uint64_t *dst, const uint64_t *lhs,
+        const uint64_t *rhs, size_t n, enum op op) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i l = _mm256_loadu_si256((const __m256i *)(lhs + i));
+        __m256i r = _mm256_loadu_si256((const __m256i *)(rhs + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), apply_avx2(l, r, op));
+    }
+    binary_scalar(dst + i, lhs + i, rhs + i, n - i, op);
+}
+
+// Counts of each nibble looked up with a shuffle, added up as bytes for up to
+// 31 vectors before they could overflow, then summed with `sad`
+AVX2 static size_t popcount_avx2(const uint64_t *words, size_t n) {
+    const __m256i lut = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+
+    while (i + 4 <= n) {
+        __m256i bytes = _mm256_setzero_si256();
+        for (size_t j = 0; j < 31 && i + 4 <= n; ++j, i += 4) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(words + i));
+            __m256i lo = _mm256_and_si256(x, nibble);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+            bytes = _mm256_add_epi8(bytes, _mm256_shuffle_epi8(lut, lo));
+            bytes = _mm256_add_epi8(bytes, _mm256_shuffle_epi8(lut, hi));
+        }
+        total = _mm256_add_epi64(total,
+                _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+        + popcount_scalar(words + i, n - i);
+}
+
+static const struct kernels avx2_kernels = {
+    .binary = binary_avx2,
+    .popcount = popcount_avx2,
+};
+
+AVX512 static inline __m512i apply_avx512(__m512i l, __m512i r, enum op op) {
+    switch (op) {
+    case OP_AND: return _mm512_and_si512(l, r);
+    case OP_OR: return _mm512_or_si512(l, r);
+    case OP_XOR: return _mm512_xor_si512(l, r);
+    case OP_ANDNOT: return _mm512_andnot_si512(r, l);
+    }
+    return l;
+}
+
+AVX512 static void binary_avx512(uint64_t *dst, const uint64_t *lhs,
+        const uint64_t *rhs, size_t n, enum op op) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i l = _mm512_loadu_si512(lhs + i);
+        __m512i r = _mm512_loadu_si512(rhs + i);
+        _mm512_storeu_si512(dst + i, apply_avx512(l, r, op));
+    }
+    binary_scalar(dst + i, lhs + i, rhs + i, n - i, op);
+}
+
+// Byte shuffles need AVX-512BW, counting stays on AVX2
+static const struct kernels avx512_kernels = {
+    .binary = binary_avx512,
+    .popcount = popcount_avx2,
+};
+
+#endif /* TUPPERWARE_X86 */
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+static const struct kernels *kernels_table = &scalar_kernels;
+
+static void init_kernels(void) {
+    switch (cpu_level()) {
+#ifdef TUPPERWARE_X86
+    case CPU_AVX512:
+        kernels_table = &avx512_kernels;
+        break;
+    case CPU_AVX2:
+        kernels_table = &avx2_kernels;
+        break;
+    case CPU_SSE2:
+        kernels_table = &sse2_kernels;
+        break;
+#endif
+    default:
+        kernels_table = &scalar_kernels;
+        break;
+    }
+}
+
+static const struct kernels *kernels(void) {
+    pthread_once(&kernels_once, init_kernels);
+    return kernels_table;
+}
+
+static size_t nwords(size_t nbits) {
+    return (nbits + 63) / 64;
+}
+
+static void drop_index(struct bitvec *b) {
+    if (!b->supers)
+        return;
+
+    free(b->supers);
+    free(b->blocks);
+    free(b->samples);
+    b->supers = NULL;
+    b->blocks = NULL;
+    b->samples = NULL;
+    b->ones = 0;
+}
+
+// Unsets the bits past the length in the last word
+static void trim(struct bitvec *b) {
+    if (b->nbits % 64)
+        b->words[b->nbits / 64] &= (UINT64_C(1) << b->nbits % 64) - 1;
+}
+
+bool bitvec_init(struct bitvec *b) {
+    if (!b)
+        return false;
+
+    memset(b, 0, sizeof(*b));
+    return true;
+}
+
+bool bitvec_with_cap(struct bitvec *b, size_t cap) {
+    if (!bitvec_init(b))
+        return false;
+    return bitvec_reserve(b, cap);
+}
+
+void bitvec_clear(struct bitvec *b) {
+    if (!b)
+        return;
+
+    drop_index(b);
+    free(b->words);
+    memset(b, 0, sizeof(*b));
+}
+
+bool bitvec_reserve(struct bitvec *b, size_t cap) {
+    if (!b)
+        return false;
+    if (b->cap >= cap)
+        return true;
+
+    uint64_t *tmp = reallocarray(b->words, nwords(cap), sizeof(*b->words));
+    if (!tmp)
+        return false;
+
+    b->words = tmp;
+    b->cap = nwords(cap) * 64;
+
+    return true;
+}
+
+bool bitvec_resize(struct bitvec *b, size_t nbits) {
+    if (!b || !bitvec_reserve(b, nbits))
+        return false;
+
+    drop_index(b);
+    size_t from = nwords(b->nbits);
+    size_t to = nwords(nbits);
+    if (to > from)
+        memset(b->words + from, 0, (to - from) * sizeof(*b->words));
+    b->nbits = nbits;
+    trim(b);
+
+    return true;
+}
+
+size_t bitvec_length(const struct bitvec *b) {
+    if (!b)
+        return 0;
+    return b->nbits;
+}
+
+size_t bitvec_capacity(const struct bitvec *b) {
+    if (!b)
+        return 0;
+    return b->cap;
+}
+
+bool bitvec_empty(const struct bitvec *b) {
+    return bitvec_length(b) == 0;
+}
+
+bool bitvec_push_back(struct bitvec *b, bool bit) {
+    if (!b)
+        return false;
+
+    if (b->nbits == b->cap)
+        if (!bitvec_reserve(b, b->cap ? b->cap * 2 : 64))
+            return false;
+
+    drop_index(b);
+    if (b->nbits % 64 == 0)
+        b->words[b->nbits / 64] = 0;
+    b->words[b->nbits / 64] |= (uint64_t)bit << b->nbits % 64;
+    ++b->nbits;
+
+    return true;
+}
+
+bool bitvec_set(struct bitvec *b, size_t i) {
+    if (!b || i >= b->nbits)
+        return false;
+
+    drop_index(b);
+    b->words[i / 64] |= UINT64_C(1) << i % 64;
+    return true;
+}
+
+bool bitvec_reset(struct bitvec *b, size_t i) {
+    if (!b || i >= b->nbits)
+        return false;
+
+    drop_index(b);
+    b->words[i / 64] &= ~(UINT64_C(1) << i % 64);
+    return true;
+}
+
+bool bitvec_flip(struct bitvec *b, size_t i) {
+    if (!b || i >= b->nbits)
+        return false;
+
+    drop_index(b);
+    b->words[i / 64] ^= UINT64_C(1) << i % 64;
+    return true;
+}
+
+bool bitvec_test(const struct bitvec *b, size_t i) {
+    if (!b || i >= b->nbits)
+        return false;
+    return b->words[i / 64] >> i % 64 & 1;
+}
+
+bool bitvec_fill(struct bitvec *b, bool bit) {
+    if (!b)
+        return false;
+
+    drop_index(b);
+    if (b->nbits) {
+        memset(b->words, bit ? 0xff : 0, nwords(b->nbits) * sizeof(*b->words));
+        trim(b);
+    }
+
+    return true;
+}
+
+bool bitvec_next_set(const struct bitvec *b, size_t i, size_t *index) {
+    if (!b || i >= b->nbits)
+        return false;
+
+    size_t w = i / 64;
+    size_t n = nwords(b->nbits);
+    uint64_t word = b->words[w] & (UINT64_MAX << i % 64);
+    while (!word) {
+        if (++w == n)
+            return false;
+        word = b->words[w];
+    }
+
+    if (index)
+        *index = w * 64 + __builtin_ctzll(word);
+    return true;
+}
+
+static bool binary(struct bitvec *res, const struct bitvec *lhs,
+        const struct bitvec *rhs, enum op op) {
+    if (!res || !lhs || !rhs || lhs->nbits != rhs->nbits)
+        return false;
+    if (!bitvec_resize(res, lhs->nbits))
+        return false;
+
+    kernels()->binary(res->words, lhs->words, rhs->words,
+            nwords(lhs->nbits), op);
+    return true;
+}
+
+bool bitvec_and(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs) {
+    return binary(res, lhs, rhs, OP_AND);
+}
+
+bool bitvec_or(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs) {
+    return binary(res, lhs, rhs, OP_OR);
+}
+
+bool bitvec_xor(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs) {
+    return binary(res, lhs, rhs, OP_XOR);
+}
+
+bool bitvec_andnot(struct bitvec *res,
+        const struct bitvec *lhs, const struct bitvec *rhs) {
+    return binary(res, lhs, rhs, OP_ANDNOT);
+}
+
+size_t bitvec_popcount(const struct bitvec *b) {
+    if (!b || !b->nbits)
+        return 0;
+    return kernels()->popcount(b->words, nwords(b->nbits));
+}
+
+bool bitvec_build_index(struct bitvec *b) {
+    if (!b)
+        return false;
+
+    drop_index(b);
+    size_t n = nwords(b->nbits);
+    size_t ones = bitvec_popcount(b);
+    // One more entry for the end, and samples end with the last super block
+    size_t nsupers = n / SUPER_WORDS + 1;
+    size_t nsamples = (ones + SAMPLE - 1) / SAMPLE + 1;
+
+    size_t *supers = malloc(nsupers * sizeof(*supers));
+    uint16_t *blocks = malloc((n / BLOCK_WORDS + 1) * sizeof(*blocks));
+    size_t *samples = malloc(nsamples * sizeof(*samples));
+    if (!supers || !blocks || !samples) {
+        free(supers);
+        free(blocks);
+        free(samples);
+        return false;
+    }
+    b->supers = supers;
+    b->blocks = blocks;
+    b->samples = samples;
+
+    size_t count = 0;
+    size_t sample = 0;
+    for (size_t w = 0; w <= n; ++w) {
+        if (w % SUPER_WORDS == 0)
+            b->supers[w / SUPER_WORDS] = count;
+        if (w % BLOCK_WORDS == 0)
+            b->blocks[w / BLOCK_WORDS] = count - b->supers[w / SUPER_WORDS];
+        if (w == n)
+            break;
+
+        count += bits_popcount(b->words[w]);
+        while (sample < nsamples && sample * SAMPLE < count)
+            b->samples[sample++] = w / SUPER_WORDS;
+    }
+    while (sample < nsamples)
+        b->samples[sample++] = nsupers - 1;
+    b->ones = ones;
+
+    return true;
+}
+
+bool bitvec_rank(const struct bitvec *b, size_t i, size_t *output) {
+    if (!b || !output || !b->supers || i > b->nbits)
+        return false;
+
+    size_t w = i / 64;
+    size_t count = b->supers[w / SUPER_WORDS] + b->blocks[w / BLOCK_WORDS];
+    for (size_t k = w / BLOCK_WORDS * BLOCK_WORDS; k < w; ++k)
+        count += bits_popcount(b->words[k]);
+    if (i % 64)
+        count += bits_popcount(b->words[w] & ((UINT64_C(1) << i % 64) - 1));
+    *output = count;
+
+    return true;
+}
+
+bool bitvec_select(const struct bitvec *b, size_t k, size_t *output) {
+    if (!b || !output || !b->supers || k >= b->ones)
+        return false;
+
+    // Last super block starting at or before the bit, between the samples
+    // around it
+    size_t lo = b->samples[k / SAMPLE];
+    size_t hi = b->samples[k / SAMPLE + 1];
+    while (lo < hi) {
+        size_t mid = hi - (hi - lo) / 2;
+        if (b->supers[mid] <= k)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    k -= b->supers[lo];
+
+    // Then the block within it, and the word within the block
+    size_t block = lo * (SUPER_WORDS / BLOCK_WORDS);
+    size_t end = block + SUPER_WORDS / BLOCK_WORDS;
+    size_t nblocks = nwords(b->nbits) / BLOCK_WORDS + 1;
+    while (block + 1 < end && block + 1 < nblocks
+            && b->blocks[block + 1] <= k)
+        ++block;
+    k -= b->blocks[block];
+
+    size_t w = block * BLOCK_WORDS;
+    for (;;) {
+        unsigned n = bits_popcount(b->words[w]);
+        if (k < n)
+            break;
+        k -= n;
+        ++w;
+    }
+    *output = w * 64 + bits_select(b->words[w], k);
+
+    return true;
+}
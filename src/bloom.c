@@ -0,0 +1,468 @@
+#include "tupperware/bloom.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#ifdef TUPPERWARE_X86
+#include <immintrin.h>
+#endif
+
+#define WORDS BLOOM_BLOCK_WORDS
+#define BLOCK_BITS (WORDS * 32)
+#define BLOCK_BYTES (WORDS * sizeof(uint32_t))
+#define ALIGN 64
+// Keys ahead whose block is prefetched by bulk operations
+#define PREFETCH 8
+#define COUNTER_MAX 15
+
+// Odd multipliers picking the bit of each word from the low half of the hash
+static const uint32_t salts[WORDS] = {
+    0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d,
+    0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31,
+};
+
+struct kernels {
+    void (*add)(uint32_t *block, uint32_t h);
+    bool (*contains)(const uint32_t *block, uint32_t h);
+};
+
+static unsigned bit_of(uint32_t h, unsigned word) {
+    return (uint32_t)(h * salts[word]) >> 27;
+}
+
+static void add_scalar(uint32_t *block, uint32_t h) {
+    for (unsigned i = 0; i < WORDS; ++i)
+        block[i] |= UINT32_C(1) << bit_of(h, i);
+}
+
+static bool contains_scalar(const uint32_t *block, uint32_t h) {
+    for (unsigned i = 0; i < WORDS; ++i)
+        if (!(block[i] & UINT32_C(1) << bit_of(h, i)))
+            return false;
+    return true;
+}
+
+static const struct kernels scalar_kernels = {
+    .add = add_scalar,
+    .contains = contains_scalar,
+};
+
+#ifdef TUPPERWARE_X86
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i masks_avx2(uint32_t h) {
+    const __m256i salt = _mm256_loadu_si256((const __m256i *)salts);
+    __m256i bits = _mm256_mullo_epi32(_mm256_set1_epi32(h), salt);
+    bits = _mm256_srli_epi32(bits, 27);
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+}
+
+AVX2 static void add_avx2(uint32_t *block, uint32_t h) {
+    __m256i b = _mm256_load_si256((const __m256i *)block);
+    _mm256_store_si256((__m256i *)block, _mm256_or_si256(b, masks_avx2(h)));
+}
+
+AVX2 static bool contains_avx2(const uint32_t *block, uint32_t h) {
+    __m256i b = _mm256_load_si256((const __m256i *)block);
+    return _mm256_testc_si256(b, masks_avx2(h));
+}
+
+static const struct kernels avx2_kernels = {
+    .add = add_avx2,
+    .contains = contains_avx2,
+};
+
+#endif /* TUPPERWARE_X86 */
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+static const struct kernels *kernels_table = &scalar_kernels;
+
+// SSE2 has neither 32-bit multiplies nor per lane shifts, and a block fits in
+// an AVX2 register
+static void init_kernels(void) {
+    switch (cpu_level()) {
+#ifdef TUPPERWARE_X86
+    case CPU_AVX512:
+    case CPU_AVX2:
+        kernels_table = &avx2_kernels;
+        break;
+#endif
+    default:
+        kernels_table = &scalar_kernels;
+        break;
+    }
+}
+
+static const struct kernels *kernels(void) {
+    pthread_once(&kernels_once, init_kernels);
+    return kernels_table;
+}
+
+// User hashes can be weak in some bits, both halves are used
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 32;
+    h *= UINT64_C(0x9e3779b97f4a7c15);
+    return h ^ h >> 29;
+}
+
+// Multiplies instead of dividing, `nblocks` fits in 32 bits
+static size_t block_of(const struct bloom *f, uint64_t h) {
+    return (size_t)(((h >> 32) * (uint64_t)f->nblocks) >> 32);
+}
+
+static uint32_t *block_at(const struct bloom *f, size_t i) {
+    return f->blocks + i * WORDS;
+}
+
+// e^-x for x >= 0, squaring the series of a small enough x
+static double exp_neg(double x) {
+    unsigned halvings = 0;
+    while (x > 1e-3) {
+        x /= 2;
+        ++halvings;
+    }
+
+    double r = 1 - x + x * x / 2 - x * x * x / 6;
+    while (halvings--)
+        r *= r;
+    return r;
+}
+
+// With `lambda` keys per block on average, Poisson distributed, each setting
+// one bit in every word
+static double fpr_at(double lambda) {
+    double term = exp_neg(lambda);
+    double unset = 1;
+    double fpr = 0;
+
+    for (size_t j = 0; j <= lambda || term > 1e-18; ++j) {
+        double p = 1 - unset;
+        p *= p;
+        p *= p;
+        fpr += term * p * p;
+        term *= lambda / (j + 1);
+        unset *= 31.0 / 32;
+    }
+
+    return fpr;
+}
+
+static bool alloc_blocks(struct bloom *f, size_t nblocks) {
+    void *blocks;
+    if (nblocks > UINT32_MAX
+            || posix_memalign(&blocks, ALIGN, nblocks * BLOCK_BYTES))
+        return false;
+
+    memset(blocks, 0, nblocks * BLOCK_BYTES);
+    f->blocks = blocks;
+    f->nblocks = nblocks;
+
+    return true;
+}
+
+bool bloom_init(struct bloom *f, size_t n, double fpr) {
+    if (!f || !(fpr > 0 && fpr < 1))
+        return false;
+
+    // Largest load still under `fpr`
+    double lo = 1e-3;
+    double hi = 500;
+    for (int i = 0; i < 64; ++i) {
+        double mid = (lo + hi) / 2;
+        if (fpr_at(mid) <= fpr)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    double nblocks = (n ? n : 1) / lo;
+    if (nblocks >= UINT32_MAX)
+        return false;
+
+    memset(f, 0, sizeof(*f));
+    return alloc_blocks(f, (size_t)nblocks + 1);
+}
+
+void bloom_clear(struct bloom *f) {
+    if (!f)
+        return;
+
+    free(f->blocks);
+    memset(f, 0, sizeof(*f));
+}
+
+void bloom_reset(struct bloom *f) {
+    if (!f || !f->blocks)
+        return;
+    memset(f->blocks, 0, f->nblocks * BLOCK_BYTES);
+}
+
+size_t bloom_bytes(const struct bloom *f) {
+    if (!f)
+        return 0;
+    return f->nblocks * BLOCK_BYTES;
+}
+
+double bloom_fpr(const struct bloom *f, size_t n) {
+    if (!f || !f->nblocks)
+        return 1;
+    return fpr_at((double)n / f->nblocks);
+}
+
+bool bloom_add(struct bloom *f, uint64_t hash) {
+    if (!f || !f->blocks)
+        return false;
+
+    uint64_t h = mix(hash);
+    kernels()->add(block_at(f, block_of(f, h)), (uint32_t)h);
+
+    return true;
+}
+
+bool bloom_add_n(struct bloom *f, const uint64_t *hashes, size_t n) {
+    if (!f || !f->blocks || (!hashes && n))
+        return false;
+
+    const struct kernels *k = kernels();
+    for (size_t i = 0; i < n; ++i) {
+        if (i + PREFETCH < n) {
+            uint64_t ahead = mix(hashes[i + PREFETCH]);
+            __builtin_prefetch(block_at(f, block_of(f, ahead)), 1);
+        }
+        uint64_t h = mix(hashes[i]);
+        k->add(block_at(f, block_of(f, h)), (uint32_t)h);
+    }
+
+    return true;
+}
+
+bool bloom_add_vector(struct bloom *f, const struct vector *v,
+        bloom_hash_f hash, void *cookie) {
+    if (!f || !f->blocks || !v || !hash)
+        return false;
+
+    uint64_t hashes[64];
+    size_t n = vector_length(v);
+    for (size_t i = 0; i < n; i += 64) {
+        size_t batch = n - i < 64 ? n - i : 64;
+        for (size_t j = 0; j < batch; ++j)
+            hashes[j] = hash(vector_at(v, i + j), cookie);
+        bloom_add_n(f, hashes, batch);
+    }
+
+    return true;
+}
+
+bool bloom_contains(const struct bloom *f, uint64_t hash) {
+    if (!f || !f->blocks)
+        return false;
+
+    uint64_t h = mix(hash);
+    return kernels()->contains(block_at(f, block_of(f, h)), (uint32_t)h);
+}
+
+size_t bloom_contains_n(const struct bloom *f,
+        const uint64_t *hashes, size_t n, bool *found) {
+    if (!f || !f->blocks || !hashes || !found)
+        return 0;
+
+    const struct kernels *k = kernels();
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i + PREFETCH < n) {
+            uint64_t ahead = mix(hashes[i + PREFETCH]);
+            __builtin_prefetch(block_at(f, block_of(f, ahead)));
+        }
+        uint64_t h = mix(hashes[i]);
+        found[i] = k->contains(block_at(f, block_of(f, h)), (uint32_t)h);
+        count += found[i];
+    }
+
+    return count;
+}
+
+static unsigned counter_get(const uint8_t *counters, size_t i) {
+    return counters[i / 2] >> (i % 2 * 4) & 0xf;
+}
+
+static void counter_set(uint8_t *counters, size_t i, unsigned v) {
+    unsigned shift = i % 2 * 4;
+    counters[i / 2] = (counters[i / 2] & ~(0xf << shift)) | v << shift;
+}
+
+bool counting_bloom_init(struct counting_bloom *c, size_t n, double fpr) {
+    if (!c || !bloom_init(&c->filter, n, fpr))
+        return false;
+
+    c->counters = calloc(c->filter.nblocks, BLOCK_BITS / 2);
+    if (!c->counters) {
+        bloom_clear(&c->filter);
+        return false;
+    }
+
+    return true;
+}
+
+void counting_bloom_clear(struct counting_bloom *c) {
+    if (!c)
+        return;
+
+    bloom_clear(&c->filter);
+    free(c->counters);
+    c->counters = NULL;
+}
+
+bool counting_bloom_add(struct counting_bloom *c, uint64_t hash) {
+    if (!c || !c->counters)
+        return false;
+
+    uint64_t h = mix(hash);
+    size_t b = block_of(&c->filter, h);
+    uint32_t *block = block_at(&c->filter, b);
+    for (unsigned i = 0; i < WORDS; ++i) {
+        unsigned bit = bit_of(h, i);
+        size_t at = b * BLOCK_BITS + i * 32 + bit;
+        unsigned v = counter_get(c->counters, at);
+        if (v < COUNTER_MAX)
+            counter_set(c->counters, at, v + 1);
+        block[i] |= UINT32_C(1) << bit;
+    }
+
+    return true;
+}
+
+bool counting_bloom_remove(struct counting_bloom *c, uint64_t hash) {
+    if (!c || !c->counters || !bloom_contains(&c->filter, hash))
+        return false;
+
+    uint64_t h = mix(hash);
+    size_t b = block_of(&c->filter, h);
+    uint32_t *block = block_at(&c->filter, b);
+    for (unsigned i = 0; i < WORDS; ++i) {
+        unsigned bit = bit_of(h, i);
+        size_t at = b * BLOCK_BITS + i * 32 + bit;
+        unsigned v = counter_get(c->counters, at);
+        // Saturated counters lost track, the bit stays set
+        if (v == COUNTER_MAX)
+            continue;
+        counter_set(c->counters, at, v - 1);
+        if (v == 1)
+            block[i] &= ~(UINT32_C(1) << bit);
+    }
+
+    return true;
+}
+
+bool counting_bloom_contains(const struct counting_bloom *c, uint64_t hash) {
+    if (!c)
+        return false;
+    return bloom_contains(&c->filter, hash);
+}
+
+struct rebuild {
+    struct counting_bloom *filter;
+    bloom_avl_hash_f hash;
+    void *cookie;
+};
+
+static void rebuild_add(struct avl_node *n, void *cookie) {
+    struct rebuild *r = cookie;
+    counting_bloom_add(r->filter, r->hash(n, r->cookie));
+}
+
+// Keeps the current filter if a bigger one cannot be allocated
+static void grow(struct bloom_avl *b) {
+    struct counting_bloom filter;
+    if (b->expected > SIZE_MAX / 2
+            || !counting_bloom_init(&filter, b->expected * 2, b->fpr))
+        return;
+
+    struct rebuild r = { &filter, b->hash, b->tree.cookie };
+    avl_infix_map(&b->tree, rebuild_add, &r);
+    counting_bloom_clear(&b->filter);
+    b->filter = filter;
+    b->expected *= 2;
+}
+
+bool bloom_avl_init(struct bloom_avl *b, avl_cmp_f cmp, bloom_avl_hash_f hash,
+        void *cookie, size_t n, double fpr) {
+    if (!b || !hash)
+        return false;
+
+    n = n ? n : 1;
+    if (!counting_bloom_init(&b->filter, n, fpr))
+        return false;
+
+    avl_init(&b->tree, cmp, cookie);
+    b->hash = hash;
+    b->nmemb = 0;
+    b->expected = n;
+    b->fpr = fpr;
+
+    return true;
+}
+
+void bloom_avl_clear(struct bloom_avl *b,
+        void (*dtor)(struct avl_node *n, void *cookie), void *cookie) {
+    if (!b)
+        return;
+
+    if (dtor)
+        avl_clear(&b->tree, dtor, cookie);
+    avl_init(&b->tree, b->tree.cmp, b->tree.cookie);
+    counting_bloom_clear(&b->filter);
+    b->nmemb = 0;
+    b->expected = 0;
+}
+
+bool bloom_avl_insert(struct bloom_avl *b,
+        struct avl_node *v, struct avl_node **inserted) {
+    if (!b || !v || !b->filter.counters)
+        return false;
+
+    if (!avl_insert(&b->tree, v, inserted))
+        return false;
+
+    counting_bloom_add(&b->filter, b->hash(v, b->tree.cookie));
+    if (++b->nmemb > b->expected)
+        grow(b);
+
+    return true;
+}
+
+struct avl_node *bloom_avl_remove(struct bloom_avl *b, struct avl_node *v) {
+    if (!b || !v || !bloom_avl_find(b, v))
+        return NULL;
+
+    struct avl_node *n = avl_remove(&b->tree, v);
+    if (n) {
+        counting_bloom_remove(&b->filter, b->hash(n, b->tree.cookie));
+        --b->nmemb;
+    }
+
+    return n;
+}
+
+bool bloom_avl_remove_at(struct bloom_avl *b, struct avl_node *v) {
+    if (!b || !v || !avl_remove_at(&b->tree, v))
+        return false;
+
+    counting_bloom_remove(&b->filter, b->hash(v, b->tree.cookie));
+    --b->nmemb;
+
+    return true;
+}
+
+struct avl_node *bloom_avl_find(const struct bloom_avl *b,
+        const struct avl_node *v) {
+    if (!b || !v)
+        return NULL;
+
+    if (!counting_bloom_contains(&b->filter, b->hash(v, b->tree.cookie)))
+        return NULL;
+    return avl_find(&b->tree, v);
+}
@@ -0,0 +1,372 @@
+#include "tupperware/cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define S3FIFO_MAX_FREQ 3
+
+#define NODE_OF(Lnode) CONTAINER_OF(struct cache_node, lnode, Lnode)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t index_hash(const struct htable_node *n, void *cookie) {
+    const struct cache *c = cookie;
+    return c->hash(CONTAINER_OF(struct cache_node, hnode, n), c->cookie);
+}
+
+static bool index_eq(const struct htable_node *lhs,
+        const struct htable_node *rhs, void *cookie) {
+    const struct cache *c = cookie;
+    return c->eq(CONTAINER_OF(struct cache_node, hnode, lhs),
+            CONTAINER_OF(struct cache_node, hnode, rhs), c->cookie);
+}
+
+static uint64_t ghost_hash(const void *elem, void *cookie) {
+    (void)cookie;
+    return ((const struct cache_ghost *)elem)->hash;
+}
+
+static bool ghost_eq(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    return ((const struct cache_ghost *)lhs)->hash
+        == ((const struct cache_ghost *)rhs)->hash;
+}
+
+// S3-FIFO gives a tenth of the entries to the small queue, the ghost queue
+// remembers as many as the main one holds
+static size_t small_cap(const struct cache *c) {
+    return c->cap / 10 ? c->cap / 10 : 1;
+}
+
+static size_t ghost_cap(const struct cache *c) {
+    return c->cap > small_cap(c) ? c->cap - small_cap(c) : 1;
+}
+
+static void ghost_add(struct cache *c, uint64_t hash) {
+    size_t cap = ghost_cap(c);
+    if (c->nghosts == cap) {
+        struct cache_ghost old = c->ghosts[c->ghost_head];
+        c->ghost_head = (c->ghost_head + 1) % cap;
+        --c->nghosts;
+
+        struct cache_ghost *found = hashmap_find(&c->ghost_set, &old);
+        if (found && found->seq == old.seq)
+            hashmap_remove(&c->ghost_set, &old, NULL);
+    }
+
+    struct cache_ghost g = { hash, ++c->ghost_seq };
+    c->ghosts[(c->ghost_head + c->nghosts++) % cap] = g;
+
+    // Ghosts only steer insertions, losing one is harmless
+    struct cache_ghost *found;
+    if (!hashmap_insert(&c->ghost_set, &g, (void **)&found) && found)
+        found->seq = g.seq;
+}
+
+static bool ghost_take(struct cache *c, uint64_t hash) {
+    struct cache_ghost g = { hash, 0 };
+    return hashmap_remove(&c->ghost_set, &g, NULL);
+}
+
+static struct list *queue_of(struct cache *c, const struct cache_node *n) {
+    return n->main ? &c->main : &c->small;
+}
+
+static struct cache_node *tail(const struct list *l) {
+    return l->head ? NODE_OF(l->head->prev) : NULL;
+}
+
+static struct cache_node *next(const struct cache_node *n) {
+    return NODE_OF(n->lnode.next);
+}
+
+static void unlink_node(struct list *l, struct cache_node *n) {
+    if (l->head == &n->lnode)
+        list_node_safe_detach(&l->head);
+    else
+        list_node_detach(&n->lnode);
+}
+
+// Takes `n` off its queue, the clock hand moves past it
+static void detach(struct cache *c, struct cache_node *n) {
+    if (c->hand == n)
+        c->hand = n->lnode.next == &n->lnode ? NULL : next(n);
+
+    unlink_node(queue_of(c, n), n);
+    if (n->main)
+        --c->nmain;
+    else
+        --c->nsmall;
+}
+
+static void touch(struct cache *c, struct cache_node *n) {
+    switch (c->policy) {
+    case CACHE_LRU:
+        if (c->small.head != &n->lnode) {
+            list_node_detach(&n->lnode);
+            list_push_front(&c->small, &n->lnode);
+        }
+        break;
+    case CACHE_CLOCK:
+        // Avoids dirtying the line again on every hit
+        if (!n->freq)
+            n->freq = 1;
+        break;
+    case CACHE_S3FIFO:
+        if (n->freq < S3FIFO_MAX_FREQ)
+            ++n->freq;
+        break;
+    }
+}
+
+static void enqueue(struct cache *c, struct cache_node *n) {
+    switch (c->policy) {
+    case CACHE_LRU:
+        list_push_front(&c->small, &n->lnode);
+        ++c->nsmall;
+        break;
+    case CACHE_CLOCK:
+        // Right behind the hand, so it is looked at last
+        if (c->hand) {
+            list_node_insert_prev(&c->hand->lnode, &n->lnode);
+        } else {
+            list_push_front(&c->small, &n->lnode);
+            c->hand = n;
+        }
+        ++c->nsmall;
+        break;
+    case CACHE_S3FIFO:
+        n->main = ghost_take(c, n->hnode.hash);
+        list_push_front(queue_of(c, n), &n->lnode);
+        if (n->main)
+            ++c->nmain;
+        else
+            ++c->nsmall;
+        break;
+    }
+}
+
+// Entries hit while in the small queue move to the main one, others leave
+// and become ghosts. Main entries go around once more per hit.
+static struct cache_node *s3fifo_victim(struct cache *c) {
+    for (;;) {
+        if (c->nsmall > small_cap(c) || !c->nmain) {
+            struct cache_node *n = tail(&c->small);
+            if (!n->freq) {
+                ghost_add(c, n->hnode.hash);
+                return n;
+            }
+            detach(c, n);
+            n->freq = 0;
+            n->main = true;
+            list_push_front(&c->main, &n->lnode);
+            ++c->nmain;
+        } else {
+            struct cache_node *n = tail(&c->main);
+            if (!n->freq)
+                return n;
+            --n->freq;
+            c->main.head = c->main.head->prev;
+        }
+    }
+}
+
+static void evict_one(struct cache *c) {
+    struct cache_node *victim = NULL;
+
+    switch (c->policy) {
+    case CACHE_LRU:
+        victim = tail(&c->small);
+        break;
+    case CACHE_CLOCK:
+        while (c->hand->freq) {
+            c->hand->freq = 0;
+            c->hand = next(c->hand);
+        }
+        victim = c->hand;
+        break;
+    case CACHE_S3FIFO:
+        victim = s3fifo_victim(c);
+        break;
+    }
+
+    detach(c, victim);
+    htable_remove_at(&c->index, &victim->hnode);
+    ++c->stats.evictions;
+    if (c->evict)
+        c->evict(victim, c->cookie);
+}
+
+bool cache_init(struct cache *c, enum cache_policy policy, size_t cap,
+        cache_hash_f hash, cache_eq_f eq, cache_evict_f evict, void *cookie) {
+    if (!c || !cap || !hash || !eq)
+        return false;
+
+    memset(c, 0, sizeof(*c));
+    c->cap = cap;
+    c->policy = policy;
+    if (policy == CACHE_S3FIFO) {
+        c->ghosts = malloc(ghost_cap(c) * sizeof(*c->ghosts));
+        if (!c->ghosts || !hashmap_init(&c->ghost_set,
+                    sizeof(struct cache_ghost), ghost_hash, ghost_eq, NULL)) {
+            free(c->ghosts);
+            return false;
+        }
+    }
+
+    htable_init(&c->index, index_hash, index_eq, c);
+    list_init(&c->small);
+    list_init(&c->main);
+    c->hash = hash;
+    c->eq = eq;
+    c->evict = evict;
+    c->cookie = cookie;
+
+    return true;
+}
+
+static void clear_queue(struct list *l,
+        void (*dtor)(struct cache_node *n, void *cookie), void *cookie) {
+    while (l->head) {
+        struct list_node *n = list_pop_front(l);
+        if (dtor)
+            dtor(NODE_OF(n), cookie);
+    }
+}
+
+void cache_clear(struct cache *c,
+        void (*dtor)(struct cache_node *n, void *cookie), void *cookie) {
+    if (!c)
+        return;
+
+    htable_clear(&c->index, NULL, NULL);
+    clear_queue(&c->small, dtor, cookie);
+    clear_queue(&c->main, dtor, cookie);
+    free(c->ghosts);
+    hashmap_clear(&c->ghost_set, NULL, NULL);
+    memset(c, 0, sizeof(*c));
+}
+
+size_t cache_length(const struct cache *c) {
+    if (!c)
+        return 0;
+    return c->nsmall + c->nmain;
+}
+
+size_t cache_capacity(const struct cache *c) {
+    if (!c)
+        return 0;
+    return c->cap;
+}
+
+bool cache_empty(const struct cache *c) {
+    return cache_length(c) == 0;
+}
+
+struct cache_node *cache_peek(const struct cache *c,
+        const struct cache_node *key) {
+    if (!c || !key)
+        return NULL;
+
+    struct htable_node *n = htable_find(&c->index, &key->hnode);
+    return n ? CONTAINER_OF(struct cache_node, hnode, n) : NULL;
+}
+
+struct cache_node *cache_get(struct cache *c, const struct cache_node *key) {
+    if (!c || !key)
+        return NULL;
+
+    uint64_t start = c->timed ? now_ns() : 0;
+    struct cache_node *n = cache_peek(c, key);
+    if (n) {
+        touch(c, n);
+        ++c->stats.hits;
+    } else {
+        ++c->stats.misses;
+    }
+
+    if (c->timed) {
+        uint64_t elapsed = now_ns() - start;
+        c->stats.get_ns += elapsed;
+        if (elapsed > c->stats.get_max_ns)
+            c->stats.get_max_ns = elapsed;
+    }
+
+    return n;
+}
+
+struct cache_node *cache_put(struct cache *c, struct cache_node *n) {
+    if (!c || !n || !c->cap)
+        return n;
+
+    // Putting an entry already cached only counts as a use of it
+    if (cache_peek(c, n) == n) {
+        touch(c, n);
+        return NULL;
+    }
+
+    struct htable_node *h = htable_insert_or_update(&c->index, &n->hnode);
+    if (h == &n->hnode)
+        return n;
+
+    // Takes the place of the entry it replaces, as if it was hit
+    if (h) {
+        struct cache_node *old = CONTAINER_OF(struct cache_node, hnode, h);
+        n->freq = old->freq;
+        n->main = old->main;
+        list_node_insert_next(&old->lnode, &n->lnode);
+        unlink_node(queue_of(c, old), old);
+        if (c->hand == old)
+            c->hand = n;
+        touch(c, n);
+        return old;
+    }
+
+    // Room is made first so CLOCK sweeps past the new entry last
+    n->freq = 0;
+    n->main = false;
+    while (cache_length(c) >= c->cap)
+        evict_one(c);
+    enqueue(c, n);
+
+    return NULL;
+}
+
+struct cache_node *cache_remove(struct cache *c,
+        const struct cache_node *key) {
+    if (!c || !key)
+        return NULL;
+
+    struct htable_node *h =
+        htable_remove(&c->index, (struct htable_node *)&key->hnode);
+    if (!h)
+        return NULL;
+
+    struct cache_node *n = CONTAINER_OF(struct cache_node, hnode, h);
+    detach(c, n);
+
+    return n;
+}
+
+void cache_set_timing(struct cache *c, bool timed) {
+    if (!c)
+        return;
+    c->timed = timed;
+}
+
+double cache_hit_rate(const struct cache *c) {
+    if (!c || !(c->stats.hits + c->stats.misses))
+        return 0;
+    return (double)c->stats.hits / (c->stats.hits + c->stats.misses);
+}
+
+void cache_reset_stats(struct cache *c) {
+    if (!c)
+        return;
+    memset(&c->stats, 0, sizeof(c->stats));
+}
@@ -0,0 +1,395 @@
+#include "tupperware/chashmap.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRIPES CHASHMAP_STRIPES
+// Removed nodes kept before a writer waits for the readers to free them
+#define RETIRE_BATCH 128
+
+// Followed by the element, 16 bytes keep it aligned like malloc would
+struct node {
+    struct node *next;
+    uint64_t hash;
+};
+
+#define NODE_DATA(Node) ((void *)((Node) + 1))
+
+struct chashmap_table {
+    size_t mask;
+    struct node *buckets[];
+};
+
+static __thread size_t reader_id;
+static size_t readers_seen;
+
+// User hashes can be weak in their low bits, which pick the bucket
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 32;
+    h *= UINT64_C(0x9e3779b97f4a7c15);
+    return h ^ h >> 29;
+}
+
+static uint64_t hash(const struct chashmap *m, const void *elem) {
+    return mix(m->hash(elem, m->cookie));
+}
+
+static struct chashmap_stripe *stripe(struct chashmap *m, uint64_t h) {
+    return &m->stripes[h & (STRIPES - 1)];
+}
+
+// Returns the counter to give back to `read_unlock`
+static size_t *read_lock(struct chashmap *m) {
+    if (!reader_id)
+        reader_id = __atomic_add_fetch(&readers_seen, 1, __ATOMIC_RELAXED);
+
+    struct chashmap_reader *r = &m->readers[reader_id % CHASHMAP_READERS];
+    unsigned epoch = __atomic_load_n(&m->epoch, __ATOMIC_RELAXED);
+    size_t *active = &r->active[epoch & 1];
+    // Full barrier, pairs with the fence in `synchronize`
+    __atomic_fetch_add(active, 1, __ATOMIC_SEQ_CST);
+
+    return active;
+}
+
+static void read_unlock(size_t *active) {
+    __atomic_fetch_sub(active, 1, __ATOMIC_RELEASE);
+}
+
+static void wait_readers(struct chashmap *m, unsigned parity) {
+    unsigned spins = 0;
+    for (size_t i = 0; i < CHASHMAP_READERS; ++i)
+        while (__atomic_load_n(&m->readers[i].active[parity],
+                    __ATOMIC_ACQUIRE))
+            if (++spins % 1024 == 0)
+                sched_yield();
+}
+
+// Once it returns, no reader can see what was unlinked before the call
+static void synchronize(struct chashmap *m) {
+    pthread_mutex_lock(&m->sync_lock);
+
+    // Twice, a reader may have read the epoch before the previous flip and
+    // be counted under the new parity
+    for (int i = 0; i < 2; ++i) {
+        unsigned epoch = __atomic_load_n(&m->epoch, __ATOMIC_RELAXED);
+        __atomic_store_n(&m->epoch, epoch + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        wait_readers(m, epoch & 1);
+    }
+
+    pthread_mutex_unlock(&m->sync_lock);
+}
+
+static struct chashmap_table *new_table(size_t nbuckets) {
+    struct chashmap_table *t = calloc(1,
+            sizeof(*t) + nbuckets * sizeof(*t->buckets));
+    if (t)
+        t->mask = nbuckets - 1;
+    return t;
+}
+
+static void free_table(struct chashmap_table *t,
+        void (*dtor)(void *elem, void *cookie), void *cookie) {
+    if (!t)
+        return;
+
+    for (size_t i = 0; i <= t->mask; ++i) {
+        struct node *cur = t->buckets[i];
+        while (cur) {
+            struct node *next = cur->next;
+            if (dtor)
+                dtor(NODE_DATA(cur), cookie);
+            free(cur);
+            cur = next;
+        }
+    }
+    free(t);
+}
+
+static struct node *new_node(const struct chashmap *m,
+        const void *elem, uint64_t h) {
+    struct node *n = malloc(sizeof(*n) + m->size);
+    if (!n)
+        return NULL;
+
+    n->next = NULL;
+    n->hash = h;
+    memcpy(NODE_DATA(n), elem, m->size);
+
+    return n;
+}
+
+static void free_retired(struct vector *nodes, struct vector *tables) {
+    for (size_t i = 0; i < vector_length(nodes); ++i)
+        free(*(struct node **)vector_at(nodes, i));
+    for (size_t i = 0; i < vector_length(tables); ++i)
+        free_table(*(struct chashmap_table **)vector_at(tables, i),
+                NULL, NULL);
+    vector_clear(nodes, NULL, NULL);
+    vector_clear(tables, NULL, NULL);
+}
+
+// Frees the retired batch if big enough, or if `force`
+static void reclaim(struct chashmap *m, bool force) {
+    pthread_mutex_lock(&m->retire_lock);
+    if (!force && vector_length(&m->retired_nodes) < RETIRE_BATCH
+            && vector_empty(&m->retired_tables)) {
+        pthread_mutex_unlock(&m->retire_lock);
+        return;
+    }
+
+    struct vector nodes = m->retired_nodes;
+    struct vector tables = m->retired_tables;
+    vector_init(&m->retired_nodes, sizeof(struct node *));
+    vector_init(&m->retired_tables, sizeof(struct chashmap_table *));
+    pthread_mutex_unlock(&m->retire_lock);
+
+    synchronize(m);
+    free_retired(&nodes, &tables);
+}
+
+// Called with no stripe locked
+static void retire(struct chashmap *m, struct node *n) {
+    pthread_mutex_lock(&m->retire_lock);
+    bool pushed = vector_push_back(&m->retired_nodes, &n);
+    pthread_mutex_unlock(&m->retire_lock);
+
+    if (!pushed) {
+        synchronize(m);
+        free(n);
+        return;
+    }
+    reclaim(m, false);
+}
+
+static void retire_table(struct chashmap *m, struct chashmap_table *t) {
+    pthread_mutex_lock(&m->retire_lock);
+    bool pushed = vector_push_back(&m->retired_tables, &t);
+    pthread_mutex_unlock(&m->retire_lock);
+
+    if (!pushed) {
+        synchronize(m);
+        free_table(t, NULL, NULL);
+        return;
+    }
+    reclaim(m, true);
+}
+
+// Readers may still walk the old table, so its nodes are copied rather than
+// relinked
+static struct chashmap_table *copy_table(const struct chashmap *m,
+        const struct chashmap_table *t, size_t nbuckets) {
+    struct chashmap_table *res = new_table(nbuckets);
+    if (!res)
+        return NULL;
+
+    for (size_t i = 0; i <= t->mask; ++i) {
+        for (struct node *cur = t->buckets[i]; cur; cur = cur->next) {
+            struct node *n = new_node(m, NODE_DATA(cur), cur->hash);
+            if (!n) {
+                free_table(res, NULL, NULL);
+                return NULL;
+            }
+            struct node **b = &res->buckets[n->hash & res->mask];
+            n->next = *b;
+            *b = n;
+        }
+    }
+
+    return res;
+}
+
+static void grow(struct chashmap *m, const struct chashmap_table *seen) {
+    for (size_t i = 0; i < STRIPES; ++i)
+        pthread_mutex_lock(&m->stripes[i].lock);
+
+    struct chashmap_table *t = m->table;
+    struct chashmap_table *bigger = NULL;
+    if (t == seen && t->mask < SIZE_MAX / 2 / sizeof(*t->buckets))
+        bigger = copy_table(m, t, (t->mask + 1) * 2);
+    if (bigger)
+        __atomic_store_n(&m->table, bigger, __ATOMIC_RELEASE);
+
+    for (size_t i = STRIPES; i-- > 0;)
+        pthread_mutex_unlock(&m->stripes[i].lock);
+
+    if (bigger)
+        retire_table(m, t);
+}
+
+// First node equal to `elem` in its chain, or the end of the chain. The
+// stripe of `h` must be locked.
+static struct node **find_link(const struct chashmap *m,
+        const void *elem, uint64_t h) {
+    struct node **link = &m->table->buckets[h & m->table->mask];
+    for (; *link; link = &(*link)->next)
+        if ((*link)->hash == h && m->eq(NODE_DATA(*link), elem, m->cookie))
+            break;
+    return link;
+}
+
+bool chashmap_init(struct chashmap *m, size_t size,
+        chashmap_hash_f hash, chashmap_eq_f eq, void *cookie) {
+    if (!m || !size || !hash || !eq
+            || size > SIZE_MAX - sizeof(struct node))
+        return false;
+
+    memset(m, 0, sizeof(*m));
+    m->table = new_table(STRIPES);
+    if (!m->table)
+        return false;
+
+    m->size = size;
+    m->hash = hash;
+    m->eq = eq;
+    m->cookie = cookie;
+    for (size_t i = 0; i < STRIPES; ++i)
+        pthread_mutex_init(&m->stripes[i].lock, NULL);
+    pthread_mutex_init(&m->retire_lock, NULL);
+    pthread_mutex_init(&m->sync_lock, NULL);
+    vector_init(&m->retired_nodes, sizeof(struct node *));
+    vector_init(&m->retired_tables, sizeof(struct chashmap_table *));
+
+    return true;
+}
+
+void chashmap_clear(struct chashmap *m,
+        void (*dtor)(void *elem, void *cookie), void *cookie) {
+    if (!m || !m->table)
+        return;
+
+    free_retired(&m->retired_nodes, &m->retired_tables);
+    free_table(m->table, dtor, cookie);
+    for (size_t i = 0; i < STRIPES; ++i)
+        pthread_mutex_destroy(&m->stripes[i].lock);
+    pthread_mutex_destroy(&m->retire_lock);
+    pthread_mutex_destroy(&m->sync_lock);
+    memset(m, 0, sizeof(*m));
+}
+
+size_t chashmap_length(const struct chashmap *m) {
+    if (!m)
+        return 0;
+
+    size_t nmemb = 0;
+    for (size_t i = 0; i < STRIPES; ++i)
+        nmemb += __atomic_load_n(&m->stripes[i].nmemb, __ATOMIC_RELAXED);
+    return nmemb;
+}
+
+bool chashmap_empty(const struct chashmap *m) {
+    return chashmap_length(m) == 0;
+}
+
+bool chashmap_find(struct chashmap *m, const void *key, void *output) {
+    if (!m || !m->size || !key)
+        return false;
+
+    uint64_t h = hash(m, key);
+    size_t *active = read_lock(m);
+
+    struct chashmap_table *t = __atomic_load_n(&m->table, __ATOMIC_ACQUIRE);
+    struct node *n =
+        __atomic_load_n(&t->buckets[h & t->mask], __ATOMIC_ACQUIRE);
+    for (; n; n = __atomic_load_n(&n->next, __ATOMIC_ACQUIRE))
+        if (n->hash == h && m->eq(NODE_DATA(n), key, m->cookie))
+            break;
+    if (n && output)
+        memcpy(output, NODE_DATA(n), m->size);
+
+    read_unlock(active);
+
+    return n != NULL;
+}
+
+// Links `elem` in place of the node equal to it if `replace`. Returns the
+// node replaced through `old`.
+static bool insert(struct chashmap *m, const void *elem, bool replace,
+        void *output, struct node **old) {
+    uint64_t h = hash(m, elem);
+    struct chashmap_stripe *s = stripe(m, h);
+    pthread_mutex_lock(&s->lock);
+
+    struct chashmap_table *t = m->table;
+    struct node **link = find_link(m, elem, h);
+    struct node *found = *link;
+    struct node *n = NULL;
+    if (found && !replace) {
+        if (output)
+            memcpy(output, NODE_DATA(found), m->size);
+    } else {
+        n = new_node(m, elem, h);
+    }
+    if (!n) {
+        pthread_mutex_unlock(&s->lock);
+        return false;
+    }
+
+    size_t nmemb = s->nmemb;
+    if (found)
+        n->next = found->next;
+    else
+        __atomic_store_n(&s->nmemb, ++nmemb, __ATOMIC_RELAXED);
+    __atomic_store_n(link, n, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&s->lock);
+
+    *old = found;
+    // Chains average one node
+    if (nmemb > (t->mask + 1) / STRIPES)
+        grow(m, t);
+
+    return true;
+}
+
+bool chashmap_insert(struct chashmap *m, const void *elem, void *output) {
+    if (!m || !m->size || !elem)
+        return false;
+
+    struct node *old;
+    return insert(m, elem, false, output, &old);
+}
+
+bool chashmap_assign(struct chashmap *m, const void *elem) {
+    if (!m || !m->size || !elem)
+        return false;
+
+    struct node *old;
+    if (!insert(m, elem, true, NULL, &old))
+        return false;
+    if (old)
+        retire(m, old);
+
+    return true;
+}
+
+bool chashmap_remove(struct chashmap *m, const void *key, void *output) {
+    if (!m || !m->size || !key)
+        return false;
+
+    uint64_t h = hash(m, key);
+    struct chashmap_stripe *s = stripe(m, h);
+    pthread_mutex_lock(&s->lock);
+
+    struct node **link = find_link(m, key, h);
+    struct node *found = *link;
+    if (found) {
+        if (output)
+            memcpy(output, NODE_DATA(found), m->size);
+        __atomic_store_n(link, found->next, __ATOMIC_RELEASE);
+        __atomic_store_n(&s->nmemb, s->nmemb - 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if (found)
+        retire(m, found);
+
+    return found != NULL;
+}
+
+void chashmap_reclaim(struct chashmap *m) {
+    if (!m || !m->size)
+        return;
+    reclaim(m, true);
+}
@@ -0,0 +1,42 @@
+#include "cpu.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char *names[] = {
+    [CPU_SCALAR] = "scalar",
+    [CPU_SSE2] = "sse2",
+    [CPU_AVX2] = "avx2",
+    [CPU_AVX512] = "avx512",
+};
+
+static enum cpu_level detect(void) {
+#ifdef TUPPERWARE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return CPU_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return CPU_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return CPU_SSE2;
+#endif
+    return CPU_SCALAR;
+}
+
+enum cpu_level cpu_level(void) {
+    enum cpu_level level = detect();
+
+    const char *wanted = getenv("TUPPERWARE_SIMD");
+    if (!wanted)
+        return level;
+
+    for (enum cpu_level l = CPU_SCALAR; l < level; ++l)
+        if (!strcmp(wanted, names[l]))
+            return l;
+
+    return level;
+}
+
+const char *cpu_level_name(enum cpu_level level) {
+    return names[level];
+}
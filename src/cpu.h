@@ -0,0 +1,20 @@
+#ifndef TUPPERWARE_CPU_H
+#define TUPPERWARE_CPU_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TUPPERWARE_X86 1
+#endif
+
+enum cpu_level {
+    CPU_SCALAR,
+    CPU_SSE2,
+    CPU_AVX2,
+    CPU_AVX512,
+};
+
+// Best instruction set supported by the running CPU, can be lowered by setting
+// the `TUPPERWARE_SIMD` environment variable to `scalar`, `sse2` or `avx2`
+enum cpu_level cpu_level(void);
+const char *cpu_level_name(enum cpu_level level);
+
+#endif /* !TUPPERWARE_CPU_H */
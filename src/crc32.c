@@ -0,0 +1,88 @@
+#include "crc32.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#ifdef TUPPERWARE_X86
+#include <nmmintrin.h>
+#endif
+
+#define POLY 0x82f63b78u
+
+typedef uint32_t (*crc32c_f)(uint32_t crc, const unsigned char *p, size_t len);
+
+// Slicing by 8: `table[k][b]` is the CRC of byte `b` followed by `k` zeros
+static uint32_t table[8][256];
+
+// Bytes are fed in memory order whatever the endianness
+static uint32_t load_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8
+        | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint32_t crc32c_scalar(uint32_t crc,
+        const unsigned char *p, size_t len) {
+    for (; len >= 8; p += 8, len -= 8) {
+        uint32_t lo = crc ^ load_le32(p);
+        uint32_t hi = load_le32(p + 4);
+        crc = table[7][lo & 0xff] ^ table[6][(lo >> 8) & 0xff]
+            ^ table[5][(lo >> 16) & 0xff] ^ table[4][lo >> 24]
+            ^ table[3][hi & 0xff] ^ table[2][(hi >> 8) & 0xff]
+            ^ table[1][(hi >> 16) & 0xff] ^ table[0][hi >> 24];
+    }
+
+    while (len--)
+        crc = table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+    return crc;
+}
+
+#ifdef TUPPERWARE_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc,
+        const unsigned char *p, size_t len) {
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = crc64;
+#endif
+
+    while (len--)
+        crc = _mm_crc32_u8(crc, *p++);
+
+    return crc;
+}
+#endif
+
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+static crc32c_f crc_impl = crc32c_scalar;
+
+static void init_crc(void) {
+    for (uint32_t b = 0; b < 256; ++b) {
+        uint32_t crc = b;
+        for (int i = 0; i < 8; ++i)
+            crc = (crc >> 1) ^ (POLY & -(crc & 1));
+        table[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; ++b)
+        for (int k = 1; k < 8; ++k)
+            table[k][b] = table[0][table[k - 1][b] & 0xff]
+                ^ (table[k - 1][b] >> 8);
+
+#ifdef TUPPERWARE_X86
+    // Only disabled along with every SIMD kernel
+    if (cpu_level() > CPU_SCALAR && __builtin_cpu_supports("sse4.2"))
+        crc_impl = crc32c_sse42;
+#endif
+}
+
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len) {
+    pthread_once(&crc_once, init_crc);
+    return ~crc_impl(~crc, buf, len);
+}
@@ -0,0 +1,12 @@
+#ifndef TUPPERWARE_CRC32_H
+#define TUPPERWARE_CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32C (Castagnoli), `crc` is 0 for the first buffer, or the result for
+// the previous one to checksum data in several pieces. Uses the SSE4.2
+// instruction when available.
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len);
+
+#endif /* !TUPPERWARE_CRC32_H */
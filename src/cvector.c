@@ -0,0 +1,198 @@
+#include "tupperware/cvector.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIRST_SEGMENT ((size_t)1 << CVECTOR_FIRST_SEGMENT_LOG2)
+
+struct location {
+    size_t segment;
+    size_t offset;
+};
+
+static size_t segment_length(size_t segment) {
+    return FIRST_SEGMENT << segment;
+}
+
+static struct location locate(size_t i) {
+    size_t j = i + FIRST_SEGMENT;
+    size_t log2 = sizeof(unsigned long long) * CHAR_BIT - 1
+        - __builtin_clzll(j);
+    size_t segment = log2 - CVECTOR_FIRST_SEGMENT_LOG2;
+
+    return (struct location){
+        .segment = segment,
+        .offset = j - segment_length(segment),
+    };
+}
+
+// Each segment stores its elements, followed by one ready flag per element
+static unsigned char *ready_flag(const struct cvector *v,
+        void *segment, struct location loc) {
+    return (unsigned char *)segment
+        + segment_length(loc.segment) * v->size + loc.offset;
+}
+
+static void *segment_at(const struct cvector *v, size_t segment) {
+    return __atomic_load_n(&v->segments[segment], __ATOMIC_ACQUIRE);
+}
+
+static void *get_segment(struct cvector *v, size_t segment) {
+    void *s = segment_at(v, segment);
+    if (s)
+        return s;
+
+    size_t n = segment_length(segment);
+    if (n > SIZE_MAX / (v->size + 1))
+        return NULL;
+
+    void *expected = NULL;
+    s = calloc(n, v->size + 1);
+    if (!s)
+        return NULL;
+
+    if (!__atomic_compare_exchange_n(&v->segments[segment], &expected, s,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(s); // Someone else was faster
+        return expected;
+    }
+
+    return s;
+}
+
+bool cvector_init(struct cvector *v, size_t size) {
+    if (!v || !size || size == SIZE_MAX)
+        return false;
+
+    v->size = size;
+    for (size_t i = 0; i < CVECTOR_SEGMENTS; ++i)
+        v->segments[i] = NULL;
+    v->reserved = 0;
+    v->published = 0;
+
+    return true;
+}
+
+void cvector_clear(struct cvector *v,
+        void (*dtor)(void *v, void *cookie), void *cookie) {
+    if (!v)
+        return;
+
+    if (dtor)
+        for (size_t i = 0; i < v->published; ++i)
+            dtor(cvector_at(v, i), cookie);
+
+    for (size_t i = 0; i < CVECTOR_SEGMENTS; ++i) {
+        free(v->segments[i]);
+        v->segments[i] = NULL;
+    }
+
+    v->size = 0;
+    v->reserved = 0;
+    v->published = 0;
+}
+
+bool cvector_reserve(struct cvector *v, size_t cap) {
+    if (!v)
+        return false;
+    if (!cap)
+        return true;
+    if (cap > SIZE_MAX - FIRST_SEGMENT)
+        return false;
+
+    size_t last = locate(cap - 1).segment;
+    for (size_t i = 0; i <= last; ++i)
+        if (!get_segment(v, i))
+            return false;
+
+    return true;
+}
+
+size_t cvector_length(const struct cvector *v) {
+    if (!v)
+        return 0;
+    return __atomic_load_n(&v->published, __ATOMIC_ACQUIRE);
+}
+
+size_t cvector_elem_size(const struct cvector *v) {
+    if (!v)
+        return 0;
+    return v->size;
+}
+
+bool cvector_empty(const struct cvector *v) {
+    return cvector_length(v) == 0;
+}
+
+void *cvector_at(const struct cvector *v, size_t i) {
+    if (!v)
+        return NULL;
+    if (cvector_length(v) <= i)
+        return NULL;
+
+    struct location loc = locate(i);
+    return (char *)segment_at(v, loc.segment) + loc.offset * v->size;
+}
+
+// End of the run of written elements starting at `p`
+static size_t ready_end(const struct cvector *v, size_t p) {
+    for (;; ++p) {
+        struct location loc = locate(p);
+        void *segment = segment_at(v, loc.segment);
+        if (!segment
+                || !__atomic_load_n(ready_flag(v, segment, loc),
+                    __ATOMIC_ACQUIRE))
+            return p;
+    }
+}
+
+// Extends the published prefix over every written element, one compare and
+// swap per run. A writer whose element `i` is not published yet only leaves
+// after a successful compare and swap that changes nothing: those are totally
+// ordered with the ones moving the prefix, so whoever moves it past `i` next
+// then sees the ready flag of `i` when scanning again.
+static void publish(struct cvector *v, size_t i) {
+    size_t p = __atomic_load_n(&v->published, __ATOMIC_ACQUIRE);
+
+    for (;;) {
+        size_t end = ready_end(v, p);
+        if (end == p && p > i)
+            return;
+        // On failure `p` is updated to the newly published length
+        if (__atomic_compare_exchange_n(&v->published, &p, end,
+                    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            if (end == p)
+                return;
+            p = end;
+        }
+    }
+}
+
+bool cvector_push_back(struct cvector *v, void *elem) {
+    if (!v || !elem)
+        return false;
+
+    // An index is only taken once its segment exists, a reserved slot that is
+    // never written would keep every later one from being published
+    size_t i = __atomic_load_n(&v->reserved, __ATOMIC_RELAXED);
+    struct location loc;
+    void *segment;
+    do {
+        loc = locate(i);
+        segment = get_segment(v, loc.segment);
+        if (!segment)
+            return false;
+    } while (!__atomic_compare_exchange_n(&v->reserved, &i, i + 1,
+                false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    // Allocate ahead of time to keep writers from racing on the next segment
+    if (!loc.offset && loc.segment + 1 < CVECTOR_SEGMENTS)
+        get_segment(v, loc.segment + 1);
+
+    memcpy((char *)segment + loc.offset * v->size, elem, v->size);
+    __atomic_store_n(ready_flag(v, segment, loc), 1, __ATOMIC_RELEASE);
+    publish(v, i);
+
+    return true;
+}
@@ -0,0 +1,213 @@
+#include "tupperware/deque.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define DEQUE_AT(Deque, Ind) \
+    ((void *)((char *)(Deque)->vec.arr + ((Deque)->vec.size * (Ind))))
+
+// Physical index of the `i`-th element, `i` must be at most the capacity
+static size_t slot(const struct deque *d, size_t i) {
+    size_t s = d->head + i;
+    return s >= d->vec.cap ? s - d->vec.cap : s;
+}
+
+bool deque_init(struct deque *d, size_t size) {
+    if (!d || !vector_init(&d->vec, size))
+        return false;
+
+    d->head = 0;
+
+    return true;
+}
+
+bool deque_with_cap(struct deque *d, size_t size, size_t cap) {
+    if (!d || !vector_with_cap(&d->vec, size, cap))
+        return false;
+
+    d->head = 0;
+
+    return true;
+}
+
+void deque_clear(struct deque *d,
+        void (*dtor)(void *v, void *cookie), void *cookie) {
+    if (!d)
+        return;
+
+    if (dtor)
+        for (size_t i = 0; i < d->vec.nmemb; ++i)
+            dtor(DEQUE_AT(d, slot(d, i)), cookie);
+
+    vector_clear(&d->vec, NULL, NULL);
+    d->head = 0;
+}
+
+bool deque_reserve(struct deque *d, size_t cap) {
+    if (!d)
+        return false;
+
+    size_t old_cap = d->vec.cap;
+    if (old_cap >= cap)
+        return true;
+
+    if (!vector_reserve(&d->vec, cap))
+        return false;
+
+    size_t head_len = old_cap - d->head;
+    if (d->vec.nmemb <= head_len)
+        return true; // Was not wrapped around, nothing to move
+
+    // Unwrap by moving whichever part is the shortest in a single copy
+    size_t wrapped = d->vec.nmemb - head_len;
+    if (wrapped <= head_len && wrapped <= cap - old_cap) {
+        memcpy(DEQUE_AT(d, old_cap), DEQUE_AT(d, 0), wrapped * d->vec.size);
+    } else {
+        size_t new_head = cap - head_len;
+        memmove(DEQUE_AT(d, new_head),
+                DEQUE_AT(d, d->head),
+                head_len * d->vec.size);
+        d->head = new_head;
+    }
+
+    return true;
+}
+
+size_t deque_length(const struct deque *d) {
+    if (!d)
+        return 0;
+    return d->vec.nmemb;
+}
+
+size_t deque_capacity(const struct deque *d) {
+    if (!d)
+        return 0;
+    return d->vec.cap;
+}
+
+size_t deque_elem_size(const struct deque *d) {
+    if (!d)
+        return 0;
+    return d->vec.size;
+}
+
+bool deque_empty(const struct deque *d) {
+    return deque_length(d) == 0;
+}
+
+void *deque_at(const struct deque *d, size_t i) {
+    if (!d)
+        return NULL;
+    if (d->vec.nmemb <= i)
+        return NULL;
+
+    return DEQUE_AT(d, slot(d, i));
+}
+
+static bool grow(struct deque *d) {
+    if (d->vec.nmemb < d->vec.cap)
+        return true;
+    return deque_reserve(d, d->vec.cap ? d->vec.cap * 2 : 2);
+}
+
+bool deque_push_back(struct deque *d, void *elem) {
+    if (!d || !elem)
+        return false;
+
+    if (!grow(d))
+        return false;
+
+    memmove(DEQUE_AT(d, slot(d, d->vec.nmemb)), elem, d->vec.size);
+    d->vec.nmemb += 1;
+
+    return true;
+}
+
+bool deque_push_front(struct deque *d, void *elem) {
+    if (!d || !elem)
+        return false;
+
+    if (!grow(d))
+        return false;
+
+    d->head = (d->head ? d->head : d->vec.cap) - 1;
+    memmove(DEQUE_AT(d, d->head), elem, d->vec.size);
+    d->vec.nmemb += 1;
+
+    return true;
+}
+
+bool deque_pop_back(struct deque *d, void *output) {
+    if (!d || !d->vec.nmemb)
+        return false;
+
+    d->vec.nmemb -= 1;
+    if (output)
+        memmove(output, DEQUE_AT(d, slot(d, d->vec.nmemb)), d->vec.size);
+
+    return true;
+}
+
+bool deque_pop_front(struct deque *d, void *output) {
+    if (!d || !d->vec.nmemb)
+        return false;
+
+    if (output)
+        memmove(output, DEQUE_AT(d, d->head), d->vec.size);
+    d->head = slot(d, 1);
+    d->vec.nmemb -= 1;
+
+    return true;
+}
+
+bool deque_push_back_n(struct deque *d, void *elems, size_t n) {
+    if (!d || !elems)
+        return false;
+    if (!n)
+        return true;
+    if (n > SIZE_MAX - d->vec.nmemb)
+        return false;
+
+    size_t needed = d->vec.nmemb + n;
+    if (needed > d->vec.cap) {
+        size_t cap = d->vec.cap * 2;
+        if (!deque_reserve(d, cap > needed ? cap : needed))
+            return false;
+    }
+
+    size_t tail = slot(d, d->vec.nmemb);
+    size_t first = d->vec.cap - tail;
+    if (first > n)
+        first = n;
+
+    memcpy(DEQUE_AT(d, tail), elems, first * d->vec.size);
+    memcpy(DEQUE_AT(d, 0),
+            (char *)elems + first * d->vec.size,
+            (n - first) * d->vec.size);
+    d->vec.nmemb += n;
+
+    return true;
+}
+
+size_t deque_pop_front_n(struct deque *d, void *output, size_t n) {
+    if (!d || !d->vec.nmemb)
+        return 0;
+
+    if (n > d->vec.nmemb)
+        n = d->vec.nmemb;
+
+    size_t first = d->vec.cap - d->head;
+    if (first > n)
+        first = n;
+
+    if (output) {
+        memcpy(output, DEQUE_AT(d, d->head), first * d->vec.size);
+        memcpy((char *)output + first * d->vec.size,
+                DEQUE_AT(d, 0),
+                (n - first) * d->vec.size);
+    }
+    d->head = slot(d, n);
+    d->vec.nmemb -= n;
+
+    return n;
+}
@@ -0,0 +1,237 @@
+#include "tupperware/elias_fano.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bits.h"
+
+#define SAMPLE ELIAS_FANO_SAMPLE
+
+static size_t nwords(size_t bits) {
+    return (bits + 63) / 64;
+}
+
+static size_t nsamples(size_t n) {
+    return (n + SAMPLE - 1) / SAMPLE;
+}
+
+static size_t nzeros(const struct elias_fano *ef) {
+    return ef->upper_bits - ef->nmemb;
+}
+
+static uint64_t lower_at(const struct elias_fano *ef, size_t i) {
+    unsigned l = ef->lower_bits;
+    if (!l)
+        return 0;
+
+    size_t bit = i * l;
+    const uint64_t *w = ef->lower + bit / 64;
+    unsigned shift = bit % 64;
+
+    uint64_t x = w[0] >> shift;
+    if (shift + l > 64)
+        x |= w[1] << (64 - shift);
+    return x & ((UINT64_C(1) << l) - 1);
+}
+
+static void lower_set(struct elias_fano *ef, size_t i, uint64_t x) {
+    unsigned l = ef->lower_bits;
+    if (!l)
+        return;
+
+    size_t bit = i * l;
+    uint64_t *w = ef->lower + bit / 64;
+    unsigned shift = bit % 64;
+
+    x &= (UINT64_C(1) << l) - 1;
+    w[0] |= x << shift;
+    if (shift + l > 64)
+        w[1] |= x >> (64 - shift);
+}
+
+// Position of the `i`th set bit, or of the `i`th unset one when `flip` is all
+// ones, starting from the sample before it
+static size_t select_bit(const struct elias_fano *ef, const size_t *samples,
+        uint64_t flip, size_t i) {
+    size_t pos = samples[i / SAMPLE];
+    size_t k = i % SAMPLE;
+    size_t w = pos / 64;
+    uint64_t word = (ef->upper[w] ^ flip) & (UINT64_MAX << pos % 64);
+
+    for (;;) {
+        unsigned n = bits_popcount(word);
+        if (k < n)
+            break;
+        k -= n;
+        word = ef->upper[++w] ^ flip;
+    }
+
+    return w * 64 + bits_select(word, k);
+}
+
+static uint64_t get(const struct elias_fano *ef, size_t i) {
+    uint64_t upper = select_bit(ef, ef->ones, 0, i) - i;
+    return upper << ef->lower_bits | lower_at(ef, i);
+}
+
+bool elias_fano_init(struct elias_fano *ef, const struct vector *v) {
+    if (!ef || !v || v->size != sizeof(uint64_t))
+        return false;
+
+    const uint64_t *arr = v->arr;
+    size_t n = v->nmemb;
+    for (size_t i = 1; i < n; ++i)
+        if (arr[i] < arr[i - 1])
+            return false;
+
+    memset(ef, 0, sizeof(*ef));
+    if (!n)
+        return true;
+
+    // About `log2(u / n)` lower bits, leaving about `2n` upper bits
+    uint64_t last = arr[n - 1];
+    unsigned l = 0;
+    while (l < 63 && last >> (l + 1) >= n)
+        ++l;
+
+    ef->nmemb = n;
+    ef->lower_bits = l;
+    ef->upper_bits = n + (last >> l) + 1;
+
+    size_t nlower = nwords(n * l);
+    ef->lower = calloc(nlower ? nlower : 1, sizeof(*ef->lower));
+    ef->upper = calloc(nwords(ef->upper_bits), sizeof(*ef->upper));
+    ef->ones = malloc(nsamples(n) * sizeof(*ef->ones));
+    ef->zeros = malloc(nsamples(nzeros(ef)) * sizeof(*ef->zeros));
+    if (!ef->lower || !ef->upper || !ef->ones || !ef->zeros) {
+        elias_fano_clear(ef);
+        return false;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t pos = (arr[i] >> l) + i;
+        ef->upper[pos / 64] |= UINT64_C(1) << pos % 64;
+        lower_set(ef, i, arr[i]);
+        if (i % SAMPLE == 0)
+            ef->ones[i / SAMPLE] = pos;
+    }
+
+    // The `h`th unset bit follows the elements with upper bits up to `h`
+    size_t i = 0;
+    for (size_t h = 0; h < nzeros(ef); h += SAMPLE) {
+        while (i < n && arr[i] >> l <= h)
+            ++i;
+        ef->zeros[h / SAMPLE] = h + i;
+    }
+
+    return true;
+}
+
+void elias_fano_clear(struct elias_fano *ef) {
+    if (!ef)
+        return;
+
+    free(ef->lower);
+    free(ef->upper);
+    free(ef->ones);
+    free(ef->zeros);
+    memset(ef, 0, sizeof(*ef));
+}
+
+size_t elias_fano_length(const struct elias_fano *ef) {
+    if (!ef)
+        return 0;
+    return ef->nmemb;
+}
+
+size_t elias_fano_bytes(const struct elias_fano *ef) {
+    if (!ef || !ef->nmemb)
+        return 0;
+
+    size_t words = nwords(ef->nmemb * ef->lower_bits)
+        + nwords(ef->upper_bits);
+    size_t samples = nsamples(ef->nmemb) + nsamples(nzeros(ef));
+
+    return words * sizeof(uint64_t) + samples * sizeof(size_t);
+}
+
+bool elias_fano_at(const struct elias_fano *ef, size_t i, uint64_t *output) {
+    if (!ef || !output || i >= ef->nmemb)
+        return false;
+
+    *output = get(ef, i);
+    return true;
+}
+
+bool elias_fano_decode(const struct elias_fano *ef, struct vector *res) {
+    if (!ef || !res || res->size != sizeof(uint64_t))
+        return false;
+    if (!ef->nmemb)
+        return true;
+    if (!vector_reserve(res, res->nmemb + ef->nmemb))
+        return false;
+
+    // Set bits in order, without selecting each of them
+    uint64_t *out = (uint64_t *)res->arr + res->nmemb;
+    size_t i = 0;
+    for (size_t w = 0; i < ef->nmemb; ++w) {
+        for (uint64_t word = ef->upper[w]; word; word &= word - 1) {
+            uint64_t upper = w * 64 + __builtin_ctzll(word) - i;
+            out[i] = upper << ef->lower_bits | lower_at(ef, i);
+            ++i;
+        }
+    }
+    res->nmemb += ef->nmemb;
+
+    return true;
+}
+
+bool elias_fano_successor(const struct elias_fano *ef, uint64_t x,
+        size_t *index, uint64_t *output) {
+    if (!ef || !ef->nmemb)
+        return false;
+
+    uint64_t h = x >> ef->lower_bits;
+    if (h >= nzeros(ef))
+        return false;
+
+    // Elements with the same upper bits as `x` start right after the unset
+    // bit ending the previous ones, larger upper bits mean larger elements
+    size_t pos = h ? select_bit(ef, ef->zeros, UINT64_MAX, h - 1) + 1 : 0;
+    size_t lo = pos - h;
+
+    // A bucket may hold any number of elements, gallop then binary search
+    // from its start rather than scanning it
+    size_t hi = lo;
+    for (size_t step = 1; hi < ef->nmemb && get(ef, hi) < x; step *= 2) {
+        lo = hi + 1;
+        hi += step;
+    }
+    if (hi > ef->nmemb)
+        hi = ef->nmemb;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (get(ef, mid) < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == ef->nmemb)
+        return false;
+
+    size_t i = lo;
+    uint64_t y = get(ef, i);
+    if (index)
+        *index = i;
+    if (output)
+        *output = y;
+
+    return true;
+}
+
+size_t elias_fano_rank(const struct elias_fano *ef, uint64_t x) {
+    size_t i;
+    if (!elias_fano_successor(ef, x, &i, NULL))
+        return elias_fano_length(ef);
+    return i;
+}
@@ -0,0 +1,36 @@
+#ifndef TUPPERWARE_FUTEX_H
+#define TUPPERWARE_FUTEX_H
+
+#include <limits.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Sleep as long as `*word == val`, may return spuriously
+static inline void futex_wait(uint32_t *word, uint32_t val) {
+#ifdef __linux__
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#else
+    (void)word;
+    (void)val;
+    sched_yield();
+#endif
+}
+
+static inline void futex_wake(uint32_t *word, size_t n) {
+#ifdef __linux__
+    int count = n > INT_MAX ? INT_MAX : (int)n;
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+#else
+    (void)word;
+    (void)n;
+#endif
+}
+
+#endif /* !TUPPERWARE_FUTEX_H */
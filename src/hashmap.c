@@ -0,0 +1,329 @@
+#include "tupperware/hashmap.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#if defined(TUPPERWARE_X86) && defined(__SSE2__)
+#include <immintrin.h>
+#define HASHMAP_SSE2 1
+#endif
+
+#define GROUP HASHMAP_GROUP
+#define EMPTY 0x80
+
+#define SLOT(Map, Ind) ((void *)((char *)(Map)->slots + (Map)->size * (Ind)))
+
+static pthread_once_t group_once = PTHREAD_ONCE_INIT;
+static bool group_sse2 = false;
+
+static void init_group(void) {
+    group_sse2 = cpu_level() >= CPU_SSE2;
+}
+
+// Bit `i` of `matches` is set when control byte `i` is `h2`, and of `empties`
+// when it is empty
+static void group_scalar(const uint8_t *ctrl, uint8_t h2,
+        uint32_t *matches, uint32_t *empties) {
+    uint32_t m = 0;
+    uint32_t e = 0;
+    for (unsigned i = 0; i < GROUP; ++i) {
+        m |= (uint32_t)(ctrl[i] == h2) << i;
+        e |= (uint32_t)(ctrl[i] == EMPTY) << i;
+    }
+    *matches = m;
+    *empties = e;
+}
+
+#ifdef HASHMAP_SSE2
+
+// Only empty control bytes have their high bit set
+static void group_sse2_match(const uint8_t *ctrl, uint8_t h2,
+        uint32_t *matches, uint32_t *empties) {
+    __m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+    *matches = _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(h2)));
+    *empties = _mm_movemask_epi8(g);
+}
+
+#endif /* HASHMAP_SSE2 */
+
+static inline void group(const uint8_t *ctrl, uint8_t h2,
+        uint32_t *matches, uint32_t *empties) {
+#ifdef HASHMAP_SSE2
+    if (group_sse2) {
+        group_sse2_match(ctrl, h2, matches, empties);
+        return;
+    }
+#endif
+    group_scalar(ctrl, h2, matches, empties);
+}
+
+// User hashes can be weak in their low bits, which pick the slot
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 32;
+    h *= UINT64_C(0x9e3779b97f4a7c15);
+    return h ^ h >> 29;
+}
+
+static uint64_t hash(const struct hashmap *m, const void *elem) {
+    return mix(m->hash(elem, m->cookie));
+}
+
+static uint8_t h2(uint64_t h) {
+    return h >> 57;
+}
+
+// Keeps a load factor up to 7/8
+static size_t max_load(size_t cap) {
+    return cap - cap / 8;
+}
+
+// The first `GROUP - 1` control bytes are repeated after the last one, so
+// that groups can be loaded from any slot
+static void set_ctrl(struct hashmap *m, size_t i, uint8_t c) {
+    m->ctrl[i] = c;
+    if (i < GROUP - 1)
+        m->ctrl[m->cap + i] = c;
+}
+
+// Home bits of the element in slot `i` of `m`, when they are enough to find
+// its home slot in a table of `cap` slots
+static uint64_t home_bits(const struct hashmap *m, size_t i, size_t cap) {
+    if ((uint64_t)(cap - 1) > UINT32_MAX)
+        return hash(m, SLOT(m, i));
+    return m->homes[i];
+}
+
+// First empty slot from the home of `h`
+static size_t probe_empty(const struct hashmap *m, uint64_t h) {
+    size_t mask = m->cap - 1;
+    size_t pos = h & mask;
+
+    for (;;) {
+        uint32_t matches;
+        uint32_t empties;
+        group(m->ctrl + pos, 0, &matches, &empties);
+        if (empties)
+            return (pos + __builtin_ctz(empties)) & mask;
+        pos = (pos + GROUP) & mask;
+    }
+}
+
+// Slot of the element equal to `key`, otherwise the empty slot ending its
+// probe sequence
+static size_t probe(const struct hashmap *m, const void *key, uint64_t h,
+        bool *found) {
+    size_t mask = m->cap - 1;
+    size_t pos = h & mask;
+
+    for (;;) {
+        uint32_t matches;
+        uint32_t empties;
+        group(m->ctrl + pos, h2(h), &matches, &empties);
+        // Matches past the first empty slot belong to other sequences
+        if (empties)
+            matches &= (empties & -empties) - 1;
+
+        for (; matches; matches &= matches - 1) {
+            size_t i = (pos + __builtin_ctz(matches)) & mask;
+            if (m->eq(SLOT(m, i), key, m->cookie)) {
+                *found = true;
+                return i;
+            }
+        }
+        if (empties) {
+            *found = false;
+            return (pos + __builtin_ctz(empties)) & mask;
+        }
+        pos = (pos + GROUP) & mask;
+    }
+}
+
+static bool rehash(struct hashmap *m, size_t cap) {
+    uint8_t *ctrl = malloc(cap + GROUP - 1);
+    void *slots = reallocarray(NULL, cap, m->size);
+    uint32_t *homes = reallocarray(NULL, cap, sizeof(*homes));
+    if (!ctrl || !slots || !homes) {
+        free(ctrl);
+        free(slots);
+        free(homes);
+        return false;
+    }
+    memset(ctrl, EMPTY, cap + GROUP - 1);
+
+    struct hashmap old = *m;
+    m->ctrl = ctrl;
+    m->slots = slots;
+    m->homes = homes;
+    m->cap = cap;
+    for (size_t i = 0; i < old.cap; ++i) {
+        if (old.ctrl[i] == EMPTY)
+            continue;
+
+        uint64_t h = home_bits(&old, i, cap);
+        size_t j = probe_empty(m, h);
+        memcpy(SLOT(m, j), SLOT(&old, i), m->size);
+        set_ctrl(m, j, old.ctrl[i]);
+        homes[j] = h;
+    }
+
+    free(old.ctrl);
+    free(old.slots);
+    free(old.homes);
+
+    return true;
+}
+
+bool hashmap_init(struct hashmap *m, size_t size,
+        hashmap_hash_f hash, hashmap_eq_f eq, void *cookie) {
+    if (!m || !size || !hash || !eq)
+        return false;
+
+    pthread_once(&group_once, init_group);
+    m->ctrl = NULL;
+    m->slots = NULL;
+    m->homes = NULL;
+    m->size = size;
+    m->nmemb = 0;
+    m->cap = 0;
+    m->hash = hash;
+    m->eq = eq;
+    m->cookie = cookie;
+
+    return true;
+}
+
+void hashmap_clear(struct hashmap *m,
+        void (*dtor)(void *elem, void *cookie), void *cookie) {
+    if (!m)
+        return;
+
+    if (dtor)
+        for (size_t i = 0; i < m->cap; ++i)
+            if (m->ctrl[i] != EMPTY)
+                dtor(SLOT(m, i), cookie);
+
+    free(m->ctrl);
+    free(m->slots);
+    free(m->homes);
+    memset(m, 0, sizeof(*m));
+}
+
+bool hashmap_reserve(struct hashmap *m, size_t n) {
+    if (!m || !m->size)
+        return false;
+
+    size_t cap = GROUP;
+    while (max_load(cap) < n) {
+        if (cap > SIZE_MAX / 2)
+            return false;
+        cap *= 2;
+    }
+    if (cap <= m->cap)
+        return true;
+
+    return rehash(m, cap);
+}
+
+size_t hashmap_length(const struct hashmap *m) {
+    if (!m)
+        return 0;
+    return m->nmemb;
+}
+
+size_t hashmap_capacity(const struct hashmap *m) {
+    if (!m)
+        return 0;
+    return max_load(m->cap);
+}
+
+bool hashmap_empty(const struct hashmap *m) {
+    return hashmap_length(m) == 0;
+}
+
+void *hashmap_find(const struct hashmap *m, const void *key) {
+    if (!m || !key || !m->nmemb)
+        return NULL;
+
+    bool found;
+    size_t i = probe(m, key, hash(m, key), &found);
+
+    return found ? SLOT(m, i) : NULL;
+}
+
+bool hashmap_insert(struct hashmap *m, const void *elem, void **inserted) {
+    if (inserted)
+        *inserted = NULL;
+    if (!m || !elem || !m->size)
+        return false;
+
+    uint64_t h = hash(m, elem);
+    bool found = false;
+    size_t i = 0;
+    if (m->cap)
+        i = probe(m, elem, h, &found);
+
+    if (!found && m->nmemb + 1 > max_load(m->cap)) {
+        if (!rehash(m, m->cap ? m->cap * 2 : GROUP))
+            return false;
+        i = probe_empty(m, h);
+    }
+
+    if (!found) {
+        memcpy(SLOT(m, i), elem, m->size);
+        set_ctrl(m, i, h2(h));
+        m->homes[i] = h;
+        ++m->nmemb;
+    }
+    if (inserted)
+        *inserted = SLOT(m, i);
+
+    return !found;
+}
+
+bool hashmap_remove(struct hashmap *m, const void *key, void *output) {
+    if (!m || !key || !m->nmemb)
+        return false;
+
+    bool found;
+    size_t hole = probe(m, key, hash(m, key), &found);
+    if (!found)
+        return false;
+    if (output)
+        memcpy(output, SLOT(m, hole), m->size);
+
+    // Later elements of the run move back into the hole, unless they would
+    // end up before their home slot
+    size_t mask = m->cap - 1;
+    for (size_t j = (hole + 1) & mask; m->ctrl[j] != EMPTY;
+            j = (j + 1) & mask) {
+        size_t home = home_bits(m, j, m->cap) & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            memcpy(SLOT(m, hole), SLOT(m, j), m->size);
+            set_ctrl(m, hole, m->ctrl[j]);
+            m->homes[hole] = m->homes[j];
+            hole = j;
+        }
+    }
+    set_ctrl(m, hole, EMPTY);
+    --m->nmemb;
+
+    return true;
+}
+
+void *hashmap_next(const struct hashmap *m, size_t *pos) {
+    if (!m || !pos)
+        return NULL;
+
+    for (size_t i = *pos; i < m->cap; ++i) {
+        if (m->ctrl[i] != EMPTY) {
+            *pos = i + 1;
+            return SLOT(m, i);
+        }
+    }
+    *pos = m->cap;
+
+    return NULL;
+}
@@ -0,0 +1,310 @@
+#include "tupperware/htable.h"
+
+#include <stdlib.h>
+
+#define MIN_BUCKETS 8
+// Old buckets moved at each insertion or removal, at least one is needed to
+// finish before the next growth
+#define MIGRATE_STEP 4
+
+enum insert_policy {
+    ALLOW_MULTI,
+    KEEP_OLD,
+    REPLACE_OLD,
+};
+
+// User hashes can be weak in their low bits, which pick the bucket
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 32;
+    h *= UINT64_C(0x9e3779b97f4a7c15);
+    return h ^ h >> 29;
+}
+
+static uint64_t hash(const struct htable *table, const struct htable_node *n) {
+    return mix(table->hash(n, table->cookie));
+}
+
+static struct htable_node **bucket(const struct htable *table, uint64_t h) {
+    if (table->old) {
+        size_t i = h & (table->nold - 1);
+        if (i >= table->migrated)
+            return &table->old[i];
+    }
+    return &table->buckets[h & (table->nbuckets - 1)];
+}
+
+static void migrate(struct htable *table, size_t n) {
+    for (; n && table->old; --n) {
+        struct htable_node *cur = table->old[table->migrated];
+        while (cur) {
+            struct htable_node *next = cur->next;
+            struct htable_node **b =
+                &table->buckets[cur->hash & (table->nbuckets - 1)];
+            cur->next = *b;
+            *b = cur;
+            cur = next;
+        }
+
+        if (++table->migrated == table->nold) {
+            free(table->old);
+            table->old = NULL;
+            table->nold = 0;
+            table->migrated = 0;
+        }
+    }
+}
+
+// Keeps the previous buckets until they are migrated
+static void grow(struct htable *table) {
+    size_t n = table->nbuckets ? table->nbuckets * 2 : MIN_BUCKETS;
+    struct htable_node **buckets = calloc(n, sizeof(*buckets));
+    if (!buckets)
+        return;
+
+    migrate(table, table->nold);
+    if (table->nbuckets) {
+        table->old = table->buckets;
+        table->nold = table->nbuckets;
+        table->migrated = 0;
+    }
+    table->buckets = buckets;
+    table->nbuckets = n;
+}
+
+// First node equal to `v` in its chain, or the end of the chain
+static struct htable_node **find_link(const struct htable *table,
+        const struct htable_node *v, uint64_t h) {
+    struct htable_node **link = bucket(table, h);
+    for (; *link; link = &(*link)->next)
+        if ((*link)->hash == h && table->eq(*link, v, table->cookie))
+            break;
+    return link;
+}
+
+// Returns `v` if inserted, the node equal to it otherwise, or NULL
+static struct htable_node *insert(struct htable *table,
+        struct htable_node *v, enum insert_policy policy) {
+    migrate(table, MIGRATE_STEP);
+    if (table->nmemb >= table->nbuckets)
+        grow(table);
+    if (!table->nbuckets)
+        return NULL;
+
+    uint64_t h = hash(table, v);
+    v->hash = h;
+    if (policy == ALLOW_MULTI) {
+        struct htable_node **b = bucket(table, h);
+        v->next = *b;
+        *b = v;
+        ++table->nmemb;
+        return v;
+    }
+
+    struct htable_node **link = find_link(table, v, h);
+    struct htable_node *found = *link;
+    // Re-inserting a node already in the table leaves it as it is
+    if (found && (found == v || policy == KEEP_OLD))
+        return found;
+
+    *link = v;
+    if (found) {
+        v->next = found->next;
+        found->next = NULL;
+        return found;
+    }
+    v->next = NULL;
+    ++table->nmemb;
+
+    return v;
+}
+
+// Any node equal to `v` unless `exact`
+static struct htable_node *remove_node(struct htable *table,
+        struct htable_node *v, bool exact) {
+    migrate(table, MIGRATE_STEP);
+    if (!table->nmemb)
+        return NULL;
+
+    uint64_t h = exact ? v->hash : hash(table, v);
+    struct htable_node **link = bucket(table, h);
+    for (; *link; link = &(*link)->next) {
+        struct htable_node *cur = *link;
+        if (exact ? cur == v
+                : cur->hash == h && table->eq(cur, v, table->cookie)) {
+            *link = cur->next;
+            cur->next = NULL;
+            --table->nmemb;
+            return cur;
+        }
+    }
+
+    return NULL;
+}
+
+void htable_init(struct htable *table,
+        htable_hash_f hash, htable_eq_f eq, void *cookie) {
+    if (!table)
+        return;
+
+    table->hash = hash;
+    table->eq = eq;
+    table->cookie = cookie;
+    table->buckets = NULL;
+    table->nbuckets = 0;
+    table->old = NULL;
+    table->nold = 0;
+    table->migrated = 0;
+    table->nmemb = 0;
+}
+
+void htable_clear(struct htable *table,
+        void (*dtor)(struct htable_node *n, void *cookie), void *cookie) {
+    if (!table)
+        return;
+
+    if (dtor)
+        htable_map(table, dtor, cookie);
+    free(table->buckets);
+    free(table->old);
+    htable_init(table, table->hash, table->eq, table->cookie);
+}
+
+bool htable_insert(struct htable *table,
+        struct htable_node *v, struct htable_node **inserted) {
+    if (!table || !v)
+        return false;
+
+    struct htable_node *n = insert(table, v, KEEP_OLD);
+    if (inserted)
+        *inserted = n;
+
+    return n == v;
+}
+
+struct htable_node *htable_insert_or_update(struct htable *table,
+        struct htable_node *v) {
+    if (!table || !v)
+        return NULL;
+
+    struct htable_node *previous = insert(table, v, REPLACE_OLD);
+    if (!previous)
+        return v;
+    return previous == v ? NULL : previous;
+}
+
+bool htable_insert_multi(struct htable *table, struct htable_node *v) {
+    if (!table || !v)
+        return false;
+    return insert(table, v, ALLOW_MULTI) != NULL;
+}
+
+struct htable_node *htable_remove(struct htable *table,
+        struct htable_node *v) {
+    if (!table || !v)
+        return NULL;
+    return remove_node(table, v, false);
+}
+
+bool htable_remove_at(struct htable *table, struct htable_node *v) {
+    if (!table || !v)
+        return false;
+    return remove_node(table, v, true) == v;
+}
+
+struct htable_node *htable_find(const struct htable *table,
+        const struct htable_node *v) {
+    if (!table || !v || !table->nmemb)
+        return NULL;
+    return *find_link(table, v, hash(table, v));
+}
+
+bool htable_empty(const struct htable *table) {
+    return htable_size(table) == 0;
+}
+
+size_t htable_size(const struct htable *table) {
+    if (!table)
+        return 0;
+    return table->nmemb;
+}
+
+// Unlinks every node of `more` into one chain
+static struct htable_node *take_all(struct htable *more) {
+    struct htable_node *chain = NULL;
+
+    migrate(more, more->nold);
+    for (size_t i = 0; i < more->nbuckets; ++i) {
+        struct htable_node *cur = more->buckets[i];
+        while (cur) {
+            struct htable_node *next = cur->next;
+            cur->next = chain;
+            chain = cur;
+            cur = next;
+        }
+    }
+    htable_clear(more, NULL, NULL);
+
+    return chain;
+}
+
+void htable_merge(struct htable *table, struct htable *more) {
+    if (!table || !more)
+        return;
+
+    struct htable_node *cur = take_all(more);
+    while (cur) {
+        struct htable_node *next = cur->next;
+        if (!htable_insert(table, cur, NULL)) // Keep old value
+            htable_insert_multi(more, cur);
+        cur = next;
+    }
+}
+
+void htable_update(struct htable *table, struct htable *more) {
+    if (!table || !more)
+        return;
+
+    struct htable_node *cur = take_all(more);
+    while (cur) {
+        struct htable_node *next = cur->next;
+        struct htable_node *v = htable_insert_or_update(table, cur);
+        if (v) // Keep new value
+            htable_insert_multi(more, v);
+        cur = next;
+    }
+}
+
+void htable_merge_all(struct htable *table, struct htable *more) {
+    if (!table || !more)
+        return;
+
+    struct htable_node *cur = take_all(more);
+    while (cur) {
+        struct htable_node *next = cur->next;
+        if (!htable_insert_multi(table, cur))
+            htable_insert_multi(more, cur);
+        cur = next;
+    }
+}
+
+static void map_chains(struct htable_node **buckets, size_t from, size_t to,
+        htable_map_f map, void *cookie) {
+    for (size_t i = from; i < to; ++i) {
+        struct htable_node *cur = buckets[i];
+        while (cur) {
+            // `map` may free the node
+            struct htable_node *next = cur->next;
+            map(cur, cookie);
+            cur = next;
+        }
+    }
+}
+
+void htable_map(struct htable *table, htable_map_f map, void *cookie) {
+    if (!table || !map)
+        return;
+
+    if (table->old)
+        map_chains(table->old, table->migrated, table->nold, map, cookie);
+    map_chains(table->buckets, 0, table->nbuckets, map, cookie);
+}
@@ -1,5 +1,7 @@
 #include "tupperware/list.h"
 
+#include <stdlib.h>
+
 void list_init(struct list *list) {
     if (!list)
         return;
@@ -151,6 +153,57 @@ void list_concat(struct list *begin, struct list *end) {
     end->head = NULL;
 }
 
+void list_splice(struct list *list, struct list_node *at, struct list *other) {
+    if (!list || !other || !other->head)
+        return;
+
+    if (!at || !list->head) {
+        list_concat(list, other);
+        return;
+    }
+
+    list_node_concat(at, other->head);
+    if (list->head == at)
+        list->head = other->head;
+    other->head = NULL;
+}
+
+// Cuts the circle of `list` in front of `at`
+static void split_before(struct list *list,
+        struct list_node *at, struct list *tail) {
+    if (at == list->head) {
+        tail->head = at;
+        list->head = NULL;
+        return;
+    }
+
+    struct list_node *last = list->head->prev;
+    struct list_node *prev = at->prev;
+
+    prev->next = list->head;
+    list->head->prev = prev;
+    at->prev = last;
+    last->next = at;
+    tail->head = at;
+}
+
+void list_split_at(struct list *list, size_t pos, struct list *tail) {
+    if (!list || !tail)
+        return;
+
+    tail->head = NULL;
+    if (!list->head)
+        return;
+
+    struct list_node *at = list->head;
+    for (size_t i = 0; i < pos; ++i) {
+        at = at->next;
+        if (at == list->head)
+            return;
+    }
+    split_before(list, at, tail);
+}
+
 void list_insert_sorted(struct list *list,
         struct list_node *n, list_cmp_f cmp, void *cookie) {
     if (!list || !n)
@@ -168,18 +221,79 @@ void list_insert_sorted(struct list *list,
     list_push_back(list, n);
 }
 
+// Merges two null-terminated runs linked through `next`, `a` wins ties
+static struct list_node *merge_runs(struct list_node *a, struct list_node *b,
+        list_cmp_f cmp, void *cookie) {
+    struct list_node *head = NULL;
+    struct list_node **tail = &head;
+
+    while (a && b) {
+        if (cmp(a, b, cookie) <= 0) {
+            *tail = a;
+            a = a->next;
+        } else {
+            *tail = b;
+            b = b->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = a ? a : b;
+
+    return head;
+}
+
+// Bottom-up merge sort, as in the Linux kernel: nodes are pushed one by one
+// on a stack of sorted runs chained through `prev`, and two runs of the same
+// size 2^k are merged as soon as a third one follows them. Runs are never
+// more than 2:1 unbalanced, which keeps it O(n log n) without recursion nor
+// knowing the length up front.
 void list_sort(struct list *list, list_cmp_f cmp, void *cookie) {
-    if (!list || !list->head)
+    if (!list || !list->head || list->head->next == list->head)
         return;
 
-    struct list_node *sorted = list_node_safe_detach(&list->head);
-    struct list_node *tmp = list->head;
-    list->head = sorted;
+    struct list_node *pending = NULL;
+    struct list_node *cur = list->head;
+    size_t count = 0;
+    list->head->prev->next = NULL;
+
+    do {
+        struct list_node **tail = &pending;
+        size_t bits = count;
+
+        // Skips the runs that have no equal-sized neighbour yet
+        for (; bits & 1; bits >>= 1)
+            tail = &(*tail)->prev;
+        if (bits) {
+            struct list_node *a = *tail;
+            struct list_node *b = a->prev;
+            a = merge_runs(b, a, cmp, cookie);
+            a->prev = b->prev;
+            *tail = a;
+        }
 
-    while (tmp) {
-        struct list_node *it = list_node_safe_detach(&tmp);
-        list_insert_sorted(list, it, cmp, cookie);
+        cur->prev = pending;
+        pending = cur;
+        cur = cur->next;
+        pending->next = NULL;
+        ++count;
+    } while (cur);
+
+    // Whatever is left is merged from the smallest run up
+    cur = pending;
+    pending = pending->prev;
+    while (pending) {
+        struct list_node *next = pending->prev;
+        cur = merge_runs(pending, cur, cmp, cookie);
+        pending = next;
     }
+
+    // Restores the back links and closes the circle
+    list->head = cur;
+    struct list_node *prev = cur;
+    for (cur = cur->next; cur; prev = cur, cur = cur->next)
+        cur->prev = prev;
+    prev->next = list->head;
+    list->head->prev = prev;
 }
 
 void list_merge_sorted(struct list *lhs,
@@ -206,6 +320,62 @@ void list_merge_sorted(struct list *lhs,
     list_concat(lhs, rhs);
 }
 
+// Exhausted lists lose against everything, ties go to the first list
+static bool beats(const struct list *lists, size_t lhs, size_t rhs,
+        list_cmp_f cmp, void *cookie) {
+    if (!lists[rhs].head)
+        return true;
+    if (!lists[lhs].head)
+        return false;
+
+    int res = cmp(lists[lhs].head, lists[rhs].head, cookie);
+    return res < 0 || (res == 0 && lhs < rhs);
+}
+
+bool list_kway_merge(struct list *res,
+        struct list *lists, size_t k, list_cmp_f cmp, void *cookie) {
+    if (!res || (!lists && k))
+        return false;
+    if (k <= 1) {
+        if (k)
+            list_concat(res, lists);
+        return true;
+    }
+
+    // Loser tree over k leaves: internal node p has children 2p and 2p + 1,
+    // leaf i sits at k + i, and `loser[p]` keeps the list that lost the match
+    // played at p. `winner` only serves to build it.
+    size_t *loser = malloc(2 * k * sizeof(*loser));
+    if (!loser)
+        return false;
+    size_t *winner = loser + k;
+
+    for (size_t p = k - 1; p >= 1; --p) {
+        size_t l = 2 * p < k ? winner[2 * p] : 2 * p - k;
+        size_t r = 2 * p + 1 < k ? winner[2 * p + 1] : 2 * p + 1 - k;
+        bool left = beats(lists, l, r, cmp, cookie);
+        winner[p] = left ? l : r;
+        loser[p] = left ? r : l;
+    }
+
+    // Only the path from the winner's leaf to the root is replayed
+    size_t cur = winner[1];
+    while (lists[cur].head) {
+        list_push_back(res, list_pop_front(&lists[cur]));
+        for (size_t p = (k + cur) / 2; p >= 1; p /= 2) {
+            if (beats(lists, loser[p], cur, cmp, cookie)) {
+                size_t tmp = loser[p];
+                loser[p] = cur;
+                cur = tmp;
+            }
+        }
+    }
+
+    free(loser);
+
+    return true;
+}
+
 void list_map(struct list *list, list_map_f map, void *cookie) {
     if (!list)
         return;
@@ -238,3 +408,161 @@ void list_filter(struct list *res,
         cur = cur->next;
     }
 }
+
+void counted_list_init(struct counted_list *list) {
+    if (!list)
+        return;
+    list_init(&list->list);
+    list->length = 0;
+}
+
+void counted_list_clear(struct counted_list *list,
+        void (*dtor)(struct list_node *n, void *cookie), void *cookie) {
+    if (!list)
+        return;
+    list_clear(&list->list, dtor, cookie);
+    list->length = 0;
+}
+
+void counted_list_push_back(struct counted_list *list, struct list_node *n) {
+    if (!list || !n)
+        return;
+    list_push_back(&list->list, n);
+    ++list->length;
+}
+
+void counted_list_push_front(struct counted_list *list, struct list_node *n) {
+    if (!list || !n)
+        return;
+    list_push_front(&list->list, n);
+    ++list->length;
+}
+
+struct list_node *counted_list_pop_front(struct counted_list *list) {
+    if (!list || !list->list.head)
+        return NULL;
+    --list->length;
+    return list_pop_front(&list->list);
+}
+
+struct list_node *counted_list_pop_back(struct counted_list *list) {
+    if (!list || !list->list.head)
+        return NULL;
+    --list->length;
+    return list_pop_back(&list->list);
+}
+
+struct list_node *counted_list_detach(struct counted_list *list,
+        struct list_node *n) {
+    if (!list || !n || !list->list.head)
+        return NULL;
+
+    --list->length;
+    if (list->list.head == n)
+        return list_node_safe_detach(&list->list.head);
+    return list_node_detach(n);
+}
+
+bool counted_list_empty(const struct counted_list *list) {
+    if (!list)
+        return true;
+    return list->length == 0;
+}
+
+size_t counted_list_length(const struct counted_list *list) {
+    if (!list)
+        return 0;
+    return list->length;
+}
+
+void counted_list_concat(struct counted_list *begin,
+        struct counted_list *end) {
+    if (!begin || !end)
+        return;
+
+    list_concat(&begin->list, &end->list);
+    begin->length += end->length;
+    end->length = 0;
+}
+
+void counted_list_splice(struct counted_list *list,
+        struct list_node *at, struct counted_list *other) {
+    if (!list || !other)
+        return;
+
+    list_splice(&list->list, at, &other->list);
+    list->length += other->length;
+    other->length = 0;
+}
+
+void counted_list_split_at(struct counted_list *list,
+        size_t pos, struct counted_list *tail) {
+    if (!list || !tail)
+        return;
+
+    counted_list_init(tail);
+    if (pos >= list->length)
+        return;
+
+    struct list_node *at = list->list.head;
+    if (pos <= list->length / 2) {
+        for (size_t i = 0; i < pos; ++i)
+            at = at->next;
+    } else {
+        for (size_t i = list->length; i > pos; --i)
+            at = at->prev;
+    }
+
+    split_before(&list->list, at, &tail->list);
+    tail->length = list->length - pos;
+    list->length = pos;
+}
+
+void counted_list_insert_sorted(struct counted_list *list,
+        struct list_node *n, list_cmp_f cmp, void *cookie) {
+    if (!list || !n)
+        return;
+    list_insert_sorted(&list->list, n, cmp, cookie);
+    ++list->length;
+}
+
+void counted_list_sort(struct counted_list *list,
+        list_cmp_f cmp, void *cookie) {
+    if (!list)
+        return;
+    list_sort(&list->list, cmp, cookie);
+}
+
+void counted_list_merge_sorted(struct counted_list *lhs,
+        struct counted_list *rhs, list_cmp_f cmp, void *cookie) {
+    if (!lhs || !rhs)
+        return;
+
+    list_merge_sorted(&lhs->list, &rhs->list, cmp, cookie);
+    lhs->length += rhs->length;
+    rhs->length = 0;
+}
+
+struct counting_filter {
+    list_filter_f filter;
+    void *cookie;
+    size_t count;
+};
+
+static bool counting_filter(struct list_node *n, void *cookie) {
+    struct counting_filter *f = cookie;
+    bool res = f->filter(n, f->cookie);
+    f->count += res;
+    return res;
+}
+
+void counted_list_filter(struct counted_list *res,
+        struct counted_list *list, list_filter_f filter, void *cookie) {
+    if (!res || !list)
+        return;
+
+    struct counting_filter f = { filter, cookie, 0 };
+    list_filter(&res->list, &list->list, counting_filter, &f);
+    res->length += f.count;
+    list->length -= f.count;
+}
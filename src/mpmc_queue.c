@@ -0,0 +1,238 @@
+#include "tupperware/mpmc_queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "futex.h"
+
+#define CELL_SEQ(Queue, Pos) \
+    ((size_t *)((char *)(Queue)->cells \
+        + (Queue)->stride * ((Pos) & (Queue)->mask)))
+#define CELL_DATA(Queue, Pos) ((void *)(CELL_SEQ(Queue, Pos) + 1))
+
+// Called after publishing `n` cells, pairs with the fence in `prepare_wait`
+static void wake_waiters(uint32_t *word, uint32_t *waiters, size_t n) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(waiters, __ATOMIC_RELAXED))
+        return;
+
+    __atomic_fetch_add(word, 1, __ATOMIC_RELEASE);
+    futex_wake(word, n);
+}
+
+// Returns the value to wait on, the caller must retry once before sleeping
+static uint32_t prepare_wait(uint32_t *word, uint32_t *waiters) {
+    uint32_t gen = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+    __atomic_fetch_add(waiters, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return gen;
+}
+
+static void cancel_wait(uint32_t *waiters) {
+    __atomic_fetch_sub(waiters, 1, __ATOMIC_RELAXED);
+}
+
+static size_t round_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        if (p > SIZE_MAX / 2)
+            return 0;
+        p *= 2;
+    }
+    return p;
+}
+
+bool mpmc_queue_init(struct mpmc_queue *q, size_t size, size_t cap) {
+    if (!q || !size || size > SIZE_MAX - 2 * sizeof(size_t))
+        return false;
+
+    cap = round_pow2(cap);
+    if (!cap)
+        return false;
+
+    size_t stride = sizeof(size_t) + size;
+    stride = (stride + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+
+    q->cells = calloc(cap, stride);
+    if (!q->cells)
+        return false;
+
+    q->size = size;
+    q->stride = stride;
+    q->mask = cap - 1;
+    q->enqueue_pos = 0;
+    q->dequeue_pos = 0;
+    q->not_empty = 0;
+    q->empty_waiters = 0;
+    q->not_full = 0;
+    q->full_waiters = 0;
+
+    for (size_t i = 0; i < cap; ++i)
+        *CELL_SEQ(q, i) = i;
+
+    return true;
+}
+
+void mpmc_queue_clear(struct mpmc_queue *q,
+        void (*dtor)(void *v, void *cookie), void *cookie) {
+    if (!q)
+        return;
+
+    if (dtor && q->cells)
+        for (size_t i = q->dequeue_pos; i != q->enqueue_pos; ++i)
+            dtor(CELL_DATA(q, i), cookie);
+
+    free(q->cells);
+    q->cells = NULL;
+    q->size = 0;
+    q->stride = 0;
+    q->mask = 0;
+    q->enqueue_pos = 0;
+    q->dequeue_pos = 0;
+}
+
+size_t mpmc_queue_length(const struct mpmc_queue *q) {
+    if (!q)
+        return 0;
+
+    size_t head = __atomic_load_n(&q->dequeue_pos, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&q->enqueue_pos, __ATOMIC_ACQUIRE);
+    return tail - head;
+}
+
+size_t mpmc_queue_capacity(const struct mpmc_queue *q) {
+    if (!q || !q->cells)
+        return 0;
+    return q->mask + 1;
+}
+
+size_t mpmc_queue_elem_size(const struct mpmc_queue *q) {
+    if (!q)
+        return 0;
+    return q->size;
+}
+
+bool mpmc_queue_empty(const struct mpmc_queue *q) {
+    return mpmc_queue_length(q) == 0;
+}
+
+// Claim up to `n` consecutive cells at `*pos`, which must have sequence
+// `*pos + i + offset`. Returns the number of cells claimed.
+static size_t claim(struct mpmc_queue *q, size_t *pos_ptr,
+        size_t offset, size_t n, size_t *pos) {
+    *pos = __atomic_load_n(pos_ptr, __ATOMIC_RELAXED);
+    for (;;) {
+        size_t k = 0;
+        for (; k < n; ++k) {
+            size_t seq =
+                __atomic_load_n(CELL_SEQ(q, *pos + k), __ATOMIC_ACQUIRE);
+            if (seq != *pos + k + offset)
+                break;
+        }
+
+        if (!k) {
+            size_t seq = __atomic_load_n(CELL_SEQ(q, *pos), __ATOMIC_ACQUIRE);
+            if ((ptrdiff_t)(seq - (*pos + offset)) < 0)
+                return 0; // Full, or empty, depending on the side
+            *pos = __atomic_load_n(pos_ptr, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        if (__atomic_compare_exchange_n(pos_ptr, pos, *pos + k,
+                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return k;
+    }
+}
+
+size_t mpmc_queue_try_push_n(struct mpmc_queue *q, void *elems, size_t n) {
+    if (!q || !elems || !n)
+        return 0;
+
+    size_t pos;
+    n = claim(q, &q->enqueue_pos, 0, n, &pos);
+
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(CELL_DATA(q, pos + i), (char *)elems + i * q->size, q->size);
+        __atomic_store_n(CELL_SEQ(q, pos + i), pos + i + 1, __ATOMIC_RELEASE);
+    }
+
+    if (n)
+        wake_waiters(&q->not_empty, &q->empty_waiters, n);
+
+    return n;
+}
+
+size_t mpmc_queue_try_pop_n(struct mpmc_queue *q, void *output, size_t n) {
+    if (!q || !n)
+        return 0;
+
+    size_t pos;
+    n = claim(q, &q->dequeue_pos, 1, n, &pos);
+
+    for (size_t i = 0; i < n; ++i) {
+        if (output)
+            memcpy((char *)output + i * q->size,
+                    CELL_DATA(q, pos + i),
+                    q->size);
+        __atomic_store_n(CELL_SEQ(q, pos + i),
+                pos + i + q->mask + 1, __ATOMIC_RELEASE);
+    }
+
+    if (n)
+        wake_waiters(&q->not_full, &q->full_waiters, n);
+
+    return n;
+}
+
+bool mpmc_queue_try_push(struct mpmc_queue *q, void *elem) {
+    return mpmc_queue_try_push_n(q, elem, 1) == 1;
+}
+
+bool mpmc_queue_try_pop(struct mpmc_queue *q, void *output) {
+    if (!q)
+        return false;
+    return mpmc_queue_try_pop_n(q, output, 1) == 1;
+}
+
+bool mpmc_queue_push_n(struct mpmc_queue *q, void *elems, size_t n) {
+    if (!q || !elems)
+        return false;
+
+    size_t pushed = mpmc_queue_try_push_n(q, elems, n);
+    while (pushed < n) {
+        uint32_t gen = prepare_wait(&q->not_full, &q->full_waiters);
+        size_t ret = mpmc_queue_try_push_n(q,
+                (char *)elems + pushed * q->size, n - pushed);
+        if (!ret)
+            futex_wait(&q->not_full, gen);
+        cancel_wait(&q->full_waiters);
+        pushed += ret;
+    }
+
+    return true;
+}
+
+size_t mpmc_queue_pop_n(struct mpmc_queue *q, void *output, size_t n) {
+    if (!q || !n)
+        return 0;
+
+    size_t popped = mpmc_queue_try_pop_n(q, output, n);
+    while (!popped) {
+        uint32_t gen = prepare_wait(&q->not_empty, &q->empty_waiters);
+        popped = mpmc_queue_try_pop_n(q, output, n);
+        if (!popped)
+            futex_wait(&q->not_empty, gen);
+        cancel_wait(&q->empty_waiters);
+    }
+
+    return popped;
+}
+
+bool mpmc_queue_push(struct mpmc_queue *q, void *elem) {
+    return mpmc_queue_push_n(q, elem, 1);
+}
+
+bool mpmc_queue_pop(struct mpmc_queue *q, void *output) {
+    return mpmc_queue_pop_n(q, output, 1) == 1;
+}
@@ -0,0 +1,123 @@
+#include "tupperware/mpsc_queue.h"
+
+static struct list_node *load_next(struct list_node *n) {
+    return __atomic_load_n(&n->next, __ATOMIC_ACQUIRE);
+}
+
+void mpsc_queue_init(struct mpsc_queue *q) {
+    if (!q)
+        return;
+
+    q->stub = LIST_NODE_INIT_VAL;
+    q->head = &q->stub;
+    q->tail = &q->stub;
+}
+
+bool mpsc_queue_empty(const struct mpsc_queue *q) {
+    if (!q)
+        return true;
+
+    return q->tail == &q->stub
+        && __atomic_load_n(&q->stub.next, __ATOMIC_ACQUIRE) == NULL;
+}
+
+void mpsc_queue_push(struct mpsc_queue *q, struct list_node *n) {
+    if (!q || !n)
+        return;
+
+    n->next = NULL;
+    struct list_node *prev =
+        __atomic_exchange_n(&q->head, n, __ATOMIC_ACQ_REL);
+    // Consumers cannot go past `prev` until this store is done
+    __atomic_store_n(&prev->next, n, __ATOMIC_RELEASE);
+}
+
+static struct list_node *detached(struct list_node *n) {
+    n->next = n;
+    n->prev = n;
+    return n;
+}
+
+struct list_node *mpsc_queue_pop(struct mpsc_queue *q) {
+    if (!q)
+        return NULL;
+
+    struct list_node *tail = q->tail;
+    struct list_node *next = load_next(tail);
+
+    if (tail == &q->stub) {
+        if (!next)
+            return NULL;
+        q->tail = next;
+        tail = next;
+        next = load_next(next);
+    }
+
+    if (next) {
+        q->tail = next;
+        return detached(tail);
+    }
+
+    // `tail` is the last node, unless a push has not linked its node yet
+    if (tail != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    // Put back the stub so that `tail` can be taken out
+    mpsc_queue_push(q, &q->stub);
+    next = load_next(tail);
+    if (next) {
+        q->tail = next;
+        return detached(tail);
+    }
+
+    return NULL;
+}
+
+void mpsc_queue_drain(struct mpsc_queue *q, struct list *res) {
+    if (!q || !res)
+        return;
+
+    struct list_node *first = NULL;
+    struct list_node *last = NULL;
+    struct list_node *cur = q->tail;
+
+    // Same walk as `mpsc_queue_pop`, but only fixing up the back links
+    for (;;) {
+        struct list_node *next = load_next(cur);
+
+        if (cur == &q->stub) {
+            if (!next)
+                break;
+            cur = next;
+            continue;
+        }
+
+        if (!next) {
+            if (cur != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE))
+                break;
+            mpsc_queue_push(q, &q->stub);
+            next = load_next(cur);
+            if (!next)
+                break;
+        }
+
+        if (!first) {
+            first = cur;
+        } else {
+            last->next = cur;
+            cur->prev = last;
+        }
+        last = cur;
+        cur = next;
+    }
+
+    q->tail = cur;
+    if (!first)
+        return;
+
+    last->next = first;
+    first->prev = last;
+
+    struct list batch = { first };
+    list_concat(res, &batch);
+}
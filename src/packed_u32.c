@@ -0,0 +1,411 @@
+#include "tupperware/packed_u32.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#ifdef TUPPERWARE_X86
+#include <immintrin.h>
+#endif
+
+// Element `k` of a block is in lane `k % LANES`. Each lane packs its values in
+// `width` words, interleaved with the other lanes so that one SIMD load gets a
+// word of each.
+#define LANES 4
+#define PER_LANE (PACKED_U32_BLOCK / LANES)
+
+// Decodes the differences of a block and adds them up from `first`
+typedef void (*decode_f)(const uint32_t *words, unsigned width,
+        uint32_t first, uint32_t *out);
+
+static uint32_t width_mask(unsigned width) {
+    return width < 32 ? (UINT32_C(1) << width) - 1 : UINT32_MAX;
+}
+
+static void pack(const uint32_t *deltas, unsigned width, uint32_t *words) {
+    if (!width)
+        return;
+
+    memset(words, 0, width * LANES * sizeof(*words));
+    for (size_t k = 0; k < PACKED_U32_BLOCK; ++k) {
+        size_t bit = k / LANES * width;
+        uint32_t *w = words + bit / 32 * LANES + k % LANES;
+        unsigned shift = bit % 32;
+
+        w[0] |= deltas[k] << shift;
+        if (shift + width > 32)
+            w[LANES] |= deltas[k] >> (32 - shift);
+    }
+}
+
+static void decode_scalar(const uint32_t *words, unsigned width,
+        uint32_t first, uint32_t *out) {
+    uint32_t mask = width_mask(width);
+    uint32_t acc = first;
+
+    for (size_t k = 0; k < PACKED_U32_BLOCK; ++k) {
+        if (width) {
+            size_t bit = k / LANES * width;
+            const uint32_t *w = words + bit / 32 * LANES + k % LANES;
+            unsigned shift = bit % 32;
+
+            uint32_t d = w[0] >> shift;
+            if (shift + width > 32)
+                d |= w[LANES] << (32 - shift);
+            acc += d & mask;
+        }
+        out[k] = acc;
+    }
+}
+
+#ifdef TUPPERWARE_X86
+
+#define SSE2 __attribute__((target("sse2")))
+
+// Decodes the four lanes at once, then adds up the four differences of each
+// vector on top of the last element so far. Inlined for every width, so that
+// the loop is unrolled with constant shifts.
+SSE2 static inline __attribute__((always_inline)) void unpack_sse2(
+        const __m128i *in, const unsigned width, __m128i acc, uint32_t *out) {
+    __m128i mask = _mm_set1_epi32(width_mask(width));
+    __m128i cur = _mm_setzero_si128();
+    unsigned shift = 0;
+
+    if (width)
+        cur = _mm_loadu_si128(in++);
+
+#pragma GCC unroll 32
+    for (size_t j = 0; j < PER_LANE; ++j) {
+        __m128i d = _mm_srli_epi32(cur, shift);
+        shift += width;
+        // The last value always ends on a word boundary
+        if (shift >= 32 && j + 1 < PER_LANE) {
+            shift -= 32;
+            cur = _mm_loadu_si128(in++);
+            if (shift)
+                d = _mm_or_si128(d, _mm_slli_epi32(cur, width - shift));
+        }
+        d = _mm_and_si128(d, mask);
+
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+        acc = _mm_add_epi32(d, acc);
+        _mm_storeu_si128((__m128i *)(out + LANES * j), acc);
+        acc = _mm_shuffle_epi32(acc, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+}
+
+#define UNPACK_CASE(Width) \
+    case Width: unpack_sse2(in, Width, acc, out); break;
+
+SSE2 static void decode_sse2(const uint32_t *words, unsigned width,
+        uint32_t first, uint32_t *out) {
+    const __m128i *in = (const __m128i *)words;
+    __m128i acc = _mm_set1_epi32(first);
+
+    switch (width) {
+    UNPACK_CASE(0) UNPACK_CASE(1) UNPACK_CASE(2) UNPACK_CASE(3)
+    UNPACK_CASE(4) UNPACK_CASE(5) UNPACK_CASE(6) UNPACK_CASE(7)
+    UNPACK_CASE(8) UNPACK_CASE(9) UNPACK_CASE(10) UNPACK_CASE(11)
+    UNPACK_CASE(12) UNPACK_CASE(13) UNPACK_CASE(14) UNPACK_CASE(15)
+    UNPACK_CASE(16) UNPACK_CASE(17) UNPACK_CASE(18) UNPACK_CASE(19)
+    UNPACK_CASE(20) UNPACK_CASE(21) UNPACK_CASE(22) UNPACK_CASE(23)
+    UNPACK_CASE(24) UNPACK_CASE(25) UNPACK_CASE(26) UNPACK_CASE(27)
+    UNPACK_CASE(28) UNPACK_CASE(29) UNPACK_CASE(30) UNPACK_CASE(31)
+    UNPACK_CASE(32)
+    }
+}
+
+#endif /* TUPPERWARE_X86 */
+
+static pthread_once_t decode_once = PTHREAD_ONCE_INIT;
+static decode_f decode_impl = decode_scalar;
+
+static void init_decode(void) {
+#ifdef TUPPERWARE_X86
+    if (cpu_level() >= CPU_SSE2)
+        decode_impl = decode_sse2;
+#endif
+}
+
+static void decode_block(const struct packed_u32 *p, size_t b, uint32_t *out) {
+    const struct packed_u32_block *block = &p->blocks[b];
+
+    pthread_once(&decode_once, init_decode);
+    decode_impl(p->words + block->offset, block->width, block->first, out);
+}
+
+static size_t block_length(const struct packed_u32 *p, size_t b) {
+    size_t begin = b * PACKED_U32_BLOCK;
+    return p->nmemb - begin < PACKED_U32_BLOCK
+        ? p->nmemb - begin
+        : PACKED_U32_BLOCK;
+}
+
+// Differences from the previous element, the first one is in the index and
+// the last block is padded with zeros
+static unsigned block_deltas(const uint32_t *arr, size_t n, uint32_t *deltas) {
+    uint32_t all = 0;
+
+    deltas[0] = 0;
+    for (size_t k = 1; k < n; ++k) {
+        deltas[k] = arr[k] - arr[k - 1];
+        all |= deltas[k];
+    }
+    for (size_t k = n; k < PACKED_U32_BLOCK; ++k)
+        deltas[k] = 0;
+
+    return all ? 32 - __builtin_clz(all) : 0;
+}
+
+bool packed_u32_init(struct packed_u32 *p, const struct vector *v) {
+    if (!p || !v || v->size != sizeof(uint32_t))
+        return false;
+
+    const uint32_t *arr = v->arr;
+    for (size_t i = 1; i < v->nmemb; ++i)
+        if (arr[i] < arr[i - 1])
+            return false;
+
+    memset(p, 0, sizeof(*p));
+    if (!v->nmemb)
+        return true;
+
+    p->nmemb = v->nmemb;
+    p->nblocks = (v->nmemb + PACKED_U32_BLOCK - 1) / PACKED_U32_BLOCK;
+    p->blocks = calloc(p->nblocks, sizeof(*p->blocks));
+    if (!p->blocks)
+        return false;
+
+    // Widths first, to allocate the words at once
+    uint32_t deltas[PACKED_U32_BLOCK];
+    size_t nwords = 0;
+    for (size_t b = 0; b < p->nblocks; ++b) {
+        const uint32_t *first = arr + b * PACKED_U32_BLOCK;
+        struct packed_u32_block *block = &p->blocks[b];
+        block->first = *first;
+        block->width = block_deltas(first, block_length(p, b), deltas);
+        block->offset = nwords;
+        nwords += block->width * LANES;
+    }
+
+    p->words = malloc((nwords ? nwords : 1) * sizeof(*p->words));
+    if (!p->words) {
+        free(p->blocks);
+        return false;
+    }
+
+    for (size_t b = 0; b < p->nblocks; ++b) {
+        struct packed_u32_block *block = &p->blocks[b];
+        block_deltas(arr + b * PACKED_U32_BLOCK, block_length(p, b), deltas);
+        pack(deltas, block->width, p->words + block->offset);
+    }
+
+    return true;
+}
+
+void packed_u32_clear(struct packed_u32 *p) {
+    if (!p)
+        return;
+
+    free(p->words);
+    free(p->blocks);
+    memset(p, 0, sizeof(*p));
+}
+
+size_t packed_u32_length(const struct packed_u32 *p) {
+    if (!p)
+        return 0;
+    return p->nmemb;
+}
+
+size_t packed_u32_bytes(const struct packed_u32 *p) {
+    if (!p || !p->nblocks)
+        return 0;
+
+    const struct packed_u32_block *last = &p->blocks[p->nblocks - 1];
+    size_t nwords = last->offset + last->width * LANES;
+
+    return nwords * sizeof(*p->words) + p->nblocks * sizeof(*p->blocks);
+}
+
+bool packed_u32_at(const struct packed_u32 *p, size_t i, uint32_t *output) {
+    if (!p || !output || i >= p->nmemb)
+        return false;
+
+    uint32_t values[PACKED_U32_BLOCK];
+    decode_block(p, i / PACKED_U32_BLOCK, values);
+    *output = values[i % PACKED_U32_BLOCK];
+
+    return true;
+}
+
+bool packed_u32_decode(const struct packed_u32 *p, struct vector *res) {
+    if (!p || !res || res->size != sizeof(uint32_t))
+        return false;
+    if (!p->nmemb)
+        return true;
+    if (!vector_reserve(res, res->nmemb + p->nmemb))
+        return false;
+
+    // Full blocks are decoded in place, the last one goes through a buffer
+    uint32_t *out = (uint32_t *)res->arr + res->nmemb;
+    for (size_t b = 0; b < p->nblocks; ++b) {
+        size_t n = block_length(p, b);
+        if (n == PACKED_U32_BLOCK) {
+            decode_block(p, b, out);
+        } else {
+            uint32_t values[PACKED_U32_BLOCK];
+            decode_block(p, b, values);
+            memcpy(out, values, n * sizeof(*values));
+        }
+        out += n;
+    }
+    res->nmemb += p->nmemb;
+
+    return true;
+}
+
+void packed_u32_iter_init(struct packed_u32_iter *it,
+        const struct packed_u32 *p) {
+    if (!it)
+        return;
+
+    it->p = p;
+    it->block = SIZE_MAX;
+    it->pos = 0;
+}
+
+static void load_block(struct packed_u32_iter *it, size_t b) {
+    if (it->block == b)
+        return;
+
+    decode_block(it->p, b, it->values);
+    it->block = b;
+}
+
+bool packed_u32_next(struct packed_u32_iter *it, uint32_t *output) {
+    if (!it || !it->p || it->pos >= it->p->nmemb)
+        return false;
+
+    load_block(it, it->pos / PACKED_U32_BLOCK);
+    if (output)
+        *output = it->values[it->pos % PACKED_U32_BLOCK];
+    ++it->pos;
+
+    return true;
+}
+
+// Moves `it->pos` to the first element not less than `target`, with its block
+// loaded, false past the end
+static bool skip_to(struct packed_u32_iter *it, uint32_t target) {
+    const struct packed_u32 *p = it->p;
+    if (it->pos >= p->nmemb)
+        return false;
+
+    size_t b = it->pos / PACKED_U32_BLOCK;
+    load_block(it, b);
+    size_t end = block_length(p, b);
+
+    // Unless it is in the current block, last block starting before `target`,
+    // later ones only hold larger elements, and earlier ones smaller
+    if (it->values[end - 1] < target) {
+        size_t lo = b + 1;
+        size_t hi = p->nblocks;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (p->blocks[mid].first < target)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo - 1 == b) {
+            // The next block starts at `target` or later
+            it->pos = lo * PACKED_U32_BLOCK;
+            if (it->pos >= p->nmemb)
+                return false;
+            load_block(it, lo);
+            return true;
+        }
+
+        b = lo - 1;
+        it->pos = b * PACKED_U32_BLOCK;
+        load_block(it, b);
+        end = block_length(p, b);
+    }
+
+    size_t len = end;
+    size_t k = it->pos % PACKED_U32_BLOCK;
+    while (k < end) {
+        size_t mid = k + (end - k) / 2;
+        if (it->values[mid] < target)
+            k = mid + 1;
+        else
+            end = mid;
+    }
+    it->pos = b * PACKED_U32_BLOCK + k;
+
+    // The whole block was smaller, the answer starts the next one
+    if (k == len) {
+        if (it->pos >= p->nmemb)
+            return false;
+        load_block(it, it->pos / PACKED_U32_BLOCK);
+    }
+
+    return true;
+}
+
+bool packed_u32_seek(struct packed_u32_iter *it,
+        uint32_t target, uint32_t *output) {
+    if (!it || !it->p || !skip_to(it, target))
+        return false;
+    return packed_u32_next(it, output);
+}
+
+bool packed_u32_intersection(struct vector *res,
+        const struct packed_u32 *lhs, const struct packed_u32 *rhs) {
+    if (!res || !lhs || !rhs || res->size != sizeof(uint32_t))
+        return false;
+
+    struct packed_u32_iter l;
+    struct packed_u32_iter r;
+    packed_u32_iter_init(&l, lhs);
+    packed_u32_iter_init(&r, rhs);
+
+    // Each side skips to the other's current element, then the rest of both
+    // blocks are merged
+    if (!skip_to(&l, 0))
+        return true;
+    for (;;) {
+        if (!skip_to(&r, l.values[l.pos % PACKED_U32_BLOCK]))
+            break;
+        if (!skip_to(&l, r.values[r.pos % PACKED_U32_BLOCK]))
+            break;
+
+        size_t i = l.pos % PACKED_U32_BLOCK;
+        size_t j = r.pos % PACKED_U32_BLOCK;
+        size_t nl = block_length(lhs, l.block);
+        size_t nr = block_length(rhs, r.block);
+        size_t n = nl - i < nr - j ? nl - i : nr - j;
+        if (!vector_reserve(res, res->nmemb + n))
+            return false;
+
+        uint32_t *out = (uint32_t *)res->arr + res->nmemb;
+        uint32_t *begin = out;
+        while (i < nl && j < nr) {
+            uint32_t x = l.values[i];
+            uint32_t y = r.values[j];
+            *out = x;
+            out += x == y;
+            i += x <= y;
+            j += y <= x;
+        }
+        res->nmemb += out - begin;
+        l.pos = l.block * PACKED_U32_BLOCK + i;
+        r.pos = r.block * PACKED_U32_BLOCK + j;
+    }
+
+    return true;
+}
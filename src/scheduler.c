@@ -0,0 +1,365 @@
+#include "tupperware/scheduler.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "futex.h"
+
+// Rounds of looking for work before going to sleep
+#define IDLE_SPINS 64
+
+#define DEQUE_MASK (SCHEDULER_DEQUE_SIZE - 1)
+
+static __thread struct scheduler_worker *current;
+
+static bool deque_push(struct scheduler_worker *w, struct scheduler_job *job) {
+    int64_t b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+    if (b - t >= SCHEDULER_DEQUE_SIZE)
+        return false;
+
+    __atomic_store_n(&w->jobs[b & DEQUE_MASK], job, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+static struct scheduler_job *deque_pop(struct scheduler_worker *w) {
+    int64_t b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&w->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&w->top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    struct scheduler_job *job =
+        __atomic_load_n(&w->jobs[b & DEQUE_MASK], __ATOMIC_RELAXED);
+    if (t == b) {
+        // Last job, race against thieves for it
+        if (!__atomic_compare_exchange_n(&w->top, &t, t + 1,
+                    false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            job = NULL;
+        __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return job;
+}
+
+static struct scheduler_job *deque_steal(struct scheduler_worker *w) {
+    int64_t t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&w->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b)
+        return NULL;
+
+    struct scheduler_job *job =
+        __atomic_load_n(&w->jobs[t & DEQUE_MASK], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&w->top, &t, t + 1,
+                false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+
+    return job;
+}
+
+static struct scheduler_job *take_injected(struct scheduler *s) {
+    if (!__atomic_load_n(&s->ninjected, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    struct list_node *n = NULL;
+    pthread_mutex_lock(&s->lock);
+    if (s->ninjected) {
+        n = list_pop_front(&s->injected);
+        __atomic_store_n(&s->ninjected, s->ninjected - 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return n ? CONTAINER_OF(struct scheduler_job, list, n) : NULL;
+}
+
+static uint32_t xorshift(uint32_t *seed) {
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *seed = x;
+}
+
+// `self` is NULL for threads outside of the pool
+static struct scheduler_job *find_job(struct scheduler *s,
+        struct scheduler_worker *self, uint32_t *seed) {
+    struct scheduler_job *job = NULL;
+
+    if (self && (job = deque_pop(self)))
+        return job;
+    if ((job = take_injected(s)))
+        return job;
+
+    size_t first = xorshift(seed) % s->nworkers;
+    for (size_t i = 0; i < s->nworkers; ++i) {
+        struct scheduler_worker *victim =
+            &s->workers[(first + i) % s->nworkers];
+        if (victim != self && (job = deque_steal(victim)))
+            return job;
+    }
+
+    return NULL;
+}
+
+// States of `scheduler_job.done`, the joiner sleeps on it once it is `WAITED`
+enum { JOB_PENDING, JOB_WAITED, JOB_DONE };
+
+static void run_job(struct scheduler *s, struct scheduler_job *job) {
+    job->fn(s, job->cookie);
+    if (__atomic_exchange_n(&job->done, JOB_DONE, __ATOMIC_RELEASE)
+            == JOB_WAITED)
+        futex_wake(&job->done, 1);
+}
+
+// Pairs with the fence in `worker_main`, see `mpmc_queue` for the protocol
+static void wake_workers(struct scheduler *s, size_t n) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&s->sleepers, __ATOMIC_RELAXED))
+        return;
+
+    __atomic_fetch_add(&s->epoch, 1, __ATOMIC_RELEASE);
+    futex_wake(&s->epoch, n);
+}
+
+static void *worker_main(void *arg) {
+    struct scheduler_worker *w = arg;
+    struct scheduler *s = w->s;
+    size_t idle = 0;
+
+    current = w;
+    for (;;) {
+        struct scheduler_job *job = find_job(s, w, &w->seed);
+        if (job) {
+            run_job(s, job);
+            idle = 0;
+            continue;
+        }
+
+        if (__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE))
+            return NULL;
+
+        if (++idle < IDLE_SPINS) {
+            sched_yield();
+            continue;
+        }
+
+        uint32_t epoch = __atomic_load_n(&s->epoch, __ATOMIC_ACQUIRE);
+        __atomic_fetch_add(&s->sleepers, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        job = find_job(s, w, &w->seed);
+        if (!job && !__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE))
+            futex_wait(&s->epoch, epoch);
+        __atomic_fetch_sub(&s->sleepers, 1, __ATOMIC_RELAXED);
+
+        if (job)
+            run_job(s, job);
+        idle = 0;
+    }
+}
+
+static void stop_workers(struct scheduler *s, size_t n) {
+    __atomic_store_n(&s->stop, true, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&s->epoch, 1, __ATOMIC_RELEASE);
+    futex_wake(&s->epoch, SIZE_MAX);
+
+    for (size_t i = 0; i < n; ++i)
+        pthread_join(s->workers[i].thread, NULL);
+}
+
+bool scheduler_init(struct scheduler *s, size_t nthreads) {
+    if (!s)
+        return false;
+
+    if (!nthreads) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    s->workers = calloc(nthreads, sizeof(*s->workers));
+    if (!s->workers)
+        return false;
+    if (pthread_mutex_init(&s->lock, NULL)) {
+        free(s->workers);
+        return false;
+    }
+
+    s->nworkers = nthreads;
+    list_init(&s->injected);
+    s->ninjected = 0;
+    s->stop = false;
+    s->epoch = 0;
+    s->sleepers = 0;
+
+    for (size_t i = 0; i < nthreads; ++i) {
+        struct scheduler_worker *w = &s->workers[i];
+        w->s = s;
+        w->seed = 2654435761u * (i + 1);
+        if (pthread_create(&w->thread, NULL, worker_main, w)) {
+            stop_workers(s, i);
+            pthread_mutex_destroy(&s->lock);
+            free(s->workers);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void scheduler_clear(struct scheduler *s) {
+    if (!s || !s->workers)
+        return;
+
+    stop_workers(s, s->nworkers);
+    pthread_mutex_destroy(&s->lock);
+    free(s->workers);
+
+    s->workers = NULL;
+    s->nworkers = 0;
+}
+
+size_t scheduler_threads(const struct scheduler *s) {
+    if (!s)
+        return 0;
+    return s->nworkers;
+}
+
+void scheduler_spawn(struct scheduler *s,
+        struct scheduler_job *job, scheduler_job_f fn, void *cookie) {
+    if (!job || !fn)
+        return;
+
+    job->fn = fn;
+    job->cookie = cookie;
+    job->done = JOB_PENDING;
+    job->list = LIST_NODE_INIT_VAL;
+
+    if (!s) {
+        run_job(s, job);
+        return;
+    }
+
+    struct scheduler_worker *w = current;
+    if (w && w->s == s) {
+        if (!deque_push(w, job)) {
+            run_job(s, job);
+            return;
+        }
+    } else {
+        pthread_mutex_lock(&s->lock);
+        list_push_back(&s->injected, &job->list);
+        __atomic_store_n(&s->ninjected, s->ninjected + 1, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&s->lock);
+    }
+
+    wake_workers(s, 1);
+}
+
+void scheduler_join(struct scheduler *s, struct scheduler_job *job) {
+    if (!s || !job)
+        return;
+
+    struct scheduler_worker *w = current;
+    if (w && w->s != s)
+        w = NULL;
+    uint32_t seed = w ? w->seed : (uint32_t)(uintptr_t)job | 1;
+
+    size_t idle = 0;
+    for (;;) {
+        uint32_t state = __atomic_load_n(&job->done, __ATOMIC_ACQUIRE);
+        if (state == JOB_DONE)
+            break;
+
+        struct scheduler_job *other = find_job(s, w, &seed);
+        if (other) {
+            run_job(s, other);
+            idle = 0;
+            continue;
+        }
+
+        // Workers keep looking for jobs, other threads sleep once there is
+        // nothing left to help with
+        if (w || ++idle < IDLE_SPINS) {
+            sched_yield();
+            continue;
+        }
+        if (state == JOB_PENDING
+                && !__atomic_compare_exchange_n(&job->done, &state,
+                    JOB_WAITED, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            continue;
+        futex_wait(&job->done, JOB_WAITED);
+    }
+
+    if (w)
+        w->seed = seed;
+}
+
+struct range {
+    size_t begin;
+    size_t end;
+    size_t grain;
+    scheduler_range_f fn;
+    void *cookie;
+};
+
+// Keep half of the range and offer the other half to thieves
+static void run_range(struct scheduler *s, void *cookie) {
+    struct range *r = cookie;
+
+    if (r->end - r->begin <= r->grain) {
+        r->fn(r->begin, r->end, r->cookie);
+        return;
+    }
+
+    size_t mid = r->begin + (r->end - r->begin) / 2;
+    struct range left = *r;
+    struct range right = *r;
+    left.end = mid;
+    right.begin = mid;
+
+    struct scheduler_job job;
+    scheduler_spawn(s, &job, run_range, &right);
+    run_range(s, &left);
+    scheduler_join(s, &job);
+}
+
+void scheduler_parallel_for(struct scheduler *s, size_t begin, size_t end,
+        size_t grain, scheduler_range_f fn, void *cookie) {
+    if (!fn || begin >= end)
+        return;
+
+    struct range r = {
+        .begin = begin,
+        .end = end,
+        .grain = grain ? grain : 1,
+        .fn = fn,
+        .cookie = cookie,
+    };
+
+    if (!s) {
+        for (size_t i = begin; i < end; i += r.grain)
+            fn(i, end - i > r.grain ? i + r.grain : end, cookie);
+        return;
+    }
+
+    // Splitting from outside of the pool would go through the injection list
+    struct scheduler_worker *w = current;
+    if (!w || w->s != s) {
+        struct scheduler_job job;
+        scheduler_spawn(s, &job, run_range, &r);
+        scheduler_join(s, &job);
+        return;
+    }
+
+    run_range(s, &r);
+}
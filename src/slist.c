@@ -0,0 +1,299 @@
+#include "tupperware/slist.h"
+
+#include <string.h>
+
+void slist_init(struct slist *list) {
+    if (!list)
+        return;
+    list->head = NULL;
+}
+
+void slist_clear(struct slist *list,
+        void (*dtor)(struct slist_node *n, void *cookie), void *cookie) {
+    if (!list)
+        return;
+
+    while (list->head) {
+        struct slist_node *tmp = slist_pop(list);
+        if (dtor)
+            dtor(tmp, cookie);
+    }
+}
+
+void slist_push(struct slist *list, struct slist_node *n) {
+    if (!list || !n)
+        return;
+
+    n->next = list->head;
+    list->head = n;
+}
+
+struct slist_node *slist_pop(struct slist *list) {
+    if (!list || !list->head)
+        return NULL;
+
+    struct slist_node *n = list->head;
+    list->head = n->next;
+    n->next = NULL;
+    return n;
+}
+
+struct slist_node *slist_peek(const struct slist *list) {
+    if (!list)
+        return NULL;
+    return list->head;
+}
+
+void slist_insert_next(struct slist_node *at, struct slist_node *n) {
+    if (!at || !n)
+        return;
+
+    n->next = at->next;
+    at->next = n;
+}
+
+struct slist_node *slist_remove_next(struct slist *list,
+        struct slist_node *at) {
+    if (!list)
+        return NULL;
+    if (!at)
+        return slist_pop(list);
+
+    struct slist_node *n = at->next;
+    if (!n)
+        return NULL;
+    at->next = n->next;
+    n->next = NULL;
+    return n;
+}
+
+bool slist_remove(struct slist *list, struct slist_node *n) {
+    if (!list || !n)
+        return false;
+
+    for (struct slist_node **it = &list->head; *it; it = &(*it)->next) {
+        if (*it == n) {
+            *it = n->next;
+            n->next = NULL;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool slist_empty(const struct slist *list) {
+    if (!list)
+        return true;
+    return list->head == NULL;
+}
+
+size_t slist_length(const struct slist *list) {
+    if (!list)
+        return 0;
+
+    size_t len = 0;
+    SLIST_FOREACH_CONST (*list, it)
+        ++len;
+    return len;
+}
+
+void slist_reverse(struct slist *list) {
+    if (!list)
+        return;
+
+    struct slist_node *res = NULL;
+    while (list->head) {
+        struct slist_node *n = list->head;
+        list->head = n->next;
+        n->next = res;
+        res = n;
+    }
+    list->head = res;
+}
+
+void slist_queue_init(struct slist_queue *q) {
+    if (!q)
+        return;
+    q->head = NULL;
+    q->tail = NULL;
+}
+
+void slist_queue_clear(struct slist_queue *q,
+        void (*dtor)(struct slist_node *n, void *cookie), void *cookie) {
+    if (!q)
+        return;
+
+    while (q->head) {
+        struct slist_node *tmp = slist_queue_pop_front(q);
+        if (dtor)
+            dtor(tmp, cookie);
+    }
+}
+
+void slist_queue_push_back(struct slist_queue *q, struct slist_node *n) {
+    if (!q || !n)
+        return;
+
+    n->next = NULL;
+    if (q->tail)
+        q->tail->next = n;
+    else
+        q->head = n;
+    q->tail = n;
+}
+
+void slist_queue_push_front(struct slist_queue *q, struct slist_node *n) {
+    if (!q || !n)
+        return;
+
+    n->next = q->head;
+    q->head = n;
+    if (!q->tail)
+        q->tail = n;
+}
+
+struct slist_node *slist_queue_pop_front(struct slist_queue *q) {
+    if (!q || !q->head)
+        return NULL;
+
+    struct slist_node *n = q->head;
+    q->head = n->next;
+    if (!q->head)
+        q->tail = NULL;
+    n->next = NULL;
+    return n;
+}
+
+bool slist_queue_empty(const struct slist_queue *q) {
+    if (!q)
+        return true;
+    return q->head == NULL;
+}
+
+size_t slist_queue_length(const struct slist_queue *q) {
+    if (!q)
+        return 0;
+
+    size_t len = 0;
+    SLIST_FOREACH_CONST (*q, it)
+        ++len;
+    return len;
+}
+
+void slist_queue_concat(struct slist_queue *begin, struct slist_queue *end) {
+    if (!begin || !end || !end->head)
+        return;
+
+    if (begin->tail)
+        begin->tail->next = end->head;
+    else
+        begin->head = end->head;
+    begin->tail = end->tail;
+    slist_queue_init(end);
+}
+
+// The double-width compare and swap is cmpxchg16b on x86-64, only the very
+// first CPUs of the family lack it
+#if UINTPTR_MAX == UINT32_MAX
+typedef uint64_t dword;
+#else
+__extension__ typedef unsigned __int128 dword;
+#endif
+
+#ifdef __x86_64__
+#define CX16 __attribute__((target("cx16")))
+#else
+#define CX16
+#endif
+
+static struct treiber_stack load(struct treiber_stack *s) {
+    // A torn read only makes the compare and swap fail
+    struct treiber_stack res;
+    res.tag = __atomic_load_n(&s->tag, __ATOMIC_ACQUIRE);
+    res.head = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+    return res;
+}
+
+// Updates `expected` with what was there on failure
+CX16 static bool cas(struct treiber_stack *s,
+        struct treiber_stack *expected, struct treiber_stack desired) {
+    dword old;
+    dword new;
+    memcpy(&old, expected, sizeof(old));
+    memcpy(&new, &desired, sizeof(new));
+
+    dword cur = __sync_val_compare_and_swap((dword *)s, old, new);
+    if (cur == old)
+        return true;
+    memcpy(expected, &cur, sizeof(cur));
+    return false;
+}
+
+void treiber_stack_init(struct treiber_stack *s) {
+    if (!s)
+        return;
+    s->head = NULL;
+    s->tag = 0;
+}
+
+bool treiber_stack_empty(const struct treiber_stack *s) {
+    if (!s)
+        return true;
+    return __atomic_load_n(&s->head, __ATOMIC_ACQUIRE) == NULL;
+}
+
+static void push_chain(struct treiber_stack *s,
+        struct slist_node *first, struct slist_node *last) {
+    struct treiber_stack cur = load(s);
+    do {
+        // Stale pops may still be reading it
+        __atomic_store_n(&last->next, cur.head, __ATOMIC_RELAXED);
+    } while (!cas(s, &cur, (struct treiber_stack){ first, cur.tag + 1 }));
+}
+
+void treiber_stack_push(struct treiber_stack *s, struct slist_node *n) {
+    if (!s || !n)
+        return;
+    push_chain(s, n, n);
+}
+
+struct slist_node *treiber_stack_pop(struct treiber_stack *s) {
+    if (!s)
+        return NULL;
+
+    struct treiber_stack cur = load(s);
+    while (cur.head) {
+        // May read a node popped meanwhile, the tag then fails the swap
+        struct slist_node *next = __atomic_load_n(&cur.head->next,
+                __ATOMIC_RELAXED);
+        if (cas(s, &cur, (struct treiber_stack){ next, cur.tag + 1 })) {
+            __atomic_store_n(&cur.head->next, NULL, __ATOMIC_RELAXED);
+            return cur.head;
+        }
+    }
+
+    return NULL;
+}
+
+void treiber_stack_push_list(struct treiber_stack *s, struct slist *list) {
+    if (!s || !list || !list->head)
+        return;
+
+    struct slist_node *last = list->head;
+    while (last->next)
+        last = last->next;
+    push_chain(s, list->head, last);
+    list->head = NULL;
+}
+
+void treiber_stack_pop_all(struct treiber_stack *s, struct slist *res) {
+    if (!s || !res)
+        return;
+
+    struct treiber_stack cur = load(s);
+    while (cur.head && !cas(s, &cur, (struct treiber_stack){ NULL,
+                cur.tag + 1 }))
+        ;
+    res->head = cur.head;
+}
@@ -0,0 +1,280 @@
+#include "tupperware/soa_vector.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define COL_AT(Col, Ind) ((char *)(Col)->arr + (Col)->size * (Ind))
+
+bool soa_vector_init(struct soa_vector *v,
+        const struct soa_field *fields, size_t nfields) {
+    if (!v || !fields || !nfields)
+        return false;
+
+    v->columns = calloc(nfields, sizeof(*v->columns));
+    v->fields = calloc(nfields, sizeof(*v->fields));
+    if (!v->columns || !v->fields)
+        goto error;
+
+    for (size_t i = 0; i < nfields; ++i)
+        if (!vector_init(&v->columns[i], fields[i].size))
+            goto error;
+
+    memcpy(v->fields, fields, nfields * sizeof(*fields));
+    v->nfields = nfields;
+
+    return true;
+
+error:
+    free(v->columns);
+    free(v->fields);
+    return false;
+}
+
+void soa_vector_clear(struct soa_vector *v) {
+    if (!v)
+        return;
+
+    for (size_t i = 0; i < v->nfields; ++i)
+        vector_clear(&v->columns[i], NULL, NULL);
+    free(v->columns);
+    free(v->fields);
+
+    v->columns = NULL;
+    v->fields = NULL;
+    v->nfields = 0;
+}
+
+// Columns that were grown stay so if another one fails, which is harmless
+bool soa_vector_reserve(struct soa_vector *v, size_t cap) {
+    if (!v)
+        return false;
+
+    for (size_t i = 0; i < v->nfields; ++i)
+        if (!vector_reserve(&v->columns[i], cap))
+            return false;
+
+    return true;
+}
+
+size_t soa_vector_length(const struct soa_vector *v) {
+    if (!v || !v->nfields)
+        return 0;
+    return v->columns[0].nmemb;
+}
+
+size_t soa_vector_fields(const struct soa_vector *v) {
+    if (!v)
+        return 0;
+    return v->nfields;
+}
+
+bool soa_vector_empty(const struct soa_vector *v) {
+    return soa_vector_length(v) == 0;
+}
+
+void *soa_vector_column(const struct soa_vector *v, size_t field) {
+    if (!v || field >= v->nfields)
+        return NULL;
+    return v->columns[field].arr;
+}
+
+void *soa_vector_at(const struct soa_vector *v, size_t field, size_t i) {
+    if (!v || field >= v->nfields)
+        return NULL;
+    return vector_at(&v->columns[field], i);
+}
+
+bool soa_vector_get(const struct soa_vector *v, void *record, size_t i) {
+    if (!v || !record || i >= soa_vector_length(v))
+        return false;
+
+    for (size_t f = 0; f < v->nfields; ++f)
+        memcpy((char *)record + v->fields[f].offset,
+                COL_AT(&v->columns[f], i), v->fields[f].size);
+
+    return true;
+}
+
+// Make room in every column first, so that no insertion can fail halfway
+static bool grow(struct soa_vector *v) {
+    size_t nmemb = soa_vector_length(v);
+
+    for (size_t i = 0; i < v->nfields; ++i) {
+        size_t cap = v->columns[i].cap;
+        if (nmemb < cap)
+            continue;
+        if (!vector_reserve(&v->columns[i], cap ? cap * 2 : 2))
+            return false;
+    }
+
+    return true;
+}
+
+bool soa_vector_push_back(struct soa_vector *v, const void *record) {
+    return soa_vector_insert_at(v, record, soa_vector_length(v));
+}
+
+bool soa_vector_insert_at(struct soa_vector *v, const void *record, size_t i) {
+    if (!v || !record || !grow(v))
+        return false;
+
+    for (size_t f = 0; f < v->nfields; ++f)
+        vector_insert_at(&v->columns[f],
+                (char *)record + v->fields[f].offset, i);
+
+    return true;
+}
+
+bool soa_vector_pop_back(struct soa_vector *v, void *record) {
+    return soa_vector_pop_at(v, record, soa_vector_length(v));
+}
+
+bool soa_vector_pop_at(struct soa_vector *v, void *record, size_t i) {
+    if (!v || !soa_vector_length(v))
+        return false;
+
+    for (size_t f = 0; f < v->nfields; ++f)
+        vector_pop_at(&v->columns[f],
+                record ? (char *)record + v->fields[f].offset : NULL, i);
+
+    return true;
+}
+
+// Keys are sorted along with their index so that comparisons do not have to
+// go through the permutation, the index is stored after the aligned key
+bool soa_vector_sort_by(struct soa_vector *v,
+        size_t field, vector_cmp_f cmp, void *cookie) {
+    if (!v || !cmp || field >= v->nfields)
+        return false;
+
+    size_t nmemb = soa_vector_length(v);
+    if (nmemb < 2)
+        return true;
+
+    const struct vector *key = &v->columns[field];
+    size_t index_offset = (key->size + sizeof(size_t) - 1)
+        / sizeof(size_t) * sizeof(size_t);
+    size_t max_size = 0;
+    for (size_t f = 0; f < v->nfields; ++f)
+        if (v->fields[f].size > max_size)
+            max_size = v->fields[f].size;
+
+    struct vector perm;
+    size_t entry_size = index_offset + sizeof(size_t);
+    char *buf = malloc(nmemb * max_size);
+    if (!buf || !vector_with_cap(&perm, entry_size, nmemb)) {
+        free(buf);
+        return false;
+    }
+
+    for (size_t i = 0; i < nmemb; ++i) {
+        char *entry = COL_AT(&perm, i);
+        memcpy(entry, COL_AT(key, i), key->size);
+        memcpy(entry + index_offset, &i, sizeof(i));
+    }
+    perm.nmemb = nmemb;
+
+    if (!vector_merge_sort(&perm, cmp, cookie)) {
+        vector_clear(&perm, NULL, NULL);
+        free(buf);
+        return false;
+    }
+
+    // Keep only the indices, packed at the front of the array
+    size_t *order = perm.arr;
+    for (size_t i = 0; i < nmemb; ++i)
+        memcpy(&order[i], COL_AT(&perm, i) + index_offset, sizeof(size_t));
+
+    for (size_t f = 0; f < v->nfields; ++f) {
+        struct vector *col = &v->columns[f];
+        for (size_t i = 0; i < nmemb; ++i)
+            memcpy(buf + i * col->size, COL_AT(col, order[i]), col->size);
+        memcpy(col->arr, buf, nmemb * col->size);
+    }
+
+    vector_clear(&perm, NULL, NULL);
+    free(buf);
+
+    return true;
+}
+
+void soa_vector_map(struct soa_vector *v,
+        size_t field, vector_map_f map, void *cookie) {
+    if (!v || field >= v->nfields)
+        return;
+
+    vector_map(&v->columns[field], map, cookie);
+}
+
+static bool same_fields(const struct soa_vector *lhs,
+        const struct soa_vector *rhs) {
+    if (lhs->nfields != rhs->nfields)
+        return false;
+
+    for (size_t f = 0; f < lhs->nfields; ++f)
+        if (lhs->fields[f].size != rhs->fields[f].size)
+            return false;
+
+    return true;
+}
+
+// Matching runs are appended to `res`, the others are moved down in place
+static void split_column(struct vector *res, struct vector *col,
+        const unsigned char *flags, size_t nmemb) {
+    char *kept = col->arr;
+
+    for (size_t i = 0; i < nmemb;) {
+        size_t j = i + 1;
+        while (j < nmemb && flags[j] == flags[i])
+            ++j;
+
+        size_t bytes = (j - i) * col->size;
+        if (flags[i]) {
+            memcpy(COL_AT(res, res->nmemb), COL_AT(col, i), bytes);
+            res->nmemb += j - i;
+        } else {
+            memmove(kept, COL_AT(col, i), bytes);
+            kept += bytes;
+        }
+
+        i = j;
+    }
+
+    col->nmemb = (kept - (char *)col->arr) / col->size;
+}
+
+bool soa_vector_filter(struct soa_vector *res, struct soa_vector *v,
+        size_t field, vector_filter_f filter, void *cookie) {
+    if (!v || !res || !filter || field >= v->nfields)
+        return false;
+    if (res == v || !same_fields(res, v))
+        return false;
+
+    size_t nmemb = soa_vector_length(v);
+    if (!nmemb)
+        return true;
+
+    unsigned char *flags = malloc(nmemb);
+    if (!flags)
+        return false;
+
+    // Only the filtered column is read while evaluating the predicate
+    const struct vector *key = &v->columns[field];
+    size_t matched = 0;
+    for (size_t i = 0; i < nmemb; ++i) {
+        flags[i] = filter(COL_AT(key, i), cookie);
+        matched += flags[i];
+    }
+
+    if (!soa_vector_reserve(res, soa_vector_length(res) + matched)) {
+        free(flags);
+        return false;
+    }
+
+    for (size_t f = 0; matched && f < v->nfields; ++f)
+        split_column(&res->columns[f], &v->columns[f], flags, nmemb);
+
+    free(flags);
+
+    return true;
+}
@@ -0,0 +1,189 @@
+#include "tupperware/spsc_ring.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RING_AT(Ring, Ind) \
+    ((void *)((char *)(Ring)->arr + ((Ring)->size * ((Ind) & (Ring)->mask))))
+
+static size_t round_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        if (p > SIZE_MAX / 2)
+            return 0;
+        p *= 2;
+    }
+    return p;
+}
+
+bool spsc_ring_init(struct spsc_ring *r, size_t size, size_t cap) {
+    if (!r || !size)
+        return false;
+
+    cap = round_pow2(cap);
+    if (!cap)
+        return false;
+
+    r->arr = calloc(cap, size);
+    if (!r->arr)
+        return false;
+
+    r->size = size;
+    r->mask = cap - 1;
+    r->tail = 0;
+    r->cached_head = 0;
+    r->head = 0;
+    r->cached_tail = 0;
+
+    return true;
+}
+
+void spsc_ring_clear(struct spsc_ring *r,
+        void (*dtor)(void *v, void *cookie), void *cookie) {
+    if (!r)
+        return;
+
+    if (dtor)
+        for (size_t i = r->head; i != r->tail; ++i)
+            dtor(RING_AT(r, i), cookie);
+
+    free(r->arr);
+    r->arr = NULL;
+    r->size = 0;
+    r->mask = 0;
+    r->tail = 0;
+    r->cached_head = 0;
+    r->head = 0;
+    r->cached_tail = 0;
+}
+
+size_t spsc_ring_length(const struct spsc_ring *r) {
+    if (!r)
+        return 0;
+
+    size_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    return tail - head;
+}
+
+size_t spsc_ring_capacity(const struct spsc_ring *r) {
+    if (!r || !r->arr)
+        return 0;
+    return r->mask + 1;
+}
+
+size_t spsc_ring_elem_size(const struct spsc_ring *r) {
+    if (!r)
+        return 0;
+    return r->size;
+}
+
+bool spsc_ring_empty(const struct spsc_ring *r) {
+    return spsc_ring_length(r) == 0;
+}
+
+// Copy `n` elements between `buf` and the ring starting at index `pos`
+static void copy_span(struct spsc_ring *r,
+        size_t pos, void *buf, size_t n, bool to_ring) {
+    size_t first = r->mask + 1 - (pos & r->mask);
+    if (first > n)
+        first = n;
+
+    char *rest = (char *)buf + first * r->size;
+    if (to_ring) {
+        memcpy(RING_AT(r, pos), buf, first * r->size);
+        memcpy(r->arr, rest, (n - first) * r->size);
+    } else {
+        memcpy(buf, RING_AT(r, pos), first * r->size);
+        memcpy(rest, r->arr, (n - first) * r->size);
+    }
+}
+
+static size_t producer_free(struct spsc_ring *r, size_t tail, size_t wanted) {
+    size_t cap = r->mask + 1;
+    size_t free_slots = cap - (tail - r->cached_head);
+
+    if (free_slots < wanted) {
+        r->cached_head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        free_slots = cap - (tail - r->cached_head);
+    }
+
+    return free_slots;
+}
+
+static size_t consumer_available(struct spsc_ring *r,
+        size_t head, size_t wanted) {
+    size_t available = r->cached_tail - head;
+
+    if (available < wanted) {
+        r->cached_tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        available = r->cached_tail - head;
+    }
+
+    return available;
+}
+
+bool spsc_ring_push(struct spsc_ring *r, void *elem) {
+    if (!r || !elem)
+        return false;
+
+    size_t tail = r->tail;
+    if (!producer_free(r, tail, 1))
+        return false;
+
+    memcpy(RING_AT(r, tail), elem, r->size);
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool spsc_ring_pop(struct spsc_ring *r, void *output) {
+    if (!r)
+        return false;
+
+    size_t head = r->head;
+    if (!consumer_available(r, head, 1))
+        return false;
+
+    if (output)
+        memcpy(output, RING_AT(r, head), r->size);
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+size_t spsc_ring_push_n(struct spsc_ring *r, void *elems, size_t n) {
+    if (!r || !elems || !n)
+        return 0;
+
+    size_t tail = r->tail;
+    size_t free_slots = producer_free(r, tail, n);
+    if (n > free_slots)
+        n = free_slots;
+    if (!n)
+        return 0;
+
+    copy_span(r, tail, elems, n, true);
+    __atomic_store_n(&r->tail, tail + n, __ATOMIC_RELEASE);
+
+    return n;
+}
+
+size_t spsc_ring_pop_n(struct spsc_ring *r, void *output, size_t n) {
+    if (!r || !n)
+        return 0;
+
+    size_t head = r->head;
+    size_t available = consumer_available(r, head, n);
+    if (n > available)
+        n = available;
+    if (!n)
+        return 0;
+
+    if (output)
+        copy_span(r, head, output, n, false);
+    __atomic_store_n(&r->head, head + n, __ATOMIC_RELEASE);
+
+    return n;
+}
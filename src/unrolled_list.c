@@ -0,0 +1,303 @@
+#include "tupperware/unrolled_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_OF(Node) CONTAINER_OF(struct unrolled_block, node, Node)
+
+#define SLOT(List, Block, I) \
+    ((void *)((Block)->data + ((Block)->head + (I)) * (List)->size))
+
+static struct unrolled_block *first(const struct unrolled_list *l) {
+    return l->blocks.head ? BLOCK_OF(l->blocks.head) : NULL;
+}
+
+static struct unrolled_block *last(const struct unrolled_list *l) {
+    return l->blocks.head ? BLOCK_OF(l->blocks.head->prev) : NULL;
+}
+
+// Not linked yet, `head` is where the first element will go
+static struct unrolled_block *new_block(struct unrolled_list *l,
+        size_t head) {
+    struct unrolled_block *b = l->spare;
+    if (b)
+        l->spare = NULL;
+    else
+        b = malloc(sizeof(*b) + l->per_block * l->size);
+    if (!b)
+        return NULL;
+
+    b->node = LIST_NODE_INIT_VAL;
+    b->head = head;
+    b->nmemb = 0;
+
+    return b;
+}
+
+static void free_block(struct unrolled_list *l, struct unrolled_block *b) {
+    if (l->blocks.head == &b->node)
+        list_node_safe_detach(&l->blocks.head);
+    else
+        list_node_detach(&b->node);
+
+    if (l->spare)
+        free(b);
+    else
+        l->spare = b;
+}
+
+// Block holding the `*i`-th element, `*i` becomes its index in there
+static struct unrolled_block *find(const struct unrolled_list *l, size_t *i) {
+    if (*i < l->nmemb / 2) {
+        struct unrolled_block *b = first(l);
+        while (*i >= b->nmemb) {
+            *i -= b->nmemb;
+            b = BLOCK_OF(b->node.next);
+        }
+        return b;
+    }
+
+    size_t from_end = l->nmemb - *i;
+    struct unrolled_block *b = last(l);
+    while (from_end > b->nmemb) {
+        from_end -= b->nmemb;
+        b = BLOCK_OF(b->node.prev);
+    }
+    *i = b->nmemb - from_end;
+    return b;
+}
+
+// Moves all of `next`, which follows `b`, at the end of `b`
+static void merge(struct unrolled_list *l,
+        struct unrolled_block *b, struct unrolled_block *next) {
+    memmove(b->data, SLOT(l, b, 0), b->nmemb * l->size);
+    b->head = 0;
+    memcpy(SLOT(l, b, b->nmemb), SLOT(l, next, 0), next->nmemb * l->size);
+    b->nmemb += next->nmemb;
+    free_block(l, next);
+}
+
+bool unrolled_list_init(struct unrolled_list *l, size_t size) {
+    if (!size)
+        return false;
+
+    size_t per_block = (UNROLLED_LIST_BLOCK_BYTES
+            - sizeof(struct unrolled_block)) / size;
+    return unrolled_list_with_block(l, size, per_block ? per_block : 1);
+}
+
+bool unrolled_list_with_block(struct unrolled_list *l,
+        size_t size, size_t per_block) {
+    if (!l || !size || !per_block)
+        return false;
+
+    list_init(&l->blocks);
+    l->spare = NULL;
+    l->size = size;
+    l->per_block = per_block;
+    l->nmemb = 0;
+
+    return true;
+}
+
+void unrolled_list_clear(struct unrolled_list *l,
+        void (*dtor)(void *v, void *cookie), void *cookie) {
+    if (!l)
+        return;
+
+    while (l->blocks.head) {
+        struct unrolled_block *b = BLOCK_OF(list_pop_front(&l->blocks));
+        if (dtor)
+            for (size_t i = 0; i < b->nmemb; ++i)
+                dtor(SLOT(l, b, i), cookie);
+        free(b);
+    }
+
+    free(l->spare);
+    l->spare = NULL;
+    l->size = 0;
+    l->per_block = 0;
+    l->nmemb = 0;
+}
+
+size_t unrolled_list_length(const struct unrolled_list *l) {
+    if (!l)
+        return 0;
+    return l->nmemb;
+}
+
+size_t unrolled_list_elem_size(const struct unrolled_list *l) {
+    if (!l)
+        return 0;
+    return l->size;
+}
+
+bool unrolled_list_empty(const struct unrolled_list *l) {
+    return unrolled_list_length(l) == 0;
+}
+
+void *unrolled_list_at(const struct unrolled_list *l, size_t i) {
+    if (!l || i >= l->nmemb)
+        return NULL;
+
+    struct unrolled_block *b = find(l, &i);
+    return SLOT(l, b, i);
+}
+
+bool unrolled_list_push_back(struct unrolled_list *l, void *elem) {
+    if (!l || !elem || !l->size)
+        return false;
+
+    struct unrolled_block *b = last(l);
+    if (!b || b->head + b->nmemb == l->per_block) {
+        b = new_block(l, 0);
+        if (!b)
+            return false;
+        list_push_back(&l->blocks, &b->node);
+    }
+
+    memcpy(SLOT(l, b, b->nmemb), elem, l->size);
+    ++b->nmemb;
+    ++l->nmemb;
+
+    return true;
+}
+
+bool unrolled_list_push_front(struct unrolled_list *l, void *elem) {
+    if (!l || !elem || !l->size)
+        return false;
+
+    struct unrolled_block *b = first(l);
+    if (!b || !b->head) {
+        b = new_block(l, l->per_block);
+        if (!b)
+            return false;
+        list_push_front(&l->blocks, &b->node);
+    }
+
+    --b->head;
+    memcpy(SLOT(l, b, 0), elem, l->size);
+    ++b->nmemb;
+    ++l->nmemb;
+
+    return true;
+}
+
+bool unrolled_list_pop_back(struct unrolled_list *l, void *output) {
+    if (!l || !l->nmemb)
+        return false;
+
+    struct unrolled_block *b = last(l);
+    --b->nmemb;
+    --l->nmemb;
+    if (output)
+        memcpy(output, SLOT(l, b, b->nmemb), l->size);
+    if (!b->nmemb)
+        free_block(l, b);
+
+    return true;
+}
+
+bool unrolled_list_pop_front(struct unrolled_list *l, void *output) {
+    if (!l || !l->nmemb)
+        return false;
+
+    struct unrolled_block *b = first(l);
+    if (output)
+        memcpy(output, SLOT(l, b, 0), l->size);
+    ++b->head;
+    --b->nmemb;
+    --l->nmemb;
+    if (!b->nmemb)
+        free_block(l, b);
+
+    return true;
+}
+
+bool unrolled_list_insert_at(struct unrolled_list *l, void *elem, size_t i) {
+    if (!l || !elem || i > l->nmemb)
+        return false;
+    if (i == l->nmemb)
+        return unrolled_list_push_back(l, elem);
+    if (i == 0)
+        return unrolled_list_push_front(l, elem);
+
+    struct unrolled_block *b = find(l, &i);
+
+    // Full, the upper half goes to a new block right after it
+    if (!b->head && b->nmemb == l->per_block) {
+        struct unrolled_block *next = new_block(l, 0);
+        if (!next)
+            return false;
+
+        size_t half = b->nmemb / 2;
+        next->nmemb = b->nmemb - half;
+        memcpy(SLOT(l, next, 0), SLOT(l, b, half), next->nmemb * l->size);
+        b->nmemb = half;
+        list_node_insert_next(&b->node, &next->node);
+
+        if (i > half) {
+            i -= half;
+            b = next;
+        }
+    }
+
+    if (b->head + b->nmemb < l->per_block) {
+        memmove(SLOT(l, b, i + 1), SLOT(l, b, i), (b->nmemb - i) * l->size);
+    } else {
+        --b->head;
+        memmove(SLOT(l, b, 0), SLOT(l, b, 1), i * l->size);
+    }
+    memcpy(SLOT(l, b, i), elem, l->size);
+    ++b->nmemb;
+    ++l->nmemb;
+
+    return true;
+}
+
+bool unrolled_list_pop_at(struct unrolled_list *l, void *output, size_t i) {
+    if (!l || i >= l->nmemb)
+        return false;
+
+    struct unrolled_block *b = find(l, &i);
+    if (output)
+        memcpy(output, SLOT(l, b, i), l->size);
+
+    // Closes the gap from the shorter side
+    if (i < b->nmemb / 2) {
+        memmove(SLOT(l, b, 1), SLOT(l, b, 0), i * l->size);
+        ++b->head;
+    } else {
+        memmove(SLOT(l, b, i), SLOT(l, b, i + 1),
+                (b->nmemb - i - 1) * l->size);
+    }
+    --b->nmemb;
+    --l->nmemb;
+
+    if (!b->nmemb) {
+        free_block(l, b);
+        return true;
+    }
+
+    // Keeps blocks at least half full on average
+    struct unrolled_block *prev = b != first(l) ? BLOCK_OF(b->node.prev) : NULL;
+    struct unrolled_block *next = b != last(l) ? BLOCK_OF(b->node.next) : NULL;
+    if (next && b->nmemb + next->nmemb <= l->per_block / 2)
+        merge(l, b, next);
+    else if (prev && prev->nmemb + b->nmemb <= l->per_block / 2)
+        merge(l, prev, b);
+
+    return true;
+}
+
+void unrolled_list_map(struct unrolled_list *l,
+        unrolled_list_map_f map, void *cookie) {
+    if (!l || !map)
+        return;
+
+    UNROLLED_LIST_FOREACH_BLOCK (*l, b) {
+        unsigned char *v = UNROLLED_BLOCK_BEGIN(*l, b);
+        for (size_t i = 0; i < b->nmemb; ++i, v += l->size)
+            map(v, cookie);
+    }
+}
@@ -564,6 +564,150 @@ bool vector_sort(struct vector *v, vector_cmp_f cmp, void *cookie) {
     return true;
 }
 
+bool vector_unique(struct vector *v, vector_cmp_f cmp, void *cookie) {
+    if (!v)
+        return false;
+    if (v->nmemb < 2)
+        return true;
+
+    size_t kept = 1;
+    for (size_t i = 1; i < v->nmemb;) {
+        if (!cmp(VEC_AT(v, i - 1), VEC_AT(v, i), cookie)) {
+            ++i;
+            continue;
+        }
+
+        // Move the whole run of distinct elements at once
+        size_t j = i + 1;
+        while (j < v->nmemb && cmp(VEC_AT(v, j - 1), VEC_AT(v, j), cookie))
+            ++j;
+        if (kept != i)
+            memmove(VEC_AT(v, kept), VEC_AT(v, i), (j - i) * v->size);
+        kept += j - i;
+        i = j;
+    }
+
+    v->nmemb = kept;
+
+    return true;
+}
+
+enum set_op {
+    SET_LHS = 1 << 0, // Keep elements only found in `lhs`
+    SET_RHS = 1 << 1, // Keep elements only found in `rhs`
+    SET_BOTH = 1 << 2, // Keep elements found in both
+};
+
+// Index of the first element from `begin` that is not less than `elem`,
+// looking at exponentially growing steps to skip long runs quickly
+static size_t gallop(const struct vector *v, size_t begin,
+        const void *elem, vector_cmp_f cmp, void *cookie) {
+    size_t lo = begin;
+    size_t hi = begin;
+    size_t step = 1;
+
+    while (hi < v->nmemb && cmp(VEC_AT(v, hi), elem, cookie) < 0) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if (hi > v->nmemb)
+        hi = v->nmemb;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cmp(VEC_AT(v, mid), elem, cookie) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+// Room has been reserved already
+static void append_range(struct vector *res,
+        const struct vector *v, size_t begin, size_t end) {
+    if (begin == end)
+        return;
+
+    memcpy(VEC_AT(res, res->nmemb), VEC_AT(v, begin), (end - begin) * v->size);
+    res->nmemb += end - begin;
+}
+
+static bool set_op(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie, int op) {
+    if (!res || !lhs || !rhs)
+        return false;
+    if (res == lhs || res == rhs)
+        return false;
+    if (res->size != lhs->size || res->size != rhs->size)
+        return false;
+
+    size_t n = 0;
+    if (op == SET_BOTH)
+        n = lhs->nmemb < rhs->nmemb ? lhs->nmemb : rhs->nmemb;
+    if (op & SET_LHS)
+        n += lhs->nmemb;
+    if (op & SET_RHS)
+        n += rhs->nmemb;
+    if (!vector_reserve(res, res->nmemb + n))
+        return false;
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < lhs->nmemb && j < rhs->nmemb) {
+        size_t k = gallop(lhs, i, VEC_AT(rhs, j), cmp, cookie);
+        if (op & SET_LHS)
+            append_range(res, lhs, i, k);
+        i = k;
+        if (i == lhs->nmemb)
+            break;
+
+        k = gallop(rhs, j, VEC_AT(lhs, i), cmp, cookie);
+        if (op & SET_RHS)
+            append_range(res, rhs, j, k);
+        j = k;
+        if (j == rhs->nmemb)
+            break;
+
+        if (!cmp(VEC_AT(lhs, i), VEC_AT(rhs, j), cookie)) {
+            if (op & SET_BOTH)
+                append_range(res, lhs, i, i + 1);
+            ++i;
+            ++j;
+        }
+    }
+
+    if (op & SET_LHS)
+        append_range(res, lhs, i, lhs->nmemb);
+    if (op & SET_RHS)
+        append_range(res, rhs, j, rhs->nmemb);
+
+    return true;
+}
+
+bool vector_set_union(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie) {
+    return set_op(res, lhs, rhs, cmp, cookie, SET_LHS | SET_RHS | SET_BOTH);
+}
+
+bool vector_set_intersection(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie) {
+    return set_op(res, lhs, rhs, cmp, cookie, SET_BOTH);
+}
+
+bool vector_set_difference(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie) {
+    return set_op(res, lhs, rhs, cmp, cookie, SET_LHS);
+}
+
+bool vector_set_symmetric_difference(struct vector *res,
+        const struct vector *lhs, const struct vector *rhs,
+        vector_cmp_f cmp, void *cookie) {
+    return set_op(res, lhs, rhs, cmp, cookie, SET_LHS | SET_RHS);
+}
+
 bool vector_filter(struct vector *res,
         struct vector *v, vector_filter_f filter, void *cookie) {
     if (!v || !res)
@@ -590,3 +734,15 @@ void vector_map(struct vector *v, vector_map_f map, void *cookie) {
         map(elem, cookie);
     }
 }
+
+bool vector_reduce(const struct vector *v,
+        void *output, vector_reduce_f reduce, void *cookie) {
+    if (!v || !output || !v->nmemb)
+        return false;
+
+    memcpy(output, v->arr, v->size);
+    for (size_t i = 1; i < v->nmemb; ++i)
+        reduce(output, VEC_AT(v, i), cookie);
+
+    return true;
+}
@@ -0,0 +1,177 @@
+#include "tupperware/vector_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "crc32.h"
+
+#define MAGIC "TPWVECT"
+#define VERSION 1
+// Reads as 0x04030201 on a machine with the other endianness
+#define ENDIANNESS 0x01020304u
+
+// Elements start right after the header, on a cache line boundary
+struct header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianness;
+    uint64_t size;
+    uint64_t nmemb;
+    uint32_t data_crc;
+    // Covers every field above
+    uint32_t header_crc;
+    char reserved[24];
+};
+
+typedef char header_is_64_bytes[sizeof(struct header) == 64 ? 1 : -1];
+
+static uint32_t header_crc(const struct header *h) {
+    return crc32c(0, h, offsetof(struct header, header_crc));
+}
+
+static bool write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+
+    return true;
+}
+
+bool vector_file_save(const struct vector *v, const char *path) {
+    if (!v || !path)
+        return false;
+
+    struct header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(h.magic));
+    h.version = VERSION;
+    h.endianness = ENDIANNESS;
+    h.size = v->size;
+    h.nmemb = v->nmemb;
+    h.data_crc = crc32c(0, v->arr, v->nmemb * v->size);
+    h.header_crc = header_crc(&h);
+
+    // Written next to the destination so that renaming it is atomic
+    size_t len = strlen(path);
+    char *tmp = malloc(len + sizeof(".tmp"));
+    if (!tmp)
+        return false;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", sizeof(".tmp"));
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(tmp);
+        return false;
+    }
+
+    bool ok = write_all(fd, &h, sizeof(h))
+        && write_all(fd, v->arr, v->nmemb * v->size)
+        && !fsync(fd);
+    ok = !close(fd) && ok;
+    ok = ok && !rename(tmp, path);
+    if (!ok)
+        unlink(tmp);
+
+    free(tmp);
+
+    return ok;
+}
+
+static bool check_header(const struct header *h, size_t file_size) {
+    if (memcmp(h->magic, MAGIC, sizeof(h->magic)))
+        return false;
+    if (h->version != VERSION || h->endianness != ENDIANNESS)
+        return false;
+    if (h->header_crc != header_crc(h) || !h->size)
+        return false;
+
+    size_t data_size = file_size - sizeof(*h);
+    return h->nmemb <= data_size / h->size
+        && h->nmemb * h->size == data_size;
+}
+
+bool vector_file_load(struct vector_file *f, const char *path, int flags) {
+    if (!f || !path)
+        return false;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(struct header)) {
+        close(fd);
+        return false;
+    }
+
+    int prot = PROT_READ;
+    int mflags = MAP_SHARED;
+    if (flags & VECTOR_FILE_PRIVATE) {
+        prot |= PROT_WRITE;
+        mflags = MAP_PRIVATE;
+    }
+#ifdef MAP_POPULATE
+    if (flags & VECTOR_FILE_POPULATE)
+        mflags |= MAP_POPULATE;
+#endif
+
+    size_t map_size = st.st_size;
+    void *map = mmap(NULL, map_size, prot, mflags, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    const struct header *h = map;
+    char *arr = (char *)map + sizeof(*h);
+    if (!check_header(h, map_size))
+        goto error;
+    if ((flags & VECTOR_FILE_VERIFY)
+            && crc32c(0, arr, h->nmemb * h->size) != h->data_crc)
+        goto error;
+
+    f->v.arr = arr;
+    f->v.size = h->size;
+    f->v.nmemb = h->nmemb;
+    f->v.cap = h->nmemb;
+    f->map = map;
+    f->map_size = map_size;
+
+    return true;
+
+error:
+    munmap(map, map_size);
+    return false;
+}
+
+void vector_file_close(struct vector_file *f) {
+    if (!f || !f->map)
+        return;
+
+    munmap(f->map, f->map_size);
+
+    memset(f, 0, sizeof(*f));
+}
+
+const struct vector *vector_file_vector(const struct vector_file *f) {
+    if (!f || !f->map)
+        return NULL;
+    return &f->v;
+}
@@ -0,0 +1,382 @@
+#include "tupperware/vector_parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Chunks are sized to stay in a core's L2 cache
+#define CHUNK_BYTES (256 * 1024)
+
+struct task {
+    const struct vector *v;
+    size_t chunk;
+    size_t nchunks;
+    void (*run)(struct task *t, size_t begin, size_t end, size_t index);
+
+    void *cookie;
+    vector_map_f map;
+    vector_filter_f filter;
+    vector_reduce_f reduce;
+
+    // Filter: one flag per element, then per chunk count of matches, which is
+    // turned into the number of matches before each chunk
+    unsigned char *flags;
+    size_t *counts;
+    struct vector *res;
+    char *kept;
+
+    // Reduce: one partial result per chunk
+    char *partials;
+};
+
+static void *at(const struct vector *v, size_t i) {
+    return (char *)v->arr + i * v->size;
+}
+
+static size_t chunk_length(size_t size) {
+    return size < CHUNK_BYTES ? CHUNK_BYTES / size : 1;
+}
+
+static void task_init(struct task *t, const struct vector *v) {
+    memset(t, 0, sizeof(*t));
+    t->v = v;
+    t->chunk = chunk_length(v->size);
+    t->nchunks = (v->nmemb + t->chunk - 1) / t->chunk;
+}
+
+static void run_chunks(size_t first, size_t last, void *cookie) {
+    struct task *t = cookie;
+
+    for (size_t i = first; i < last; ++i) {
+        size_t begin = i * t->chunk;
+        size_t end = begin + t->chunk;
+        if (end > t->v->nmemb)
+            end = t->v->nmemb;
+        t->run(t, begin, end, i);
+    }
+}
+
+static void run(struct task *t, struct scheduler *s) {
+    scheduler_parallel_for(s, 0, t->nchunks, 1, run_chunks, t);
+}
+
+static void map_chunk(struct task *t, size_t begin, size_t end, size_t index) {
+    (void)index;
+
+    for (size_t i = begin; i < end; ++i)
+        t->map(at(t->v, i), t->cookie);
+}
+
+void vector_parallel_map(struct vector *v,
+        vector_map_f map, void *cookie, struct scheduler *s) {
+    if (!v || !v->nmemb)
+        return;
+
+    struct task t;
+    task_init(&t, v);
+    t.run = map_chunk;
+    t.map = map;
+    t.cookie = cookie;
+
+    run(&t, s);
+}
+
+static void flag_chunk(struct task *t, size_t begin, size_t end, size_t index) {
+    size_t count = 0;
+
+    for (size_t i = begin; i < end; ++i) {
+        t->flags[i] = t->filter(at(t->v, i), t->cookie);
+        count += t->flags[i];
+    }
+
+    t->counts[index] = count;
+}
+
+// Copy runs of elements with the same flag at once
+static void split_chunk(struct task *t,
+        size_t begin, size_t end, size_t index) {
+    const struct vector *v = t->v;
+    size_t matched = t->counts[index];
+    char *res = at(t->res, t->res->nmemb + matched);
+    char *kept = t->kept + (begin - matched) * v->size;
+
+    for (size_t i = begin; i < end;) {
+        size_t j = i + 1;
+        while (j < end && t->flags[j] == t->flags[i])
+            ++j;
+
+        size_t bytes = (j - i) * v->size;
+        char **dst = t->flags[i] ? &res : &kept;
+        memcpy(*dst, at(v, i), bytes);
+        *dst += bytes;
+
+        i = j;
+    }
+}
+
+bool vector_parallel_filter(struct vector *res, struct vector *v,
+        vector_filter_f filter, void *cookie, struct scheduler *s) {
+    if (!v || !res)
+        return false;
+    if (!v->nmemb)
+        return true;
+    if (res == v || res->size != v->size)
+        return false;
+
+    struct task t;
+    task_init(&t, v);
+    t.run = flag_chunk;
+    t.filter = filter;
+    t.cookie = cookie;
+    t.res = res;
+    t.flags = malloc(v->nmemb);
+    t.counts = calloc(t.nchunks, sizeof(*t.counts));
+    if (!t.flags || !t.counts)
+        goto error;
+
+    run(&t, s);
+
+    size_t matched = 0;
+    for (size_t i = 0; i < t.nchunks; ++i) {
+        size_t count = t.counts[i];
+        t.counts[i] = matched;
+        matched += count;
+    }
+
+    size_t kept = v->nmemb - matched;
+    if (kept) {
+        t.kept = malloc(kept * v->size);
+        if (!t.kept)
+            goto error;
+    }
+    if (res->nmemb + matched > res->cap
+            && !vector_reserve(res, res->nmemb + matched))
+        goto error;
+
+    // The predicate has been called already, nothing can fail from here on
+    t.run = split_chunk;
+    run(&t, s);
+
+    res->nmemb += matched;
+    if (kept) {
+        free(v->arr);
+        v->arr = t.kept;
+        v->cap = kept;
+    }
+    v->nmemb = kept;
+
+    free(t.flags);
+    free(t.counts);
+
+    return true;
+
+error:
+    free(t.kept);
+    free(t.flags);
+    free(t.counts);
+    return false;
+}
+
+static void reduce_chunk(struct task *t,
+        size_t begin, size_t end, size_t index) {
+    char *partial = t->partials + index * t->v->size;
+
+    memcpy(partial, at(t->v, begin), t->v->size);
+    for (size_t i = begin + 1; i < end; ++i)
+        t->reduce(partial, at(t->v, i), t->cookie);
+}
+
+bool vector_parallel_reduce(const struct vector *v, void *output,
+        vector_reduce_f reduce, void *cookie, struct scheduler *s) {
+    if (!v || !output || !v->nmemb)
+        return false;
+
+    struct task t;
+    task_init(&t, v);
+    t.run = reduce_chunk;
+    t.reduce = reduce;
+    t.cookie = cookie;
+    t.partials = calloc(t.nchunks, v->size);
+    if (!t.partials)
+        return false;
+
+    run(&t, s);
+
+    // Partials are combined in order, for non commutative operations
+    memcpy(output, t.partials, v->size);
+    for (size_t i = 1; i < t.nchunks; ++i)
+        reduce(output, t.partials + i * v->size, cookie);
+
+    free(t.partials);
+
+    return true;
+}
+
+struct sort {
+    size_t size;
+    size_t grain;
+    vector_cmp_f cmp;
+    void *cookie;
+    bool failed;
+};
+
+struct sort_range {
+    struct sort *sort;
+    char *arr;
+    char *buf;
+    size_t n;
+    // Whether the sorted range should end up in `buf` rather than `arr`
+    bool to_buf;
+};
+
+struct merge_range {
+    struct sort *sort;
+    const char *lhs;
+    size_t nlhs;
+    const char *rhs;
+    size_t nrhs;
+    char *out;
+};
+
+// First element of `arr` for which `elem < arr[i]`, or `elem <= arr[i]` if
+// `inclusive`
+static size_t bound(struct sort *sort, const char *arr, size_t n,
+        const void *elem, bool inclusive) {
+    size_t lo = 0;
+    size_t hi = n;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = sort->cmp(arr + mid * sort->size, elem, sort->cookie);
+        if (c < 0 || (!inclusive && c == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static void merge(struct sort *sort, const char *lhs, size_t nlhs,
+        const char *rhs, size_t nrhs, char *out) {
+    size_t size = sort->size;
+
+    while (nlhs && nrhs) {
+        if (sort->cmp(rhs, lhs, sort->cookie) < 0) {
+            memcpy(out, rhs, size);
+            rhs += size;
+            --nrhs;
+        } else {
+            memcpy(out, lhs, size);
+            lhs += size;
+            --nlhs;
+        }
+        out += size;
+    }
+
+    memcpy(out, lhs, nlhs * size);
+    memcpy(out + nlhs * size, rhs, nrhs * size);
+}
+
+// Split both halves around the median of the longest one, ties staying on the
+// left hand side to keep the merge stable
+static void merge_job(struct scheduler *s, void *cookie) {
+    struct merge_range *m = cookie;
+    struct sort *sort = m->sort;
+    size_t size = sort->size;
+
+    if (m->nlhs + m->nrhs <= sort->grain) {
+        merge(sort, m->lhs, m->nlhs, m->rhs, m->nrhs, m->out);
+        return;
+    }
+
+    size_t l = m->nlhs / 2;
+    size_t r = m->nrhs / 2;
+    if (m->nlhs >= m->nrhs)
+        r = bound(sort, m->rhs, m->nrhs, m->lhs + l * size, true);
+    else
+        l = bound(sort, m->lhs, m->nlhs, m->rhs + r * size, false);
+
+    struct merge_range left = {
+        sort, m->lhs, l, m->rhs, r, m->out,
+    };
+    struct merge_range right = {
+        sort, m->lhs + l * size, m->nlhs - l, m->rhs + r * size, m->nrhs - r,
+        m->out + (l + r) * size,
+    };
+
+    struct scheduler_job job;
+    scheduler_spawn(s, &job, merge_job, &right);
+    merge_job(s, &left);
+    scheduler_join(s, &job);
+}
+
+static void sort_job(struct scheduler *s, void *cookie) {
+    struct sort_range *r = cookie;
+    struct sort *sort = r->sort;
+    size_t size = sort->size;
+
+    if (r->n <= sort->grain) {
+        struct vector view = { r->arr, size, r->n, r->n };
+        if (!vector_merge_sort(&view, sort->cmp, sort->cookie))
+            __atomic_store_n(&sort->failed, true, __ATOMIC_RELAXED);
+        if (r->to_buf)
+            memcpy(r->buf, r->arr, r->n * size);
+        return;
+    }
+
+    // Sort both halves into the other array, then merge them back
+    size_t mid = r->n / 2;
+    struct sort_range left = { sort, r->arr, r->buf, mid, !r->to_buf };
+    struct sort_range right = {
+        sort, r->arr + mid * size, r->buf + mid * size, r->n - mid, !r->to_buf,
+    };
+
+    struct scheduler_job job;
+    scheduler_spawn(s, &job, sort_job, &right);
+    sort_job(s, &left);
+    scheduler_join(s, &job);
+
+    char *src = r->to_buf ? r->arr : r->buf;
+    char *dst = r->to_buf ? r->buf : r->arr;
+    struct merge_range m = {
+        sort, src, mid, src + mid * size, r->n - mid, dst,
+    };
+    merge_job(s, &m);
+}
+
+bool vector_parallel_merge_sort(struct vector *v,
+        vector_cmp_f cmp, void *cookie, struct scheduler *s) {
+    if (!v || !v->nmemb)
+        return true;
+
+    struct sort sort = {
+        .size = v->size,
+        .grain = chunk_length(v->size),
+        .cmp = cmp,
+        .cookie = cookie,
+        .failed = false,
+    };
+    // Both sides of a split must be non empty
+    if (sort.grain < 2)
+        sort.grain = 2;
+    if (!s || v->nmemb <= sort.grain)
+        return vector_merge_sort(v, cmp, cookie);
+
+    struct sort_range r = {
+        .sort = &sort,
+        .arr = v->arr,
+        .buf = malloc(v->nmemb * v->size),
+        .n = v->nmemb,
+        .to_buf = false,
+    };
+    if (!r.buf)
+        return false;
+
+    struct scheduler_job job;
+    scheduler_spawn(s, &job, sort_job, &r);
+    scheduler_join(s, &job);
+
+    free(r.buf);
+
+    return !sort.failed;
+}
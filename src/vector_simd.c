@@ -0,0 +1,1072 @@
+#include "tupperware/vector_simd.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#ifdef TUPPERWARE_X86
+#include <immintrin.h>
+#endif
+
+#define FILTER_CHUNK 4096
+#define FILTER_SLACK 16
+// Size ratio above which binary searches beat comparing blocks
+#define INTERSECT_SKEW 32
+
+// Kernels work on raw 32-bit lanes, `is_float` tells how to compare them
+struct kernels {
+    // Matches are written to `match`, others are compacted to `keep`, which
+    // must not be after `src`. Returns the number of matches.
+    size_t (*filter)(uint32_t *keep, const uint32_t *src, size_t n,
+            enum vector_simd_cmp cmp, uint32_t val, bool is_float,
+            uint32_t *match);
+    void (*affine_u32)(uint32_t *arr, size_t n, uint32_t mul, uint32_t add);
+    void (*affine_f32)(float *arr, size_t n, float mul, float add);
+    uint64_t (*sum_u32)(const uint32_t *arr, size_t n);
+    double (*sum_f32)(const float *arr, size_t n);
+    void (*minmax_u32)(const uint32_t *arr, size_t n,
+            uint32_t *min, uint32_t *max);
+    void (*minmax_f32)(const float *arr, size_t n, float *min, float *max);
+    size_t (*find)(const uint32_t *arr, size_t n, uint32_t val, bool is_float);
+    // Inputs are strictly increasing, `out` needs 8 elements of slack
+    size_t (*intersect)(const uint32_t *lhs, size_t nlhs,
+            const uint32_t *rhs, size_t nrhs, uint32_t *out);
+};
+
+static float as_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static uint32_t as_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static bool match_u32(uint32_t x, enum vector_simd_cmp cmp, uint32_t val) {
+    switch (cmp) {
+    case VECTOR_SIMD_EQ: return x == val;
+    case VECTOR_SIMD_NE: return x != val;
+    case VECTOR_SIMD_LT: return x < val;
+    case VECTOR_SIMD_LE: return x <= val;
+    case VECTOR_SIMD_GT: return x > val;
+    case VECTOR_SIMD_GE: return x >= val;
+    }
+    return false;
+}
+
+static bool match_f32(float x, enum vector_simd_cmp cmp, float val) {
+    switch (cmp) {
+    case VECTOR_SIMD_EQ: return x == val;
+    case VECTOR_SIMD_NE: return x != val;
+    case VECTOR_SIMD_LT: return x < val;
+    case VECTOR_SIMD_LE: return x <= val;
+    case VECTOR_SIMD_GT: return x > val;
+    case VECTOR_SIMD_GE: return x >= val;
+    }
+    return false;
+}
+
+static bool match(uint32_t x,
+        enum vector_simd_cmp cmp, uint32_t val, bool is_float) {
+    if (is_float)
+        return match_f32(as_float(x), cmp, as_float(val));
+    return match_u32(x, cmp, val);
+}
+
+static size_t filter_scalar(uint32_t *keep, const uint32_t *src, size_t n,
+        enum vector_simd_cmp cmp, uint32_t val, bool is_float,
+        uint32_t *match_out) {
+    size_t m = 0;
+    size_t k = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t x = src[i];
+        if (match(x, cmp, val, is_float))
+            match_out[m++] = x;
+        else
+            keep[k++] = x;
+    }
+
+    return m;
+}
+
+static void affine_u32_scalar(uint32_t *arr,
+        size_t n, uint32_t mul, uint32_t add) {
+    for (size_t i = 0; i < n; ++i)
+        arr[i] = arr[i] * mul + add;
+}
+
+static void affine_f32_scalar(float *arr, size_t n, float mul, float add) {
+    for (size_t i = 0; i < n; ++i)
+        arr[i] = arr[i] * mul + add;
+}
+
+static uint64_t sum_u32_scalar(const uint32_t *arr, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i)
+        sum += arr[i];
+    return sum;
+}
+
+static double sum_f32_scalar(const float *arr, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i)
+        sum += arr[i];
+    return sum;
+}
+
+static void minmax_u32_scalar(const uint32_t *arr, size_t n,
+        uint32_t *min, uint32_t *max) {
+    for (size_t i = 0; i < n; ++i) {
+        if (arr[i] < *min)
+            *min = arr[i];
+        if (arr[i] > *max)
+            *max = arr[i];
+    }
+}
+
+static void minmax_f32_scalar(const float *arr, size_t n,
+        float *min, float *max) {
+    for (size_t i = 0; i < n; ++i) {
+        if (arr[i] < *min)
+            *min = arr[i];
+        if (arr[i] > *max)
+            *max = arr[i];
+    }
+}
+
+static size_t find_scalar(const uint32_t *arr,
+        size_t n, uint32_t val, bool is_float) {
+    for (size_t i = 0; i < n; ++i)
+        if (match(arr[i], VECTOR_SIMD_EQ, val, is_float))
+            return i;
+    return n;
+}
+
+static size_t intersect_scalar(const uint32_t *lhs, size_t nlhs,
+        const uint32_t *rhs, size_t nrhs, uint32_t *out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    while (i < nlhs && j < nrhs) {
+        if (lhs[i] < rhs[j]) {
+            ++i;
+        } else if (rhs[j] < lhs[i]) {
+            ++j;
+        } else {
+            out[k++] = lhs[i];
+            ++i;
+            ++j;
+        }
+    }
+
+    return k;
+}
+
+static const struct kernels scalar_kernels = {
+    .filter = filter_scalar,
+    .affine_u32 = affine_u32_scalar,
+    .affine_f32 = affine_f32_scalar,
+    .sum_u32 = sum_u32_scalar,
+    .sum_f32 = sum_f32_scalar,
+    .minmax_u32 = minmax_u32_scalar,
+    .minmax_f32 = minmax_f32_scalar,
+    .find = find_scalar,
+    .intersect = intersect_scalar,
+};
+
+#ifdef TUPPERWARE_X86
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+#define AVX512 __attribute__((target("avx512f")))
+
+SSE2 static inline unsigned mask_sse2(__m128i x,
+        enum vector_simd_cmp cmp, __m128i val, bool is_float) {
+    if (is_float) {
+        __m128 a = _mm_castsi128_ps(x);
+        __m128 b = _mm_castsi128_ps(val);
+        __m128 r = _mm_setzero_ps();
+        switch (cmp) {
+        case VECTOR_SIMD_EQ: r = _mm_cmpeq_ps(a, b); break;
+        case VECTOR_SIMD_NE: r = _mm_cmpneq_ps(a, b); break;
+        case VECTOR_SIMD_LT: r = _mm_cmplt_ps(a, b); break;
+        case VECTOR_SIMD_LE: r = _mm_cmple_ps(a, b); break;
+        case VECTOR_SIMD_GT: r = _mm_cmpgt_ps(a, b); break;
+        case VECTOR_SIMD_GE: r = _mm_cmpge_ps(a, b); break;
+        }
+        return _mm_movemask_ps(r);
+    }
+
+    // No unsigned comparisons, flip the sign bit to use the signed ones
+    __m128i bias = _mm_set1_epi32(INT32_MIN);
+    __m128i a = _mm_xor_si128(x, bias);
+    __m128i b = _mm_xor_si128(val, bias);
+    switch (cmp) {
+    case VECTOR_SIMD_EQ:
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, val)));
+    case VECTOR_SIMD_NE:
+        return mask_sse2(x, VECTOR_SIMD_EQ, val, false) ^ 0xF;
+    case VECTOR_SIMD_LT:
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(a, b)));
+    case VECTOR_SIMD_GE:
+        return mask_sse2(x, VECTOR_SIMD_LT, val, false) ^ 0xF;
+    case VECTOR_SIMD_GT:
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(a, b)));
+    case VECTOR_SIMD_LE:
+        return mask_sse2(x, VECTOR_SIMD_GT, val, false) ^ 0xF;
+    }
+    return 0;
+}
+
+SSE2 static size_t filter_sse2(uint32_t *keep, const uint32_t *src, size_t n,
+        enum vector_simd_cmp cmp, uint32_t val, bool is_float,
+        uint32_t *match_out) {
+    __m128i v = _mm_set1_epi32(val);
+    size_t m = 0;
+    size_t k = 0;
+    size_t i = 0;
+
+    // No cheap lane compaction before SSSE3, only the comparison is vectorized
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        unsigned mask = mask_sse2(x, cmp, v, is_float);
+        for (unsigned j = 0; j < 4; ++j) {
+            uint32_t e = src[i + j];
+            if (mask & (1u << j))
+                match_out[m++] = e;
+            else
+                keep[k++] = e;
+        }
+    }
+
+    return m + filter_scalar(keep + k, src + i, n - i,
+            cmp, val, is_float, match_out + m);
+}
+
+SSE2 static inline __m128i mullo_sse2(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(
+            _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+SSE2 static void affine_u32_sse2(uint32_t *arr,
+        size_t n, uint32_t mul, uint32_t add) {
+    __m128i m = _mm_set1_epi32(mul);
+    __m128i a = _mm_set1_epi32(add);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(arr + i));
+        x = _mm_add_epi32(mullo_sse2(x, m), a);
+        _mm_storeu_si128((__m128i *)(arr + i), x);
+    }
+
+    affine_u32_scalar(arr + i, n - i, mul, add);
+}
+
+SSE2 static void affine_f32_sse2(float *arr, size_t n, float mul, float add) {
+    __m128 m = _mm_set1_ps(mul);
+    __m128 a = _mm_set1_ps(add);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(arr + i);
+        _mm_storeu_ps(arr + i, _mm_add_ps(_mm_mul_ps(x, m), a));
+    }
+
+    affine_f32_scalar(arr + i, n - i, mul, add);
+}
+
+SSE2 static uint64_t sum_u32_sse2(const uint32_t *arr, size_t n) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(arr + i));
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(x, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(x, zero));
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + sum_u32_scalar(arr + i, n - i);
+}
+
+SSE2 static double sum_f32_sse2(const float *arr, size_t n) {
+    __m128d lo = _mm_setzero_pd();
+    __m128d hi = _mm_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(arr + i);
+        lo = _mm_add_pd(lo, _mm_cvtps_pd(x));
+        hi = _mm_add_pd(hi, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(lo, hi));
+    return lanes[0] + lanes[1] + sum_f32_scalar(arr + i, n - i);
+}
+
+SSE2 static void minmax_u32_sse2(const uint32_t *arr, size_t n,
+        uint32_t *min, uint32_t *max) {
+    // Work on biased values to use signed comparisons
+    __m128i bias = _mm_set1_epi32(INT32_MIN);
+    __m128i mn = _mm_xor_si128(_mm_set1_epi32(*min), bias);
+    __m128i mx = _mm_xor_si128(_mm_set1_epi32(*max), bias);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(arr + i));
+        x = _mm_xor_si128(x, bias);
+        __m128i lt = _mm_cmplt_epi32(x, mn);
+        __m128i gt = _mm_cmpgt_epi32(x, mx);
+        mn = _mm_or_si128(_mm_and_si128(lt, x), _mm_andnot_si128(lt, mn));
+        mx = _mm_or_si128(_mm_and_si128(gt, x), _mm_andnot_si128(gt, mx));
+    }
+
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, _mm_xor_si128(mn, bias));
+    minmax_u32_scalar(lanes, 4, min, max);
+    _mm_storeu_si128((__m128i *)lanes, _mm_xor_si128(mx, bias));
+    minmax_u32_scalar(lanes, 4, min, max);
+    minmax_u32_scalar(arr + i, n - i, min, max);
+}
+
+SSE2 static void minmax_f32_sse2(const float *arr, size_t n,
+        float *min, float *max) {
+    __m128 mn = _mm_set1_ps(*min);
+    __m128 mx = _mm_set1_ps(*max);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(arr + i);
+        mn = _mm_min_ps(mn, x);
+        mx = _mm_max_ps(mx, x);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, mn);
+    minmax_f32_scalar(lanes, 4, min, max);
+    _mm_storeu_ps(lanes, mx);
+    minmax_f32_scalar(lanes, 4, min, max);
+    minmax_f32_scalar(arr + i, n - i, min, max);
+}
+
+SSE2 static size_t find_sse2(const uint32_t *arr,
+        size_t n, uint32_t val, bool is_float) {
+    __m128i v = _mm_set1_epi32(val);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(arr + i));
+        unsigned mask = mask_sse2(x, VECTOR_SIMD_EQ, v, is_float);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + find_scalar(arr + i, n - i, val, is_float);
+}
+
+// Compare blocks of 4 elements against each other, moving forward the block
+// with the smallest maximum
+SSE2 static size_t intersect_sse2(const uint32_t *lhs, size_t nlhs,
+        const uint32_t *rhs, size_t nrhs, uint32_t *out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    while (i + 4 <= nlhs && j + 4 <= nrhs) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(lhs + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(rhs + j));
+
+        __m128i eq = _mm_cmpeq_epi32(a, b);
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi32(a,
+                    _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1))));
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi32(a,
+                    _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))));
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi32(a,
+                    _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3))));
+
+        unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        for (; mask; mask &= mask - 1)
+            out[k++] = lhs[i + __builtin_ctz(mask)];
+
+        uint32_t amax = lhs[i + 3];
+        uint32_t bmax = rhs[j + 3];
+        if (amax <= bmax)
+            i += 4;
+        if (bmax <= amax)
+            j += 4;
+    }
+
+    return k + intersect_scalar(lhs + i, nlhs - i, rhs + j, nrhs - j, out + k);
+}
+
+static const struct kernels sse2_kernels = {
+    .filter = filter_sse2,
+    .affine_u32 = affine_u32_sse2,
+    .affine_f32 = affine_f32_sse2,
+    .sum_u32 = sum_u32_sse2,
+    .sum_f32 = sum_f32_sse2,
+    .minmax_u32 = minmax_u32_sse2,
+    .minmax_f32 = minmax_f32_sse2,
+    .find = find_sse2,
+    .intersect = intersect_sse2,
+};
+
+// Permutation moving the lanes selected by the index's bits to the front
+static uint32_t compact_lut[256][8];
+
+static void init_compact_lut(void) {
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        unsigned k = 0;
+        for (unsigned lane = 0; lane < 8; ++lane)
+            if (mask & (1u << lane))
+                compact_lut[mask][k++] = lane;
+        while (k < 8)
+            compact_lut[mask][k++] = 0;
+    }
+}
+
+AVX2 static inline unsigned mask_avx2(__m256i x,
+        enum vector_simd_cmp cmp, __m256i val, bool is_float) {
+    if (is_float) {
+        __m256 a = _mm256_castsi256_ps(x);
+        __m256 b = _mm256_castsi256_ps(val);
+        __m256 r = _mm256_setzero_ps();
+        switch (cmp) {
+        case VECTOR_SIMD_EQ: r = _mm256_cmp_ps(a, b, _CMP_EQ_OQ); break;
+        case VECTOR_SIMD_NE: r = _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); break;
+        case VECTOR_SIMD_LT: r = _mm256_cmp_ps(a, b, _CMP_LT_OQ); break;
+        case VECTOR_SIMD_LE: r = _mm256_cmp_ps(a, b, _CMP_LE_OQ); break;
+        case VECTOR_SIMD_GT: r = _mm256_cmp_ps(a, b, _CMP_GT_OQ); break;
+        case VECTOR_SIMD_GE: r = _mm256_cmp_ps(a, b, _CMP_GE_OQ); break;
+        }
+        return _mm256_movemask_ps(r);
+    }
+
+    __m256i bias = _mm256_set1_epi32(INT32_MIN);
+    __m256i a = _mm256_xor_si256(x, bias);
+    __m256i b = _mm256_xor_si256(val, bias);
+    switch (cmp) {
+    case VECTOR_SIMD_EQ:
+        return _mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_cmpeq_epi32(x, val)));
+    case VECTOR_SIMD_NE:
+        return mask_avx2(x, VECTOR_SIMD_EQ, val, false) ^ 0xFF;
+    case VECTOR_SIMD_LT:
+        return _mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)));
+    case VECTOR_SIMD_GE:
+        return mask_avx2(x, VECTOR_SIMD_LT, val, false) ^ 0xFF;
+    case VECTOR_SIMD_GT:
+        return _mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b)));
+    case VECTOR_SIMD_LE:
+        return mask_avx2(x, VECTOR_SIMD_GT, val, false) ^ 0xFF;
+    }
+    return 0;
+}
+
+AVX2 static size_t filter_avx2(uint32_t *keep, const uint32_t *src, size_t n,
+        enum vector_simd_cmp cmp, uint32_t val, bool is_float,
+        uint32_t *match_out) {
+    __m256i v = _mm256_set1_epi32(val);
+    size_t m = 0;
+    size_t k = 0;
+    size_t i = 0;
+
+    // Full lanes are stored, `match_out` needs 8 elements of slack, writes to
+    // `keep` stay within what has already been loaded
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+        unsigned mask = mask_avx2(x, cmp, v, is_float);
+        unsigned count = __builtin_popcount(mask);
+
+        __m256i sel = _mm256_loadu_si256((const __m256i *)compact_lut[mask]);
+        __m256i rej = _mm256_loadu_si256(
+                (const __m256i *)compact_lut[mask ^ 0xFF]);
+        _mm256_storeu_si256((__m256i *)(match_out + m),
+                _mm256_permutevar8x32_epi32(x, sel));
+        _mm256_storeu_si256((__m256i *)(keep + k),
+                _mm256_permutevar8x32_epi32(x, rej));
+
+        m += count;
+        k += 8 - count;
+    }
+
+    return m + filter_scalar(keep + k, src + i, n - i,
+            cmp, val, is_float, match_out + m);
+}
+
+AVX2 static void affine_u32_avx2(uint32_t *arr,
+        size_t n, uint32_t mul, uint32_t add) {
+    __m256i m = _mm256_set1_epi32(mul);
+    __m256i a = _mm256_set1_epi32(add);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(arr + i));
+        x = _mm256_add_epi32(_mm256_mullo_epi32(x, m), a);
+        _mm256_storeu_si256((__m256i *)(arr + i), x);
+    }
+
+    affine_u32_scalar(arr + i, n - i, mul, add);
+}
+
+AVX2 static void affine_f32_avx2(float *arr, size_t n, float mul, float add) {
+    __m256 m = _mm256_set1_ps(mul);
+    __m256 a = _mm256_set1_ps(add);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(arr + i);
+        _mm256_storeu_ps(arr + i, _mm256_add_ps(_mm256_mul_ps(x, m), a));
+    }
+
+    affine_f32_scalar(arr + i, n - i, mul, add);
+}
+
+AVX2 static uint64_t sum_u32_avx2(const uint32_t *arr, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(arr + i));
+        acc = _mm256_add_epi64(acc,
+                _mm256_cvtepu32_epi64(_mm256_castsi256_si128(x)));
+        acc = _mm256_add_epi64(acc,
+                _mm256_cvtepu32_epi64(_mm256_extracti128_si256(x, 1)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+        + sum_u32_scalar(arr + i, n - i);
+}
+
+AVX2 static double sum_f32_avx2(const float *arr, size_t n) {
+    __m256d lo = _mm256_setzero_pd();
+    __m256d hi = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(arr + i);
+        lo = _mm256_add_pd(lo, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        hi = _mm256_add_pd(hi, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(lo, hi));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+        + sum_f32_scalar(arr + i, n - i);
+}
+
+AVX2 static void minmax_u32_avx2(const uint32_t *arr, size_t n,
+        uint32_t *min, uint32_t *max) {
+    __m256i mn = _mm256_set1_epi32(*min);
+    __m256i mx = _mm256_set1_epi32(*max);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(arr + i));
+        mn = _mm256_min_epu32(mn, x);
+        mx = _mm256_max_epu32(mx, x);
+    }
+
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, mn);
+    minmax_u32_scalar(lanes, 8, min, max);
+    _mm256_storeu_si256((__m256i *)lanes, mx);
+    minmax_u32_scalar(lanes, 8, min, max);
+    minmax_u32_scalar(arr + i, n - i, min, max);
+}
+
+AVX2 static void minmax_f32_avx2(const float *arr, size_t n,
+        float *min, float *max) {
+    __m256 mn = _mm256_set1_ps(*min);
+    __m256 mx = _mm256_set1_ps(*max);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(arr + i);
+        mn = _mm256_min_ps(mn, x);
+        mx = _mm256_max_ps(mx, x);
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, mn);
+    minmax_f32_scalar(lanes, 8, min, max);
+    _mm256_storeu_ps(lanes, mx);
+    minmax_f32_scalar(lanes, 8, min, max);
+    minmax_f32_scalar(arr + i, n - i, min, max);
+}
+
+AVX2 static size_t find_avx2(const uint32_t *arr,
+        size_t n, uint32_t val, bool is_float) {
+    __m256i v = _mm256_set1_epi32(val);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(arr + i));
+        unsigned mask = mask_avx2(x, VECTOR_SIMD_EQ, v, is_float);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + find_scalar(arr + i, n - i, val, is_float);
+}
+
+AVX2 static size_t intersect_avx2(const uint32_t *lhs, size_t nlhs,
+        const uint32_t *rhs, size_t nrhs, uint32_t *out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+
+    while (i + 8 <= nlhs && j + 8 <= nrhs) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(lhs + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(rhs + j));
+        // Same rotations within each half, for both orders of the halves
+        __m256i c = _mm256_permute2x128_si256(b, b, 1);
+
+        __m256i eq = _mm256_or_si256(
+                _mm256_cmpeq_epi32(a, b), _mm256_cmpeq_epi32(a, c));
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a,
+                    _mm256_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1))));
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a,
+                    _mm256_shuffle_epi32(c, _MM_SHUFFLE(0, 3, 2, 1))));
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a,
+                    _mm256_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))));
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a,
+                    _mm256_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2))));
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a,
+                    _mm256_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3))));
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a,
+                    _mm256_shuffle_epi32(c, _MM_SHUFFLE(2, 1, 0, 3))));
+
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        __m256i sel = _mm256_loadu_si256((const __m256i *)compact_lut[mask]);
+        _mm256_storeu_si256((__m256i *)(out + k),
+                _mm256_permutevar8x32_epi32(a, sel));
+        k += __builtin_popcount(mask);
+
+        uint32_t amax = lhs[i + 7];
+        uint32_t bmax = rhs[j + 7];
+        if (amax <= bmax)
+            i += 8;
+        if (bmax <= amax)
+            j += 8;
+    }
+
+    return k + intersect_scalar(lhs + i, nlhs - i, rhs + j, nrhs - j, out + k);
+}
+
+static const struct kernels avx2_kernels = {
+    .filter = filter_avx2,
+    .affine_u32 = affine_u32_avx2,
+    .affine_f32 = affine_f32_avx2,
+    .sum_u32 = sum_u32_avx2,
+    .sum_f32 = sum_f32_avx2,
+    .minmax_u32 = minmax_u32_avx2,
+    .minmax_f32 = minmax_f32_avx2,
+    .find = find_avx2,
+    .intersect = intersect_avx2,
+};
+
+AVX512 static inline __mmask16 mask_avx512(__m512i x,
+        enum vector_simd_cmp cmp, __m512i val, bool is_float) {
+    if (is_float) {
+        __m512 a = _mm512_castsi512_ps(x);
+        __m512 b = _mm512_castsi512_ps(val);
+        switch (cmp) {
+        case VECTOR_SIMD_EQ: return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ);
+        case VECTOR_SIMD_NE: return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ);
+        case VECTOR_SIMD_LT: return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+        case VECTOR_SIMD_LE: return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ);
+        case VECTOR_SIMD_GT: return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+        case VECTOR_SIMD_GE: return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ);
+        }
+        return 0;
+    }
+
+    switch (cmp) {
+    case VECTOR_SIMD_EQ: return _mm512_cmp_epu32_mask(x, val, _MM_CMPINT_EQ);
+    case VECTOR_SIMD_NE: return _mm512_cmp_epu32_mask(x, val, _MM_CMPINT_NE);
+    case VECTOR_SIMD_LT: return _mm512_cmp_epu32_mask(x, val, _MM_CMPINT_LT);
+    case VECTOR_SIMD_LE: return _mm512_cmp_epu32_mask(x, val, _MM_CMPINT_LE);
+    case VECTOR_SIMD_GT: return _mm512_cmp_epu32_mask(x, val, _MM_CMPINT_NLE);
+    case VECTOR_SIMD_GE: return _mm512_cmp_epu32_mask(x, val, _MM_CMPINT_NLT);
+    }
+    return 0;
+}
+
+AVX512 static size_t filter_avx512(uint32_t *keep, const uint32_t *src,
+        size_t n, enum vector_simd_cmp cmp, uint32_t val, bool is_float,
+        uint32_t *match_out) {
+    __m512i v = _mm512_set1_epi32(val);
+    size_t m = 0;
+    size_t k = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(src + i);
+        __mmask16 mask = mask_avx512(x, cmp, v, is_float);
+        unsigned count = __builtin_popcount(mask);
+
+        _mm512_mask_compressstoreu_epi32(match_out + m, mask, x);
+        _mm512_mask_compressstoreu_epi32(keep + k, (__mmask16)~mask, x);
+
+        m += count;
+        k += 16 - count;
+    }
+
+    return m + filter_avx2(keep + k, src + i, n - i,
+            cmp, val, is_float, match_out + m);
+}
+
+AVX512 static void affine_u32_avx512(uint32_t *arr,
+        size_t n, uint32_t mul, uint32_t add) {
+    __m512i m = _mm512_set1_epi32(mul);
+    __m512i a = _mm512_set1_epi32(add);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(arr + i);
+        _mm512_storeu_si512(arr + i,
+                _mm512_add_epi32(_mm512_mullo_epi32(x, m), a));
+    }
+
+    affine_u32_scalar(arr + i, n - i, mul, add);
+}
+
+AVX512 static void affine_f32_avx512(float *arr,
+        size_t n, float mul, float add) {
+    __m512 m = _mm512_set1_ps(mul);
+    __m512 a = _mm512_set1_ps(add);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m512 x = _mm512_loadu_ps(arr + i);
+        _mm512_storeu_ps(arr + i, _mm512_add_ps(_mm512_mul_ps(x, m), a));
+    }
+
+    affine_f32_scalar(arr + i, n - i, mul, add);
+}
+
+AVX512 static void minmax_u32_avx512(const uint32_t *arr, size_t n,
+        uint32_t *min, uint32_t *max) {
+    __m512i mn = _mm512_set1_epi32(*min);
+    __m512i mx = _mm512_set1_epi32(*max);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(arr + i);
+        mn = _mm512_min_epu32(mn, x);
+        mx = _mm512_max_epu32(mx, x);
+    }
+
+    *min = _mm512_reduce_min_epu32(mn);
+    *max = _mm512_reduce_max_epu32(mx);
+    minmax_u32_scalar(arr + i, n - i, min, max);
+}
+
+AVX512 static size_t find_avx512(const uint32_t *arr,
+        size_t n, uint32_t val, bool is_float) {
+    __m512i v = _mm512_set1_epi32(val);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(arr + i);
+        unsigned mask = mask_avx512(x, VECTOR_SIMD_EQ, v, is_float);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + find_scalar(arr + i, n - i, val, is_float);
+}
+
+// Sums and float min/max are memory bound, the AVX2 versions are kept, as
+// well as the intersection which would need 16 rotations
+static const struct kernels avx512_kernels = {
+    .filter = filter_avx512,
+    .affine_u32 = affine_u32_avx512,
+    .affine_f32 = affine_f32_avx512,
+    .sum_u32 = sum_u32_avx2,
+    .sum_f32 = sum_f32_avx2,
+    .minmax_u32 = minmax_u32_avx512,
+    .minmax_f32 = minmax_f32_avx2,
+    .find = find_avx512,
+    .intersect = intersect_avx2,
+};
+
+#endif /* TUPPERWARE_X86 */
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+static const struct kernels *kernels_table = &scalar_kernels;
+static enum cpu_level kernels_level = CPU_SCALAR;
+
+static void init_kernels(void) {
+    kernels_level = cpu_level();
+
+    switch (kernels_level) {
+#ifdef TUPPERWARE_X86
+    case CPU_AVX512:
+        init_compact_lut();
+        kernels_table = &avx512_kernels;
+        break;
+    case CPU_AVX2:
+        init_compact_lut();
+        kernels_table = &avx2_kernels;
+        break;
+    case CPU_SSE2:
+        kernels_table = &sse2_kernels;
+        break;
+#endif
+    default:
+        kernels_level = CPU_SCALAR;
+        kernels_table = &scalar_kernels;
+        break;
+    }
+}
+
+static const struct kernels *kernels(void) {
+    pthread_once(&kernels_once, init_kernels);
+    return kernels_table;
+}
+
+const char *vector_simd_isa(void) {
+    kernels();
+    return cpu_level_name(kernels_level);
+}
+
+static bool has_u32(const struct vector *v) {
+    return v && v->size == sizeof(uint32_t);
+}
+
+static bool has_f32(const struct vector *v) {
+    return v && v->size == sizeof(float);
+}
+
+static bool append(struct vector *res, const uint32_t *elems, size_t n) {
+    if (!n)
+        return true;
+
+    size_t needed = res->nmemb + n;
+    if (needed > res->cap) {
+        size_t cap = res->cap * 2;
+        if (!vector_reserve(res, cap > needed ? cap : needed))
+            return false;
+    }
+
+    memcpy((uint32_t *)res->arr + res->nmemb, elems, n * sizeof(*elems));
+    res->nmemb += n;
+
+    return true;
+}
+
+static bool filter(struct vector *res, struct vector *v,
+        enum vector_simd_cmp cmp, uint32_t val, bool is_float) {
+    const struct kernels *k = kernels();
+    uint32_t buf[FILTER_CHUNK + FILTER_SLACK];
+    uint32_t *arr = v->arr;
+    size_t kept = 0;
+
+    for (size_t i = 0; i < v->nmemb; i += FILTER_CHUNK) {
+        size_t n = v->nmemb - i;
+        if (n > FILTER_CHUNK)
+            n = FILTER_CHUNK;
+
+        size_t m = k->filter(arr + kept, arr + i, n, cmp, val, is_float, buf);
+        if (!append(res, buf, m))
+            return false; // Undefined state at this point...
+        kept += n - m;
+    }
+
+    v->nmemb = kept;
+
+    return true;
+}
+
+bool vector_simd_filter_u32(struct vector *res,
+        struct vector *v, enum vector_simd_cmp cmp, uint32_t val) {
+    if (!has_u32(res) || !has_u32(v))
+        return false;
+    return filter(res, v, cmp, val, false);
+}
+
+bool vector_simd_filter_f32(struct vector *res,
+        struct vector *v, enum vector_simd_cmp cmp, float val) {
+    if (!has_f32(res) || !has_f32(v))
+        return false;
+    return filter(res, v, cmp, as_bits(val), true);
+}
+
+bool vector_simd_affine_u32(struct vector *v, uint32_t mul, uint32_t add) {
+    if (!has_u32(v))
+        return false;
+
+    kernels()->affine_u32(v->arr, v->nmemb, mul, add);
+
+    return true;
+}
+
+bool vector_simd_affine_f32(struct vector *v, float mul, float add) {
+    if (!has_f32(v))
+        return false;
+
+    kernels()->affine_f32(v->arr, v->nmemb, mul, add);
+
+    return true;
+}
+
+bool vector_simd_sum_u32(const struct vector *v, uint64_t *output) {
+    if (!has_u32(v) || !output)
+        return false;
+
+    *output = kernels()->sum_u32(v->arr, v->nmemb);
+
+    return true;
+}
+
+bool vector_simd_sum_f32(const struct vector *v, double *output) {
+    if (!has_f32(v) || !output)
+        return false;
+
+    *output = kernels()->sum_f32(v->arr, v->nmemb);
+
+    return true;
+}
+
+static bool minmax_u32(const struct vector *v, uint32_t *min, uint32_t *max) {
+    if (!has_u32(v) || !v->nmemb)
+        return false;
+
+    *min = *max = *(uint32_t *)v->arr;
+    kernels()->minmax_u32(v->arr, v->nmemb, min, max);
+
+    return true;
+}
+
+static bool minmax_f32(const struct vector *v, float *min, float *max) {
+    if (!has_f32(v) || !v->nmemb)
+        return false;
+
+    *min = *max = *(float *)v->arr;
+    kernels()->minmax_f32(v->arr, v->nmemb, min, max);
+
+    return true;
+}
+
+bool vector_simd_min_u32(const struct vector *v, uint32_t *output) {
+    uint32_t max;
+    return output && minmax_u32(v, output, &max);
+}
+
+bool vector_simd_max_u32(const struct vector *v, uint32_t *output) {
+    uint32_t min;
+    return output && minmax_u32(v, &min, output);
+}
+
+bool vector_simd_min_f32(const struct vector *v, float *output) {
+    float max;
+    return output && minmax_f32(v, output, &max);
+}
+
+bool vector_simd_max_f32(const struct vector *v, float *output) {
+    float min;
+    return output && minmax_f32(v, &min, output);
+}
+
+static bool find(const struct vector *v,
+        uint32_t val, bool is_float, size_t *index) {
+    size_t i = kernels()->find(v->arr, v->nmemb, val, is_float);
+    if (i == v->nmemb)
+        return false;
+
+    if (index)
+        *index = i;
+
+    return true;
+}
+
+bool vector_simd_find_u32(const struct vector *v, uint32_t val, size_t *index) {
+    if (!has_u32(v))
+        return false;
+    return find(v, val, false, index);
+}
+
+bool vector_simd_find_f32(const struct vector *v, float val, size_t *index) {
+    if (!has_f32(v))
+        return false;
+    return find(v, as_bits(val), true, index);
+}
+
+// Used when one side is much smaller than the other
+static size_t intersect_gallop(const uint32_t *small, size_t nsmall,
+        const uint32_t *large, size_t nlarge, uint32_t *out) {
+    size_t k = 0;
+    size_t j = 0;
+
+    for (size_t i = 0; i < nsmall && j < nlarge; ++i) {
+        uint32_t x = small[i];
+        size_t lo = j;
+        size_t hi = j;
+        size_t step = 1;
+        while (hi < nlarge && large[hi] < x) {
+            lo = hi + 1;
+            hi += step;
+            step *= 2;
+        }
+        if (hi > nlarge)
+            hi = nlarge;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (large[mid] < x)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        j = lo;
+        if (j < nlarge && large[j] == x)
+            out[k++] = x;
+    }
+
+    return k;
+}
+
+bool vector_simd_set_intersection_u32(struct vector *res,
+        const struct vector *lhs, const struct vector *rhs) {
+    if (!has_u32(res) || !has_u32(lhs) || !has_u32(rhs))
+        return false;
+    if (res == lhs || res == rhs)
+        return false;
+
+    size_t nlhs = lhs->nmemb;
+    size_t nrhs = rhs->nmemb;
+    size_t n = nlhs < nrhs ? nlhs : nrhs;
+    if (!n)
+        return true;
+    if (!vector_reserve(res, res->nmemb + n + FILTER_SLACK))
+        return false;
+
+    uint32_t *out = (uint32_t *)res->arr + res->nmemb;
+    if (nlhs / INTERSECT_SKEW >= nrhs)
+        res->nmemb += intersect_gallop(rhs->arr, nrhs, lhs->arr, nlhs, out);
+    else if (nrhs / INTERSECT_SKEW >= nlhs)
+        res->nmemb += intersect_gallop(lhs->arr, nlhs, rhs->arr, nrhs, out);
+    else
+        res->nmemb += kernels()->intersect(lhs->arr, nlhs, rhs->arr, nrhs, out);
+
+    return true;
+}
@@ -0,0 +1,704 @@
+#include "tupperware/vector_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc32.h"
+
+#define MAGIC "TPWSTRM"
+#define VERSION 1
+#define ENDIANNESS 0x01020304u
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_LOG 12
+
+#define DELTA_BLOCK 128
+
+struct stream_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianness;
+    uint64_t size;
+    uint32_t chunk;
+    uint32_t codec;
+    uint32_t reserved;
+    // Covers every field above
+    uint32_t crc;
+};
+
+// `nmemb` elements encoded in `len` bytes. The stream ends with a chunk
+// without elements, whose payload is the total number of elements.
+struct chunk_header {
+    uint32_t nmemb;
+    uint32_t codec;
+    uint32_t len;
+    uint32_t crc;
+};
+
+static size_t chunk_length(size_t size) {
+    return size < VECTOR_STREAM_CHUNK_BYTES
+        ? VECTOR_STREAM_CHUNK_BYTES / size
+        : 1;
+}
+
+static uint32_t header_crc(const struct stream_header *h) {
+    return crc32c(0, h, offsetof(struct stream_header, crc));
+}
+
+static uint32_t load32(const unsigned char *p) {
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+static uint32_t lz_hash(uint32_t x) {
+    return (x * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+// Lengths that do not fit in a token nibble continue in bytes of up to 255
+static bool lz_put_length(unsigned char **out,
+        const unsigned char *end, size_t len) {
+    for (; len >= 255; len -= 255) {
+        if (*out == end)
+            return false;
+        *(*out)++ = 255;
+    }
+    if (*out == end)
+        return false;
+    *(*out)++ = len;
+
+    return true;
+}
+
+static bool lz_get_length(const unsigned char **in,
+        const unsigned char *end, size_t *len) {
+    unsigned char byte;
+
+    do {
+        if (*in == end)
+            return false;
+        byte = *(*in)++;
+        *len += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+// A token with both lengths, the literals, then the offset of the match. The
+// last sequence only has literals.
+static bool lz_put_sequence(unsigned char **out, const unsigned char *end,
+        const unsigned char *lit, size_t nlit, size_t offset, size_t match) {
+    if (*out == end)
+        return false;
+    unsigned char *token = (*out)++;
+    *token = (nlit < 15 ? nlit : 15) << 4;
+    if (nlit >= 15 && !lz_put_length(out, end, nlit - 15))
+        return false;
+    if ((size_t)(end - *out) < nlit)
+        return false;
+    memcpy(*out, lit, nlit);
+    *out += nlit;
+
+    if (!match)
+        return true;
+
+    match -= LZ_MIN_MATCH;
+    *token |= match < 15 ? match : 15;
+    if (end - *out < 2)
+        return false;
+    *(*out)++ = offset & 0xff;
+    *(*out)++ = offset >> 8;
+    if (match >= 15 && !lz_put_length(out, end, match - 15))
+        return false;
+
+    return true;
+}
+
+// 0 if the result does not fit in `cap` bytes
+static size_t lz_encode(const unsigned char *src, size_t n,
+        unsigned char *dst, size_t cap) {
+    // Positions are offset by one, 0 means empty
+    uint32_t table[1 << LZ_HASH_LOG] = { 0 };
+    unsigned char *out = dst;
+    unsigned char *end = dst + cap;
+    size_t anchor = 0;
+    size_t i = 0;
+
+    if (n > UINT32_MAX)
+        return 0;
+
+    while (i + LZ_MIN_MATCH <= n) {
+        uint32_t seq = load32(src + i);
+        uint32_t h = lz_hash(seq);
+        size_t cand = table[h];
+        table[h] = i + 1;
+
+        if (!cand || i - (cand - 1) > LZ_MAX_OFFSET
+                || load32(src + cand - 1) != seq) {
+            // Skip faster through data that does not compress
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+
+        --cand;
+        size_t len = LZ_MIN_MATCH;
+        while (i + len < n && src[cand + len] == src[i + len])
+            ++len;
+
+        if (!lz_put_sequence(&out, end,
+                    src + anchor, i - anchor, i - cand, len))
+            return 0;
+        i += len;
+        anchor = i;
+    }
+
+    if (!lz_put_sequence(&out, end, src + anchor, n - anchor, 0, 0))
+        return 0;
+
+    return out - dst;
+}
+
+static bool lz_decode(const unsigned char *src, size_t n,
+        unsigned char *dst, size_t len) {
+    const unsigned char *end = src + n;
+    size_t o = 0;
+
+    for (;;) {
+        if (src == end)
+            return false;
+        unsigned token = *src++;
+
+        size_t nlit = token >> 4;
+        if (nlit == 15 && !lz_get_length(&src, end, &nlit))
+            return false;
+        if ((size_t)(end - src) < nlit || len - o < nlit)
+            return false;
+        memcpy(dst + o, src, nlit);
+        src += nlit;
+        o += nlit;
+
+        if (src == end)
+            return o == len;
+
+        if (end - src < 2)
+            return false;
+        size_t offset = src[0] | (size_t)src[1] << 8;
+        src += 2;
+        size_t match = token & 15;
+        if (match == 15 && !lz_get_length(&src, end, &match))
+            return false;
+        match += LZ_MIN_MATCH;
+        if (!offset || offset > o || len - o < match)
+            return false;
+
+        // Overlapping matches repeat the last `offset` bytes
+        unsigned char *p = dst + o;
+        if (offset >= match)
+            memcpy(p, p - offset, match);
+        else
+            for (size_t k = 0; k < match; ++k)
+                p[k] = p[k - offset];
+        o += match;
+    }
+}
+
+static uint64_t load_elem(const unsigned char *p, size_t size) {
+    if (size == sizeof(uint32_t))
+        return load32(p);
+
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+static void store_elem(unsigned char *p, size_t size, uint64_t x) {
+    if (size == sizeof(uint32_t)) {
+        uint32_t y = x;
+        memcpy(p, &y, sizeof(y));
+    } else {
+        memcpy(p, &x, sizeof(x));
+    }
+}
+
+#define DELTA_ZIGZAG 0x80
+
+// Differences are zigzag encoded at the width of the elements in blocks with
+// decreases, so that small ones stay small too
+static uint64_t zigzag(uint64_t d, size_t size) {
+    if (size == sizeof(uint32_t)) {
+        uint32_t x = d;
+        return (uint32_t)(x << 1) ^ (uint32_t)-(x >> 31);
+    }
+    return (d << 1) ^ -(d >> 63);
+}
+
+static uint64_t unzigzag(uint64_t z) {
+    return (z >> 1) ^ -(z & 1);
+}
+
+struct bit_writer {
+    unsigned char *out;
+    unsigned char *end;
+    uint64_t acc;
+    unsigned nbits;
+};
+
+struct bit_reader {
+    const unsigned char *in;
+    const unsigned char *end;
+    uint64_t acc;
+    unsigned nbits;
+};
+
+// Bit streams are little endian whatever the machine, these compile to plain
+// loads and stores on little endian ones
+static void store_le32(unsigned char *p, uint32_t x) {
+    p[0] = x;
+    p[1] = x >> 8;
+    p[2] = x >> 16;
+    p[3] = x >> 24;
+}
+
+static uint64_t load_le64(const unsigned char *p) {
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8
+        | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24
+        | (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40
+        | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+// At most 32 bits at a time, there are less than 32 bits left in the
+// accumulator between calls
+static bool put_bits(struct bit_writer *bw, uint64_t x, unsigned width) {
+    if (width > 32) {
+        if (!put_bits(bw, x & UINT32_MAX, 32))
+            return false;
+        x >>= 32;
+        width -= 32;
+    }
+
+    bw->acc |= x << bw->nbits;
+    bw->nbits += width;
+    if (bw->nbits >= 32) {
+        if (bw->end - bw->out < 4)
+            return false;
+        store_le32(bw->out, bw->acc);
+        bw->out += 4;
+        bw->acc >>= 32;
+        bw->nbits -= 32;
+    }
+
+    return true;
+}
+
+// Blocks end on a byte boundary
+static bool flush_bits(struct bit_writer *bw) {
+    for (; bw->nbits; bw->nbits = bw->nbits > 8 ? bw->nbits - 8 : 0) {
+        if (bw->out == bw->end)
+            return false;
+        *bw->out++ = bw->acc;
+        bw->acc >>= 8;
+    }
+
+    return true;
+}
+
+static bool get_bits(struct bit_reader *br, unsigned width, uint64_t *x) {
+    if (width > 32) {
+        uint64_t lo;
+        uint64_t hi;
+        if (!get_bits(br, 32, &lo) || !get_bits(br, width - 32, &hi))
+            return false;
+        *x = lo | hi << 32;
+        return true;
+    }
+
+    for (; br->nbits < width; br->nbits += 8) {
+        if (br->in == br->end)
+            return false;
+        br->acc |= (uint64_t)*br->in++ << br->nbits;
+    }
+
+    *x = br->acc & ((UINT64_C(1) << width) - 1);
+    br->acc >>= width;
+    br->nbits -= width;
+
+    return true;
+}
+
+// `in` holds at least the `(n * width + 7) / 8` bytes of the block. Values
+// are read with unaligned 8 bytes loads when they cannot overflow the end.
+static void unpack(const unsigned char *in, const unsigned char *end,
+        unsigned width, uint64_t *out, size_t n) {
+    size_t bytes = (n * width + 7) / 8;
+
+    if (width <= 56 && (size_t)(end - in) >= bytes + 8) {
+        uint64_t mask = (UINT64_C(1) << width) - 1;
+        for (size_t k = 0, bit = 0; k < n; ++k, bit += width)
+            out[k] = (load_le64(in + bit / 8) >> (bit % 8)) & mask;
+        return;
+    }
+
+    struct bit_reader br = { in, in + bytes, 0, 0 };
+    for (size_t k = 0; k < n; ++k)
+        get_bits(&br, width, &out[k]);
+}
+
+// Each block is its bit width on a byte, with `DELTA_ZIGZAG` set if there are
+// decreases, then the packed differences
+static size_t delta_encode(const unsigned char *src, size_t nmemb,
+        size_t size, unsigned char *dst, size_t cap) {
+    struct bit_writer bw = { dst, dst + cap, 0, 0 };
+    uint64_t sign = UINT64_C(1) << (8 * size - 1);
+    uint64_t mask = sign | (sign - 1);
+    uint64_t deltas[DELTA_BLOCK];
+    uint64_t prev = 0;
+
+    for (size_t i = 0; i < nmemb; i += DELTA_BLOCK) {
+        size_t n = nmemb - i < DELTA_BLOCK ? nmemb - i : DELTA_BLOCK;
+        uint64_t all = 0;
+        for (size_t k = 0; k < n; ++k) {
+            uint64_t x = load_elem(src + (i + k) * size, size);
+            deltas[k] = (x - prev) & mask;
+            all |= deltas[k];
+            prev = x;
+        }
+
+        unsigned flags = 0;
+        if (all & sign) {
+            flags = DELTA_ZIGZAG;
+            all = 0;
+            for (size_t k = 0; k < n; ++k) {
+                deltas[k] = zigzag(deltas[k], size);
+                all |= deltas[k];
+            }
+        }
+
+        unsigned width = all ? 64 - __builtin_clzll(all) : 0;
+        if (bw.out == bw.end)
+            return 0;
+        *bw.out++ = width | flags;
+        for (size_t k = 0; k < n; ++k)
+            if (!put_bits(&bw, deltas[k], width))
+                return 0;
+        if (!flush_bits(&bw))
+            return 0;
+    }
+
+    return bw.out - dst;
+}
+
+static bool delta_decode(const unsigned char *src, size_t n,
+        unsigned char *dst, size_t nmemb, size_t size) {
+    const unsigned char *end = src + n;
+    uint64_t deltas[DELTA_BLOCK];
+    uint64_t prev = 0;
+
+    if (size != sizeof(uint32_t) && size != sizeof(uint64_t))
+        return false;
+
+    for (size_t i = 0; i < nmemb; i += DELTA_BLOCK) {
+        size_t count = nmemb - i < DELTA_BLOCK ? nmemb - i : DELTA_BLOCK;
+        if (src == end)
+            return false;
+        bool zigzagged = *src & DELTA_ZIGZAG;
+        unsigned width = *src++ & ~DELTA_ZIGZAG;
+        size_t bytes = (count * width + 7) / 8;
+        if (width > 8 * size || (size_t)(end - src) < bytes)
+            return false;
+
+        unpack(src, end, width, deltas, count);
+        src += bytes;
+
+        if (zigzagged)
+            for (size_t k = 0; k < count; ++k)
+                deltas[k] = unzigzag(deltas[k]);
+        for (size_t k = 0; k < count; ++k) {
+            prev += deltas[k];
+            store_elem(dst + (i + k) * size, size, prev);
+        }
+    }
+
+    return src == end;
+}
+
+static size_t encode(enum vector_stream_codec codec, const void *elems,
+        size_t nmemb, size_t size, void *dst, size_t cap) {
+    switch (codec) {
+    case VECTOR_STREAM_LZ:
+        return lz_encode(elems, nmemb * size, dst, cap);
+    case VECTOR_STREAM_DELTA:
+        return delta_encode(elems, nmemb, size, dst, cap);
+    default:
+        return 0;
+    }
+}
+
+static bool decode(enum vector_stream_codec codec, const void *src,
+        size_t len, void *elems, size_t nmemb, size_t size) {
+    switch (codec) {
+    case VECTOR_STREAM_RAW:
+        return len == nmemb * size;
+    case VECTOR_STREAM_LZ:
+        return lz_decode(src, len, elems, nmemb * size);
+    case VECTOR_STREAM_DELTA:
+        return delta_decode(src, len, elems, nmemb, size);
+    default:
+        return false;
+    }
+}
+
+bool vector_stream_writer_init(struct vector_stream_writer *w,
+        FILE *file, size_t size, enum vector_stream_codec codec) {
+    if (!w || !file || !size || (unsigned)codec > VECTOR_STREAM_DELTA)
+        return false;
+    if (codec == VECTOR_STREAM_DELTA
+            && size != sizeof(uint32_t) && size != sizeof(uint64_t))
+        return false;
+
+    size_t chunk = chunk_length(size);
+    if (chunk * size > UINT32_MAX)
+        return false;
+
+    struct stream_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(h.magic));
+    h.version = VERSION;
+    h.endianness = ENDIANNESS;
+    h.size = size;
+    h.chunk = chunk;
+    h.codec = codec;
+    h.crc = header_crc(&h);
+
+    w->file = file;
+    w->size = size;
+    w->codec = codec;
+    w->chunk = chunk;
+    w->pending = malloc(chunk * size);
+    w->npending = 0;
+    // Encoded chunks larger than the raw elements are not kept
+    w->encoded = codec != VECTOR_STREAM_RAW ? malloc(chunk * size) : NULL;
+    w->nmemb = 0;
+    w->failed = false;
+
+    if (!w->pending || (codec != VECTOR_STREAM_RAW && !w->encoded)
+            || fwrite(&h, sizeof(h), 1, file) != 1) {
+        free(w->pending);
+        free(w->encoded);
+        w->file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static bool write_chunk(struct vector_stream_writer *w,
+        const char *elems, size_t nmemb) {
+    size_t raw = nmemb * w->size;
+    const void *payload = elems;
+    struct chunk_header c = {
+        .nmemb = nmemb,
+        .codec = VECTOR_STREAM_RAW,
+        .len = raw,
+    };
+
+    size_t len = encode(w->codec, elems, nmemb, w->size, w->encoded, raw);
+    if (len && len < raw) {
+        c.codec = w->codec;
+        c.len = len;
+        payload = w->encoded;
+    }
+    c.crc = crc32c(0, payload, c.len);
+
+    if (fwrite(&c, sizeof(c), 1, w->file) != 1
+            || fwrite(payload, 1, c.len, w->file) != c.len) {
+        w->failed = true;
+        return false;
+    }
+
+    w->nmemb += nmemb;
+
+    return true;
+}
+
+bool vector_stream_write(struct vector_stream_writer *w,
+        const void *elems, size_t nmemb) {
+    if (!w || !w->file || w->failed || (!elems && nmemb))
+        return false;
+
+    const char *p = elems;
+    while (nmemb) {
+        // Full chunks are encoded straight from the caller's elements
+        if (!w->npending && nmemb >= w->chunk) {
+            if (!write_chunk(w, p, w->chunk))
+                return false;
+            p += w->chunk * w->size;
+            nmemb -= w->chunk;
+            continue;
+        }
+
+        size_t n = w->chunk - w->npending;
+        if (n > nmemb)
+            n = nmemb;
+        memcpy(w->pending + w->npending * w->size, p, n * w->size);
+        w->npending += n;
+        p += n * w->size;
+        nmemb -= n;
+
+        if (w->npending == w->chunk) {
+            if (!write_chunk(w, w->pending, w->chunk))
+                return false;
+            w->npending = 0;
+        }
+    }
+
+    return true;
+}
+
+bool vector_stream_write_vector(struct vector_stream_writer *w,
+        const struct vector *v) {
+    if (!w || !v || v->size != w->size)
+        return false;
+    return vector_stream_write(w, v->arr, v->nmemb);
+}
+
+bool vector_stream_writer_finish(struct vector_stream_writer *w) {
+    if (!w || !w->file)
+        return false;
+
+    bool ok = !w->failed;
+    ok = ok && (!w->npending || write_chunk(w, w->pending, w->npending));
+
+    struct chunk_header c = {
+        .nmemb = 0,
+        .codec = VECTOR_STREAM_RAW,
+        .len = sizeof(w->nmemb),
+        .crc = crc32c(0, &w->nmemb, sizeof(w->nmemb)),
+    };
+    ok = ok && fwrite(&c, sizeof(c), 1, w->file) == 1
+        && fwrite(&w->nmemb, sizeof(w->nmemb), 1, w->file) == 1
+        && !fflush(w->file);
+
+    free(w->pending);
+    free(w->encoded);
+    memset(w, 0, sizeof(*w));
+
+    return ok;
+}
+
+bool vector_stream_reader_init(struct vector_stream_reader *r, FILE *file) {
+    if (!r || !file)
+        return false;
+
+    struct stream_header h;
+    if (fread(&h, sizeof(h), 1, file) != 1)
+        return false;
+    if (memcmp(h.magic, MAGIC, sizeof(h.magic)) || h.version != VERSION)
+        return false;
+    if (h.endianness != ENDIANNESS || h.crc != header_crc(&h))
+        return false;
+    if (!h.size || h.chunk != chunk_length(h.size))
+        return false;
+
+    r->file = file;
+    r->size = h.size;
+    r->chunk = h.chunk;
+    r->encoded = malloc(r->chunk * r->size);
+    r->nmemb = 0;
+    r->end = false;
+    if (!r->encoded) {
+        r->file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void vector_stream_reader_clear(struct vector_stream_reader *r) {
+    if (!r)
+        return;
+
+    free(r->encoded);
+    memset(r, 0, sizeof(*r));
+}
+
+size_t vector_stream_elem_size(const struct vector_stream_reader *r) {
+    if (!r)
+        return 0;
+    return r->size;
+}
+
+bool vector_stream_reader_end(const struct vector_stream_reader *r) {
+    return r && r->end;
+}
+
+static bool read_end(struct vector_stream_reader *r,
+        const struct chunk_header *c) {
+    uint64_t total;
+
+    if (c->len != sizeof(total))
+        return false;
+    if (fread(&total, sizeof(total), 1, r->file) != 1)
+        return false;
+    if (crc32c(0, &total, sizeof(total)) != c->crc || total != r->nmemb)
+        return false;
+
+    r->end = true;
+
+    return true;
+}
+
+static bool read_chunk(struct vector_stream_reader *r, struct vector *v) {
+    struct chunk_header c;
+    if (fread(&c, sizeof(c), 1, r->file) != 1)
+        return false;
+    // The end of the stream is not a chunk, tell it apart with `r->end`
+    if (!c.nmemb) {
+        read_end(r, &c);
+        return false;
+    }
+
+    size_t raw = c.nmemb * r->size;
+    if (c.nmemb > r->chunk || c.len > raw)
+        return false;
+
+    size_t needed = v->nmemb + c.nmemb;
+    if (needed > v->cap && !vector_reserve(v,
+                needed > 2 * v->cap ? needed : 2 * v->cap))
+        return false;
+
+    // Raw chunks are read in place
+    char *dst = (char *)v->arr + v->nmemb * v->size;
+    char *payload = c.codec == VECTOR_STREAM_RAW ? dst : r->encoded;
+    if (fread(payload, 1, c.len, r->file) != c.len)
+        return false;
+    if (crc32c(0, payload, c.len) != c.crc)
+        return false;
+    if (!decode(c.codec, payload, c.len, dst, c.nmemb, r->size))
+        return false;
+
+    v->nmemb += c.nmemb;
+    r->nmemb += c.nmemb;
+
+    return true;
+}
+
+bool vector_stream_read_chunk(struct vector_stream_reader *r,
+        struct vector *v) {
+    if (!r || !v || !r->file || r->end || v->size != r->size)
+        return false;
+
+    // Nothing can be read after an invalid chunk
+    if (!read_chunk(r, v) && !r->end)
+        r->file = NULL;
+
+    return r->file && !r->end;
+}
+
+bool vector_stream_read_vector(struct vector_stream_reader *r,
+        struct vector *v) {
+    while (vector_stream_read_chunk(r, v))
+        continue;
+
+    return vector_stream_reader_end(r);
+}
@@ -332,6 +332,29 @@ Test(avl, remove_at_multi_root_first) {
     cr_assert_null(tree.root);
 }
 
+Test(avl, remove_many) {
+    struct int_tree t[1000];
+    size_t count = 0;
+    struct avl tree;
+    avl_init(&tree, int_tree_cmp, &count);
+
+    for (int i = 0; i < 1000; ++i) {
+        t[i].val = (i * 337) % 1000;
+        t[i].avl = AVL_NODE_INIT_VAL;
+        cr_assert(avl_insert(&tree, &t[i].avl, NULL));
+    }
+
+    // Removing inner nodes takes their predecessor or successor
+    for (int i = 0; i < 1000; ++i) {
+        struct int_tree *n = &t[(i * 613) % 1000];
+        cr_assert(avl_remove_at(&tree, &n->avl));
+        cr_assert_null(avl_find(&tree, &n->avl));
+        cr_assert_eq(avl_size(&tree), 999 - (size_t)i);
+        cr_assert_leq(avl_height(&tree), 15);
+    }
+    cr_assert_null(tree.root);
+}
+
 Test(avl, find_null) {
     cr_assert_null(avl_find(NULL, NULL));
 
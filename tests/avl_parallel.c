@@ -0,0 +1,115 @@
+#include <criterion/criterion.h>
+
+#include <stdlib.h>
+
+#include "tupperware/avl_parallel.h"
+
+TestSuite(avl_parallel, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+#define NODES 100000
+
+// No scheduler at all for 0
+static const size_t nthreads[] = { 0, 1, 3 };
+
+struct int_tree {
+    int val;
+    int seen;
+    struct avl_node avl;
+};
+
+static int int_tree_cmp(const struct avl_node *lhs,
+        const struct avl_node *rhs, void *cookie) {
+    (void)cookie;
+    struct int_tree *l = CONTAINER_OF(struct int_tree, avl, lhs);
+    struct int_tree *r = CONTAINER_OF(struct int_tree, avl, rhs);
+
+    if (l->val < r->val)
+        return -1;
+    return (l->val > r->val);
+}
+
+static struct scheduler *start(struct scheduler *s, size_t nthreads) {
+    if (!nthreads)
+        return NULL;
+    cr_assert(scheduler_init(s, nthreads));
+    return s;
+}
+
+static struct int_tree *fill(struct avl *tree) {
+    struct int_tree *arr = calloc(NODES, sizeof(*arr));
+    avl_init(tree, int_tree_cmp, NULL);
+    for (int i = 0; i < NODES; ++i) {
+        arr[i].val = i;
+        arr[i].avl = AVL_NODE_INIT_VAL;
+        cr_assert(avl_insert(tree, &arr[i].avl, NULL));
+    }
+    return arr;
+}
+
+static void int_tree_visit(struct avl_node *n, void *cookie) {
+    size_t *count = cookie;
+    __atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+    ++CONTAINER_OF(struct int_tree, avl, n)->seen;
+}
+
+// Children are destroyed first and unlinked
+static void int_tree_dtor(struct avl_node *n, void *cookie) {
+    cr_assert_null(n->left);
+    cr_assert_null(n->right);
+    int_tree_visit(n, cookie);
+}
+
+Test(avl_parallel, null) {
+    struct avl tree;
+    avl_init(&tree, int_tree_cmp, NULL);
+
+    avl_parallel_map(NULL, int_tree_visit, NULL, NULL);
+    avl_parallel_map(&tree, NULL, NULL, NULL);
+    avl_parallel_clear(NULL, int_tree_dtor, NULL, NULL);
+    avl_parallel_clear(&tree, NULL, NULL, NULL);
+
+    // Empty tree
+    avl_parallel_map(&tree, int_tree_visit, NULL, NULL);
+    avl_parallel_clear(&tree, int_tree_dtor, NULL, NULL);
+}
+
+Test(avl_parallel, map) {
+    for (size_t t = 0; t < ARR_SIZE(nthreads); ++t) {
+        struct scheduler sched;
+        struct scheduler *s = start(&sched, nthreads[t]);
+        struct avl tree;
+        struct int_tree *arr = fill(&tree);
+        size_t count = 0;
+
+        avl_parallel_map(&tree, int_tree_visit, &count, s);
+        cr_assert_eq(count, NODES);
+        for (int i = 0; i < NODES; ++i)
+            cr_assert_eq(arr[i].seen, 1);
+        cr_assert_eq(avl_size(&tree), NODES);
+
+        if (s)
+            scheduler_clear(s);
+        free(arr);
+    }
+}
+
+Test(avl_parallel, clear) {
+    for (size_t t = 0; t < ARR_SIZE(nthreads); ++t) {
+        struct scheduler sched;
+        struct scheduler *s = start(&sched, nthreads[t]);
+        struct avl tree;
+        struct int_tree *arr = fill(&tree);
+        size_t count = 0;
+
+        avl_parallel_clear(&tree, int_tree_dtor, &count, s);
+        cr_assert_eq(count, NODES);
+        for (int i = 0; i < NODES; ++i)
+            cr_assert_eq(arr[i].seen, 1);
+
+        if (s)
+            scheduler_clear(s);
+        free(arr);
+    }
+}
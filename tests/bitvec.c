@@ -0,0 +1,277 @@
+#include <criterion/criterion.h>
+
+#include <stdlib.h>
+
+#include "tupperware/bitvec.h"
+
+TestSuite(bitvec, .timeout = 15);
+
+static void fill(struct bitvec *b, bool *bits, size_t n, int density) {
+    cr_assert(bitvec_init(b));
+    for (size_t i = 0; i < n; ++i) {
+        bits[i] = rand() % 100 < density;
+        cr_assert(bitvec_push_back(b, bits[i]));
+    }
+}
+
+static void check_bits(const struct bitvec *b, const bool *bits, size_t n) {
+    size_t count = 0;
+
+    cr_assert_eq(bitvec_length(b), n);
+    for (size_t i = 0; i < n; ++i) {
+        cr_assert_eq(bitvec_test(b, i), bits[i]);
+        count += bits[i];
+    }
+    cr_assert_not(bitvec_test(b, n));
+    cr_assert_eq(bitvec_popcount(b), count);
+}
+
+Test(bitvec, init) {
+    struct bitvec b;
+
+    cr_assert(bitvec_init(&b));
+    cr_assert(bitvec_empty(&b));
+    cr_assert_eq(bitvec_capacity(&b), 0);
+    bitvec_clear(&b);
+
+    cr_assert(bitvec_with_cap(&b, 100));
+    cr_assert(bitvec_empty(&b));
+    cr_assert_eq(bitvec_capacity(&b), 128);
+    bitvec_clear(&b);
+
+    cr_assert_not(bitvec_init(NULL));
+    cr_assert_not(bitvec_with_cap(NULL, 1));
+    bitvec_clear(NULL);
+    cr_assert_eq(bitvec_length(NULL), 0);
+    cr_assert_eq(bitvec_capacity(NULL), 0);
+    cr_assert(bitvec_empty(NULL));
+}
+
+Test(bitvec, push_back) {
+    struct bitvec b;
+    bool bits[1000];
+
+    fill(&b, bits, 1000, 50);
+    check_bits(&b, bits, 1000);
+    cr_assert_eq(bitvec_capacity(&b), 1024);
+    cr_assert_not(bitvec_push_back(NULL, true));
+
+    bitvec_clear(&b);
+}
+
+Test(bitvec, set_reset_flip) {
+    struct bitvec b;
+    bool bits[300] = { 0 };
+
+    cr_assert(bitvec_init(&b));
+    cr_assert(bitvec_resize(&b, 300));
+    check_bits(&b, bits, 300);
+
+    for (size_t i = 0; i < 300; i += 3) {
+        cr_assert(bitvec_set(&b, i));
+        bits[i] = true;
+    }
+    for (size_t i = 0; i < 300; i += 6) {
+        cr_assert(bitvec_reset(&b, i));
+        bits[i] = false;
+    }
+    for (size_t i = 0; i < 300; i += 5) {
+        cr_assert(bitvec_flip(&b, i));
+        bits[i] = !bits[i];
+    }
+    check_bits(&b, bits, 300);
+
+    cr_assert_not(bitvec_set(&b, 300));
+    cr_assert_not(bitvec_reset(&b, 300));
+    cr_assert_not(bitvec_flip(&b, 300));
+    cr_assert_not(bitvec_set(NULL, 0));
+    cr_assert_not(bitvec_test(NULL, 0));
+
+    bitvec_clear(&b);
+}
+
+Test(bitvec, resize_fill) {
+    struct bitvec b;
+    bool bits[200];
+
+    cr_assert(bitvec_init(&b));
+    cr_assert(bitvec_resize(&b, 130));
+    cr_assert(bitvec_fill(&b, true));
+    cr_assert_eq(bitvec_popcount(&b), 130);
+
+    // Shrinking then growing back unsets the bits in between
+    cr_assert(bitvec_resize(&b, 70));
+    cr_assert_eq(bitvec_popcount(&b), 70);
+    cr_assert(bitvec_resize(&b, 200));
+    for (size_t i = 0; i < 200; ++i)
+        bits[i] = i < 70;
+    check_bits(&b, bits, 200);
+
+    cr_assert(bitvec_fill(&b, false));
+    cr_assert_eq(bitvec_popcount(&b), 0);
+    cr_assert_not(bitvec_fill(NULL, true));
+    cr_assert_not(bitvec_resize(NULL, 1));
+
+    bitvec_clear(&b);
+}
+
+Test(bitvec, next_set) {
+    struct bitvec b;
+    bool bits[5000];
+    size_t i;
+
+    fill(&b, bits, 5000, 1);
+    size_t expected = 0;
+    for (size_t from = 0; from < 5000; ++from) {
+        while (expected < 5000 && (expected < from || !bits[expected]))
+            ++expected;
+        if (expected == 5000) {
+            cr_assert_not(bitvec_next_set(&b, from, &i));
+            continue;
+        }
+        cr_assert(bitvec_next_set(&b, from, &i));
+        cr_assert_eq(i, expected);
+    }
+    cr_assert_not(bitvec_next_set(&b, 5000, &i));
+    cr_assert_not(bitvec_next_set(NULL, 0, &i));
+
+    bitvec_clear(&b);
+}
+
+static void check_level(const char *level) {
+    setenv("TUPPERWARE_SIMD", level, 1);
+
+    size_t lengths[] = { 0, 1, 63, 64, 65, 511, 1000, 100003 };
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(*lengths); ++l) {
+        size_t n = lengths[l];
+        bool *lbits = malloc(n + 1);
+        bool *rbits = malloc(n + 1);
+        bool *expected = malloc(n + 1);
+        struct bitvec lhs;
+        struct bitvec rhs;
+        struct bitvec res;
+        fill(&lhs, lbits, n, 30);
+        fill(&rhs, rbits, n, 60);
+        bitvec_init(&res);
+
+        cr_assert(bitvec_and(&res, &lhs, &rhs));
+        for (size_t i = 0; i < n; ++i)
+            expected[i] = lbits[i] && rbits[i];
+        check_bits(&res, expected, n);
+
+        cr_assert(bitvec_or(&res, &lhs, &rhs));
+        for (size_t i = 0; i < n; ++i)
+            expected[i] = lbits[i] || rbits[i];
+        check_bits(&res, expected, n);
+
+        cr_assert(bitvec_xor(&res, &lhs, &rhs));
+        for (size_t i = 0; i < n; ++i)
+            expected[i] = lbits[i] != rbits[i];
+        check_bits(&res, expected, n);
+
+        cr_assert(bitvec_andnot(&res, &lhs, &rhs));
+        for (size_t i = 0; i < n; ++i)
+            expected[i] = lbits[i] && !rbits[i];
+        check_bits(&res, expected, n);
+
+        // In place
+        cr_assert(bitvec_or(&lhs, &lhs, &rhs));
+        for (size_t i = 0; i < n; ++i)
+            expected[i] = lbits[i] || rbits[i];
+        check_bits(&lhs, expected, n);
+
+        bitvec_clear(&lhs);
+        bitvec_clear(&rhs);
+        bitvec_clear(&res);
+        free(lbits);
+        free(rbits);
+        free(expected);
+    }
+}
+
+Test(bitvec, scalar) {
+    check_level("scalar");
+}
+
+Test(bitvec, sse2) {
+    check_level("sse2");
+}
+
+Test(bitvec, avx2) {
+    check_level("avx2");
+}
+
+Test(bitvec, simd) {
+    check_level("avx512");
+}
+
+Test(bitvec, binary_invalid) {
+    struct bitvec lhs;
+    struct bitvec rhs;
+    bitvec_init(&lhs);
+    bitvec_init(&rhs);
+    bitvec_resize(&lhs, 10);
+    bitvec_resize(&rhs, 11);
+
+    cr_assert_not(bitvec_and(&lhs, &lhs, &rhs));
+    cr_assert_not(bitvec_or(NULL, &lhs, &lhs));
+    cr_assert_not(bitvec_xor(&lhs, NULL, &lhs));
+    cr_assert_not(bitvec_andnot(&lhs, &lhs, NULL));
+    cr_assert_eq(bitvec_popcount(NULL), 0);
+
+    bitvec_clear(&lhs);
+    bitvec_clear(&rhs);
+}
+
+Test(bitvec, rank_select) {
+    int densities[] = { 0, 1, 50, 99, 100 };
+    size_t n = 70000;
+    bool *bits = malloc(n);
+
+    for (size_t d = 0; d < sizeof(densities) / sizeof(*densities); ++d) {
+        struct bitvec b;
+        fill(&b, bits, n, densities[d]);
+
+        size_t x;
+        cr_assert_not(bitvec_rank(&b, 0, &x));
+        cr_assert(bitvec_build_index(&b));
+
+        size_t ones = 0;
+        for (size_t i = 0; i <= n; ++i) {
+            cr_assert(bitvec_rank(&b, i, &x));
+            cr_assert_eq(x, ones);
+            if (i < n && bits[i]) {
+                cr_assert(bitvec_select(&b, ones, &x));
+                cr_assert_eq(x, i);
+                ++ones;
+            }
+        }
+        cr_assert_not(bitvec_rank(&b, n + 1, &x));
+        cr_assert_not(bitvec_select(&b, ones, &x));
+
+        // Changes drop the index
+        if (n) {
+            cr_assert(bitvec_flip(&b, 0));
+            cr_assert_not(bitvec_rank(&b, 0, &x));
+            cr_assert_not(bitvec_select(&b, 0, &x));
+        }
+
+        bitvec_clear(&b);
+    }
+
+    cr_assert_not(bitvec_build_index(NULL));
+    free(bits);
+}
+
+Test(bitvec, rank_select_empty) {
+    struct bitvec b;
+    size_t x;
+    bitvec_init(&b);
+
+    cr_assert(bitvec_build_index(&b));
+    cr_assert(bitvec_rank(&b, 0, &x));
+    cr_assert_eq(x, 0);
+    cr_assert_not(bitvec_select(&b, 0, &x));
+
+    bitvec_clear(&b);
+}
@@ -0,0 +1,241 @@
+#include <criterion/criterion.h>
+
+#include <stdlib.h>
+
+#include "tupperware/bloom.h"
+
+TestSuite(bloom, .timeout = 15);
+
+#define KEYS 10000
+#define PROBES 100000
+
+Test(bloom, init_null) {
+    struct bloom f;
+    struct counting_bloom c;
+
+    cr_assert_not(bloom_init(NULL, 10, 0.01));
+    cr_assert_not(bloom_init(&f, 10, 0));
+    cr_assert_not(bloom_init(&f, 10, 1));
+    cr_assert_not(bloom_init(&f, 10, -0.5));
+    cr_assert_not(counting_bloom_init(NULL, 10, 0.01));
+    cr_assert_not(counting_bloom_init(&c, 10, 2));
+
+    cr_assert_eq(bloom_bytes(NULL), 0);
+    cr_assert_not(bloom_add(NULL, 1));
+    cr_assert_not(bloom_add_n(NULL, NULL, 0));
+    cr_assert_not(bloom_contains(NULL, 1));
+    cr_assert_eq(bloom_contains_n(NULL, NULL, 0, NULL), 0);
+    cr_assert_not(counting_bloom_add(NULL, 1));
+    cr_assert_not(counting_bloom_remove(NULL, 1));
+    cr_assert_not(counting_bloom_contains(NULL, 1));
+    bloom_clear(NULL);
+    bloom_reset(NULL);
+    counting_bloom_clear(NULL);
+}
+
+Test(bloom, init) {
+    struct bloom f;
+
+    cr_assert(bloom_init(&f, KEYS, 0.01));
+    cr_assert_eq((uintptr_t)f.blocks % 64, 0);
+    cr_assert_eq(bloom_bytes(&f), f.nblocks * 32);
+    cr_assert_leq(bloom_fpr(&f, KEYS), 0.01);
+    cr_assert_gt(bloom_fpr(&f, KEYS), 0.005);
+    cr_assert_lt(bloom_fpr(&f, KEYS), bloom_fpr(&f, 2 * KEYS));
+    // A dozen bits per key or so
+    cr_assert_lt(bloom_bytes(&f), KEYS * 2);
+    cr_assert_not(bloom_contains(&f, 42));
+    bloom_clear(&f);
+    cr_assert_eq(bloom_bytes(&f), 0);
+
+    cr_assert(bloom_init(&f, 0, 0.5));
+    cr_assert_eq(f.nblocks, 1);
+    bloom_clear(&f);
+
+    struct bloom g;
+    cr_assert(bloom_init(&f, KEYS, 0.01));
+    cr_assert(bloom_init(&g, KEYS, 0.0001));
+    cr_assert_gt(bloom_bytes(&g), bloom_bytes(&f));
+    bloom_clear(&f);
+    bloom_clear(&g);
+}
+
+static uint64_t key(uint64_t i) {
+    return i * 2654435761u + 17;
+}
+
+static void check_level(const char *level) {
+    setenv("TUPPERWARE_SIMD", level, 1);
+
+    struct bloom f;
+    struct counting_bloom c;
+    uint64_t *hashes = malloc(KEYS * sizeof(*hashes));
+    bool *found = malloc(KEYS * sizeof(*found));
+    cr_assert(bloom_init(&f, KEYS, 0.01));
+    cr_assert(counting_bloom_init(&c, KEYS, 0.01));
+
+    for (uint64_t i = 0; i < KEYS; ++i)
+        hashes[i] = key(i);
+    cr_assert(bloom_add_n(&f, hashes, KEYS / 2));
+    for (uint64_t i = KEYS / 2; i < KEYS; ++i)
+        cr_assert(bloom_add(&f, hashes[i]));
+    for (uint64_t i = 0; i < KEYS; ++i)
+        cr_assert(counting_bloom_add(&c, hashes[i]));
+
+    cr_assert_eq(bloom_contains_n(&f, hashes, KEYS, found), KEYS);
+    for (uint64_t i = 0; i < KEYS; ++i) {
+        cr_assert(found[i]);
+        cr_assert(bloom_contains(&f, hashes[i]));
+        cr_assert(counting_bloom_contains(&c, hashes[i]));
+    }
+
+    // Counting filters set the same bits
+    cr_assert_eq(memcmp(f.blocks, c.filter.blocks, bloom_bytes(&f)), 0);
+
+    size_t positives = 0;
+    for (uint64_t i = KEYS; i < KEYS + PROBES; ++i)
+        positives += bloom_contains(&f, key(i));
+    cr_assert_lt(positives, PROBES * 0.015);
+    cr_assert_gt(positives, 0);
+
+    for (uint64_t i = 0; i < KEYS; i += 2)
+        cr_assert(counting_bloom_remove(&c, hashes[i]));
+    for (uint64_t i = 1; i < KEYS; i += 2)
+        cr_assert(counting_bloom_contains(&c, hashes[i]));
+
+    bloom_clear(&f);
+    counting_bloom_clear(&c);
+    free(hashes);
+    free(found);
+}
+
+Test(bloom, scalar) {
+    check_level("scalar");
+}
+
+Test(bloom, avx2) {
+    check_level("avx2");
+}
+
+Test(bloom, avx512) {
+    check_level("avx512");
+}
+
+static uint64_t int_hash(const void *elem, void *cookie) {
+    (void)cookie;
+    return *(const int *)elem;
+}
+
+Test(bloom, add_vector) {
+    struct bloom f;
+    struct vector v;
+    vector_init(&v, sizeof(int));
+    for (int i = 0; i < 1000; ++i)
+        vector_push_back(&v, &i);
+
+    cr_assert(bloom_init(&f, 1000, 0.01));
+    cr_assert_not(bloom_add_vector(&f, NULL, int_hash, NULL));
+    cr_assert_not(bloom_add_vector(&f, &v, NULL, NULL));
+    cr_assert(bloom_add_vector(&f, &v, int_hash, NULL));
+    for (int i = 0; i < 1000; ++i)
+        cr_assert(bloom_contains(&f, i));
+
+    bloom_reset(&f);
+    for (int i = 0; i < 1000; ++i)
+        cr_assert_not(bloom_contains(&f, i));
+
+    bloom_clear(&f);
+    vector_clear(&v, NULL, NULL);
+}
+
+Test(bloom, counting) {
+    struct counting_bloom c;
+    cr_assert(counting_bloom_init(&c, 100, 0.01));
+
+    cr_assert_not(counting_bloom_remove(&c, 42));
+    cr_assert(counting_bloom_add(&c, 42));
+    cr_assert(counting_bloom_add(&c, 42));
+    cr_assert(counting_bloom_remove(&c, 42));
+    cr_assert(counting_bloom_contains(&c, 42));
+    cr_assert(counting_bloom_remove(&c, 42));
+    cr_assert_not(counting_bloom_contains(&c, 42));
+
+    // Saturated counters never go back to zero
+    for (int i = 0; i < 20; ++i)
+        counting_bloom_add(&c, 7);
+    for (int i = 0; i < 20; ++i)
+        cr_assert(counting_bloom_remove(&c, 7));
+    cr_assert(counting_bloom_contains(&c, 7));
+
+    counting_bloom_clear(&c);
+}
+
+struct int_tree {
+    int val;
+    struct avl_node node;
+};
+
+static int int_tree_cmp(const struct avl_node *lhs,
+        const struct avl_node *rhs, void *cookie) {
+    int l = CONTAINER_OF(struct int_tree, node, lhs)->val;
+    int r = CONTAINER_OF(struct int_tree, node, rhs)->val;
+    size_t *count = cookie;
+    if (count)
+        ++*count;
+    return (l > r) - (l < r);
+}
+
+static uint64_t int_tree_hash(const struct avl_node *n, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct int_tree, node, n)->val;
+}
+
+static struct int_tree *find(const struct bloom_avl *b, int val) {
+    struct int_tree key = { val, AVL_NODE_INIT_VAL };
+    struct avl_node *n = bloom_avl_find(b, &key.node);
+    return n ? CONTAINER_OF(struct int_tree, node, n) : NULL;
+}
+
+Test(bloom, avl) {
+    struct bloom_avl b;
+    struct int_tree *t = calloc(1000, sizeof(*t));
+    size_t count = 0;
+
+    cr_assert_not(bloom_avl_init(NULL, int_tree_cmp, int_tree_hash,
+                NULL, 10, 0.01));
+    cr_assert_not(bloom_avl_init(&b, int_tree_cmp, NULL, NULL, 10, 0.01));
+    // Grows past the expected size
+    cr_assert(bloom_avl_init(&b, int_tree_cmp, int_tree_hash,
+                &count, 10, 0.01));
+
+    for (int i = 0; i < 1000; ++i) {
+        t[i].val = 2 * i;
+        t[i].node = AVL_NODE_INIT_VAL;
+        cr_assert(bloom_avl_insert(&b, &t[i].node, NULL));
+    }
+    cr_assert_not(bloom_avl_insert(&b, &t[0].node, NULL));
+    cr_assert_eq(b.nmemb, 1000);
+    cr_assert_geq(b.expected, 1000);
+
+    for (int i = 0; i < 1000; ++i)
+        cr_assert_eq(find(&b, 2 * i), &t[i]);
+
+    // Most absent keys never reach the tree
+    count = 0;
+    for (int i = 0; i < 1000; ++i)
+        cr_assert_null(find(&b, 2 * i + 1));
+    cr_assert_lt(count, 1000);
+
+    struct int_tree key = { 0, AVL_NODE_INIT_VAL };
+    cr_assert_eq(bloom_avl_remove(&b, &key.node), &t[0].node);
+    cr_assert_null(bloom_avl_remove(&b, &key.node));
+    cr_assert(bloom_avl_remove_at(&b, &t[1].node));
+    cr_assert_null(find(&b, 0));
+    cr_assert_null(find(&b, 2));
+    cr_assert_eq(find(&b, 4), &t[2]);
+    cr_assert_eq(b.nmemb, 998);
+
+    bloom_avl_clear(&b, NULL, NULL);
+    cr_assert_null(find(&b, 4));
+    free(t);
+}
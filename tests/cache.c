@@ -0,0 +1,335 @@
+#include <criterion/criterion.h>
+
+#include <stdlib.h>
+
+#include "tupperware/cache.h"
+
+TestSuite(cache, .timeout = 15);
+
+#define ENTRIES 1000
+
+struct entry {
+    int key;
+    bool present;
+    struct cache_node node;
+};
+
+static uint64_t entry_hash(const struct cache_node *n, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct entry, node, n)->key;
+}
+
+static bool entry_eq(const struct cache_node *lhs,
+        const struct cache_node *rhs, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct entry, node, lhs)->key
+        == CONTAINER_OF(struct entry, node, rhs)->key;
+}
+
+static void entry_evict(struct cache_node *n, void *cookie) {
+    struct entry *e = CONTAINER_OF(struct entry, node, n);
+    size_t *count = cookie;
+    e->present = false;
+    if (count)
+        ++*count;
+}
+
+static struct entry *entries(void) {
+    struct entry *e = calloc(ENTRIES, sizeof(*e));
+    for (int i = 0; i < ENTRIES; ++i) {
+        e[i].key = i;
+        e[i].node = CACHE_NODE_INIT_VAL;
+    }
+    return e;
+}
+
+static struct entry *get(struct cache *c, int key) {
+    struct entry k = { key, false, CACHE_NODE_INIT_VAL };
+    struct cache_node *n = cache_get(c, &k.node);
+    return n ? CONTAINER_OF(struct entry, node, n) : NULL;
+}
+
+static struct entry *peek(const struct cache *c, int key) {
+    struct entry k = { key, false, CACHE_NODE_INIT_VAL };
+    struct cache_node *n = cache_peek(c, &k.node);
+    return n ? CONTAINER_OF(struct entry, node, n) : NULL;
+}
+
+static void put(struct cache *c, struct entry *e) {
+    e->present = true;
+    cr_assert_null(cache_put(c, &e->node));
+}
+
+Test(cache, init_null) {
+    struct cache c;
+    struct entry e = { 0, false, CACHE_NODE_INIT_VAL };
+
+    cr_assert_not(cache_init(NULL, CACHE_LRU, 1, entry_hash, entry_eq,
+                NULL, NULL));
+    cr_assert_not(cache_init(&c, CACHE_LRU, 0, entry_hash, entry_eq,
+                NULL, NULL));
+    cr_assert_not(cache_init(&c, CACHE_LRU, 1, NULL, entry_eq, NULL, NULL));
+    cr_assert_not(cache_init(&c, CACHE_LRU, 1, entry_hash, NULL, NULL, NULL));
+
+    cr_assert_eq(cache_length(NULL), 0);
+    cr_assert_eq(cache_capacity(NULL), 0);
+    cr_assert(cache_empty(NULL));
+    cr_assert_null(cache_get(NULL, NULL));
+    cr_assert_null(cache_peek(NULL, NULL));
+    cr_assert_null(cache_put(NULL, NULL));
+    cr_assert_eq(cache_put(NULL, &e.node), &e.node);
+    cr_assert_null(cache_remove(NULL, NULL));
+    cr_assert_eq(cache_hit_rate(NULL), 0);
+    cache_set_timing(NULL, true);
+    cache_reset_stats(NULL);
+    cache_clear(NULL, NULL, NULL);
+}
+
+Test(cache, lru) {
+    struct cache c;
+    struct entry *e = entries();
+    cr_assert(cache_init(&c, CACHE_LRU, 3, entry_hash, entry_eq,
+                entry_evict, NULL));
+    cr_assert_eq(cache_capacity(&c), 3);
+
+    for (int i = 0; i < 3; ++i)
+        put(&c, &e[i]);
+    cr_assert_eq(get(&c, 0), &e[0]);
+    put(&c, &e[3]);
+    cr_assert_eq(cache_length(&c), 3);
+    cr_assert_not(e[1].present);
+    cr_assert_null(get(&c, 1));
+    cr_assert_eq(c.stats.evictions, 1);
+
+    put(&c, &e[4]);
+    cr_assert_not(e[2].present);
+    cr_assert_eq(get(&c, 0), &e[0]);
+
+    cache_clear(&c, NULL, NULL);
+    free(e);
+}
+
+Test(cache, put_again) {
+    struct cache c;
+    struct entry *e = entries();
+    cr_assert(cache_init(&c, CACHE_LRU, 4, entry_hash, entry_eq,
+                entry_evict, NULL));
+
+    for (int i = 0; i < 3; ++i)
+        put(&c, &e[i]);
+    put(&c, &e[0]);
+    cr_assert_eq(cache_length(&c), 3);
+
+    // 0 is now the most recent, 1 goes first
+    put(&c, &e[3]);
+    put(&c, &e[4]);
+    cr_assert_not(e[1].present);
+    cr_assert_eq(cache_length(&c), 4);
+    size_t len = 0;
+    LIST_FOREACH (c.small, it)
+        ++len;
+    cr_assert_eq(len, 4);
+
+    cache_clear(&c, NULL, NULL);
+    free(e);
+}
+
+Test(cache, clock) {
+    struct cache c;
+    struct entry *e = entries();
+    cr_assert(cache_init(&c, CACHE_CLOCK, 3, entry_hash, entry_eq,
+                entry_evict, NULL));
+
+    for (int i = 0; i < 3; ++i)
+        put(&c, &e[i]);
+    cr_assert_eq(get(&c, 0), &e[0]);
+    cr_assert_eq(e[0].node.freq, 1);
+
+    // The hand skips 0 and clears its bit
+    put(&c, &e[3]);
+    cr_assert_not(e[1].present);
+    cr_assert_eq(e[0].node.freq, 0);
+    put(&c, &e[4]);
+    cr_assert_not(e[2].present);
+    put(&c, &e[5]);
+    cr_assert_not(e[0].present);
+
+    // Removing the node under the hand moves it
+    cr_assert_eq(c.hand, &e[3].node);
+    struct entry k = { 3, false, CACHE_NODE_INIT_VAL };
+    cr_assert_eq(cache_remove(&c, &k.node), &e[3].node);
+    cr_assert_eq(c.hand, &e[4].node);
+    put(&c, &e[6]);
+    put(&c, &e[7]);
+    cr_assert_eq(cache_length(&c), 3);
+
+    cache_clear(&c, NULL, NULL);
+    free(e);
+}
+
+Test(cache, s3fifo_scan) {
+    struct cache c;
+    struct cache l;
+    struct entry *e = entries();
+    struct entry *f = entries();
+    cr_assert(cache_init(&c, CACHE_S3FIFO, 10, entry_hash, entry_eq,
+                entry_evict, NULL));
+    cr_assert(cache_init(&l, CACHE_LRU, 10, entry_hash, entry_eq,
+                entry_evict, NULL));
+
+    for (int i = 0; i < 5; ++i) {
+        put(&c, &e[i]);
+        put(&l, &f[i]);
+        get(&c, i);
+        get(&l, i);
+    }
+
+    // One-hit wonders go through the small queue only
+    for (int i = 5; i < 500; ++i) {
+        put(&c, &e[i]);
+        put(&l, &f[i]);
+    }
+    for (int i = 0; i < 5; ++i) {
+        cr_assert_eq(peek(&c, i), &e[i]);
+        cr_assert(e[i].node.main);
+        cr_assert_null(peek(&l, i));
+    }
+
+    cache_clear(&c, NULL, NULL);
+    cache_clear(&l, NULL, NULL);
+    free(e);
+    free(f);
+}
+
+Test(cache, s3fifo_ghost) {
+    struct cache c;
+    struct entry *e = entries();
+    cr_assert(cache_init(&c, CACHE_S3FIFO, 10, entry_hash, entry_eq,
+                entry_evict, NULL));
+
+    for (int i = 0; i < 11; ++i)
+        put(&c, &e[i]);
+    cr_assert_not(e[0].present);
+    cr_assert_eq(c.nghosts, 1);
+
+    // Back from the ghost queue, straight to the main one
+    put(&c, &e[0]);
+    cr_assert(e[0].node.main);
+    cr_assert_eq(c.nmain, 1);
+
+    // Ghosts are forgotten after as many evictions as the main queue holds
+    for (int i = 11; i < 100; ++i)
+        put(&c, &e[i]);
+    cr_assert_leq(c.nghosts, 9);
+    cr_assert_leq(hashmap_length(&c.ghost_set), c.nghosts);
+    put(&c, &e[1]);
+    cr_assert_not(e[1].node.main);
+
+    cache_clear(&c, NULL, NULL);
+    free(e);
+}
+
+Test(cache, replace) {
+    enum cache_policy policies[] = { CACHE_LRU, CACHE_CLOCK, CACHE_S3FIFO };
+    for (size_t p = 0; p < 3; ++p) {
+        struct cache c;
+        struct entry a = { 1, false, CACHE_NODE_INIT_VAL };
+        struct entry b = { 1, false, CACHE_NODE_INIT_VAL };
+        struct entry d = { 2, false, CACHE_NODE_INIT_VAL };
+        cache_init(&c, policies[p], 2, entry_hash, entry_eq, NULL, NULL);
+
+        put(&c, &a);
+        put(&c, &d);
+        cr_assert_eq(cache_put(&c, &b.node), &a.node);
+        cr_assert_eq(cache_length(&c), 2);
+        cr_assert_eq(get(&c, 1), &b);
+        cr_assert_eq(get(&c, 2), &d);
+
+        cache_clear(&c, NULL, NULL);
+    }
+}
+
+Test(cache, stats) {
+    struct cache c;
+    struct entry *e = entries();
+    cache_init(&c, CACHE_LRU, 10, entry_hash, entry_eq, NULL, NULL);
+
+    put(&c, &e[0]);
+    cache_set_timing(&c, true);
+    get(&c, 0);
+    get(&c, 0);
+    get(&c, 0);
+    get(&c, 1);
+    cr_assert_eq(c.stats.hits, 3);
+    cr_assert_eq(c.stats.misses, 1);
+    cr_assert_eq(cache_hit_rate(&c), 0.75);
+    cr_assert_gt(c.stats.get_ns, 0);
+    cr_assert_geq(c.stats.get_ns, c.stats.get_max_ns);
+
+    // Peeking does not count
+    peek(&c, 0);
+    cr_assert_eq(c.stats.hits, 3);
+
+    cache_reset_stats(&c);
+    cr_assert_eq(cache_hit_rate(&c), 0);
+
+    cache_clear(&c, NULL, NULL);
+    free(e);
+}
+
+static void check_random(enum cache_policy policy) {
+    struct cache c;
+    struct entry *e = entries();
+    size_t evicted = 0;
+    cr_assert(cache_init(&c, policy, 50, entry_hash, entry_eq,
+                entry_evict, &evicted));
+
+    for (int i = 0; i < 20000; ++i) {
+        // Skewed towards small keys
+        int key = rand() % (rand() % ENTRIES + 1);
+        switch (rand() % 4) {
+        case 0:
+            if (!e[key].present)
+                put(&c, &e[key]);
+            break;
+        case 1: {
+            struct entry k = { key, false, CACHE_NODE_INIT_VAL };
+            struct cache_node *n = cache_remove(&c, &k.node);
+            cr_assert_eq(n, e[key].present ? &e[key].node : NULL);
+            e[key].present = false;
+            break;
+        }
+        default:
+            cr_assert_eq(get(&c, key), e[key].present ? &e[key] : NULL);
+            break;
+        }
+
+        cr_assert_leq(cache_length(&c), 50);
+        cr_assert_eq(cache_length(&c), list_length(&c.small)
+                + list_length(&c.main));
+    }
+
+    size_t present = 0;
+    for (int i = 0; i < ENTRIES; ++i)
+        present += e[i].present;
+    cr_assert_eq(cache_length(&c), present);
+    cr_assert_eq(c.stats.evictions, evicted);
+    cr_assert_gt(evicted, 0);
+
+    cache_clear(&c, entry_evict, &evicted);
+    for (int i = 0; i < ENTRIES; ++i)
+        cr_assert_not(e[i].present);
+    free(e);
+}
+
+Test(cache, random_lru) {
+    check_random(CACHE_LRU);
+}
+
+Test(cache, random_clock) {
+    check_random(CACHE_CLOCK);
+}
+
+Test(cache, random_s3fifo) {
+    check_random(CACHE_S3FIFO);
+}
@@ -0,0 +1,225 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+
+#include "tupperware/chashmap.h"
+
+TestSuite(chashmap, .timeout = 30);
+
+#define THREADS 4
+#define KEYS 4096
+
+struct pair {
+    uint64_t key;
+    uint64_t val;
+    // Always `~val`, torn copies would break it
+    uint64_t check;
+};
+
+static uint64_t pair_hash(const void *elem, void *cookie) {
+    (void)cookie;
+    return ((const struct pair *)elem)->key;
+}
+
+static bool pair_eq(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    return ((const struct pair *)lhs)->key == ((const struct pair *)rhs)->key;
+}
+
+static struct pair pair(uint64_t key, uint64_t val) {
+    return (struct pair){ key, val, ~val };
+}
+
+static void pair_count(void *elem, void *cookie) {
+    (void)elem;
+    ++*(size_t *)cookie;
+}
+
+Test(chashmap, init_null) {
+    struct chashmap m;
+
+    cr_assert_not(chashmap_init(NULL, 1, pair_hash, pair_eq, NULL));
+    cr_assert_not(chashmap_init(&m, 0, pair_hash, pair_eq, NULL));
+    cr_assert_not(chashmap_init(&m, 1, NULL, pair_eq, NULL));
+    cr_assert_not(chashmap_init(&m, 1, pair_hash, NULL, NULL));
+    cr_assert_not(chashmap_init(&m, -1, pair_hash, pair_eq, NULL));
+}
+
+Test(chashmap, accessors_null) {
+    struct pair p = pair(1, 1);
+
+    cr_assert_eq(chashmap_length(NULL), 0);
+    cr_assert(chashmap_empty(NULL));
+    cr_assert_not(chashmap_find(NULL, &p, NULL));
+    cr_assert_not(chashmap_insert(NULL, &p, NULL));
+    cr_assert_not(chashmap_assign(NULL, &p));
+    cr_assert_not(chashmap_remove(NULL, &p, NULL));
+    chashmap_reclaim(NULL);
+    chashmap_clear(NULL, NULL, NULL);
+}
+
+Test(chashmap, insert_find) {
+    struct chashmap m;
+    struct pair p;
+    cr_assert(chashmap_init(&m, sizeof(p), pair_hash, pair_eq, NULL));
+    cr_assert(chashmap_empty(&m));
+
+    for (uint64_t i = 0; i < KEYS; ++i) {
+        p = pair(i, i * 3);
+        cr_assert(chashmap_insert(&m, &p, NULL));
+    }
+    cr_assert_eq(chashmap_length(&m), KEYS);
+
+    for (uint64_t i = 0; i < KEYS; ++i) {
+        p = pair(i, 0);
+        cr_assert(chashmap_find(&m, &p, &p));
+        cr_assert_eq(p.val, i * 3);
+        cr_assert(chashmap_find(&m, &p, NULL));
+    }
+    p = pair(KEYS, 0);
+    cr_assert_not(chashmap_find(&m, &p, &p));
+    cr_assert_eq(p.val, 0);
+
+    size_t count = 0;
+    chashmap_clear(&m, pair_count, &count);
+    cr_assert_eq(count, KEYS);
+    cr_assert(chashmap_empty(&m));
+}
+
+Test(chashmap, insert_existing) {
+    struct chashmap m;
+    struct pair p = pair(42, 1);
+    struct pair q = pair(42, 2);
+    struct pair out;
+    chashmap_init(&m, sizeof(p), pair_hash, pair_eq, NULL);
+
+    cr_assert(chashmap_insert(&m, &p, NULL));
+    cr_assert_not(chashmap_insert(&m, &q, &out));
+    cr_assert_eq(out.val, 1);
+    cr_assert_eq(chashmap_length(&m), 1);
+
+    chashmap_clear(&m, NULL, NULL);
+}
+
+Test(chashmap, assign) {
+    struct chashmap m;
+    struct pair p = pair(42, 1);
+    struct pair q = pair(42, 2);
+    chashmap_init(&m, sizeof(p), pair_hash, pair_eq, NULL);
+
+    cr_assert(chashmap_assign(&m, &p));
+    cr_assert(chashmap_assign(&m, &q));
+    cr_assert_eq(chashmap_length(&m), 1);
+    cr_assert(chashmap_find(&m, &p, &p));
+    cr_assert_eq(p.val, 2);
+
+    chashmap_clear(&m, NULL, NULL);
+}
+
+Test(chashmap, remove) {
+    struct chashmap m;
+    struct pair p;
+    chashmap_init(&m, sizeof(p), pair_hash, pair_eq, NULL);
+
+    for (uint64_t i = 0; i < KEYS; ++i) {
+        p = pair(i, i);
+        chashmap_insert(&m, &p, NULL);
+    }
+    for (uint64_t i = 0; i < KEYS; i += 2) {
+        p = pair(i, 0);
+        cr_assert(chashmap_remove(&m, &p, &p));
+        cr_assert_eq(p.val, i);
+        cr_assert_not(chashmap_remove(&m, &p, NULL));
+    }
+    cr_assert_eq(chashmap_length(&m), KEYS / 2);
+    for (uint64_t i = 0; i < KEYS; ++i) {
+        p = pair(i, 0);
+        cr_assert_eq(chashmap_find(&m, &p, NULL), i % 2 == 1);
+    }
+
+    chashmap_reclaim(&m);
+    cr_assert(vector_empty(&m.retired_nodes));
+    cr_assert(vector_empty(&m.retired_tables));
+
+    chashmap_clear(&m, NULL, NULL);
+}
+
+struct worker {
+    struct chashmap *m;
+    uint64_t id;
+    bool stop;
+    size_t found;
+};
+
+static void *writer(void *arg) {
+    struct worker *w = arg;
+
+    // Every key is inserted and removed by one writer, updated by all
+    for (uint64_t i = w->id; i < KEYS; i += THREADS) {
+        struct pair p = pair(i, i);
+        struct pair out;
+        if (!chashmap_insert(w->m, &p, &out))
+            cr_assert_eq(out.key, i); // Assigned by a faster writer
+    }
+    for (uint64_t round = 0; round < 4; ++round) {
+        for (uint64_t i = 0; i < KEYS; ++i) {
+            struct pair p = pair(i, i + round * KEYS);
+            cr_assert(chashmap_assign(w->m, &p));
+        }
+    }
+    for (uint64_t i = w->id; i < KEYS; i += THREADS) {
+        struct pair p = pair(i, 0);
+        cr_assert(chashmap_remove(w->m, &p, &p));
+        cr_assert_eq(p.check, ~p.val);
+    }
+
+    return NULL;
+}
+
+static void *reader(void *arg) {
+    struct worker *w = arg;
+
+    while (!__atomic_load_n(&w->stop, __ATOMIC_ACQUIRE)) {
+        for (uint64_t i = 0; i < KEYS; ++i) {
+            struct pair p = pair(i, 0);
+            if (!chashmap_find(w->m, &p, &p))
+                continue;
+            cr_assert_eq(p.key, i);
+            cr_assert_eq(p.val % KEYS, i);
+            cr_assert_eq(p.check, ~p.val);
+            ++w->found;
+        }
+    }
+
+    return NULL;
+}
+
+Test(chashmap, concurrent) {
+    struct chashmap m;
+    struct worker writers[THREADS];
+    struct worker readers[THREADS];
+    pthread_t wt[THREADS];
+    pthread_t rt[THREADS];
+    chashmap_init(&m, sizeof(struct pair), pair_hash, pair_eq, NULL);
+
+    for (size_t i = 0; i < THREADS; ++i) {
+        readers[i] = (struct worker){ &m, i, false, 0 };
+        cr_assert_eq(pthread_create(&rt[i], NULL, reader, &readers[i]), 0);
+    }
+    for (size_t i = 0; i < THREADS; ++i) {
+        writers[i] = (struct worker){ &m, i, false, 0 };
+        cr_assert_eq(pthread_create(&wt[i], NULL, writer, &writers[i]), 0);
+    }
+
+    for (size_t i = 0; i < THREADS; ++i)
+        pthread_join(wt[i], NULL);
+    for (size_t i = 0; i < THREADS; ++i) {
+        __atomic_store_n(&readers[i].stop, true, __ATOMIC_RELEASE);
+        pthread_join(rt[i], NULL);
+    }
+
+    // Assignments may bring back removed keys
+    size_t count = 0;
+    chashmap_clear(&m, pair_count, &count);
+    cr_assert_leq(count, KEYS);
+}
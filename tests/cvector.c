@@ -0,0 +1,178 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "tupperware/cvector.h"
+
+TestSuite(cvector, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+Test(cvector, init_null) {
+    struct cvector v;
+
+    cr_assert_not(cvector_init(NULL, 1));
+    cr_assert_not(cvector_init(&v, 0));
+}
+
+Test(cvector, init) {
+    struct cvector v;
+
+    cr_assert(cvector_init(&v, sizeof(int)));
+
+    cr_assert_eq(cvector_elem_size(&v), sizeof(int));
+    cr_assert(cvector_empty(&v));
+    cr_assert_null(cvector_at(&v, 0));
+
+    cvector_clear(&v, NULL, NULL);
+}
+
+Test(cvector, accessors_null) {
+    cr_assert_eq(cvector_length(NULL), 0);
+    cr_assert_eq(cvector_elem_size(NULL), 0);
+    cr_assert(cvector_empty(NULL));
+    cr_assert_null(cvector_at(NULL, 0));
+    cr_assert_not(cvector_push_back(NULL, NULL));
+    cr_assert_not(cvector_reserve(NULL, 1));
+}
+
+Test(cvector, push_back) {
+    struct cvector v;
+    cvector_init(&v, sizeof(int));
+
+    for (int i = 0; i < 1000; ++i)
+        cr_assert(cvector_push_back(&v, &i));
+    cr_assert_eq(cvector_length(&v), 1000);
+
+    for (int i = 0; i < 1000; ++i)
+        cr_assert_eq(*(int *)cvector_at(&v, i), i);
+    cr_assert_null(cvector_at(&v, 1000));
+
+    int n = 42;
+    cr_assert_not(cvector_push_back(&v, NULL));
+    cr_assert(cvector_push_back(&v, &n));
+    cr_assert_eq(*(int *)cvector_at(&v, 1000), 42);
+
+    cvector_clear(&v, NULL, NULL);
+}
+
+Test(cvector, push_back_no_segment) {
+    struct cvector v;
+    char c = 0;
+
+    // Too large for the first segment, the slot must not be taken
+    cr_assert(cvector_init(&v, SIZE_MAX / 16));
+    cr_assert_not(cvector_push_back(&v, &c));
+    cr_assert_eq(v.reserved, 0);
+    cr_assert(cvector_empty(&v));
+
+    cvector_clear(&v, NULL, NULL);
+}
+
+Test(cvector, elements_do_not_move) {
+    struct cvector v;
+    cvector_init(&v, sizeof(int));
+
+    int n = 0;
+    cvector_push_back(&v, &n);
+    int *first = cvector_at(&v, 0);
+
+    for (n = 1; n < 10000; ++n)
+        cvector_push_back(&v, &n);
+
+    cr_assert_eq(cvector_at(&v, 0), first);
+    cr_assert_eq(*first, 0);
+
+    cvector_clear(&v, NULL, NULL);
+}
+
+Test(cvector, reserve) {
+    struct cvector v;
+    cvector_init(&v, sizeof(int));
+
+    cr_assert(cvector_reserve(&v, 0));
+    cr_assert(cvector_reserve(&v, 96));
+    cr_assert_not_null(v.segments[0]);
+    cr_assert_not_null(v.segments[1]);
+    cr_assert_null(v.segments[2]);
+    cr_assert(cvector_empty(&v));
+
+    cr_assert_not(cvector_reserve(&v, -1));
+
+    cvector_clear(&v, NULL, NULL);
+}
+
+static void int_dtor(void *val, void *cookie) {
+    int *n = val;
+    int *count = cookie;
+
+    cr_assert_eq(*n, (*count)++);
+}
+
+Test(cvector, clear) {
+    struct cvector v;
+    cvector_init(&v, sizeof(int));
+
+    for (int i = 0; i < 100; ++i)
+        cvector_push_back(&v, &i);
+
+    int count = 0;
+    cvector_clear(&v, int_dtor, &count);
+
+    cr_assert_eq(count, 100);
+    cr_assert(cvector_empty(&v));
+    for (size_t i = 0; i < CVECTOR_SEGMENTS; ++i)
+        cr_assert_null(v.segments[i]);
+}
+
+#define THREADS 4
+#define PER_THREAD 20000
+
+struct writer {
+    struct cvector *v;
+    size_t id;
+};
+
+static void *writer(void *arg) {
+    struct writer *w = arg;
+
+    for (size_t i = 0; i < PER_THREAD; ++i) {
+        size_t val = w->id * PER_THREAD + i;
+        cvector_push_back(w->v, &val);
+    }
+
+    return NULL;
+}
+
+Test(cvector, threads) {
+    struct cvector v;
+    cvector_init(&v, sizeof(size_t));
+
+    struct writer writers[THREADS];
+    pthread_t threads[THREADS];
+    for (size_t i = 0; i < THREADS; ++i) {
+        writers[i] = (struct writer){ &v, i };
+        cr_assert_eq(pthread_create(&threads[i], NULL, writer, &writers[i]), 0);
+    }
+
+    // Every published element must be readable while writers are running
+    size_t last[THREADS] = { 0 };
+    size_t seen = 0;
+    while (seen < THREADS * PER_THREAD) {
+        size_t len = cvector_length(&v);
+        for (; seen < len; ++seen) {
+            size_t val = *(size_t *)cvector_at(&v, seen);
+            size_t id = val / PER_THREAD;
+            cr_assert_lt(id, THREADS);
+            // Elements of a given writer are published in order
+            cr_assert_eq(val % PER_THREAD, last[id]++);
+        }
+    }
+
+    for (size_t i = 0; i < THREADS; ++i)
+        pthread_join(threads[i], NULL);
+    cr_assert_eq(cvector_length(&v), THREADS * PER_THREAD);
+
+    cvector_clear(&v, NULL, NULL);
+}
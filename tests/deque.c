@@ -0,0 +1,257 @@
+#include <criterion/criterion.h>
+
+#include "tupperware/deque.h"
+
+TestSuite(deque, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+static void assert_deque(const struct deque *d, int first, size_t n) {
+    cr_assert_eq(deque_length(d), n);
+    for (size_t i = 0; i < n; ++i)
+        cr_assert_eq(*(int *)deque_at(d, i), first + (int)i);
+    cr_assert_null(deque_at(d, n));
+}
+
+Test(deque, init_null) {
+    cr_assert_not(deque_init(NULL, 1));
+}
+
+Test(deque, init_zero) {
+    struct deque d;
+    cr_assert_not(deque_init(&d, 0));
+}
+
+Test(deque, init) {
+    struct deque d;
+
+    cr_assert(deque_init(&d, sizeof(int)));
+
+    cr_assert_eq(deque_elem_size(&d), sizeof(int));
+    cr_assert_eq(deque_capacity(&d), 0);
+    cr_assert(deque_empty(&d));
+    cr_assert_null(deque_at(&d, 0));
+}
+
+Test(deque, with_cap) {
+    struct deque d;
+
+    cr_assert(deque_with_cap(&d, sizeof(int), 4));
+
+    cr_assert_eq(deque_capacity(&d), 4);
+    cr_assert(deque_empty(&d));
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, accessors_null) {
+    cr_assert_eq(deque_length(NULL), 0);
+    cr_assert_eq(deque_capacity(NULL), 0);
+    cr_assert_eq(deque_elem_size(NULL), 0);
+    cr_assert(deque_empty(NULL));
+    cr_assert_null(deque_at(NULL, 0));
+}
+
+Test(deque, push_null) {
+    struct deque d;
+    int n = 42;
+    deque_init(&d, sizeof(int));
+
+    cr_assert_not(deque_push_back(NULL, &n));
+    cr_assert_not(deque_push_back(&d, NULL));
+    cr_assert_not(deque_push_front(NULL, &n));
+    cr_assert_not(deque_push_front(&d, NULL));
+}
+
+Test(deque, pop_empty) {
+    struct deque d;
+    deque_init(&d, sizeof(int));
+
+    cr_assert_not(deque_pop_back(&d, NULL));
+    cr_assert_not(deque_pop_front(&d, NULL));
+    cr_assert_not(deque_pop_back(NULL, NULL));
+    cr_assert_not(deque_pop_front(NULL, NULL));
+    cr_assert_eq(deque_pop_front_n(&d, NULL, 1), 0);
+}
+
+Test(deque, push_back_pop_front) {
+    struct deque d;
+    deque_init(&d, sizeof(int));
+
+    for (int i = 0; i < 100; ++i)
+        cr_assert(deque_push_back(&d, &i));
+    assert_deque(&d, 0, 100);
+
+    for (int i = 0; i < 100; ++i) {
+        int n;
+        cr_assert(deque_pop_front(&d, &n));
+        cr_assert_eq(n, i);
+    }
+    cr_assert(deque_empty(&d));
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, push_front_pop_back) {
+    struct deque d;
+    deque_init(&d, sizeof(int));
+
+    for (int i = 0; i < 100; ++i)
+        cr_assert(deque_push_front(&d, &i));
+    cr_assert_eq(deque_length(&d), 100);
+    cr_assert_eq(*(int *)deque_at(&d, 0), 99);
+
+    for (int i = 0; i < 100; ++i) {
+        int n;
+        cr_assert(deque_pop_back(&d, &n));
+        cr_assert_eq(n, i);
+    }
+    cr_assert(deque_empty(&d));
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, push_front_order) {
+    struct deque d;
+    deque_init(&d, sizeof(int));
+
+    for (int i = 9; i >= 0; --i)
+        cr_assert(deque_push_front(&d, &i));
+    assert_deque(&d, 0, 10);
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, grow_wrapped_short_tail) {
+    struct deque d;
+    deque_with_cap(&d, sizeof(int), 8);
+
+    // Wrap the two last elements around the end
+    for (int i = 0; i < 6; ++i)
+        deque_push_back(&d, &i);
+    deque_pop_front_n(&d, NULL, 2);
+    for (int i = 6; i < 10; ++i)
+        deque_push_back(&d, &i);
+    cr_assert_eq(d.head, 2);
+
+    int n = 10;
+    cr_assert(deque_push_back(&d, &n));
+
+    cr_assert_eq(deque_capacity(&d), 16);
+    cr_assert_eq(d.head, 2);
+    assert_deque(&d, 2, 9);
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, grow_wrapped_short_head) {
+    struct deque d;
+    deque_with_cap(&d, sizeof(int), 8);
+
+    // Wrap all but the two first elements around the end
+    for (int i = 0; i < 8; ++i)
+        deque_push_back(&d, &i);
+    deque_pop_front_n(&d, NULL, 6);
+    for (int i = 8; i < 14; ++i)
+        deque_push_back(&d, &i);
+    cr_assert_eq(d.head, 6);
+
+    int n = 14;
+    cr_assert(deque_push_back(&d, &n));
+
+    cr_assert_eq(deque_capacity(&d), 16);
+    cr_assert_eq(d.head, 14);
+    assert_deque(&d, 6, 9);
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, reserve) {
+    struct deque d;
+    deque_with_cap(&d, sizeof(int), 4);
+
+    for (int i = 0; i < 4; ++i)
+        deque_push_back(&d, &i);
+    deque_pop_front_n(&d, NULL, 3);
+    for (int i = 4; i < 7; ++i)
+        deque_push_back(&d, &i);
+
+    cr_assert(deque_reserve(&d, 2));
+    cr_assert_eq(deque_capacity(&d), 4);
+
+    cr_assert(deque_reserve(&d, 5));
+    cr_assert_eq(deque_capacity(&d), 5);
+    assert_deque(&d, 3, 4);
+
+    cr_assert_not(deque_reserve(NULL, 42));
+    cr_assert_not(deque_reserve(&d, -1));
+    assert_deque(&d, 3, 4);
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, push_back_n) {
+    struct deque d;
+    deque_with_cap(&d, sizeof(int), 4);
+    int arr[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+    cr_assert(deque_push_back_n(&d, arr, 3));
+    cr_assert_eq(deque_pop_front_n(&d, NULL, 2), 2);
+
+    // Wraps around without growing
+    cr_assert(deque_push_back_n(&d, arr + 3, 3));
+    cr_assert_eq(deque_capacity(&d), 4);
+    assert_deque(&d, 2, 4);
+
+    // Grows past twice the capacity
+    cr_assert(deque_push_back_n(&d, arr + 6, 4));
+    assert_deque(&d, 2, 8);
+
+    cr_assert(deque_push_back_n(&d, arr, 0));
+    cr_assert_not(deque_push_back_n(&d, NULL, 1));
+    cr_assert_not(deque_push_back_n(NULL, arr, 1));
+
+    deque_clear(&d, NULL, NULL);
+}
+
+Test(deque, pop_front_n) {
+    struct deque d;
+    deque_with_cap(&d, sizeof(int), 8);
+    int arr[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+    deque_push_back_n(&d, arr, 6);
+    deque_pop_front_n(&d, NULL, 4);
+    deque_push_back_n(&d, arr + 6, 4);
+
+    int out[ARR_SIZE(arr)] = { 0 };
+    cr_assert_eq(deque_pop_front_n(&d, out, ARR_SIZE(out)), 6);
+    for (size_t i = 0; i < 6; ++i)
+        cr_assert_eq(out[i], arr[i + 4]);
+    cr_assert(deque_empty(&d));
+
+    deque_clear(&d, NULL, NULL);
+}
+
+static void int_dtor(void *val, void *cookie) {
+    int *n = val;
+    int *count = cookie;
+
+    cr_assert_eq(*n, (*count)++);
+}
+
+Test(deque, clear) {
+    struct deque d;
+    deque_with_cap(&d, sizeof(int), 4);
+
+    for (int i = 2; i < 5; ++i)
+        deque_push_back(&d, &i);
+    for (int i = 1; i >= 0; --i)
+        deque_push_front(&d, &i);
+
+    int count = 0;
+    deque_clear(&d, int_dtor, &count);
+
+    cr_assert_eq(count, 5);
+    cr_assert_eq(deque_capacity(&d), 0);
+    cr_assert(deque_empty(&d));
+}
@@ -0,0 +1,204 @@
+#include <criterion/criterion.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tupperware/elias_fano.h"
+
+TestSuite(elias_fano, .timeout = 15);
+
+// Non decreasing, with random gaps in `[0, step]` starting from `x`
+static void fill(struct vector *v, size_t n, uint64_t x, uint64_t step) {
+    cr_assert(vector_init(v, sizeof(uint64_t)));
+    for (size_t i = 0; i < n; ++i) {
+        cr_assert(vector_push_back(v, &x));
+        x += ((uint64_t)rand() << 31 | rand()) % (step + 1);
+    }
+}
+
+// Index of the first element not less than `x`
+static size_t lower_bound(const struct vector *v, uint64_t x) {
+    const uint64_t *arr = v->arr;
+    size_t lo = 0;
+    size_t hi = v->nmemb;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (arr[mid] < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void check_successor(const struct elias_fano *ef,
+        const struct vector *v, uint64_t x) {
+    const uint64_t *arr = v->arr;
+    size_t expected = lower_bound(v, x);
+    size_t i;
+    uint64_t y;
+
+    cr_assert_eq(elias_fano_rank(ef, x), expected);
+    if (expected == v->nmemb) {
+        cr_assert_not(elias_fano_successor(ef, x, &i, &y));
+        return;
+    }
+    cr_assert(elias_fano_successor(ef, x, &i, &y));
+    cr_assert_eq(i, expected);
+    cr_assert_eq(y, arr[expected]);
+}
+
+static void check(const struct vector *v) {
+    struct elias_fano ef;
+    struct vector res;
+    const uint64_t *arr = v->arr;
+
+    cr_assert(elias_fano_init(&ef, v));
+    cr_assert_eq(elias_fano_length(&ef), v->nmemb);
+
+    vector_init(&res, sizeof(uint64_t));
+    cr_assert(elias_fano_decode(&ef, &res));
+    cr_assert_eq(res.nmemb, v->nmemb);
+    if (v->nmemb)
+        cr_assert_arr_eq(res.arr, v->arr, v->nmemb * sizeof(uint64_t));
+
+    uint64_t x;
+    for (size_t i = 0; i < v->nmemb; ++i) {
+        cr_assert(elias_fano_at(&ef, i, &x));
+        cr_assert_eq(x, arr[i]);
+    }
+    cr_assert_not(elias_fano_at(&ef, v->nmemb, &x));
+
+    // Each element, its neighbours and the extremes
+    for (size_t i = 0; i < v->nmemb; ++i) {
+        check_successor(&ef, v, arr[i]);
+        if (arr[i])
+            check_successor(&ef, v, arr[i] - 1);
+        if (arr[i] < UINT64_MAX)
+            check_successor(&ef, v, arr[i] + 1);
+    }
+    check_successor(&ef, v, 0);
+    check_successor(&ef, v, UINT64_MAX);
+
+    vector_clear(&res, NULL, NULL);
+    elias_fano_clear(&ef);
+}
+
+Test(elias_fano, sequences) {
+    struct vector v;
+
+    size_t lengths[] = { 1, 2, 255, 256, 257, 1000, 20000 };
+    uint64_t steps[] = { 0, 1, 3, 1000, UINT64_C(1) << 40 };
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(*lengths); ++i) {
+        for (size_t j = 0; j < sizeof(steps) / sizeof(*steps); ++j) {
+            fill(&v, lengths[i], 5, steps[j]);
+            check(&v);
+            vector_clear(&v, NULL, NULL);
+        }
+    }
+}
+
+Test(elias_fano, extremes) {
+    struct vector v;
+
+    uint64_t extremes[] = { 0, 0, 1, UINT64_MAX - 1, UINT64_MAX, UINT64_MAX };
+    vector_init(&v, sizeof(uint64_t));
+    for (size_t i = 0; i < sizeof(extremes) / sizeof(*extremes); ++i)
+        vector_push_back(&v, &extremes[i]);
+    check(&v);
+    vector_clear(&v, NULL, NULL);
+
+    // A single outlier after a dense run
+    fill(&v, 5000, 0, 2);
+    uint64_t outlier = UINT64_C(1) << 50;
+    vector_push_back(&v, &outlier);
+    check(&v);
+    vector_clear(&v, NULL, NULL);
+}
+
+Test(elias_fano, long_runs) {
+    struct vector v;
+    vector_init(&v, sizeof(uint64_t));
+
+    // Buckets full of equal values, scanning them would time out
+    uint64_t values[] = { 3, 4, 1000, 1001 };
+    for (size_t i = 0; i < sizeof(values) / sizeof(*values); ++i)
+        for (size_t j = 0; j < 30000; ++j)
+            vector_push_back(&v, &values[i]);
+    // Spread out, so that the runs share their upper bits
+    for (uint64_t x = 2000; v.nmemb < 150000; x += 64)
+        vector_push_back(&v, &x);
+    check(&v);
+
+    vector_clear(&v, NULL, NULL);
+}
+
+Test(elias_fano, null) {
+    struct elias_fano ef;
+    struct vector v;
+    uint64_t x;
+    vector_init(&v, sizeof(uint64_t));
+
+    cr_assert_not(elias_fano_init(NULL, &v));
+    cr_assert_not(elias_fano_init(&ef, NULL));
+    elias_fano_clear(NULL);
+    cr_assert_eq(elias_fano_length(NULL), 0);
+    cr_assert_eq(elias_fano_bytes(NULL), 0);
+    cr_assert_not(elias_fano_at(NULL, 0, &x));
+    cr_assert_not(elias_fano_decode(NULL, &v));
+    cr_assert_eq(elias_fano_rank(NULL, 0), 0);
+    cr_assert_not(elias_fano_successor(NULL, 0, NULL, &x));
+}
+
+Test(elias_fano, invalid) {
+    struct elias_fano ef;
+    struct vector v;
+
+    vector_init(&v, sizeof(uint32_t));
+    cr_assert_not(elias_fano_init(&ef, &v));
+
+    uint64_t unsorted[] = { 1, 5, 4 };
+    vector_init(&v, sizeof(uint64_t));
+    for (size_t i = 0; i < 3; ++i)
+        vector_push_back(&v, &unsorted[i]);
+    cr_assert_not(elias_fano_init(&ef, &v));
+    vector_clear(&v, NULL, NULL);
+
+    struct vector wrong;
+    vector_init(&v, sizeof(uint64_t));
+    vector_init(&wrong, sizeof(uint32_t));
+    cr_assert(elias_fano_init(&ef, &v));
+    cr_assert_not(elias_fano_decode(&ef, &wrong));
+    elias_fano_clear(&ef);
+}
+
+Test(elias_fano, empty) {
+    struct elias_fano ef;
+    struct vector v;
+    uint64_t x;
+    vector_init(&v, sizeof(uint64_t));
+
+    cr_assert(elias_fano_init(&ef, &v));
+    cr_assert_eq(elias_fano_length(&ef), 0);
+    cr_assert_eq(elias_fano_bytes(&ef), 0);
+    cr_assert(elias_fano_decode(&ef, &v));
+    cr_assert_eq(v.nmemb, 0);
+    cr_assert_not(elias_fano_at(&ef, 0, &x));
+    cr_assert_eq(elias_fano_rank(&ef, 42), 0);
+    cr_assert_not(elias_fano_successor(&ef, 0, NULL, &x));
+
+    elias_fano_clear(&ef);
+}
+
+Test(elias_fano, size) {
+    struct elias_fano ef;
+    struct vector v;
+    // Gaps of about 500, so about 11 bits per element
+    fill(&v, 100000, 0, 1000);
+
+    cr_assert(elias_fano_init(&ef, &v));
+    cr_assert_lt(elias_fano_bytes(&ef), v.nmemb * sizeof(uint64_t) / 4);
+
+    elias_fano_clear(&ef);
+    vector_clear(&v, NULL, NULL);
+}
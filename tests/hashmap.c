@@ -0,0 +1,239 @@
+#include <criterion/criterion.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tupperware/hashmap.h"
+
+TestSuite(hashmap, .timeout = 15);
+
+struct entry {
+    uint64_t key;
+    uint64_t val;
+};
+
+static uint64_t entry_hash(const void *elem, void *cookie) {
+    (void)cookie;
+    return ((const struct entry *)elem)->key;
+}
+
+// Every element in the same run, wrapping around the end of the table
+static uint64_t entry_collide(const void *elem, void *cookie) {
+    (void)elem;
+    (void)cookie;
+    return UINT64_MAX;
+}
+
+static size_t hashed;
+
+// entry_collide, counting the calls in `hashed`
+static uint64_t entry_collide_count(const void *elem, void *cookie) {
+    ++hashed;
+    return entry_collide(elem, cookie);
+}
+
+static bool entry_eq(const void *lhs, const void *rhs, void *cookie) {
+    size_t *count = cookie;
+    if (count)
+        ++*count;
+    return ((const struct entry *)lhs)->key == ((const struct entry *)rhs)->key;
+}
+
+static void entry_dtor(void *elem, void *cookie) {
+    size_t *count = cookie;
+    (void)elem;
+    ++*count;
+}
+
+Test(hashmap, init) {
+    struct hashmap m;
+
+    cr_assert(hashmap_init(&m, sizeof(struct entry), entry_hash, entry_eq,
+                NULL));
+    cr_assert(hashmap_empty(&m));
+    cr_assert_eq(hashmap_capacity(&m), 0);
+    cr_assert_null(hashmap_find(&m, &(struct entry){ .key = 1 }));
+    hashmap_clear(&m, NULL, NULL);
+
+    cr_assert_not(hashmap_init(NULL, 8, entry_hash, entry_eq, NULL));
+    cr_assert_not(hashmap_init(&m, 0, entry_hash, entry_eq, NULL));
+    cr_assert_not(hashmap_init(&m, 8, NULL, entry_eq, NULL));
+    cr_assert_not(hashmap_init(&m, 8, entry_hash, NULL, NULL));
+    hashmap_clear(NULL, NULL, NULL);
+    cr_assert_eq(hashmap_length(NULL), 0);
+    cr_assert(hashmap_empty(NULL));
+    cr_assert_null(hashmap_find(NULL, &m));
+    cr_assert_not(hashmap_insert(NULL, &m, NULL));
+    cr_assert_not(hashmap_remove(NULL, &m, NULL));
+    cr_assert_not(hashmap_reserve(NULL, 1));
+}
+
+Test(hashmap, insert_find) {
+    struct hashmap m;
+    void *inserted;
+    hashmap_init(&m, sizeof(struct entry), entry_hash, entry_eq, NULL);
+
+    for (uint64_t i = 0; i < 10000; ++i) {
+        struct entry e = { .key = i * 7, .val = i };
+        cr_assert(hashmap_insert(&m, &e, &inserted));
+        cr_assert_eq(((struct entry *)inserted)->val, i);
+    }
+    cr_assert_eq(hashmap_length(&m), 10000);
+
+    // Duplicates point to the element already there
+    struct entry dup = { .key = 70, .val = 42 };
+    cr_assert_not(hashmap_insert(&m, &dup, &inserted));
+    cr_assert_eq(((struct entry *)inserted)->val, 10);
+    cr_assert_eq(hashmap_length(&m), 10000);
+
+    for (uint64_t i = 0; i < 70000; ++i) {
+        struct entry *e = hashmap_find(&m, &(struct entry){ .key = i });
+        if (i % 7) {
+            cr_assert_null(e);
+        } else {
+            cr_assert_not_null(e);
+            cr_assert_eq(e->val, i / 7);
+        }
+    }
+
+    hashmap_clear(&m, NULL, NULL);
+}
+
+static void check_random(hashmap_hash_f hash, size_t nkeys) {
+    struct hashmap m;
+    bool *present = calloc(nkeys, sizeof(*present));
+    size_t count = 0;
+    hashmap_init(&m, sizeof(struct entry), hash, entry_eq, NULL);
+
+    // Against a flag per key
+    for (size_t op = 0; op < nkeys * 20; ++op) {
+        struct entry e = { .key = rand() % nkeys };
+        e.val = e.key + 1;
+        if (rand() % 3) {
+            cr_assert_eq(hashmap_insert(&m, &e, NULL), !present[e.key]);
+            count += !present[e.key];
+            present[e.key] = true;
+        } else {
+            struct entry out;
+            cr_assert_eq(hashmap_remove(&m, &e, &out), present[e.key]);
+            if (present[e.key])
+                cr_assert_eq(out.val, e.key + 1);
+            count -= present[e.key];
+            present[e.key] = false;
+        }
+        cr_assert_eq(hashmap_length(&m), count);
+    }
+
+    for (uint64_t k = 0; k < nkeys; ++k) {
+        struct entry *e = hashmap_find(&m, &(struct entry){ .key = k });
+        cr_assert_eq(e != NULL, present[k]);
+        if (e)
+            cr_assert_eq(e->val, k + 1);
+    }
+
+    hashmap_clear(&m, NULL, NULL);
+    free(present);
+}
+
+static void check_level(const char *level) {
+    setenv("TUPPERWARE_SIMD", level, 1);
+    check_random(entry_hash, 5000);
+    check_random(entry_collide, 100);
+}
+
+Test(hashmap, scalar) {
+    check_level("scalar");
+}
+
+Test(hashmap, simd) {
+    check_level("avx512");
+}
+
+Test(hashmap, remove) {
+    struct hashmap m;
+    struct entry out;
+    hashmap_init(&m, sizeof(struct entry), entry_hash, entry_eq, NULL);
+
+    cr_assert_not(hashmap_remove(&m, &(struct entry){ .key = 1 }, &out));
+    for (uint64_t i = 0; i < 1000; ++i)
+        hashmap_insert(&m, &(struct entry){ .key = i, .val = i }, NULL);
+    for (uint64_t i = 0; i < 1000; i += 2) {
+        cr_assert(hashmap_remove(&m, &(struct entry){ .key = i }, &out));
+        cr_assert_eq(out.val, i);
+        cr_assert_not(hashmap_remove(&m, &(struct entry){ .key = i }, NULL));
+    }
+    cr_assert_eq(hashmap_length(&m), 500);
+    for (uint64_t i = 1; i < 1000; i += 2)
+        cr_assert(hashmap_remove(&m, &(struct entry){ .key = i }, NULL));
+    cr_assert(hashmap_empty(&m));
+
+    hashmap_clear(&m, NULL, NULL);
+}
+
+Test(hashmap, hash_once) {
+    struct hashmap m;
+    hashmap_init(&m, sizeof(struct entry), entry_collide_count, entry_eq,
+            NULL);
+
+    // Neither growing nor shifting the run back hashes elements again
+    for (uint64_t i = 0; i < 100; ++i)
+        hashmap_insert(&m, &(struct entry){ .key = i, .val = i }, NULL);
+    cr_assert_eq(hashed, 100);
+    for (uint64_t i = 0; i < 100; i += 2)
+        cr_assert(hashmap_remove(&m, &(struct entry){ .key = i }, NULL));
+    cr_assert_eq(hashed, 150);
+
+    for (uint64_t i = 1; i < 100; i += 2) {
+        struct entry *e = hashmap_find(&m, &(struct entry){ .key = i });
+        cr_assert_not_null(e);
+        cr_assert_eq(e->val, i);
+    }
+
+    hashmap_clear(&m, NULL, NULL);
+}
+
+Test(hashmap, reserve) {
+    struct hashmap m;
+    size_t compared = 0;
+    hashmap_init(&m, sizeof(struct entry), entry_hash, entry_eq, &compared);
+
+    cr_assert_not(hashmap_reserve(&m, SIZE_MAX));
+    cr_assert(hashmap_reserve(&m, 1000));
+    cr_assert_geq(hashmap_capacity(&m), 1000);
+    size_t cap = hashmap_capacity(&m);
+    for (uint64_t i = 0; i < 1000; ++i)
+        hashmap_insert(&m, &(struct entry){ .key = i }, NULL);
+    cr_assert_eq(hashmap_capacity(&m), cap);
+
+    // Control bytes filter out almost every other key
+    compared = 0;
+    for (uint64_t i = 0; i < 1000; ++i)
+        cr_assert_not_null(hashmap_find(&m, &(struct entry){ .key = i }));
+    cr_assert_lt(compared, 1100);
+
+    hashmap_clear(&m, NULL, NULL);
+}
+
+Test(hashmap, iterate_clear) {
+    struct hashmap m;
+    hashmap_init(&m, sizeof(struct entry), entry_hash, entry_eq, NULL);
+
+    for (uint64_t i = 0; i < 300; ++i)
+        hashmap_insert(&m, &(struct entry){ .key = i }, NULL);
+
+    bool seen[300] = { 0 };
+    size_t pos = 0;
+    struct entry *e;
+    while ((e = hashmap_next(&m, &pos))) {
+        cr_assert_not(seen[e->key]);
+        seen[e->key] = true;
+    }
+    for (size_t i = 0; i < 300; ++i)
+        cr_assert(seen[i]);
+    cr_assert_null(hashmap_next(NULL, &pos));
+
+    size_t count = 0;
+    hashmap_clear(&m, entry_dtor, &count);
+    cr_assert_eq(count, 300);
+    cr_assert_eq(hashmap_length(&m), 0);
+}
@@ -0,0 +1,327 @@
+#include <criterion/criterion.h>
+
+#include "tupperware/htable.h"
+
+TestSuite(htable, .timeout = 15);
+
+struct int_table {
+    int val;
+    struct htable_node node;
+};
+
+static uint64_t int_table_hash(const struct htable_node *n, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct int_table, node, n)->val;
+}
+
+static uint64_t zero_hash(const struct htable_node *n, void *cookie) {
+    (void)n;
+    (void)cookie;
+    return 0;
+}
+
+static bool int_table_eq(const struct htable_node *lhs,
+        const struct htable_node *rhs, void *cookie) {
+    struct int_table *l = CONTAINER_OF(struct int_table, node, lhs);
+    struct int_table *r = CONTAINER_OF(struct int_table, node, rhs);
+
+    size_t *count = cookie;
+    if (count)
+        ++*count;
+
+    return l->val == r->val;
+}
+
+static void int_table_count(struct htable_node *n, void *cookie) {
+    size_t *count = cookie;
+    (void)n;
+    ++*count;
+}
+
+static struct int_table *fill(struct htable *table, size_t n) {
+    struct int_table *t = calloc(n, sizeof(*t));
+    for (size_t i = 0; i < n; ++i) {
+        t[i].val = i;
+        t[i].node = HTABLE_NODE_INIT_VAL;
+        cr_assert(htable_insert(table, &t[i].node, NULL));
+    }
+    return t;
+}
+
+static struct int_table *find(const struct htable *table, int val) {
+    struct int_table key = { val, HTABLE_NODE_INIT_VAL };
+    struct htable_node *n = htable_find(table, &key.node);
+    return n ? CONTAINER_OF(struct int_table, node, n) : NULL;
+}
+
+Test(htable, init) {
+    struct htable table;
+    size_t count = 0;
+    htable_init(&table, int_table_hash, int_table_eq, &count);
+
+    cr_assert_eq(table.hash, int_table_hash);
+    cr_assert_eq(table.eq, int_table_eq);
+    cr_assert_eq(table.cookie, &count);
+    cr_assert(htable_empty(&table));
+    cr_assert_null(find(&table, 0));
+
+    htable_init(NULL, NULL, NULL, NULL);
+    htable_clear(NULL, NULL, NULL);
+    cr_assert(htable_empty(NULL));
+    cr_assert_eq(htable_size(NULL), 0);
+    cr_assert_null(htable_find(NULL, &(struct htable_node){ 0 }));
+}
+
+Test(htable, insert_null) {
+    struct htable table;
+    struct int_table t = { 42, HTABLE_NODE_INIT_VAL };
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+
+    cr_assert_not(htable_insert(NULL, &t.node, NULL));
+    cr_assert_not(htable_insert(&table, NULL, NULL));
+    cr_assert_null(htable_insert_or_update(NULL, &t.node));
+    cr_assert_not(htable_insert_multi(NULL, &t.node));
+    cr_assert(htable_empty(&table));
+}
+
+Test(htable, insert_find) {
+    struct htable table;
+    size_t count = 0;
+    htable_init(&table, int_table_hash, int_table_eq, &count);
+
+    struct int_table *t = fill(&table, 1000);
+    cr_assert_eq(htable_size(&table), 1000);
+    for (int i = 0; i < 1000; ++i)
+        cr_assert_eq(find(&table, i), &t[i]);
+    cr_assert_null(find(&table, 1000));
+    cr_assert_null(find(&table, -1));
+
+    // Cached hashes skip most comparisons
+    count = 0;
+    for (int i = 0; i < 1000; ++i)
+        find(&table, i);
+    cr_assert_eq(count, 1000);
+
+    htable_clear(&table, NULL, NULL);
+    free(t);
+}
+
+Test(htable, insert_preexisting) {
+    struct htable table;
+    struct int_table t = { 42, HTABLE_NODE_INIT_VAL };
+    struct int_table t2 = { 42, HTABLE_NODE_INIT_VAL };
+    struct htable_node *inserted = NULL;
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+
+    cr_assert(htable_insert(&table, &t.node, &inserted));
+    cr_assert_eq(inserted, &t.node);
+    cr_assert_not(htable_insert(&table, &t2.node, &inserted));
+    cr_assert_eq(inserted, &t.node);
+    cr_assert_eq(htable_size(&table), 1);
+
+    htable_clear(&table, NULL, NULL);
+}
+
+Test(htable, insert_or_update) {
+    struct htable table;
+    struct int_table t = { 42, HTABLE_NODE_INIT_VAL };
+    struct int_table t2 = { 42, HTABLE_NODE_INIT_VAL };
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+
+    cr_assert_null(htable_insert_or_update(&table, &t.node));
+    cr_assert_eq(htable_insert_or_update(&table, &t2.node), &t.node);
+    cr_assert_eq(find(&table, 42), &t2);
+    cr_assert_eq(htable_size(&table), 1);
+
+    htable_clear(&table, NULL, NULL);
+}
+
+Test(htable, insert_or_update_same) {
+    struct htable table;
+    struct int_table t[4];
+    htable_init(&table, zero_hash, int_table_eq, NULL);
+
+    // All in one chain, re-inserting must keep the ones after it
+    for (int i = 0; i < 4; ++i) {
+        t[i] = (struct int_table){ i, HTABLE_NODE_INIT_VAL };
+        cr_assert(htable_insert(&table, &t[i].node, NULL));
+    }
+    for (int i = 0; i < 4; ++i)
+        cr_assert_null(htable_insert_or_update(&table, &t[i].node));
+
+    cr_assert_eq(htable_size(&table), 4);
+    for (int i = 0; i < 4; ++i)
+        cr_assert_eq(find(&table, i), &t[i]);
+
+    htable_clear(&table, NULL, NULL);
+}
+
+Test(htable, insert_multi_remove_at) {
+    struct htable table;
+    struct int_table t = { 42, HTABLE_NODE_INIT_VAL };
+    struct int_table t2 = { 42, HTABLE_NODE_INIT_VAL };
+    size_t count = 0;
+    htable_init(&table, int_table_hash, int_table_eq, &count);
+
+    cr_assert(htable_insert_multi(&table, &t.node));
+    cr_assert(htable_insert_multi(&table, &t2.node));
+    cr_assert_eq(htable_size(&table), 2);
+
+    // Exact removals do not compare
+    count = 0;
+    cr_assert(htable_remove_at(&table, &t.node));
+    cr_assert_not(htable_remove_at(&table, &t.node));
+    cr_assert_eq(count, 0);
+    cr_assert_eq(find(&table, 42), &t2);
+    cr_assert(htable_remove_at(&table, &t2.node));
+    cr_assert(htable_empty(&table));
+
+    cr_assert_not(htable_remove_at(NULL, &t.node));
+    cr_assert_not(htable_remove_at(&table, NULL));
+    htable_clear(&table, NULL, NULL);
+}
+
+Test(htable, remove) {
+    struct htable table;
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+
+    struct int_table *t = fill(&table, 1000);
+    for (int i = 0; i < 1000; i += 2) {
+        struct int_table key = { i, HTABLE_NODE_INIT_VAL };
+        cr_assert_eq(htable_remove(&table, &key.node), &t[i].node);
+        cr_assert_null(htable_remove(&table, &key.node));
+    }
+    cr_assert_eq(htable_size(&table), 500);
+    for (int i = 0; i < 1000; ++i)
+        cr_assert_eq(find(&table, i), i % 2 ? &t[i] : NULL);
+
+    cr_assert_null(htable_remove(NULL, &t[0].node));
+    cr_assert_null(htable_remove(&table, NULL));
+    htable_clear(&table, NULL, NULL);
+    free(t);
+}
+
+Test(htable, incremental_resize) {
+    struct htable table;
+    struct int_table *t = calloc(10000, sizeof(*t));
+    size_t resizing = 0;
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+
+    for (int i = 0; i < 10000; ++i) {
+        t[i].val = i;
+        cr_assert(htable_insert(&table, &t[i].node, NULL));
+
+        // Never all at once past the first arrays
+        if (table.old) {
+            ++resizing;
+            cr_assert_lt(table.migrated, table.nold);
+        }
+        cr_assert_eq(find(&table, i / 2), &t[i / 2]);
+        cr_assert_eq(find(&table, i), &t[i]);
+    }
+    cr_assert_gt(resizing, 1000);
+
+    // Removals move buckets too, and nodes are found wherever they are
+    for (int i = 0; i < 10000; i += 3)
+        cr_assert(htable_remove_at(&table, &t[i].node));
+    for (int i = 0; i < 10000; ++i)
+        cr_assert_eq(find(&table, i), i % 3 ? &t[i] : NULL);
+
+    size_t count = 0;
+    htable_map(&table, int_table_count, &count);
+    cr_assert_eq(count, htable_size(&table));
+
+    htable_clear(&table, NULL, NULL);
+    free(t);
+}
+
+Test(htable, clear) {
+    struct htable table;
+    size_t count = 0;
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+
+    struct int_table *t = fill(&table, 100);
+    htable_clear(&table, int_table_count, &count);
+    cr_assert_eq(count, 100);
+    cr_assert(htable_empty(&table));
+    cr_assert_null(find(&table, 0));
+
+    // Still usable
+    cr_assert(htable_insert(&table, &t[0].node, NULL));
+    htable_clear(&table, NULL, NULL);
+    free(t);
+}
+
+Test(htable, merge) {
+    struct htable table;
+    struct htable more;
+    struct int_table t[] = { { 1, HTABLE_NODE_INIT_VAL },
+        { 2, HTABLE_NODE_INIT_VAL } };
+    struct int_table m[] = { { 2, HTABLE_NODE_INIT_VAL },
+        { 3, HTABLE_NODE_INIT_VAL } };
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+    htable_init(&more, int_table_hash, int_table_eq, NULL);
+    for (size_t i = 0; i < 2; ++i) {
+        htable_insert(&table, &t[i].node, NULL);
+        htable_insert(&more, &m[i].node, NULL);
+    }
+
+    htable_merge(&table, &more);
+    cr_assert_eq(htable_size(&table), 3);
+    cr_assert_eq(find(&table, 2), &t[1]);
+    cr_assert_eq(find(&table, 3), &m[1]);
+    cr_assert_eq(htable_size(&more), 1);
+    cr_assert_eq(find(&more, 2), &m[0]);
+
+    htable_merge(NULL, &more);
+    htable_merge(&table, NULL);
+    htable_clear(&table, NULL, NULL);
+    htable_clear(&more, NULL, NULL);
+}
+
+Test(htable, update) {
+    struct htable table;
+    struct htable more;
+    struct int_table t[] = { { 1, HTABLE_NODE_INIT_VAL },
+        { 2, HTABLE_NODE_INIT_VAL } };
+    struct int_table m[] = { { 2, HTABLE_NODE_INIT_VAL },
+        { 3, HTABLE_NODE_INIT_VAL } };
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+    htable_init(&more, int_table_hash, int_table_eq, NULL);
+    for (size_t i = 0; i < 2; ++i) {
+        htable_insert(&table, &t[i].node, NULL);
+        htable_insert(&more, &m[i].node, NULL);
+    }
+
+    htable_update(&table, &more);
+    cr_assert_eq(htable_size(&table), 3);
+    cr_assert_eq(find(&table, 2), &m[0]);
+    cr_assert_eq(htable_size(&more), 1);
+    cr_assert_eq(find(&more, 2), &t[1]);
+
+    htable_clear(&table, NULL, NULL);
+    htable_clear(&more, NULL, NULL);
+}
+
+Test(htable, merge_all) {
+    struct htable table;
+    struct htable more;
+    htable_init(&table, int_table_hash, int_table_eq, NULL);
+    htable_init(&more, int_table_hash, int_table_eq, NULL);
+
+    struct int_table *t = fill(&table, 100);
+    struct int_table *m = fill(&more, 100);
+    htable_merge_all(&table, &more);
+    cr_assert_eq(htable_size(&table), 200);
+    cr_assert(htable_empty(&more));
+
+    for (int i = 0; i < 100; ++i) {
+        cr_assert(htable_remove_at(&table, &t[i].node));
+        cr_assert_eq(find(&table, i), &m[i]);
+    }
+
+    htable_clear(&table, NULL, NULL);
+    htable_clear(&more, NULL, NULL);
+    free(t);
+    free(m);
+}
@@ -1,5 +1,7 @@
 #include <criterion/criterion.h>
 
+#include <stdlib.h>
+
 #include "tupperware/list.h"
 
 TestSuite(list, .timeout = 15);
@@ -415,7 +417,8 @@ Test(list, sort_sorted) {
 
     cr_assert_eq(l.head, &arr[0].list);
     assert_list(arr, ARR_SIZE(arr), 0);
-    cr_assert_eq(count, ARR_SIZE(arr) * (ARR_SIZE(arr) - 1) / 2);
+    // Runs [1 2] [3 4] [5], then [3 4 5] and [1 2 3 4 5]
+    cr_assert_eq(count, 6);
 }
 
 Test(list, sort_inverted) {
@@ -435,6 +438,49 @@ Test(list, sort_inverted) {
     assert_list(arr, ARR_SIZE(arr), 0);
 }
 
+struct key_list {
+    int key;
+    int pos;
+    struct list_node list;
+};
+
+static int key_list_cmp(const struct list_node *lhs,
+        const struct list_node *rhs, void *cookie) {
+    (void)cookie;
+    int l = CONTAINER_OF(struct key_list, list, lhs)->key;
+    int r = CONTAINER_OF(struct key_list, list, rhs)->key;
+    return (l > r) - (l < r);
+}
+
+Test(list, sort_stable) {
+    enum { N = 100000 };
+    struct key_list *arr = malloc(N * sizeof(*arr));
+    struct list l;
+    list_init(&l);
+
+    for (int i = 0; i < N; ++i) {
+        arr[i].key = rand() % 100;
+        arr[i].pos = i;
+        list_push_back(&l, &arr[i].list);
+    }
+    list_sort(&l, key_list_cmp, NULL);
+    cr_assert_eq(list_length(&l), N);
+
+    const struct key_list *prev = NULL;
+    LIST_FOREACH_ENTRY (struct key_list, list, l, it) {
+        cr_assert_eq(it->list.next->prev, &it->list);
+        if (prev) {
+            cr_assert_leq(prev->key, it->key);
+            if (prev->key == it->key)
+                cr_assert_lt(prev->pos, it->pos);
+        }
+        prev = it;
+    }
+    cr_assert_eq(l.head->prev, &prev->list);
+
+    free(arr);
+}
+
 Test(list, merge_sorted_null) {
     list_merge_sorted(NULL, NULL, int_list_cmp, NULL);
 
@@ -483,6 +529,237 @@ Test(list, merge_sorted_alternate) {
     cr_assert_null(odd.head);
 }
 
+static int counting_key_cmp(const struct list_node *lhs,
+        const struct list_node *rhs, void *cookie) {
+    size_t *count = cookie;
+    ++*count;
+    return key_list_cmp(lhs, rhs, NULL);
+}
+
+Test(list, kway_merge_null) {
+    struct list res = { NULL };
+    struct list l = { NULL };
+
+    cr_assert_not(list_kway_merge(NULL, &l, 1, key_list_cmp, NULL));
+    cr_assert_not(list_kway_merge(&res, NULL, 1, key_list_cmp, NULL));
+    cr_assert(list_kway_merge(&res, NULL, 0, key_list_cmp, NULL));
+    cr_assert(list_kway_merge(&res, &l, 1, key_list_cmp, NULL));
+    cr_assert_null(res.head);
+}
+
+Test(list, kway_merge_one) {
+    struct key_list arr[3] = { { 1, 0, LIST_NODE_INIT_VAL },
+        { 2, 1, LIST_NODE_INIT_VAL }, { 3, 2, LIST_NODE_INIT_VAL } };
+    struct list res;
+    struct list l;
+    list_init(&res);
+    list_init(&l);
+    list_push_back(&res, &arr[0].list);
+    list_push_back(&l, &arr[1].list);
+    list_push_back(&l, &arr[2].list);
+
+    // Appends to what is already there
+    cr_assert(list_kway_merge(&res, &l, 1, key_list_cmp, NULL));
+    cr_assert_null(l.head);
+    cr_assert_eq(list_length(&res), 3);
+    cr_assert_eq(res.head->prev, &arr[2].list);
+}
+
+Test(list, kway_merge) {
+    enum { K = 37, N = 20000 };
+    struct key_list *arr = malloc(N * sizeof(*arr));
+    struct list lists[K];
+    struct list res;
+    list_init(&res);
+    for (size_t i = 0; i < K; ++i)
+        list_init(&lists[i]);
+
+    // Some lists stay empty, `pos` orders by list then by position
+    for (int i = 0; i < N; ++i) {
+        int list = rand() % (K - 5);
+        arr[i].key = rand() % 1000;
+        arr[i].pos = list * N + i;
+        list_push_back(&lists[list], &arr[i].list);
+    }
+    for (size_t i = 0; i < K; ++i)
+        list_sort(&lists[i], key_list_cmp, NULL);
+
+    size_t count = 0;
+    cr_assert(list_kway_merge(&res, lists, K, counting_key_cmp, &count));
+    for (size_t i = 0; i < K; ++i)
+        cr_assert_null(lists[i].head);
+    cr_assert_eq(list_length(&res), N);
+    // Each node plays one match per level of the tree
+    cr_assert_leq(count, (N + K) * 6);
+
+    const struct key_list *prev = NULL;
+    LIST_FOREACH_ENTRY (struct key_list, list, res, it) {
+        cr_assert_eq(it->list.next->prev, &it->list);
+        if (prev) {
+            cr_assert_leq(prev->key, it->key);
+            if (prev->key == it->key)
+                cr_assert_lt(prev->pos, it->pos);
+        }
+        prev = it;
+    }
+
+    free(arr);
+}
+
+static int key_at(const struct list *l, size_t i) {
+    const struct list_node *n = l->head;
+    while (i--)
+        n = n->next;
+    return CONTAINER_OF(struct key_list, list, n)->key;
+}
+
+static void key_lists(struct key_list *arr, size_t n,
+        struct list *a, struct list *b) {
+    list_init(a);
+    list_init(b);
+    for (size_t i = 0; i < n; ++i) {
+        arr[i].key = i;
+        list_push_back(i < n / 2 ? a : b, &arr[i].list);
+    }
+}
+
+Test(list, splice) {
+    struct key_list arr[6];
+    struct list a;
+    struct list b;
+
+    list_splice(NULL, NULL, &a);
+    list_splice(&a, NULL, NULL);
+
+    // [0 1 2] + [3 4 5] before 1
+    key_lists(arr, 6, &a, &b);
+    list_splice(&a, &arr[1].list, &b);
+    cr_assert_null(b.head);
+    cr_assert_eq(list_length(&a), 6);
+    int mid[] = { 0, 3, 4, 5, 1, 2 };
+    for (size_t i = 0; i < 6; ++i)
+        cr_assert_eq(key_at(&a, i), mid[i]);
+    cr_assert_eq(a.head->prev, &arr[2].list);
+
+    // Before the head, then at the end
+    key_lists(arr, 6, &a, &b);
+    list_splice(&a, a.head, &b);
+    cr_assert_eq(a.head, &arr[3].list);
+    cr_assert_eq(a.head->prev, &arr[2].list);
+    key_lists(arr, 6, &a, &b);
+    list_splice(&a, NULL, &b);
+    for (size_t i = 0; i < 6; ++i)
+        cr_assert_eq(key_at(&a, i), (int)i);
+
+    list_init(&a);
+    key_lists(arr, 6, &b, &b);
+    list_splice(&a, NULL, &b);
+    cr_assert_eq(list_length(&a), 6);
+}
+
+Test(list, split_at) {
+    struct key_list arr[6];
+    struct list a;
+    struct list b;
+
+    list_split_at(NULL, 0, &b);
+    list_split_at(&a, 0, NULL);
+
+    key_lists(arr, 6, &a, &a);
+    list_split_at(&a, 4, &b);
+    cr_assert_eq(list_length(&a), 4);
+    cr_assert_eq(list_length(&b), 2);
+    cr_assert_eq(a.head->prev, &arr[3].list);
+    cr_assert_eq(arr[3].list.next, &arr[0].list);
+    cr_assert_eq(b.head, &arr[4].list);
+    cr_assert_eq(b.head->prev, &arr[5].list);
+
+    list_split_at(&a, 4, &b);
+    cr_assert_null(b.head);
+    list_split_at(&a, 0, &b);
+    cr_assert_null(a.head);
+    cr_assert_eq(list_length(&b), 4);
+}
+
+static bool odd_key(struct list_node *n, void *cookie) {
+    (void)cookie;
+    return CONTAINER_OF(struct key_list, list, n)->key & 1;
+}
+
+Test(list, counted) {
+    enum { N = 1000 };
+    struct key_list *arr = malloc(N * sizeof(*arr));
+    struct counted_list l[3];
+    for (size_t i = 0; i < 3; ++i)
+        counted_list_init(&l[i]);
+    for (int i = 0; i < N; ++i) {
+        arr[i].key = rand() % 100;
+        counted_list_push_back(&l[i % 3], &arr[i].list);
+    }
+
+    for (int i = 0; i < 5000; ++i) {
+        struct counted_list *x = &l[rand() % 3];
+        struct counted_list *y = &l[rand() % 3];
+        if (x == y)
+            continue;
+
+        switch (rand() % 9) {
+        case 0:
+            if (x->list.head)
+                counted_list_push_front(y, counted_list_pop_back(x));
+            break;
+        case 1:
+            if (x->list.head)
+                counted_list_push_back(y, counted_list_pop_front(x));
+            break;
+        case 2:
+            if (x->list.head)
+                counted_list_push_back(y,
+                        counted_list_detach(x, x->list.head->next));
+            break;
+        case 3:
+            counted_list_concat(x, y);
+            break;
+        case 4:
+            counted_list_splice(x, x->list.head ? x->list.head->prev : NULL,
+                    y);
+            break;
+        case 5: {
+            struct counted_list tail;
+            counted_list_split_at(x, rand() % (x->length + 2), &tail);
+            counted_list_concat(y, &tail);
+            break;
+        }
+        case 6:
+            counted_list_filter(y, x, odd_key, NULL);
+            break;
+        case 7:
+            counted_list_sort(x, key_list_cmp, NULL);
+            counted_list_sort(y, key_list_cmp, NULL);
+            counted_list_merge_sorted(x, y, key_list_cmp, NULL);
+            break;
+        default:
+            if (y->list.head)
+                counted_list_insert_sorted(x, counted_list_pop_front(y),
+                        key_list_cmp, NULL);
+            break;
+        }
+
+        size_t total = 0;
+        for (size_t j = 0; j < 3; ++j) {
+            cr_assert_eq(counted_list_length(&l[j]), list_length(&l[j].list));
+            cr_assert_eq(counted_list_empty(&l[j]), list_empty(&l[j].list));
+            total += counted_list_length(&l[j]);
+        }
+        cr_assert_eq(total, N);
+    }
+
+    cr_assert_eq(counted_list_length(NULL), 0);
+    cr_assert(counted_list_empty(NULL));
+    cr_assert_null(counted_list_pop_front(NULL));
+    free(arr);
+}
+
 static void int_list_map(struct list_node *n, void *cookie) {
     size_t *count = cookie;
 
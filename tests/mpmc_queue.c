@@ -0,0 +1,182 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+
+#include "tupperware/mpmc_queue.h"
+
+TestSuite(mpmc_queue, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+Test(mpmc_queue, init_null) {
+    struct mpmc_queue q;
+
+    cr_assert_not(mpmc_queue_init(NULL, 1, 1));
+    cr_assert_not(mpmc_queue_init(&q, 0, 1));
+    cr_assert_not(mpmc_queue_init(&q, 1, -1));
+    cr_assert_not(mpmc_queue_init(&q, -1, 1));
+}
+
+Test(mpmc_queue, init) {
+    struct mpmc_queue q;
+
+    cr_assert(mpmc_queue_init(&q, 3, 3));
+
+    cr_assert_eq(mpmc_queue_capacity(&q), 4);
+    cr_assert_eq(mpmc_queue_elem_size(&q), 3);
+    cr_assert_eq(q.stride % sizeof(size_t), 0);
+    cr_assert(mpmc_queue_empty(&q));
+
+    mpmc_queue_clear(&q, NULL, NULL);
+    cr_assert_eq(mpmc_queue_capacity(&q), 0);
+}
+
+Test(mpmc_queue, accessors_null) {
+    cr_assert_eq(mpmc_queue_length(NULL), 0);
+    cr_assert_eq(mpmc_queue_capacity(NULL), 0);
+    cr_assert_eq(mpmc_queue_elem_size(NULL), 0);
+    cr_assert(mpmc_queue_empty(NULL));
+    cr_assert_not(mpmc_queue_try_push(NULL, NULL));
+    cr_assert_not(mpmc_queue_try_pop(NULL, NULL));
+    cr_assert_not(mpmc_queue_push(NULL, NULL));
+    cr_assert_not(mpmc_queue_pop(NULL, NULL));
+}
+
+Test(mpmc_queue, try_push_pop) {
+    struct mpmc_queue q;
+    mpmc_queue_init(&q, sizeof(int), 4);
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i)
+            cr_assert(mpmc_queue_try_push(&q, &i));
+        int n = 42;
+        cr_assert_not(mpmc_queue_try_push(&q, &n));
+        cr_assert_eq(mpmc_queue_length(&q), 4);
+
+        for (int i = 0; i < 4; ++i) {
+            cr_assert(mpmc_queue_try_pop(&q, &n));
+            cr_assert_eq(n, i);
+        }
+        cr_assert_not(mpmc_queue_try_pop(&q, &n));
+    }
+
+    mpmc_queue_clear(&q, NULL, NULL);
+}
+
+Test(mpmc_queue, try_batch) {
+    struct mpmc_queue q;
+    mpmc_queue_init(&q, sizeof(int), 8);
+    int arr[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    int out[ARR_SIZE(arr)] = { 0 };
+
+    cr_assert_eq(mpmc_queue_try_push_n(&q, arr, 6), 6);
+    cr_assert_eq(mpmc_queue_try_pop_n(&q, out, 5), 5);
+    cr_assert_eq(mpmc_queue_try_push_n(&q, arr + 6, ARR_SIZE(arr) - 6), 6);
+    cr_assert_eq(mpmc_queue_try_push_n(&q, arr, ARR_SIZE(arr)), 1);
+
+    cr_assert_eq(mpmc_queue_try_pop_n(&q, out, ARR_SIZE(out)), 8);
+    for (int i = 0; i < 7; ++i)
+        cr_assert_eq(out[i], i + 5);
+    cr_assert_eq(out[7], 0);
+
+    cr_assert_eq(mpmc_queue_try_pop_n(&q, out, ARR_SIZE(out)), 0);
+
+    mpmc_queue_clear(&q, NULL, NULL);
+}
+
+static void int_dtor(void *val, void *cookie) {
+    int *n = val;
+    int *count = cookie;
+
+    cr_assert_eq(*n, (*count)++);
+}
+
+Test(mpmc_queue, clear) {
+    struct mpmc_queue q;
+    mpmc_queue_init(&q, sizeof(int), 4);
+
+    for (int i = 0; i < 3; ++i)
+        mpmc_queue_try_push(&q, &i);
+    mpmc_queue_try_pop(&q, NULL);
+    for (int i = 3; i < 5; ++i)
+        mpmc_queue_try_push(&q, &i);
+
+    int count = 1;
+    mpmc_queue_clear(&q, int_dtor, &count);
+
+    cr_assert_eq(count, 5);
+}
+
+#define THREADS 4
+#define PER_THREAD 20000
+
+struct worker {
+    struct mpmc_queue *q;
+    size_t id;
+    size_t sum;
+};
+
+static void *producer(void *arg) {
+    struct worker *w = arg;
+    size_t batch[3];
+
+    for (size_t i = 0; i < PER_THREAD;) {
+        if (i % 2) {
+            size_t val = w->id * PER_THREAD + i;
+            mpmc_queue_push(w->q, &val);
+            i += 1;
+            continue;
+        }
+
+        size_t n = 0;
+        for (; n < ARR_SIZE(batch) && i + n < PER_THREAD; ++n)
+            batch[n] = w->id * PER_THREAD + i + n;
+        mpmc_queue_push_n(w->q, batch, n);
+        i += n;
+    }
+
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    struct worker *w = arg;
+    size_t batch[5];
+
+    for (size_t i = 0; i < PER_THREAD;) {
+        size_t n = ARR_SIZE(batch);
+        if (n > PER_THREAD - i)
+            n = PER_THREAD - i;
+
+        n = mpmc_queue_pop_n(w->q, batch, n);
+        for (size_t j = 0; j < n; ++j)
+            w->sum += batch[j];
+        i += n;
+    }
+
+    return NULL;
+}
+
+Test(mpmc_queue, threads) {
+    struct mpmc_queue q;
+    mpmc_queue_init(&q, sizeof(size_t), 16);
+
+    pthread_t threads[2 * THREADS];
+    struct worker workers[2 * THREADS];
+    for (size_t i = 0; i < ARR_SIZE(workers); ++i) {
+        workers[i] = (struct worker){ &q, i % THREADS, 0 };
+        cr_assert_eq(pthread_create(&threads[i], NULL,
+                    i < THREADS ? producer : consumer, &workers[i]), 0);
+    }
+
+    size_t sum = 0;
+    for (size_t i = 0; i < ARR_SIZE(threads); ++i) {
+        pthread_join(threads[i], NULL);
+        sum += workers[i].sum;
+    }
+
+    size_t total = THREADS * PER_THREAD;
+    cr_assert_eq(sum, total * (total - 1) / 2);
+    cr_assert(mpmc_queue_empty(&q));
+
+    mpmc_queue_clear(&q, NULL, NULL);
+}
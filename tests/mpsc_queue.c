@@ -0,0 +1,221 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "tupperware/mpsc_queue.h"
+
+TestSuite(mpsc_queue, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+struct int_list {
+    int val;
+    struct list_node list;
+};
+
+static void init_arr(struct int_list *arr, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        arr[i].val = i;
+        arr[i].list = LIST_NODE_INIT_VAL;
+    }
+}
+
+static void assert_list(struct list *l, int first, size_t n) {
+    size_t count = 0;
+    LIST_FOREACH_ENTRY (struct int_list, list, *l, it) {
+        cr_assert_eq(it->val, first + (int)count++);
+        cr_assert_eq(it->list.next->prev, &it->list);
+    }
+    cr_assert_eq(count, n);
+}
+
+Test(mpsc_queue, null) {
+    mpsc_queue_init(NULL);
+    mpsc_queue_push(NULL, NULL);
+    mpsc_queue_drain(NULL, NULL);
+    cr_assert_null(mpsc_queue_pop(NULL));
+    cr_assert(mpsc_queue_empty(NULL));
+}
+
+Test(mpsc_queue, init) {
+    struct mpsc_queue q;
+    mpsc_queue_init(&q);
+
+    cr_assert(mpsc_queue_empty(&q));
+    cr_assert_null(mpsc_queue_pop(&q));
+}
+
+Test(mpsc_queue, push_pop) {
+    struct mpsc_queue q;
+    struct int_list arr[5];
+    init_arr(arr, ARR_SIZE(arr));
+    mpsc_queue_init(&q);
+
+    for (int round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < ARR_SIZE(arr); ++i)
+            mpsc_queue_push(&q, &arr[i].list);
+        cr_assert_not(mpsc_queue_empty(&q));
+
+        for (size_t i = 0; i < ARR_SIZE(arr); ++i) {
+            struct list_node *n = mpsc_queue_pop(&q);
+            cr_assert_eq(n, &arr[i].list);
+            cr_assert_eq(n->next, n);
+            cr_assert_eq(n->prev, n);
+        }
+        cr_assert_null(mpsc_queue_pop(&q));
+        cr_assert(mpsc_queue_empty(&q));
+    }
+}
+
+Test(mpsc_queue, drain) {
+    struct mpsc_queue q;
+    struct int_list arr[5];
+    init_arr(arr, ARR_SIZE(arr));
+    mpsc_queue_init(&q);
+
+    for (size_t i = 0; i < ARR_SIZE(arr); ++i)
+        mpsc_queue_push(&q, &arr[i].list);
+
+    struct list l = { NULL };
+    mpsc_queue_drain(&q, &l);
+
+    assert_list(&l, 0, ARR_SIZE(arr));
+    cr_assert(mpsc_queue_empty(&q));
+
+    mpsc_queue_drain(&q, &l);
+    assert_list(&l, 0, ARR_SIZE(arr));
+}
+
+Test(mpsc_queue, drain_appends) {
+    struct mpsc_queue q;
+    struct int_list arr[6];
+    init_arr(arr, ARR_SIZE(arr));
+    mpsc_queue_init(&q);
+
+    struct list l = { NULL };
+    list_push_back(&l, &arr[0].list);
+
+    // Popping the last node queues the stub behind it
+    mpsc_queue_push(&q, &arr[1].list);
+    mpsc_queue_push(&q, &arr[2].list);
+    cr_assert_eq(mpsc_queue_pop(&q), &arr[1].list);
+    cr_assert_eq(mpsc_queue_pop(&q), &arr[2].list);
+    list_push_back(&l, &arr[1].list);
+    list_push_back(&l, &arr[2].list);
+
+    mpsc_queue_push(&q, &arr[3].list);
+    cr_assert_eq(mpsc_queue_pop(&q), &arr[3].list);
+    list_push_back(&l, &arr[3].list);
+    mpsc_queue_push(&q, &arr[4].list);
+    mpsc_queue_push(&q, &arr[5].list);
+
+    mpsc_queue_drain(&q, &l);
+
+    assert_list(&l, 0, ARR_SIZE(arr));
+    cr_assert(mpsc_queue_empty(&q));
+}
+
+#define THREADS 4
+#define PER_THREAD 20000
+
+struct producer_arg {
+    struct mpsc_queue *q;
+    struct int_list *nodes;
+};
+
+static void *producer(void *arg) {
+    struct producer_arg *p = arg;
+
+    for (size_t i = 0; i < PER_THREAD; ++i)
+        mpsc_queue_push(p->q, &p->nodes[i].list);
+
+    return NULL;
+}
+
+Test(mpsc_queue, threads) {
+    struct mpsc_queue q;
+    mpsc_queue_init(&q);
+
+    static struct int_list nodes[THREADS][PER_THREAD];
+    struct producer_arg args[THREADS];
+    pthread_t threads[THREADS];
+    for (size_t i = 0; i < THREADS; ++i) {
+        init_arr(nodes[i], PER_THREAD);
+        args[i] = (struct producer_arg){ &q, nodes[i] };
+        cr_assert_eq(pthread_create(&threads[i], NULL, producer, &args[i]), 0);
+    }
+
+    int next[THREADS] = { 0 };
+    size_t total = 0;
+    while (total < THREADS * PER_THREAD) {
+        struct list l = { NULL };
+        if (total % 2) {
+            struct list_node *n = mpsc_queue_pop(&q);
+            if (n)
+                list_push_back(&l, n);
+        } else {
+            mpsc_queue_drain(&q, &l);
+        }
+
+        if (list_empty(&l))
+            sched_yield();
+
+        LIST_FOREACH_ENTRY (struct int_list, list, l, it) {
+            size_t t = (it - &nodes[0][0]) / PER_THREAD;
+            cr_assert_eq(it->val, next[t]++);
+            ++total;
+        }
+    }
+
+    for (size_t i = 0; i < THREADS; ++i)
+        pthread_join(threads[i], NULL);
+    cr_assert(mpsc_queue_empty(&q));
+}
+
+Test(mpsc_queue, held_producer) {
+    struct mpsc_queue q;
+    struct int_list held[2];
+    init_arr(held, ARR_SIZE(held));
+    mpsc_queue_init(&q);
+
+    // The second push stops between the exchange and linking its node
+    mpsc_queue_push(&q, &held[0].list);
+    held[1].list.next = NULL;
+    struct list_node *prev =
+        __atomic_exchange_n(&q.head, &held[1].list, __ATOMIC_ACQ_REL);
+
+    static struct int_list nodes[THREADS][PER_THREAD];
+    struct producer_arg args[THREADS];
+    pthread_t threads[THREADS];
+    for (size_t i = 0; i < THREADS; ++i) {
+        init_arr(nodes[i], PER_THREAD);
+        args[i] = (struct producer_arg){ &q, nodes[i] };
+        cr_assert_eq(pthread_create(&threads[i], NULL, producer, &args[i]), 0);
+    }
+    for (size_t i = 0; i < THREADS; ++i)
+        pthread_join(threads[i], NULL);
+
+    // Nothing can be taken past the missing link
+    struct list l = { NULL };
+    mpsc_queue_drain(&q, &l);
+    cr_assert(list_empty(&l));
+    cr_assert_null(mpsc_queue_pop(&q));
+
+    __atomic_store_n(&prev->next, &held[1].list, __ATOMIC_RELEASE);
+    mpsc_queue_drain(&q, &l);
+    cr_assert(mpsc_queue_empty(&q));
+
+    int next[THREADS] = { 0 };
+    size_t total = 0;
+    LIST_FOREACH_ENTRY (struct int_list, list, l, it) {
+        cr_assert_eq(it->list.next->prev, &it->list);
+        if (total++ < ARR_SIZE(held)) {
+            cr_assert_eq(it, &held[total - 1]);
+            continue;
+        }
+        size_t t = (it - &nodes[0][0]) / PER_THREAD;
+        cr_assert_eq(it->val, next[t]++);
+    }
+    cr_assert_eq(total, ARR_SIZE(held) + THREADS * PER_THREAD);
+}
@@ -0,0 +1,269 @@
+#include <criterion/criterion.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tupperware/packed_u32.h"
+
+TestSuite(packed_u32, .timeout = 15);
+
+static int u32_cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    uint32_t l = *(const uint32_t *)lhs;
+    uint32_t r = *(const uint32_t *)rhs;
+    return (l > r) - (l < r);
+}
+
+// Non decreasing, with random gaps in `[0, step]` starting from `x`
+static void fill(struct vector *v, size_t n, uint32_t x, uint32_t step) {
+    cr_assert(vector_init(v, sizeof(uint32_t)));
+    for (size_t i = 0; i < n; ++i) {
+        cr_assert(vector_push_back(v, &x));
+        x += rand() % (step + 1);
+    }
+}
+
+static void check_roundtrip(const struct vector *v) {
+    struct packed_u32 p;
+    struct packed_u32_iter it;
+    struct vector res;
+    const uint32_t *arr = v->arr;
+
+    cr_assert(packed_u32_init(&p, v));
+    cr_assert_eq(packed_u32_length(&p), v->nmemb);
+
+    vector_init(&res, sizeof(uint32_t));
+    cr_assert(packed_u32_decode(&p, &res));
+    cr_assert_eq(res.nmemb, v->nmemb);
+    if (v->nmemb)
+        cr_assert_arr_eq(res.arr, v->arr, v->nmemb * sizeof(uint32_t));
+
+    packed_u32_iter_init(&it, &p);
+    uint32_t x;
+    for (size_t i = 0; i < v->nmemb; ++i) {
+        cr_assert(packed_u32_next(&it, &x));
+        cr_assert_eq(x, arr[i]);
+    }
+    cr_assert_not(packed_u32_next(&it, &x));
+
+    for (size_t i = 0; i < v->nmemb; i += 1 + i / 3) {
+        cr_assert(packed_u32_at(&p, i, &x));
+        cr_assert_eq(x, arr[i]);
+    }
+    cr_assert_not(packed_u32_at(&p, v->nmemb, &x));
+
+    vector_clear(&res, NULL, NULL);
+    packed_u32_clear(&p);
+}
+
+static void check_seek(const struct vector *v, uint32_t stride) {
+    struct packed_u32 p;
+    struct packed_u32_iter it;
+    const uint32_t *arr = v->arr;
+    cr_assert(packed_u32_init(&p, v));
+    packed_u32_iter_init(&it, &p);
+
+    // Increasing targets, compared against a linear scan
+    size_t i = 0;
+    uint32_t target = arr[0];
+    for (;;) {
+        while (i < v->nmemb && arr[i] < target)
+            ++i;
+
+        uint32_t x;
+        if (i == v->nmemb) {
+            cr_assert_not(packed_u32_seek(&it, target, &x));
+            break;
+        }
+        cr_assert(packed_u32_seek(&it, target, &x));
+        cr_assert_eq(x, arr[i]);
+        ++i;
+
+        if (target > UINT32_MAX - stride)
+            break;
+        target += rand() % stride;
+    }
+
+    packed_u32_clear(&p);
+}
+
+static void check_intersection(size_t nlhs, uint32_t lstep,
+        size_t nrhs, uint32_t rstep) {
+    struct vector lhs;
+    struct vector rhs;
+    struct vector res;
+    struct vector expected;
+    struct packed_u32 plhs;
+    struct packed_u32 prhs;
+    fill(&lhs, nlhs, 1000, lstep);
+    fill(&rhs, nrhs, 1000, rstep);
+    cr_assert(packed_u32_init(&plhs, &lhs));
+    cr_assert(packed_u32_init(&prhs, &rhs));
+    vector_init(&res, sizeof(uint32_t));
+    vector_init(&expected, sizeof(uint32_t));
+
+    cr_assert(vector_set_intersection(&expected, &lhs, &rhs, u32_cmp, NULL));
+    cr_assert(packed_u32_intersection(&res, &plhs, &prhs));
+    cr_assert_eq(res.nmemb, expected.nmemb);
+    if (res.nmemb)
+        cr_assert_arr_eq(res.arr, expected.arr, res.nmemb * sizeof(uint32_t));
+
+    vector_clear(&lhs, NULL, NULL);
+    vector_clear(&rhs, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+    vector_clear(&expected, NULL, NULL);
+    packed_u32_clear(&plhs);
+    packed_u32_clear(&prhs);
+}
+
+static void check_level(const char *level) {
+    struct vector v;
+    setenv("TUPPERWARE_SIMD", level, 1);
+
+    size_t lengths[] = { 1, 127, 128, 129, 1000, 100003 };
+    uint32_t steps[] = { 0, 1, 63, 100000 };
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(*lengths); ++i) {
+        for (size_t j = 0; j < sizeof(steps) / sizeof(*steps); ++j) {
+            // Without wrapping around
+            uint32_t step = steps[j] < UINT32_MAX / lengths[i]
+                ? steps[j] : UINT32_MAX / lengths[i] - 1;
+            fill(&v, lengths[i], 7, step);
+            check_roundtrip(&v);
+            check_seek(&v, step * 50 + 1);
+            vector_clear(&v, NULL, NULL);
+        }
+    }
+
+    // Full width differences
+    uint32_t extremes[] = { 0, 0, 1, UINT32_MAX - 1, UINT32_MAX, UINT32_MAX };
+    vector_init(&v, sizeof(uint32_t));
+    for (size_t i = 0; i < sizeof(extremes) / sizeof(*extremes); ++i)
+        vector_push_back(&v, &extremes[i]);
+    check_roundtrip(&v);
+    vector_clear(&v, NULL, NULL);
+
+    check_intersection(1000, 10, 1000, 10);
+    check_intersection(10000, 3, 1000, 30);
+    check_intersection(50, 2000, 100000, 1);
+    check_intersection(3000, 0, 3000, 1);
+}
+
+Test(packed_u32, scalar) {
+    check_level("scalar");
+}
+
+Test(packed_u32, simd) {
+    check_level("avx512");
+}
+
+Test(packed_u32, intersection_skip_block) {
+    struct vector lhs;
+    struct vector rhs;
+    struct vector res;
+    struct packed_u32 plhs;
+    struct packed_u32 prhs;
+    vector_init(&lhs, sizeof(uint32_t));
+    vector_init(&rhs, sizeof(uint32_t));
+    vector_init(&res, sizeof(uint32_t));
+
+    // Skipping from the first block lands in the second, entirely smaller
+    for (uint32_t x = 0; x < 6 * PACKED_U32_BLOCK; x += 2)
+        vector_push_back(&lhs, &x);
+    uint32_t r[] = { 4 * PACKED_U32_BLOCK - 1, 4 * PACKED_U32_BLOCK,
+        6 * PACKED_U32_BLOCK - 2 };
+    for (size_t i = 0; i < 3; ++i)
+        vector_push_back(&rhs, &r[i]);
+    cr_assert(packed_u32_init(&plhs, &lhs));
+    cr_assert(packed_u32_init(&prhs, &rhs));
+
+    cr_assert(packed_u32_intersection(&res, &plhs, &prhs));
+    cr_assert_eq(res.nmemb, 2);
+    cr_assert_eq(((uint32_t *)res.arr)[0], r[1]);
+    cr_assert_eq(((uint32_t *)res.arr)[1], r[2]);
+
+    packed_u32_clear(&plhs);
+    packed_u32_clear(&prhs);
+    vector_clear(&lhs, NULL, NULL);
+    vector_clear(&rhs, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+}
+
+Test(packed_u32, null) {
+    struct packed_u32 p;
+    struct packed_u32_iter it;
+    struct vector v;
+    uint32_t x;
+    vector_init(&v, sizeof(uint32_t));
+
+    cr_assert_not(packed_u32_init(NULL, &v));
+    cr_assert_not(packed_u32_init(&p, NULL));
+    packed_u32_clear(NULL);
+    cr_assert_eq(packed_u32_length(NULL), 0);
+    cr_assert_eq(packed_u32_bytes(NULL), 0);
+    cr_assert_not(packed_u32_at(NULL, 0, &x));
+    cr_assert_not(packed_u32_decode(NULL, &v));
+    packed_u32_iter_init(NULL, &p);
+    packed_u32_iter_init(&it, NULL);
+    cr_assert_not(packed_u32_next(&it, &x));
+    cr_assert_not(packed_u32_seek(&it, 0, &x));
+    cr_assert_not(packed_u32_intersection(NULL, &p, &p));
+}
+
+Test(packed_u32, invalid) {
+    struct packed_u32 p;
+    struct vector v;
+
+    vector_init(&v, sizeof(uint64_t));
+    cr_assert_not(packed_u32_init(&p, &v));
+
+    uint32_t unsorted[] = { 1, 5, 4 };
+    vector_init(&v, sizeof(uint32_t));
+    for (size_t i = 0; i < 3; ++i)
+        vector_push_back(&v, &unsorted[i]);
+    cr_assert_not(packed_u32_init(&p, &v));
+    vector_clear(&v, NULL, NULL);
+
+    struct vector wrong;
+    vector_init(&v, sizeof(uint32_t));
+    vector_init(&wrong, sizeof(uint64_t));
+    cr_assert(packed_u32_init(&p, &v));
+    cr_assert_not(packed_u32_decode(&p, &wrong));
+    cr_assert_not(packed_u32_intersection(&wrong, &p, &p));
+    packed_u32_clear(&p);
+}
+
+Test(packed_u32, empty) {
+    struct packed_u32 p;
+    struct packed_u32_iter it;
+    struct vector v;
+    uint32_t x;
+    vector_init(&v, sizeof(uint32_t));
+
+    cr_assert(packed_u32_init(&p, &v));
+    cr_assert_eq(packed_u32_length(&p), 0);
+    cr_assert_eq(packed_u32_bytes(&p), 0);
+    cr_assert(packed_u32_decode(&p, &v));
+    cr_assert_eq(v.nmemb, 0);
+
+    packed_u32_iter_init(&it, &p);
+    cr_assert_not(packed_u32_next(&it, &x));
+    cr_assert_not(packed_u32_seek(&it, 0, &x));
+
+    cr_assert(packed_u32_intersection(&v, &p, &p));
+    cr_assert_eq(v.nmemb, 0);
+
+    packed_u32_clear(&p);
+}
+
+Test(packed_u32, size) {
+    struct packed_u32 p;
+    struct vector v;
+    // Differences of up to 6 bits
+    fill(&v, 100000, 0, 63);
+
+    cr_assert(packed_u32_init(&p, &v));
+    cr_assert_lt(packed_u32_bytes(&p), v.nmemb * sizeof(uint32_t) / 4);
+
+    packed_u32_clear(&p);
+    vector_clear(&v, NULL, NULL);
+}
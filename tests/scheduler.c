@@ -0,0 +1,245 @@
+#include <criterion/criterion.h>
+
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+#include "tupperware/scheduler.h"
+
+TestSuite(scheduler, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+static void incr(struct scheduler *s, void *cookie) {
+    (void)s;
+    size_t *count = cookie;
+    __atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+}
+
+Test(scheduler, null) {
+    cr_assert_not(scheduler_init(NULL, 1));
+    scheduler_clear(NULL);
+    cr_assert_eq(scheduler_threads(NULL), 0);
+    scheduler_join(NULL, NULL);
+}
+
+Test(scheduler, init) {
+    struct scheduler s;
+
+    cr_assert(scheduler_init(&s, 3));
+    cr_assert_eq(scheduler_threads(&s), 3);
+    scheduler_clear(&s);
+    cr_assert_eq(scheduler_threads(&s), 0);
+
+    cr_assert(scheduler_init(&s, 0));
+    cr_assert_geq(scheduler_threads(&s), 1);
+    scheduler_clear(&s);
+}
+
+Test(scheduler, spawn_join) {
+    struct scheduler s;
+    struct scheduler_job jobs[100];
+    size_t count = 0;
+    scheduler_init(&s, 2);
+
+    for (size_t i = 0; i < ARR_SIZE(jobs); ++i)
+        scheduler_spawn(&s, &jobs[i], incr, &count);
+    for (size_t i = 0; i < ARR_SIZE(jobs); ++i) {
+        scheduler_join(&s, &jobs[i]);
+        cr_assert(jobs[i].done);
+    }
+
+    cr_assert_eq(count, ARR_SIZE(jobs));
+    scheduler_clear(&s);
+}
+
+Test(scheduler, spawn_inline) {
+    struct scheduler_job job;
+    size_t count = 0;
+
+    scheduler_spawn(NULL, &job, incr, &count);
+    cr_assert(job.done);
+    cr_assert_eq(count, 1);
+    scheduler_join(NULL, &job);
+}
+
+static void nap(struct scheduler *s, void *cookie) {
+    (void)s;
+    __atomic_store_n((bool *)cookie, true, __ATOMIC_RELEASE);
+    struct timespec t = { 0, 200 * 1000 * 1000 };
+    nanosleep(&t, NULL);
+}
+
+static double thread_cpu(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+Test(scheduler, join_sleeps) {
+    struct scheduler s;
+    struct scheduler_job job;
+    scheduler_init(&s, 1);
+
+    bool started = false;
+    scheduler_spawn(&s, &job, nap, &started);
+    while (!__atomic_load_n(&started, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    // Nothing to help with, joining from outside of the pool must not spin
+    double start = thread_cpu();
+    scheduler_join(&s, &job);
+    cr_assert(job.done);
+    cr_assert_lt(thread_cpu() - start, 0.1);
+
+    scheduler_clear(&s);
+}
+
+struct fib {
+    unsigned n;
+    unsigned long res;
+};
+
+static void fib(struct scheduler *s, void *cookie) {
+    struct fib *f = cookie;
+    if (f->n < 2) {
+        f->res = f->n;
+        return;
+    }
+
+    struct fib lhs = { f->n - 1, 0 };
+    struct fib rhs = { f->n - 2, 0 };
+    struct scheduler_job job;
+    scheduler_spawn(s, &job, fib, &lhs);
+    fib(s, &rhs);
+    scheduler_join(s, &job);
+
+    f->res = lhs.res + rhs.res;
+}
+
+Test(scheduler, fork_join) {
+    struct scheduler s;
+    scheduler_init(&s, 4);
+
+    struct fib f = { 24, 0 };
+    struct scheduler_job job;
+    scheduler_spawn(&s, &job, fib, &f);
+    scheduler_join(&s, &job);
+
+    cr_assert_eq(f.res, 46368);
+    scheduler_clear(&s);
+}
+
+struct many {
+    size_t count;
+    struct scheduler_job jobs[3 * SCHEDULER_DEQUE_SIZE];
+};
+
+// Overflows the worker's deque, the extra jobs are run inline
+static void spawn_many(struct scheduler *s, void *cookie) {
+    struct many *m = cookie;
+
+    for (size_t i = 0; i < ARR_SIZE(m->jobs); ++i)
+        scheduler_spawn(s, &m->jobs[i], incr, &m->count);
+    for (size_t i = 0; i < ARR_SIZE(m->jobs); ++i)
+        scheduler_join(s, &m->jobs[i]);
+}
+
+Test(scheduler, deque_full) {
+    struct scheduler s;
+    static struct many m;
+    scheduler_init(&s, 2);
+
+    struct scheduler_job job;
+    scheduler_spawn(&s, &job, spawn_many, &m);
+    scheduler_join(&s, &job);
+
+    cr_assert_eq(m.count, ARR_SIZE(m.jobs));
+    scheduler_clear(&s);
+}
+
+#define RANGE 100000
+
+struct coverage {
+    unsigned char seen[RANGE];
+    size_t grain;
+};
+
+static void mark(size_t begin, size_t end, void *cookie) {
+    struct coverage *c = cookie;
+
+    cr_assert_lt(begin, end);
+    cr_assert_leq(end - begin, c->grain);
+    for (size_t i = begin; i < end; ++i)
+        ++c->seen[i];
+}
+
+static void assert_covered(struct coverage *c, size_t begin, size_t end) {
+    for (size_t i = 0; i < RANGE; ++i)
+        cr_assert_eq(c->seen[i], i >= begin && i < end);
+}
+
+Test(scheduler, parallel_for) {
+    struct scheduler s;
+    static struct coverage c;
+    scheduler_init(&s, 3);
+
+    size_t grains[] = { 1, 7, 1000, RANGE };
+    for (size_t i = 0; i < ARR_SIZE(grains); ++i) {
+        memset(&c, 0, sizeof(c));
+        c.grain = grains[i];
+        scheduler_parallel_for(&s, 3, RANGE - 5, c.grain, mark, &c);
+        assert_covered(&c, 3, RANGE - 5);
+    }
+
+    memset(&c, 0, sizeof(c));
+    c.grain = 10;
+    scheduler_parallel_for(&s, 5, 5, c.grain, mark, &c);
+    assert_covered(&c, 0, 0);
+
+    scheduler_clear(&s);
+}
+
+Test(scheduler, parallel_for_inline) {
+    static struct coverage c;
+
+    c.grain = 33;
+    scheduler_parallel_for(NULL, 0, RANGE, c.grain, mark, &c);
+    assert_covered(&c, 0, RANGE);
+}
+
+#define THREADS 4
+
+struct submitter {
+    struct scheduler *s;
+    struct coverage c;
+};
+
+static void *submit(void *arg) {
+    struct submitter *sub = arg;
+
+    for (int round = 0; round < 20; ++round) {
+        memset(&sub->c, 0, sizeof(sub->c));
+        sub->c.grain = 512;
+        scheduler_parallel_for(sub->s, 0, RANGE, sub->c.grain, mark, &sub->c);
+        assert_covered(&sub->c, 0, RANGE);
+    }
+
+    return NULL;
+}
+
+Test(scheduler, external_threads) {
+    struct scheduler s;
+    static struct submitter subs[THREADS];
+    pthread_t threads[THREADS];
+    scheduler_init(&s, 2);
+
+    for (size_t i = 0; i < THREADS; ++i) {
+        subs[i].s = &s;
+        cr_assert_eq(pthread_create(&threads[i], NULL, submit, &subs[i]), 0);
+    }
+    for (size_t i = 0; i < THREADS; ++i)
+        pthread_join(threads[i], NULL);
+
+    scheduler_clear(&s);
+}
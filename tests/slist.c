@@ -0,0 +1,220 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "tupperware/slist.h"
+
+TestSuite(slist, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+struct int_slist {
+    int val;
+    struct slist_node node;
+};
+
+static void init_arr(struct int_slist *arr, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        arr[i].val = i;
+        arr[i].node = SLIST_NODE_INIT_VAL;
+    }
+}
+
+static void int_slist_dtor(struct slist_node *n, void *cookie) {
+    int *sum = cookie;
+    *sum += CONTAINER_OF(struct int_slist, node, n)->val;
+}
+
+Test(slist, null) {
+    slist_init(NULL);
+    slist_clear(NULL, NULL, NULL);
+    slist_push(NULL, NULL);
+    cr_assert_null(slist_pop(NULL));
+    cr_assert_null(slist_peek(NULL));
+    cr_assert_null(slist_remove_next(NULL, NULL));
+    cr_assert_not(slist_remove(NULL, NULL));
+    cr_assert(slist_empty(NULL));
+    cr_assert_eq(slist_length(NULL), 0);
+    slist_reverse(NULL);
+
+    slist_queue_init(NULL);
+    slist_queue_push_back(NULL, NULL);
+    cr_assert_null(slist_queue_pop_front(NULL));
+    cr_assert(slist_queue_empty(NULL));
+    slist_queue_concat(NULL, NULL);
+
+    treiber_stack_init(NULL);
+    treiber_stack_push(NULL, NULL);
+    cr_assert_null(treiber_stack_pop(NULL));
+    cr_assert(treiber_stack_empty(NULL));
+}
+
+Test(slist, node_size) {
+    cr_assert_eq(sizeof(struct slist_node), sizeof(void *));
+}
+
+Test(slist, stack) {
+    struct int_slist arr[5];
+    struct slist l;
+    init_arr(arr, ARR_SIZE(arr));
+    slist_init(&l);
+
+    for (size_t i = 0; i < ARR_SIZE(arr); ++i)
+        slist_push(&l, &arr[i].node);
+    cr_assert_eq(slist_length(&l), 5);
+    cr_assert_eq(slist_peek(&l), &arr[4].node);
+
+    int expected = 4;
+    SLIST_FOREACH_ENTRY (struct int_slist, node, l, it)
+        cr_assert_eq(it->val, expected--);
+
+    slist_reverse(&l);
+    expected = 0;
+    SLIST_FOREACH_ENTRY (struct int_slist, node, l, it)
+        cr_assert_eq(it->val, expected++);
+
+    cr_assert(slist_remove(&l, &arr[2].node));
+    cr_assert_not(slist_remove(&l, &arr[2].node));
+    cr_assert_eq(slist_remove_next(&l, &arr[0].node), &arr[1].node);
+    cr_assert_null(slist_remove_next(&l, &arr[4].node));
+    slist_insert_next(&arr[0].node, &arr[2].node);
+
+    cr_assert_eq(slist_pop(&l), &arr[0].node);
+    cr_assert_null(arr[0].node.next);
+    cr_assert_eq(slist_remove_next(&l, NULL), &arr[2].node);
+
+    int sum = 0;
+    slist_clear(&l, int_slist_dtor, &sum);
+    cr_assert_eq(sum, 3 + 4);
+    cr_assert(slist_empty(&l));
+}
+
+Test(slist, queue) {
+    struct int_slist arr[6];
+    struct slist_queue a;
+    struct slist_queue b;
+    init_arr(arr, ARR_SIZE(arr));
+    slist_queue_init(&a);
+    slist_queue_init(&b);
+
+    slist_queue_push_back(&a, &arr[1].node);
+    slist_queue_push_front(&a, &arr[0].node);
+    slist_queue_push_back(&a, &arr[2].node);
+    cr_assert_eq(a.tail, &arr[2].node);
+
+    // Into an empty queue, then appending another
+    slist_queue_concat(&b, &a);
+    cr_assert(slist_queue_empty(&a));
+    cr_assert_null(a.tail);
+    for (size_t i = 3; i < ARR_SIZE(arr); ++i)
+        slist_queue_push_back(&a, &arr[i].node);
+    slist_queue_concat(&b, &a);
+    cr_assert_eq(slist_queue_length(&b), 6);
+    cr_assert_eq(b.tail, &arr[5].node);
+
+    for (size_t i = 0; i < ARR_SIZE(arr); ++i)
+        cr_assert_eq(slist_queue_pop_front(&b), &arr[i].node);
+    cr_assert_null(b.tail);
+    cr_assert_null(slist_queue_pop_front(&b));
+
+    slist_queue_push_front(&b, &arr[0].node);
+    cr_assert_eq(b.tail, &arr[0].node);
+    int sum = 0;
+    slist_queue_clear(&b, int_slist_dtor, &sum);
+    cr_assert(slist_queue_empty(&b));
+}
+
+Test(slist, treiber) {
+    struct int_slist arr[5];
+    struct treiber_stack s;
+    struct slist l;
+    init_arr(arr, ARR_SIZE(arr));
+    treiber_stack_init(&s);
+    slist_init(&l);
+
+    cr_assert_eq((uintptr_t)&s % (2 * sizeof(void *)), 0);
+    cr_assert(treiber_stack_empty(&s));
+    cr_assert_null(treiber_stack_pop(&s));
+
+    treiber_stack_push(&s, &arr[0].node);
+    treiber_stack_push(&s, &arr[1].node);
+    for (size_t i = 2; i < ARR_SIZE(arr); ++i)
+        slist_push(&l, &arr[i].node);
+    treiber_stack_push_list(&s, &l);
+    cr_assert(slist_empty(&l));
+
+    cr_assert_eq(treiber_stack_pop(&s), &arr[4].node);
+    cr_assert_eq(treiber_stack_pop(&s), &arr[3].node);
+    treiber_stack_pop_all(&s, &l);
+    cr_assert(treiber_stack_empty(&s));
+    cr_assert_eq(slist_length(&l), 3);
+    int expected = 2;
+    SLIST_FOREACH_ENTRY (struct int_slist, node, l, it)
+        cr_assert_eq(it->val, expected--);
+}
+
+#define THREADS 4
+#define NODES 64
+#define ROUNDS 50000
+
+struct pool_node {
+    int owned;
+    struct slist_node node;
+};
+
+static void *worker(void *arg) {
+    struct treiber_stack *s = arg;
+
+    for (size_t i = 0; i < ROUNDS; ++i) {
+        struct slist_node *n = treiber_stack_pop(s);
+        if (!n)
+            continue;
+
+        // A node handed out twice would be seen owned here
+        struct pool_node *p = CONTAINER_OF(struct pool_node, node, n);
+        cr_assert_eq(__atomic_exchange_n(&p->owned, 1, __ATOMIC_RELAXED), 0);
+        if (i % 16 == 0)
+            sched_yield();
+        __atomic_store_n(&p->owned, 0, __ATOMIC_RELAXED);
+
+        if (i % 64) {
+            treiber_stack_push(s, n);
+            continue;
+        }
+
+        struct slist l = { NULL };
+        treiber_stack_pop_all(s, &l);
+        slist_push(&l, n);
+        treiber_stack_push_list(s, &l);
+    }
+
+    return NULL;
+}
+
+Test(slist, treiber_threads) {
+    struct pool_node *pool = calloc(NODES, sizeof(*pool));
+    struct treiber_stack s;
+    pthread_t threads[THREADS];
+    treiber_stack_init(&s);
+    for (size_t i = 0; i < NODES; ++i)
+        treiber_stack_push(&s, &pool[i].node);
+
+    for (size_t i = 0; i < THREADS; ++i)
+        cr_assert_eq(pthread_create(&threads[i], NULL, worker, &s), 0);
+    for (size_t i = 0; i < THREADS; ++i)
+        pthread_join(threads[i], NULL);
+
+    // Every node is back exactly once
+    struct slist l;
+    treiber_stack_pop_all(&s, &l);
+    cr_assert_eq(slist_length(&l), NODES);
+    SLIST_FOREACH (l, it) {
+        struct pool_node *p = CONTAINER_OF(struct pool_node, node, it);
+        cr_assert_eq(p->owned, 0);
+        p->owned = 1;
+    }
+
+    free(pool);
+}
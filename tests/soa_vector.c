@@ -0,0 +1,294 @@
+#include <criterion/criterion.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tupperware/soa_vector.h"
+
+TestSuite(soa_vector, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+struct record {
+    uint64_t id;
+    char tag;
+    float weight;
+    uint16_t group;
+};
+
+enum { ID, TAG, WEIGHT, GROUP };
+
+static const struct soa_field fields[] = {
+    [ID] = SOA_FIELD(struct record, id),
+    [TAG] = SOA_FIELD(struct record, tag),
+    [WEIGHT] = SOA_FIELD(struct record, weight),
+    [GROUP] = SOA_FIELD(struct record, group),
+};
+
+static struct record make(uint64_t i) {
+    struct record r = {
+        .id = i,
+        .tag = 'a' + i % 26,
+        .weight = i * 0.5f,
+        .group = (i * 7919) % 13,
+    };
+    return r;
+}
+
+static void assert_record(const struct soa_vector *v, size_t i,
+        const struct record *expected) {
+    struct record r;
+    memset(&r, 0, sizeof(r));
+    cr_assert(soa_vector_get(v, &r, i));
+    cr_assert_eq(r.id, expected->id);
+    cr_assert_eq(r.tag, expected->tag);
+    cr_assert_eq(r.weight, expected->weight);
+    cr_assert_eq(r.group, expected->group);
+}
+
+static void fill(struct soa_vector *v, size_t n) {
+    cr_assert(soa_vector_init(v, fields, ARR_SIZE(fields)));
+    for (size_t i = 0; i < n; ++i) {
+        struct record r = make(i);
+        cr_assert(soa_vector_push_back(v, &r));
+    }
+}
+
+Test(soa_vector, null) {
+    struct soa_vector v;
+    struct record r;
+
+    cr_assert_not(soa_vector_init(NULL, fields, ARR_SIZE(fields)));
+    cr_assert_not(soa_vector_init(&v, NULL, 1));
+    cr_assert_not(soa_vector_init(&v, fields, 0));
+    soa_vector_clear(NULL);
+    cr_assert_eq(soa_vector_length(NULL), 0);
+    cr_assert(soa_vector_empty(NULL));
+    cr_assert_null(soa_vector_column(NULL, 0));
+    cr_assert_null(soa_vector_at(NULL, 0, 0));
+    cr_assert_not(soa_vector_get(NULL, &r, 0));
+    cr_assert_not(soa_vector_push_back(NULL, &r));
+    cr_assert_not(soa_vector_pop_back(NULL, &r));
+    cr_assert_not(soa_vector_sort_by(NULL, 0, NULL, NULL));
+    cr_assert_not(soa_vector_filter(NULL, NULL, 0, NULL, NULL));
+    soa_vector_map(NULL, 0, NULL, NULL);
+}
+
+Test(soa_vector, zero_sized_field) {
+    struct soa_vector v;
+    struct soa_field bad[] = { { 0, 4 }, { 4, 0 } };
+
+    cr_assert_not(soa_vector_init(&v, bad, ARR_SIZE(bad)));
+}
+
+Test(soa_vector, init) {
+    struct soa_vector v;
+
+    cr_assert(soa_vector_init(&v, fields, ARR_SIZE(fields)));
+    cr_assert_eq(soa_vector_fields(&v), ARR_SIZE(fields));
+    cr_assert_eq(soa_vector_length(&v), 0);
+    cr_assert(soa_vector_empty(&v));
+    cr_assert_null(soa_vector_column(&v, ARR_SIZE(fields)));
+
+    soa_vector_clear(&v);
+    cr_assert_eq(soa_vector_fields(&v), 0);
+}
+
+Test(soa_vector, push_back) {
+    struct soa_vector v;
+    fill(&v, 1000);
+
+    cr_assert_eq(soa_vector_length(&v), 1000);
+    for (size_t i = 0; i < 1000; ++i) {
+        struct record r = make(i);
+        assert_record(&v, i, &r);
+    }
+    cr_assert_not(soa_vector_get(&v, &(struct record){ 0 }, 1000));
+
+    // Columns are contiguous arrays of their field
+    const uint64_t *ids = soa_vector_column(&v, ID);
+    const float *weights = soa_vector_column(&v, WEIGHT);
+    for (size_t i = 0; i < 1000; ++i) {
+        cr_assert_eq(ids[i], i);
+        cr_assert_eq(weights[i], i * 0.5f);
+        cr_assert_eq(*(char *)soa_vector_at(&v, TAG, i), 'a' + i % 26);
+    }
+
+    soa_vector_clear(&v);
+}
+
+Test(soa_vector, insert_pop) {
+    struct soa_vector v;
+    fill(&v, 10);
+
+    struct record r = make(100);
+    cr_assert(soa_vector_insert_at(&v, &r, 3));
+    r = make(101);
+    cr_assert(soa_vector_insert_at(&v, &r, 0));
+    // Past the end inserts at the back
+    r = make(102);
+    cr_assert(soa_vector_insert_at(&v, &r, 1000));
+    cr_assert_eq(soa_vector_length(&v), 13);
+
+    uint64_t expected[] = { 101, 0, 1, 2, 100, 3, 4, 5, 6, 7, 8, 9, 102 };
+    for (size_t i = 0; i < ARR_SIZE(expected); ++i) {
+        r = make(expected[i]);
+        assert_record(&v, i, &r);
+    }
+
+    struct record out;
+    cr_assert(soa_vector_pop_at(&v, &out, 4));
+    r = make(100);
+    cr_assert_eq(memcmp(&out.id, &r.id, sizeof(r.id)), 0);
+    cr_assert_eq(out.group, r.group);
+    cr_assert(soa_vector_pop_back(&v, &out));
+    cr_assert_eq(out.id, 102);
+    cr_assert(soa_vector_pop_at(&v, NULL, 0));
+    cr_assert_eq(soa_vector_length(&v), 10);
+
+    for (size_t i = 0; i < 10; ++i) {
+        r = make(i);
+        assert_record(&v, i, &r);
+    }
+
+    while (soa_vector_pop_back(&v, NULL))
+        continue;
+    cr_assert(soa_vector_empty(&v));
+
+    soa_vector_clear(&v);
+}
+
+static int u16_cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    uint16_t l = *(const uint16_t *)lhs;
+    uint16_t r = *(const uint16_t *)rhs;
+    return (l > r) - (l < r);
+}
+
+static int float_desc_cmp(const void *lhs, const void *rhs, void *cookie) {
+    size_t *count = cookie;
+    ++*count;
+    float l = *(const float *)lhs;
+    float r = *(const float *)rhs;
+    return (l < r) - (l > r);
+}
+
+Test(soa_vector, sort_by) {
+    struct soa_vector v;
+    fill(&v, 5000);
+
+    cr_assert(soa_vector_sort_by(&v, GROUP, u16_cmp, NULL));
+    cr_assert_eq(soa_vector_length(&v), 5000);
+
+    // Stable: ids stay increasing within a group
+    struct record prev;
+    soa_vector_get(&v, &prev, 0);
+    for (size_t i = 1; i < 5000; ++i) {
+        struct record r;
+        soa_vector_get(&v, &r, i);
+        cr_assert_leq(prev.group, r.group);
+        if (prev.group == r.group)
+            cr_assert_lt(prev.id, r.id);
+
+        struct record expected = make(r.id);
+        assert_record(&v, i, &expected);
+        prev = r;
+    }
+
+    size_t count = 0;
+    cr_assert(soa_vector_sort_by(&v, WEIGHT, float_desc_cmp, &count));
+    cr_assert_gt(count, 0);
+    for (size_t i = 0; i < 5000; ++i) {
+        struct record expected = make(4999 - i);
+        assert_record(&v, i, &expected);
+    }
+
+    cr_assert_not(soa_vector_sort_by(&v, ARR_SIZE(fields), u16_cmp, NULL));
+
+    soa_vector_clear(&v);
+}
+
+Test(soa_vector, sort_by_trivial) {
+    struct soa_vector v;
+    fill(&v, 1);
+
+    cr_assert(soa_vector_sort_by(&v, ID, u16_cmp, NULL));
+    struct record r = make(0);
+    assert_record(&v, 0, &r);
+
+    soa_vector_clear(&v);
+}
+
+static void double_weight(void *v, void *cookie) {
+    size_t *count = cookie;
+    ++*count;
+    *(float *)v *= 2;
+}
+
+Test(soa_vector, map) {
+    struct soa_vector v;
+    size_t count = 0;
+    fill(&v, 100);
+
+    soa_vector_map(&v, WEIGHT, double_weight, &count);
+    cr_assert_eq(count, 100);
+
+    for (size_t i = 0; i < 100; ++i) {
+        struct record r = make(i);
+        r.weight *= 2;
+        assert_record(&v, i, &r);
+    }
+
+    soa_vector_clear(&v);
+}
+
+static bool group_below(void *v, void *cookie) {
+    return *(uint16_t *)v < *(uint16_t *)cookie;
+}
+
+Test(soa_vector, filter) {
+    struct soa_vector v;
+    struct soa_vector res;
+    uint16_t limit = 5;
+    fill(&v, 3000);
+    cr_assert(soa_vector_init(&res, fields, ARR_SIZE(fields)));
+
+    // Records already in `res` are kept
+    struct record first = make(7);
+    cr_assert(soa_vector_push_back(&res, &first));
+
+    cr_assert(soa_vector_filter(&res, &v, GROUP, group_below, &limit));
+    cr_assert_eq(soa_vector_length(&res) + soa_vector_length(&v), 3001);
+    assert_record(&res, 0, &first);
+
+    size_t matched = 1;
+    size_t kept = 0;
+    for (uint64_t i = 0; i < 3000; ++i) {
+        struct record r = make(i);
+        if (r.group < limit)
+            assert_record(&res, matched++, &r);
+        else
+            assert_record(&v, kept++, &r);
+    }
+    cr_assert_eq(matched, soa_vector_length(&res));
+    cr_assert_eq(kept, soa_vector_length(&v));
+
+    soa_vector_clear(&res);
+    soa_vector_clear(&v);
+}
+
+Test(soa_vector, filter_mismatch) {
+    struct soa_vector v;
+    struct soa_vector res;
+    uint16_t limit = 5;
+    fill(&v, 10);
+    cr_assert(soa_vector_init(&res, fields, ARR_SIZE(fields) - 1));
+
+    cr_assert_not(soa_vector_filter(&res, &v, GROUP, group_below, &limit));
+    cr_assert_not(soa_vector_filter(&v, &v, GROUP, group_below, &limit));
+    cr_assert_not(soa_vector_filter(&v, &v, 42, group_below, &limit));
+    cr_assert_eq(soa_vector_length(&v), 10);
+
+    soa_vector_clear(&res);
+    soa_vector_clear(&v);
+}
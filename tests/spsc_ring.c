@@ -0,0 +1,163 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "tupperware/spsc_ring.h"
+
+TestSuite(spsc_ring, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+Test(spsc_ring, init_null) {
+    struct spsc_ring r;
+
+    cr_assert_not(spsc_ring_init(NULL, 1, 1));
+    cr_assert_not(spsc_ring_init(&r, 0, 1));
+    cr_assert_not(spsc_ring_init(&r, 1, -1));
+}
+
+Test(spsc_ring, init_rounds_capacity) {
+    struct spsc_ring r;
+
+    cr_assert(spsc_ring_init(&r, sizeof(int), 5));
+
+    cr_assert_eq(spsc_ring_capacity(&r), 8);
+    cr_assert_eq(spsc_ring_elem_size(&r), sizeof(int));
+    cr_assert(spsc_ring_empty(&r));
+
+    spsc_ring_clear(&r, NULL, NULL);
+    cr_assert_eq(spsc_ring_capacity(&r), 0);
+}
+
+Test(spsc_ring, accessors_null) {
+    cr_assert_eq(spsc_ring_length(NULL), 0);
+    cr_assert_eq(spsc_ring_capacity(NULL), 0);
+    cr_assert_eq(spsc_ring_elem_size(NULL), 0);
+    cr_assert(spsc_ring_empty(NULL));
+    cr_assert_not(spsc_ring_push(NULL, NULL));
+    cr_assert_not(spsc_ring_pop(NULL, NULL));
+    cr_assert_eq(spsc_ring_push_n(NULL, NULL, 1), 0);
+    cr_assert_eq(spsc_ring_pop_n(NULL, NULL, 1), 0);
+}
+
+Test(spsc_ring, push_pop) {
+    struct spsc_ring r;
+    spsc_ring_init(&r, sizeof(int), 4);
+
+    for (int i = 0; i < 4; ++i)
+        cr_assert(spsc_ring_push(&r, &i));
+    int n = 42;
+    cr_assert_not(spsc_ring_push(&r, &n));
+    cr_assert_eq(spsc_ring_length(&r), 4);
+
+    for (int i = 0; i < 4; ++i) {
+        cr_assert(spsc_ring_pop(&r, &n));
+        cr_assert_eq(n, i);
+    }
+    cr_assert_not(spsc_ring_pop(&r, &n));
+
+    spsc_ring_clear(&r, NULL, NULL);
+}
+
+Test(spsc_ring, batch_wraps_around) {
+    struct spsc_ring r;
+    spsc_ring_init(&r, sizeof(int), 8);
+    int arr[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    int out[ARR_SIZE(arr)] = { 0 };
+
+    cr_assert_eq(spsc_ring_push_n(&r, arr, 6), 6);
+    cr_assert_eq(spsc_ring_pop_n(&r, out, 5), 5);
+
+    // Only 7 slots are free
+    cr_assert_eq(spsc_ring_push_n(&r, arr + 6, 6), 6);
+    cr_assert_eq(spsc_ring_push_n(&r, arr, ARR_SIZE(arr)), 1);
+    cr_assert_eq(spsc_ring_length(&r), 8);
+
+    cr_assert_eq(spsc_ring_pop_n(&r, out, ARR_SIZE(out)), 8);
+    for (int i = 0; i < 7; ++i)
+        cr_assert_eq(out[i], i + 5);
+    cr_assert_eq(out[7], 0);
+
+    cr_assert_eq(spsc_ring_pop_n(&r, out, ARR_SIZE(out)), 0);
+
+    spsc_ring_clear(&r, NULL, NULL);
+}
+
+static void int_dtor(void *val, void *cookie) {
+    int *n = val;
+    int *count = cookie;
+
+    cr_assert_eq(*n, (*count)++);
+}
+
+Test(spsc_ring, clear) {
+    struct spsc_ring r;
+    spsc_ring_init(&r, sizeof(int), 4);
+
+    for (int i = 0; i < 3; ++i)
+        spsc_ring_push(&r, &i);
+    spsc_ring_pop(&r, NULL);
+    for (int i = 3; i < 5; ++i)
+        spsc_ring_push(&r, &i);
+
+    int count = 1;
+    spsc_ring_clear(&r, int_dtor, &count);
+
+    cr_assert_eq(count, 5);
+}
+
+#define TRANSFER_N 200000
+
+static void *producer(void *arg) {
+    struct spsc_ring *r = arg;
+    size_t batch[7];
+
+    for (size_t i = 0; i < TRANSFER_N;) {
+        size_t n = 0;
+        for (; n < ARR_SIZE(batch) && i + n < TRANSFER_N; ++n)
+            batch[n] = i + n;
+
+        size_t pushed = 0;
+        while (pushed < n) {
+            size_t ret = spsc_ring_push_n(r, batch + pushed, n - pushed);
+            if (!ret)
+                sched_yield();
+            pushed += ret;
+        }
+        i += n;
+    }
+
+    return NULL;
+}
+
+Test(spsc_ring, threads) {
+    struct spsc_ring r;
+    spsc_ring_init(&r, sizeof(size_t), 64);
+
+    pthread_t t;
+    cr_assert_eq(pthread_create(&t, NULL, producer, &r), 0);
+
+    for (size_t i = 0; i < TRANSFER_N;) {
+        size_t n;
+        if (i % 2) {
+            size_t out[5];
+            n = spsc_ring_pop_n(&r, out, ARR_SIZE(out));
+            for (size_t j = 0; j < n; ++j)
+                cr_assert_eq(out[j], i + j);
+        } else {
+            size_t out;
+            n = spsc_ring_pop(&r, &out);
+            if (n)
+                cr_assert_eq(out, i);
+        }
+        if (!n)
+            sched_yield();
+        i += n;
+    }
+
+    pthread_join(t, NULL);
+    cr_assert(spsc_ring_empty(&r));
+
+    spsc_ring_clear(&r, NULL, NULL);
+}
@@ -0,0 +1,162 @@
+#include <criterion/criterion.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tupperware/unrolled_list.h"
+
+TestSuite(unrolled_list, .timeout = 15);
+
+Test(unrolled_list, null) {
+    struct unrolled_list l;
+    int x = 0;
+
+    cr_assert_not(unrolled_list_init(NULL, sizeof(int)));
+    cr_assert_not(unrolled_list_init(&l, 0));
+    cr_assert_not(unrolled_list_with_block(&l, sizeof(int), 0));
+
+    cr_assert_eq(unrolled_list_length(NULL), 0);
+    cr_assert_eq(unrolled_list_elem_size(NULL), 0);
+    cr_assert(unrolled_list_empty(NULL));
+    cr_assert_null(unrolled_list_at(NULL, 0));
+    cr_assert_not(unrolled_list_push_back(NULL, &x));
+    cr_assert_not(unrolled_list_push_front(NULL, &x));
+    cr_assert_not(unrolled_list_pop_back(NULL, &x));
+    cr_assert_not(unrolled_list_pop_front(NULL, &x));
+    cr_assert_not(unrolled_list_insert_at(NULL, &x, 0));
+    cr_assert_not(unrolled_list_pop_at(NULL, &x, 0));
+    unrolled_list_map(NULL, NULL, NULL);
+    unrolled_list_clear(NULL, NULL, NULL);
+}
+
+Test(unrolled_list, init) {
+    struct unrolled_list l;
+
+    cr_assert(unrolled_list_init(&l, sizeof(int)));
+    cr_assert_eq(unrolled_list_elem_size(&l), sizeof(int));
+    cr_assert_gt(l.per_block, 1000);
+    cr_assert_leq(sizeof(struct unrolled_block) + l.per_block * sizeof(int),
+            UNROLLED_LIST_BLOCK_BYTES);
+    cr_assert(unrolled_list_empty(&l));
+    unrolled_list_clear(&l, NULL, NULL);
+
+    // Elements larger than a block still get one each
+    cr_assert(unrolled_list_init(&l, 2 * UNROLLED_LIST_BLOCK_BYTES));
+    cr_assert_eq(l.per_block, 1);
+    unrolled_list_clear(&l, NULL, NULL);
+}
+
+Test(unrolled_list, ends) {
+    struct unrolled_list l;
+    cr_assert(unrolled_list_with_block(&l, sizeof(int), 4));
+
+    for (int i = 0; i < 10; ++i) {
+        cr_assert(unrolled_list_push_back(&l, &i));
+        int j = -i - 1;
+        cr_assert(unrolled_list_push_front(&l, &j));
+    }
+    cr_assert_eq(unrolled_list_length(&l), 20);
+    for (int i = 0; i < 20; ++i)
+        cr_assert_eq(*(int *)unrolled_list_at(&l, i), i - 10);
+    cr_assert_null(unrolled_list_at(&l, 20));
+
+    size_t blocks = 0;
+    UNROLLED_LIST_FOREACH_BLOCK (l, b)
+        ++blocks;
+    cr_assert_eq(blocks, 6);
+
+    int x;
+    for (int i = 0; i < 10; ++i) {
+        cr_assert(unrolled_list_pop_front(&l, &x));
+        cr_assert_eq(x, i - 10);
+        cr_assert(unrolled_list_pop_back(&l, &x));
+        cr_assert_eq(x, 9 - i);
+    }
+    cr_assert(unrolled_list_empty(&l));
+    cr_assert_null(l.blocks.head);
+    cr_assert_not(unrolled_list_pop_back(&l, &x));
+    cr_assert_not(unrolled_list_pop_front(&l, &x));
+
+    // The spare block is reused
+    cr_assert_not_null(l.spare);
+    cr_assert(unrolled_list_push_back(&l, &x));
+    cr_assert_null(l.spare);
+
+    unrolled_list_clear(&l, NULL, NULL);
+}
+
+static void check_blocks(const struct unrolled_list *l) {
+    size_t total = 0;
+    UNROLLED_LIST_FOREACH_BLOCK (*l, b) {
+        cr_assert_gt(b->nmemb, 0);
+        cr_assert_leq(b->head + b->nmemb, l->per_block);
+        total += b->nmemb;
+    }
+    cr_assert_eq(total, l->nmemb);
+}
+
+Test(unrolled_list, random) {
+    enum { MAX = 2000 };
+    struct unrolled_list l;
+    int *ref = malloc(MAX * sizeof(*ref));
+    size_t n = 0;
+    cr_assert(unrolled_list_with_block(&l, sizeof(int), 7));
+
+    for (int op = 0; op < 20000; ++op) {
+        int x = rand();
+        size_t i = n ? rand() % (n + 1) : 0;
+
+        // Grows then shrinks
+        bool grow = op < 10000 ? rand() % 3 : !(rand() % 3);
+        if (grow && n < MAX) {
+            cr_assert(unrolled_list_insert_at(&l, &x, i));
+            memmove(ref + i + 1, ref + i, (n - i) * sizeof(*ref));
+            ref[i] = x;
+            ++n;
+        } else if (i < n) {
+            cr_assert(unrolled_list_pop_at(&l, &x, i));
+            cr_assert_eq(x, ref[i]);
+            memmove(ref + i, ref + i + 1, (n - i - 1) * sizeof(*ref));
+            --n;
+        } else {
+            cr_assert_not(unrolled_list_pop_at(&l, &x, n));
+            cr_assert_not(unrolled_list_insert_at(&l, &x, n + 1));
+        }
+
+        cr_assert_eq(unrolled_list_length(&l), n);
+        check_blocks(&l);
+        if (op % 100 == 0)
+            for (size_t j = 0; j < n; ++j)
+                cr_assert_eq(*(int *)unrolled_list_at(&l, j), ref[j]);
+    }
+
+    // Merging keeps the blocks from thinning out
+    size_t blocks = 0;
+    UNROLLED_LIST_FOREACH_BLOCK (l, b)
+        ++blocks;
+    cr_assert_leq(blocks, n / 2 + 1);
+
+    unrolled_list_clear(&l, NULL, NULL);
+    free(ref);
+}
+
+static void add(void *v, void *cookie) {
+    *(long *)cookie += *(int *)v;
+}
+
+Test(unrolled_list, map_clear) {
+    struct unrolled_list l;
+    cr_assert(unrolled_list_with_block(&l, sizeof(int), 16));
+    for (int i = 0; i < 1000; ++i)
+        cr_assert(unrolled_list_push_back(&l, &i));
+    cr_assert(unrolled_list_pop_at(&l, NULL, 500));
+
+    long sum = 0;
+    unrolled_list_map(&l, add, &sum);
+    cr_assert_eq(sum, 999 * 1000 / 2 - 500);
+
+    sum = 0;
+    unrolled_list_clear(&l, add, &sum);
+    cr_assert_eq(sum, 999 * 1000 / 2 - 500);
+    cr_assert(unrolled_list_empty(&l));
+}
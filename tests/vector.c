@@ -1,5 +1,7 @@
 #include <criterion/criterion.h>
 
+#include <string.h>
+
 #include "tupperware/vector.h"
 
 struct vector v;
@@ -965,3 +967,204 @@ Test(vector, map) {
         cr_assert_eq(varr[i], i + 1);
     }
 }
+
+static void int_sum(void *acc, const void *v, void *cookie) {
+    int *count = cookie;
+    ++*count;
+
+    *(int *)acc += *(const int *)v;
+}
+
+Test(vector, reduce_null) {
+    int count = 0;
+    int sum;
+    cr_assert_not(vector_reduce(NULL, &sum, int_sum, &count));
+    cr_assert_not(vector_reduce(&v, NULL, int_sum, &count));
+    cr_assert_eq(count, 0);
+}
+
+Test(vector, reduce_empty) {
+    int count = 0;
+    int sum = 42;
+    cr_assert_not(vector_reduce(&v, &sum, int_sum, &count));
+    cr_assert_eq(count, 0);
+    cr_assert_eq(sum, 42);
+}
+
+Test(vector, reduce) {
+    fill_v();
+    int count = 0;
+    int sum;
+    cr_assert(vector_reduce(&v, &sum, int_sum, &count));
+
+    cr_assert_eq(count, init_n - 1);
+    cr_assert_eq(sum, init_n * (init_n - 1) / 2);
+}
+
+Test(vector, unique_null) {
+    int count = 0;
+    cr_assert_not(vector_unique(NULL, int_cmp, &count));
+}
+
+Test(vector, unique) {
+    int arr[] = { 0, 0, 1, 2, 2, 2, 3, 4, 5, 5, 6, 7, 7 };
+    int expected[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    memcpy(v.arr, arr, sizeof(arr));
+    v.nmemb = sizeof(arr) / sizeof(*arr);
+
+    int count = 0;
+    cr_assert(vector_unique(&v, int_cmp, &count));
+
+    cr_assert_eq(v.nmemb, sizeof(expected) / sizeof(*expected));
+    cr_assert_arr_eq(v.arr, expected, sizeof(expected));
+}
+
+Test(vector, unique_no_duplicates) {
+    fill_v();
+    int count = 0;
+    cr_assert(vector_unique(&v, int_cmp, &count));
+
+    cr_assert_eq(v.nmemb, init_n);
+    assert_sorted();
+}
+
+#define SET_VALUES 50
+
+// Multiplicities of each value in both operands of a set operation
+struct multiset {
+    size_t lhs[SET_VALUES];
+    size_t rhs[SET_VALUES];
+};
+
+static void random_sets(struct multiset *m, struct vector *lhs,
+        struct vector *rhs, size_t nlhs, size_t nrhs) {
+    memset(m, 0, sizeof(*m));
+    vector_init(lhs, sizeof(int));
+    vector_init(rhs, sizeof(int));
+
+    for (size_t i = 0; i < nlhs; ++i)
+        ++m->lhs[rand() % SET_VALUES];
+    for (size_t i = 0; i < nrhs; ++i)
+        ++m->rhs[rand() % SET_VALUES];
+
+    for (int i = 0; i < SET_VALUES; ++i) {
+        for (size_t n = 0; n < m->lhs[i]; ++n)
+            vector_push_back(lhs, &i);
+        for (size_t n = 0; n < m->rhs[i]; ++n)
+            vector_push_back(rhs, &i);
+    }
+}
+
+static size_t max_count(size_t lhs, size_t rhs) {
+    return lhs > rhs ? lhs : rhs;
+}
+
+static size_t min_count(size_t lhs, size_t rhs) {
+    return lhs < rhs ? lhs : rhs;
+}
+
+static size_t diff_count(size_t lhs, size_t rhs) {
+    return lhs > rhs ? lhs - rhs : 0;
+}
+
+static size_t sym_diff_count(size_t lhs, size_t rhs) {
+    return lhs > rhs ? lhs - rhs : rhs - lhs;
+}
+
+typedef bool (*set_op_f)(struct vector *res, const struct vector *lhs,
+        const struct vector *rhs, vector_cmp_f cmp, void *cookie);
+
+static void check_set_op(set_op_f op,
+        size_t (*expected)(size_t lhs, size_t rhs), size_t nlhs, size_t nrhs) {
+    struct multiset m;
+    struct vector lhs;
+    struct vector rhs;
+    struct vector res;
+    int count = 0;
+    int first = -1;
+
+    random_sets(&m, &lhs, &rhs, nlhs, nrhs);
+    vector_init(&res, sizeof(int));
+    vector_push_back(&res, &first);
+
+    cr_assert(op(&res, &lhs, &rhs, int_cmp, &count));
+
+    size_t k = 0;
+    cr_assert_eq(*(int *)vector_at(&res, k++), -1);
+    for (int i = 0; i < SET_VALUES; ++i)
+        for (size_t n = 0; n < expected(m.lhs[i], m.rhs[i]); ++n)
+            cr_assert_eq(*(int *)vector_at(&res, k++), i);
+    cr_assert_eq(vector_length(&res), k);
+
+    vector_clear(&lhs, NULL, NULL);
+    vector_clear(&rhs, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+}
+
+static void check_set_ops(size_t nlhs, size_t nrhs) {
+    check_set_op(vector_set_union, max_count, nlhs, nrhs);
+    check_set_op(vector_set_intersection, min_count, nlhs, nrhs);
+    check_set_op(vector_set_difference, diff_count, nlhs, nrhs);
+    check_set_op(vector_set_symmetric_difference,
+            sym_diff_count, nlhs, nrhs);
+}
+
+Test(vector, set_null) {
+    struct vector other;
+    int count = 0;
+    vector_init(&other, sizeof(int));
+
+    cr_assert_not(vector_set_union(NULL, &v, &v, int_cmp, &count));
+    cr_assert_not(vector_set_union(&other, NULL, &v, int_cmp, &count));
+    cr_assert_not(vector_set_union(&other, &v, NULL, int_cmp, &count));
+    cr_assert_not(vector_set_union(&v, &v, &other, int_cmp, &count));
+    cr_assert_not(vector_set_intersection(&v, &other, &v, int_cmp, &count));
+    cr_assert_eq(count, 0);
+
+    struct vector chars;
+    vector_init(&chars, sizeof(char));
+    cr_assert_not(vector_set_difference(&chars, &v, &other, int_cmp, &count));
+}
+
+Test(vector, set_empty) {
+    check_set_ops(0, 0);
+    check_set_ops(0, 10);
+    check_set_ops(10, 0);
+}
+
+Test(vector, set_ops) {
+    srand(42);
+    for (int i = 0; i < 20; ++i)
+        check_set_ops(rand() % 200, rand() % 200);
+}
+
+Test(vector, set_ops_skewed) {
+    srand(43);
+    check_set_ops(3, 5000);
+    check_set_ops(5000, 3);
+    check_set_ops(1, 5000);
+}
+
+Test(vector, set_intersection_gallops) {
+    struct vector lhs;
+    struct vector rhs;
+    struct vector res;
+    vector_init(&lhs, sizeof(int));
+    vector_init(&rhs, sizeof(int));
+    vector_init(&res, sizeof(int));
+
+    for (int i = 0; i < 10000; ++i)
+        vector_push_back(&lhs, &i);
+    for (int i = 0; i < 10000; i += 1000)
+        vector_push_back(&rhs, &i);
+
+    int count = 0;
+    cr_assert(vector_set_intersection(&res, &lhs, &rhs, int_cmp, &count));
+
+    cr_assert_eq(vector_length(&res), 10);
+    cr_assert_lt(count, 500);
+
+    vector_clear(&lhs, NULL, NULL);
+    vector_clear(&rhs, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+}
@@ -0,0 +1,199 @@
+#include <criterion/criterion.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tupperware/vector_file.h"
+
+#define LENGTH 100000
+
+static char path[64];
+static struct vector v;
+
+static void setup(void) {
+    snprintf(path, sizeof(path), "/tmp/tupperware-vector-%ld", (long)getpid());
+
+    cr_assert(vector_with_cap(&v, sizeof(uint64_t), LENGTH));
+    for (uint64_t i = 0; i < LENGTH; ++i) {
+        uint64_t x = i * 0x9e3779b97f4a7c15ULL;
+        vector_push_back(&v, &x);
+    }
+}
+
+static void teardown(void) {
+    vector_clear(&v, NULL, NULL);
+    unlink(path);
+}
+
+TestSuite(vector_file, .timeout = 15, .init = setup, .fini = teardown);
+
+static void assert_same(const struct vector *lhs, const struct vector *rhs) {
+    cr_assert_eq(lhs->size, rhs->size);
+    cr_assert_eq(lhs->nmemb, rhs->nmemb);
+    if (lhs->nmemb)
+        cr_assert_eq(memcmp(lhs->arr, rhs->arr, lhs->nmemb * lhs->size), 0);
+}
+
+// Overwrites `len` bytes at `offset` in the saved file
+static void corrupt(long offset, const void *bytes, size_t len) {
+    FILE *file = fopen(path, "r+b");
+    cr_assert_not_null(file);
+    cr_assert_eq(fseek(file, offset, SEEK_SET), 0);
+    cr_assert_eq(fwrite(bytes, 1, len, file), len);
+    fclose(file);
+}
+
+Test(vector_file, null) {
+    struct vector_file f;
+
+    cr_assert_not(vector_file_save(NULL, path));
+    cr_assert_not(vector_file_save(&v, NULL));
+    cr_assert_not(vector_file_load(NULL, path, 0));
+    cr_assert_not(vector_file_load(&f, NULL, 0));
+    cr_assert_null(vector_file_vector(NULL));
+    vector_file_close(NULL);
+}
+
+Test(vector_file, missing) {
+    struct vector_file f;
+
+    cr_assert_not(vector_file_load(&f, path, 0));
+    cr_assert_not(vector_file_save(&v, "/nonexistent/directory/file"));
+}
+
+Test(vector_file, save_load) {
+    struct vector_file f;
+
+    cr_assert(vector_file_save(&v, path));
+    cr_assert(vector_file_load(&f, path, VECTOR_FILE_VERIFY));
+
+    const struct vector *loaded = vector_file_vector(&f);
+    cr_assert_not_null(loaded);
+    assert_same(loaded, &v);
+    cr_assert_eq(*(uint64_t *)vector_at(loaded, 12345),
+            12345 * 0x9e3779b97f4a7c15ULL);
+    // Elements are 64 bytes aligned in the mapping
+    cr_assert_eq((uintptr_t)loaded->arr % 64, 0);
+
+    vector_file_close(&f);
+    cr_assert_null(vector_file_vector(&f));
+}
+
+Test(vector_file, save_load_scalar) {
+    struct vector_file f;
+    setenv("TUPPERWARE_SIMD", "scalar", 1);
+
+    cr_assert(vector_file_save(&v, path));
+    unsetenv("TUPPERWARE_SIMD");
+    cr_assert(vector_file_load(&f, path, VECTOR_FILE_VERIFY));
+    assert_same(vector_file_vector(&f), &v);
+
+    vector_file_close(&f);
+}
+
+Test(vector_file, empty) {
+    struct vector empty;
+    struct vector_file f;
+    vector_init(&empty, 3);
+
+    cr_assert(vector_file_save(&empty, path));
+    cr_assert(vector_file_load(&f, path, VECTOR_FILE_VERIFY));
+    assert_same(vector_file_vector(&f), &empty);
+    cr_assert(vector_empty(vector_file_vector(&f)));
+
+    vector_file_close(&f);
+}
+
+Test(vector_file, overwrite) {
+    struct vector_file f;
+    struct vector small;
+    vector_init(&small, sizeof(uint16_t));
+    for (uint16_t i = 0; i < 10; ++i)
+        vector_push_back(&small, &i);
+
+    cr_assert(vector_file_save(&v, path));
+    cr_assert(vector_file_save(&small, path));
+    cr_assert(vector_file_load(&f, path, VECTOR_FILE_VERIFY));
+    assert_same(vector_file_vector(&f), &small);
+
+    vector_file_close(&f);
+    vector_clear(&small, NULL, NULL);
+}
+
+Test(vector_file, private) {
+    struct vector_file f;
+
+    cr_assert(vector_file_save(&v, path));
+    cr_assert(vector_file_load(&f, path,
+                VECTOR_FILE_PRIVATE | VECTOR_FILE_POPULATE));
+
+    // Changes stay in this mapping
+    uint64_t *first = vector_at(vector_file_vector(&f), 0);
+    *first = 42;
+    vector_file_close(&f);
+
+    cr_assert(vector_file_load(&f, path, VECTOR_FILE_VERIFY));
+    assert_same(vector_file_vector(&f), &v);
+
+    vector_file_close(&f);
+}
+
+Test(vector_file, shared) {
+    struct vector_file lhs;
+    struct vector_file rhs;
+
+    cr_assert(vector_file_save(&v, path));
+    cr_assert(vector_file_load(&lhs, path, 0));
+    cr_assert(vector_file_load(&rhs, path, 0));
+
+    assert_same(vector_file_vector(&lhs), vector_file_vector(&rhs));
+
+    vector_file_close(&lhs);
+    vector_file_close(&rhs);
+}
+
+Test(vector_file, corrupted_data) {
+    struct vector_file f;
+    char byte = 0x5a;
+
+    cr_assert(vector_file_save(&v, path));
+    corrupt(64 + 8 * 777, &byte, 1);
+
+    // Only noticed when verifying
+    cr_assert_not(vector_file_load(&f, path, VECTOR_FILE_VERIFY));
+    cr_assert(vector_file_load(&f, path, 0));
+    vector_file_close(&f);
+}
+
+Test(vector_file, corrupted_header) {
+    struct vector_file f;
+    uint64_t nmemb = LENGTH - 1;
+
+    cr_assert(vector_file_save(&v, path));
+    corrupt(24, &nmemb, sizeof(nmemb));
+    cr_assert_not(vector_file_load(&f, path, 0));
+
+    cr_assert(vector_file_save(&v, path));
+    corrupt(0, "XX", 2);
+    cr_assert_not(vector_file_load(&f, path, 0));
+
+    // Other endianness
+    uint32_t endianness = 0x04030201;
+    cr_assert(vector_file_save(&v, path));
+    corrupt(12, &endianness, sizeof(endianness));
+    cr_assert_not(vector_file_load(&f, path, 0));
+}
+
+Test(vector_file, truncated) {
+    struct vector_file f;
+
+    cr_assert(vector_file_save(&v, path));
+    cr_assert_eq(truncate(path, 64 + 8 * LENGTH - 1), 0);
+    cr_assert_not(vector_file_load(&f, path, 0));
+
+    cr_assert_eq(truncate(path, 10), 0);
+    cr_assert_not(vector_file_load(&f, path, 0));
+}
@@ -0,0 +1,277 @@
+#include <criterion/criterion.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tupperware/vector_parallel.h"
+
+TestSuite(vector_parallel, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+// Spans several chunks, with a partial last one
+#define LENGTH (300 * 1000 + 7)
+
+// No scheduler at all for 0
+static const size_t nthreads[] = { 0, 1, 3 };
+
+static struct scheduler *start(struct scheduler *s, size_t nthreads) {
+    if (!nthreads)
+        return NULL;
+    cr_assert(scheduler_init(s, nthreads));
+    return s;
+}
+
+static void fill(struct vector *v) {
+    cr_assert(vector_with_cap(v, sizeof(int), LENGTH));
+    for (int i = 0; i < LENGTH; ++i)
+        cr_assert(vector_push_back(v, &i));
+}
+
+static void int_incr(void *v, void *cookie) {
+    size_t *count = cookie;
+    __atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+
+    int *val = v;
+    *val = *val * 3 + 1;
+}
+
+static bool int_odd_third(void *v, void *cookie) {
+    size_t *count = cookie;
+    __atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+
+    int *val = v;
+    return *val % 3 == 1;
+}
+
+struct range {
+    int first;
+    int last;
+    int length;
+};
+
+// Associative but not commutative
+static void range_concat(void *acc, const void *v, void *cookie) {
+    size_t *count = cookie;
+    __atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+
+    struct range *lhs = acc;
+    const struct range *rhs = v;
+    if (lhs->last + 1 != rhs->first)
+        lhs->length = -1;
+    else if (lhs->length >= 0 && rhs->length >= 0)
+        lhs->length += rhs->length;
+    lhs->last = rhs->last;
+}
+
+Test(vector_parallel, null) {
+    size_t count = 0;
+    struct vector v;
+    int out;
+
+    vector_parallel_map(NULL, int_incr, &count, NULL);
+    cr_assert_not(vector_parallel_filter(NULL, NULL,
+                int_odd_third, &count, NULL));
+    cr_assert_not(vector_parallel_filter(&v, NULL,
+                int_odd_third, &count, NULL));
+    cr_assert_not(vector_parallel_filter(NULL, &v,
+                int_odd_third, &count, NULL));
+    cr_assert_not(vector_parallel_reduce(NULL, &out,
+                range_concat, &count, NULL));
+    cr_assert(vector_parallel_merge_sort(NULL, NULL, NULL, NULL));
+    cr_assert_eq(count, 0);
+}
+
+Test(vector_parallel, empty) {
+    size_t count = 0;
+    struct vector v;
+    struct range out = { 0, 0, 42 };
+    vector_init(&v, sizeof(struct range));
+
+    vector_parallel_map(&v, int_incr, &count, NULL);
+    cr_assert(vector_parallel_filter(&v, &v, int_odd_third, &count, NULL));
+    cr_assert_not(vector_parallel_reduce(&v, &out, range_concat, &count, NULL));
+    cr_assert_eq(out.length, 42);
+    cr_assert_eq(count, 0);
+}
+
+Test(vector_parallel, map) {
+    for (size_t t = 0; t < ARR_SIZE(nthreads); ++t) {
+        struct scheduler sched;
+        struct scheduler *s = start(&sched, nthreads[t]);
+        struct vector v;
+        size_t count = 0;
+        fill(&v);
+
+        vector_parallel_map(&v, int_incr, &count, s);
+
+        cr_assert_eq(count, LENGTH);
+        for (int i = 0; i < LENGTH; ++i)
+            cr_assert_eq(*(int *)vector_at(&v, i), i * 3 + 1);
+        vector_clear(&v, NULL, NULL);
+        scheduler_clear(s);
+    }
+}
+
+Test(vector_parallel, filter) {
+    for (size_t t = 0; t < ARR_SIZE(nthreads); ++t) {
+        struct scheduler sched;
+        struct scheduler *s = start(&sched, nthreads[t]);
+        struct vector v;
+        struct vector res;
+        size_t count = 0;
+        int first = -1;
+        fill(&v);
+        vector_init(&res, sizeof(int));
+        vector_push_back(&res, &first);
+
+        cr_assert(vector_parallel_filter(&res, &v, int_odd_third, &count, s));
+
+        cr_assert_eq(count, LENGTH);
+        cr_assert_eq(vector_length(&res) + vector_length(&v), LENGTH + 1);
+        cr_assert_eq(*(int *)vector_at(&res, 0), -1);
+        size_t r = 1;
+        size_t k = 0;
+        for (int i = 0; i < LENGTH; ++i) {
+            int *val = i % 3 == 1 ? vector_at(&res, r++) : vector_at(&v, k++);
+            cr_assert_eq(*val, i);
+        }
+
+        vector_clear(&v, NULL, NULL);
+        vector_clear(&res, NULL, NULL);
+        scheduler_clear(s);
+    }
+}
+
+Test(vector_parallel, filter_all) {
+    struct vector v;
+    struct vector res;
+    size_t count = 0;
+    vector_init(&v, sizeof(int));
+    vector_init(&res, sizeof(int));
+    for (int i = 0; i < LENGTH; ++i) {
+        int val = 1 + 3 * i;
+        vector_push_back(&v, &val);
+    }
+
+    struct scheduler s;
+    scheduler_init(&s, 2);
+    cr_assert(vector_parallel_filter(&res, &v, int_odd_third, &count, &s));
+    scheduler_clear(&s);
+
+    cr_assert(vector_empty(&v));
+    cr_assert_eq(vector_length(&res), LENGTH);
+    vector_clear(&v, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+}
+
+Test(vector_parallel, filter_size_mismatch) {
+    struct vector v;
+    struct vector res;
+    size_t count = 0;
+    fill(&v);
+    vector_init(&res, sizeof(char));
+
+    cr_assert_not(vector_parallel_filter(&res, &v,
+                int_odd_third, &count, NULL));
+    cr_assert_not(vector_parallel_filter(&v, &v,
+                int_odd_third, &count, NULL));
+    cr_assert_eq(count, 0);
+
+    vector_clear(&v, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+}
+
+Test(vector_parallel, reduce) {
+    struct vector v;
+    vector_init(&v, sizeof(struct range));
+    for (int i = 0; i < LENGTH; ++i) {
+        struct range r = { i, i, 1 };
+        vector_push_back(&v, &r);
+    }
+
+    struct range expected;
+    size_t count = 0;
+    cr_assert(vector_reduce(&v, &expected, range_concat, &count));
+    cr_assert_eq(expected.length, LENGTH);
+
+    for (size_t t = 0; t < ARR_SIZE(nthreads); ++t) {
+        struct scheduler sched;
+        struct scheduler *s = start(&sched, nthreads[t]);
+        struct range out;
+        count = 0;
+        cr_assert(vector_parallel_reduce(&v, &out, range_concat, &count, s));
+        cr_assert_eq(memcmp(&out, &expected, sizeof(out)), 0);
+        cr_assert_lt(count, LENGTH);
+        scheduler_clear(s);
+    }
+
+    vector_clear(&v, NULL, NULL);
+}
+
+struct keyed {
+    unsigned key;
+    unsigned index;
+};
+
+static int keyed_cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    const struct keyed *l = lhs;
+    const struct keyed *r = rhs;
+    return (l->key > r->key) - (l->key < r->key);
+}
+
+Test(vector_parallel, merge_sort) {
+    for (size_t t = 0; t < ARR_SIZE(nthreads); ++t) {
+        struct scheduler sched;
+        struct scheduler *s = start(&sched, nthreads[t]);
+        struct vector v;
+        vector_init(&v, sizeof(struct keyed));
+
+        // Few distinct keys to check stability
+        srand(t);
+        for (unsigned i = 0; i < LENGTH; ++i) {
+            struct keyed k = { rand() % 1000, i };
+            vector_push_back(&v, &k);
+        }
+
+        cr_assert(vector_parallel_merge_sort(&v, keyed_cmp, NULL, s));
+
+        cr_assert_eq(vector_length(&v), LENGTH);
+        for (size_t i = 1; i < LENGTH; ++i) {
+            struct keyed *prev = vector_at(&v, i - 1);
+            struct keyed *cur = vector_at(&v, i);
+            cr_assert(prev->key < cur->key
+                    || (prev->key == cur->key && prev->index < cur->index));
+        }
+
+        vector_clear(&v, NULL, NULL);
+        scheduler_clear(s);
+    }
+}
+
+static int char_cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    return *(const char *)lhs - *(const char *)rhs;
+}
+
+// Large elements make for single element chunks
+Test(vector_parallel, merge_sort_large_elements) {
+    struct scheduler s;
+    struct vector v;
+    char elem[300 * 1024] = { 0 };
+    scheduler_init(&s, 2);
+    vector_init(&v, sizeof(elem));
+
+    for (int i = 0; i < 7; ++i) {
+        elem[0] = (i * 5) % 7;
+        vector_push_back(&v, elem);
+    }
+
+    cr_assert(vector_parallel_merge_sort(&v, char_cmp, NULL, &s));
+    for (int i = 0; i < 7; ++i)
+        cr_assert_eq(*(char *)vector_at(&v, i), i);
+
+    vector_clear(&v, NULL, NULL);
+    scheduler_clear(&s);
+}
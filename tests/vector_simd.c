@@ -0,0 +1,325 @@
+#include <criterion/criterion.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tupperware/vector_simd.h"
+
+TestSuite(vector_simd, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+// Long enough to go over several filter chunks, odd to exercise the tails
+#define LENGTH 10007
+
+static const char *levels[] = { "scalar", "sse2", "avx2", "avx512" };
+
+static void fill_u32(struct vector *v, size_t n, unsigned seed) {
+    cr_assert(vector_init(v, sizeof(uint32_t)));
+    srand(seed);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t x = (uint32_t)rand() * 2654435761u;
+        cr_assert(vector_push_back(v, &x));
+    }
+}
+
+static void fill_f32(struct vector *v, size_t n, unsigned seed) {
+    cr_assert(vector_init(v, sizeof(float)));
+    srand(seed);
+    for (size_t i = 0; i < n; ++i) {
+        float x = (float)rand() / RAND_MAX * 200 - 100;
+        cr_assert(vector_push_back(v, &x));
+    }
+}
+
+static bool ref_match(double x, enum vector_simd_cmp cmp, double val) {
+    switch (cmp) {
+    case VECTOR_SIMD_EQ: return x == val;
+    case VECTOR_SIMD_NE: return x != val;
+    case VECTOR_SIMD_LT: return x < val;
+    case VECTOR_SIMD_LE: return x <= val;
+    case VECTOR_SIMD_GT: return x > val;
+    case VECTOR_SIMD_GE: return x >= val;
+    }
+    return false;
+}
+
+static void check_filter_u32(uint32_t val) {
+    for (enum vector_simd_cmp cmp = VECTOR_SIMD_EQ;
+            cmp <= VECTOR_SIMD_GE; ++cmp) {
+        struct vector v;
+        struct vector orig;
+        struct vector res;
+        fill_u32(&v, LENGTH, 42);
+        fill_u32(&orig, LENGTH, 42);
+        vector_init(&res, sizeof(uint32_t));
+
+        cr_assert(vector_simd_filter_u32(&res, &v, cmp, val));
+        cr_assert_eq(vector_length(&res) + vector_length(&v), LENGTH);
+
+        size_t r = 0;
+        size_t k = 0;
+        for (size_t i = 0; i < LENGTH; ++i) {
+            uint32_t x = *(uint32_t *)vector_at(&orig, i);
+            if (ref_match(x, cmp, val))
+                cr_assert_eq(*(uint32_t *)vector_at(&res, r++), x);
+            else
+                cr_assert_eq(*(uint32_t *)vector_at(&v, k++), x);
+        }
+
+        vector_clear(&v, NULL, NULL);
+        vector_clear(&orig, NULL, NULL);
+        vector_clear(&res, NULL, NULL);
+    }
+}
+
+static void check_filter_f32(float val) {
+    for (enum vector_simd_cmp cmp = VECTOR_SIMD_EQ;
+            cmp <= VECTOR_SIMD_GE; ++cmp) {
+        struct vector v;
+        struct vector orig;
+        struct vector res;
+        fill_f32(&v, LENGTH, 43);
+        fill_f32(&orig, LENGTH, 43);
+        vector_init(&res, sizeof(float));
+
+        // Keep a few exact matches and NaNs around
+        float nan = NAN;
+        for (size_t i = 0; i < LENGTH; i += 97) {
+            cr_assert(vector_insert_at(&v, &val, i));
+            cr_assert(vector_insert_at(&orig, &val, i));
+            cr_assert(vector_insert_at(&v, &nan, i));
+            cr_assert(vector_insert_at(&orig, &nan, i));
+        }
+
+        size_t n = vector_length(&orig);
+        cr_assert(vector_simd_filter_f32(&res, &v, cmp, val));
+        cr_assert_eq(vector_length(&res) + vector_length(&v), n);
+
+        size_t r = 0;
+        size_t k = 0;
+        for (size_t i = 0; i < n; ++i) {
+            float x = *(float *)vector_at(&orig, i);
+            float *y = ref_match(x, cmp, val)
+                ? vector_at(&res, r++) : vector_at(&v, k++);
+            cr_assert(memcmp(y, &x, sizeof(x)) == 0);
+        }
+
+        vector_clear(&v, NULL, NULL);
+        vector_clear(&orig, NULL, NULL);
+        vector_clear(&res, NULL, NULL);
+    }
+}
+
+static void check_reductions(void) {
+    struct vector v;
+    fill_u32(&v, LENGTH, 44);
+
+    uint64_t sum = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    for (size_t i = 0; i < LENGTH; ++i) {
+        uint32_t x = *(uint32_t *)vector_at(&v, i);
+        sum += x;
+        if (x < min)
+            min = x;
+        if (x > max)
+            max = x;
+    }
+
+    uint64_t s;
+    uint32_t n;
+    cr_assert(vector_simd_sum_u32(&v, &s));
+    cr_assert_eq(s, sum);
+    cr_assert(vector_simd_min_u32(&v, &n));
+    cr_assert_eq(n, min);
+    cr_assert(vector_simd_max_u32(&v, &n));
+    cr_assert_eq(n, max);
+    vector_clear(&v, NULL, NULL);
+
+    fill_f32(&v, LENGTH, 45);
+    double fsum = 0;
+    float fmin = INFINITY;
+    float fmax = -INFINITY;
+    for (size_t i = 0; i < LENGTH; ++i) {
+        float x = *(float *)vector_at(&v, i);
+        fsum += x;
+        fmin = fminf(fmin, x);
+        fmax = fmaxf(fmax, x);
+    }
+
+    double d;
+    float f;
+    cr_assert(vector_simd_sum_f32(&v, &d));
+    cr_assert(fabs(d - fsum) < 1e-6 * LENGTH * 100);
+    cr_assert(vector_simd_min_f32(&v, &f));
+    cr_assert_eq(f, fmin);
+    cr_assert(vector_simd_max_f32(&v, &f));
+    cr_assert_eq(f, fmax);
+    vector_clear(&v, NULL, NULL);
+}
+
+static void check_affine_find(void) {
+    struct vector v;
+    struct vector orig;
+    fill_u32(&v, LENGTH, 46);
+    fill_u32(&orig, LENGTH, 46);
+
+    cr_assert(vector_simd_affine_u32(&v, 3, 7));
+    for (size_t i = 0; i < LENGTH; ++i)
+        cr_assert_eq(*(uint32_t *)vector_at(&v, i),
+                *(uint32_t *)vector_at(&orig, i) * 3 + 7);
+
+    size_t index;
+    for (size_t i = 0; i < LENGTH; i += 1001) {
+        uint32_t x = *(uint32_t *)vector_at(&v, i);
+        cr_assert(vector_simd_find_u32(&v, x, &index));
+        cr_assert_eq(*(uint32_t *)vector_at(&v, index), x);
+        cr_assert_leq(index, i);
+    }
+    vector_clear(&v, NULL, NULL);
+    vector_clear(&orig, NULL, NULL);
+
+    fill_f32(&v, LENGTH, 47);
+    fill_f32(&orig, LENGTH, 47);
+
+    cr_assert(vector_simd_affine_f32(&v, 0.5f, -1.0f));
+    for (size_t i = 0; i < LENGTH; ++i) {
+        volatile float x = *(float *)vector_at(&orig, i) * 0.5f;
+        cr_assert_eq(*(float *)vector_at(&v, i), x + -1.0f);
+    }
+
+    float last = *(float *)vector_at(&v, LENGTH - 1);
+    cr_assert(vector_simd_find_f32(&v, last, &index));
+    cr_assert_eq(*(float *)vector_at(&v, index), last);
+    cr_assert_not(vector_simd_find_f32(&v, 1000.0f, &index));
+    cr_assert_not(vector_simd_find_f32(&v, NAN, &index));
+
+    vector_clear(&v, NULL, NULL);
+    vector_clear(&orig, NULL, NULL);
+}
+
+static int u32_cmp(const void *lhs, const void *rhs, void *cookie) {
+    (void)cookie;
+    uint32_t l = *(const uint32_t *)lhs;
+    uint32_t r = *(const uint32_t *)rhs;
+    return (l > r) - (l < r);
+}
+
+// Strictly increasing, with random gaps of at most `step` up to UINT32_MAX
+static void fill_set(struct vector *v, size_t n, uint32_t step) {
+    cr_assert(vector_init(v, sizeof(uint32_t)));
+    uint32_t x = UINT32_MAX - n * step;
+    for (size_t i = 0; i < n; ++i) {
+        x += 1 + rand() % step;
+        cr_assert(vector_push_back(v, &x));
+    }
+}
+
+static void check_intersection(size_t nlhs, size_t nrhs) {
+    struct vector lhs;
+    struct vector rhs;
+    struct vector res;
+    struct vector expected;
+    fill_set(&lhs, nlhs, nlhs > nrhs ? 2 : 2 * nrhs / (nlhs + 1) + 2);
+    fill_set(&rhs, nrhs, nrhs > nlhs ? 2 : 2 * nlhs / (nrhs + 1) + 2);
+    vector_init(&res, sizeof(uint32_t));
+    vector_init(&expected, sizeof(uint32_t));
+
+    cr_assert(vector_set_intersection(&expected, &lhs, &rhs, u32_cmp, NULL));
+    cr_assert(vector_simd_set_intersection_u32(&res, &lhs, &rhs));
+
+    cr_assert_eq(vector_length(&res), vector_length(&expected));
+    if (vector_length(&res))
+        cr_assert_arr_eq(res.arr, expected.arr,
+                vector_length(&res) * sizeof(uint32_t));
+
+    vector_clear(&lhs, NULL, NULL);
+    vector_clear(&rhs, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+    vector_clear(&expected, NULL, NULL);
+}
+
+static void check_level(const char *level) {
+    setenv("TUPPERWARE_SIMD", level, 1);
+    const char *isa = vector_simd_isa();
+    // Levels above what the CPU supports are ignored
+    if (strcmp(isa, level))
+        cr_assert_str_eq(level, "avx512");
+
+    check_filter_u32(1u << 31);
+    check_filter_u32(0);
+    check_filter_u32(UINT32_MAX);
+    check_filter_f32(0.0f);
+    check_filter_f32(12.5f);
+    check_reductions();
+    check_affine_find();
+
+    srand(48);
+    check_intersection(0, 100);
+    check_intersection(1000, 1000);
+    check_intersection(1003, 517);
+    check_intersection(5, 10000);
+    check_intersection(10000, 200);
+}
+
+// Each test runs in its own process, the instruction set is picked only once
+Test(vector_simd, scalar) {
+    check_level(levels[0]);
+}
+
+Test(vector_simd, sse2) {
+    check_level(levels[1]);
+}
+
+Test(vector_simd, avx2) {
+    check_level(levels[2]);
+}
+
+Test(vector_simd, avx512) {
+    check_level(levels[3]);
+}
+
+Test(vector_simd, wrong_size) {
+    struct vector v;
+    struct vector res;
+    vector_init(&v, sizeof(uint64_t));
+    vector_init(&res, sizeof(uint32_t));
+
+    uint64_t sum;
+    uint32_t n;
+    size_t index;
+    cr_assert_not(vector_simd_filter_u32(&res, &v, VECTOR_SIMD_EQ, 0));
+    cr_assert_not(vector_simd_filter_u32(&v, &res, VECTOR_SIMD_EQ, 0));
+    cr_assert_not(vector_simd_affine_u32(&v, 1, 0));
+    cr_assert_not(vector_simd_sum_u32(&v, &sum));
+    cr_assert_not(vector_simd_min_u32(&v, &n));
+    cr_assert_not(vector_simd_find_u32(&v, 0, &index));
+
+    cr_assert_not(vector_simd_set_intersection_u32(&res, &v, &res));
+    cr_assert_not(vector_simd_set_intersection_u32(&res, &res, &res));
+    cr_assert_not(vector_simd_filter_u32(NULL, &res, VECTOR_SIMD_EQ, 0));
+    cr_assert_not(vector_simd_sum_u32(NULL, &sum));
+    cr_assert_not(vector_simd_sum_u32(&res, NULL));
+
+    vector_clear(&v, NULL, NULL);
+    vector_clear(&res, NULL, NULL);
+}
+
+Test(vector_simd, empty) {
+    struct vector v;
+    vector_init(&v, sizeof(float));
+
+    double sum = 1;
+    float f;
+    size_t index;
+    cr_assert(vector_simd_sum_f32(&v, &sum));
+    cr_assert_eq(sum, 0);
+    cr_assert_not(vector_simd_min_f32(&v, &f));
+    cr_assert_not(vector_simd_max_f32(&v, &f));
+    cr_assert_not(vector_simd_find_f32(&v, 0, &index));
+    cr_assert(vector_simd_affine_f32(&v, 2, 1));
+
+    vector_clear(&v, NULL, NULL);
+}
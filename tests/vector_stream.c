@@ -0,0 +1,402 @@
+#include <criterion/criterion.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tupperware/vector_stream.h"
+
+TestSuite(vector_stream, .timeout = 15);
+
+#define ARR_SIZE(Arr) (sizeof(Arr) / sizeof(*Arr))
+
+// Spans several chunks whatever the element size, with a partial last one
+#define LENGTH (300 * 1000 + 7)
+
+static const enum vector_stream_codec codecs[] = {
+    VECTOR_STREAM_RAW, VECTOR_STREAM_LZ, VECTOR_STREAM_DELTA,
+};
+
+struct triple {
+    uint32_t key;
+    uint16_t kind;
+    char name[6];
+};
+
+static uint64_t xorshift(uint64_t *seed) {
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *seed = x;
+}
+
+static void fill_sorted_u64(struct vector *v, size_t n) {
+    uint64_t seed = 42;
+    uint64_t x = 1000;
+    cr_assert(vector_init(v, sizeof(uint64_t)));
+    for (size_t i = 0; i < n; ++i) {
+        x += xorshift(&seed) % 100;
+        cr_assert(vector_push_back(v, &x));
+    }
+}
+
+static void fill_random_u32(struct vector *v, size_t n) {
+    uint64_t seed = 7;
+    cr_assert(vector_init(v, sizeof(uint32_t)));
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t x = xorshift(&seed);
+        cr_assert(vector_push_back(v, &x));
+    }
+}
+
+static void fill_triples(struct vector *v, size_t n) {
+    static const char *names[] = { "alpha", "beta", "gamma", "delta" };
+    uint64_t seed = 3;
+    cr_assert(vector_init(v, sizeof(struct triple)));
+    for (size_t i = 0; i < n; ++i) {
+        struct triple t;
+        memset(&t, 0, sizeof(t));
+        t.key = i / 16;
+        t.kind = xorshift(&seed) % 4;
+        strcpy(t.name, names[t.kind]);
+        cr_assert(vector_push_back(v, &t));
+    }
+}
+
+// Returns the size of the stream
+static long write_stream(FILE *file, const struct vector *v,
+        enum vector_stream_codec codec) {
+    struct vector_stream_writer w;
+
+    cr_assert(vector_stream_writer_init(&w, file, v->size, codec));
+    cr_assert(vector_stream_write_vector(&w, v));
+    cr_assert(vector_stream_writer_finish(&w));
+
+    long len = ftell(file);
+    rewind(file);
+    return len;
+}
+
+static void assert_same(const struct vector *lhs, const struct vector *rhs) {
+    cr_assert_eq(lhs->size, rhs->size);
+    cr_assert_eq(lhs->nmemb, rhs->nmemb);
+    if (lhs->nmemb)
+        cr_assert_eq(memcmp(lhs->arr, rhs->arr, lhs->nmemb * lhs->size), 0);
+}
+
+static void check_roundtrip(const struct vector *v,
+        enum vector_stream_codec codec) {
+    struct vector_stream_reader r;
+    struct vector res;
+    FILE *file = tmpfile();
+    cr_assert_not_null(file);
+
+    write_stream(file, v, codec);
+
+    cr_assert(vector_stream_reader_init(&r, file));
+    cr_assert_eq(vector_stream_elem_size(&r), v->size);
+    cr_assert(vector_init(&res, v->size));
+    cr_assert(vector_stream_read_vector(&r, &res));
+    cr_assert(vector_stream_reader_end(&r));
+    assert_same(&res, v);
+
+    // Nothing more to read
+    cr_assert_not(vector_stream_read_chunk(&r, &res));
+    cr_assert(vector_stream_reader_end(&r));
+
+    vector_stream_reader_clear(&r);
+    vector_clear(&res, NULL, NULL);
+    fclose(file);
+}
+
+Test(vector_stream, null) {
+    struct vector_stream_writer w;
+    struct vector_stream_reader r;
+    struct vector v;
+    vector_init(&v, 1);
+
+    cr_assert_not(vector_stream_writer_init(NULL, stdout, 1, 0));
+    cr_assert_not(vector_stream_writer_init(&w, NULL, 1, 0));
+    cr_assert_not(vector_stream_write(NULL, "", 1));
+    cr_assert_not(vector_stream_write_vector(NULL, &v));
+    cr_assert_not(vector_stream_writer_finish(NULL));
+
+    cr_assert_not(vector_stream_reader_init(NULL, stdin));
+    cr_assert_not(vector_stream_reader_init(&r, NULL));
+    cr_assert_not(vector_stream_read_chunk(NULL, &v));
+    cr_assert_not(vector_stream_read_vector(NULL, &v));
+    cr_assert_not(vector_stream_reader_end(NULL));
+    cr_assert_eq(vector_stream_elem_size(NULL), 0);
+    vector_stream_reader_clear(NULL);
+}
+
+Test(vector_stream, invalid_writer) {
+    struct vector_stream_writer w;
+    FILE *file = tmpfile();
+
+    cr_assert_not(vector_stream_writer_init(&w, file, 0, VECTOR_STREAM_RAW));
+    cr_assert_not(vector_stream_writer_init(&w, file, 4, 42));
+    // Deltas are only taken between integers
+    cr_assert_not(vector_stream_writer_init(&w, file, 3, VECTOR_STREAM_DELTA));
+    cr_assert_not(vector_stream_writer_init(&w, file, 16, VECTOR_STREAM_DELTA));
+
+    struct vector v;
+    vector_init(&v, 8);
+    cr_assert(vector_stream_writer_init(&w, file, 4, VECTOR_STREAM_LZ));
+    cr_assert_not(vector_stream_write_vector(&w, &v));
+    cr_assert(vector_stream_writer_finish(&w));
+    // Cleared by finishing
+    cr_assert_not(vector_stream_write(&w, "abcd", 1));
+
+    fclose(file);
+}
+
+Test(vector_stream, roundtrip_sorted) {
+    struct vector v;
+    fill_sorted_u64(&v, LENGTH);
+
+    for (size_t i = 0; i < ARR_SIZE(codecs); ++i)
+        check_roundtrip(&v, codecs[i]);
+
+    vector_clear(&v, NULL, NULL);
+}
+
+Test(vector_stream, roundtrip_random) {
+    struct vector v;
+    fill_random_u32(&v, LENGTH);
+
+    for (size_t i = 0; i < ARR_SIZE(codecs); ++i)
+        check_roundtrip(&v, codecs[i]);
+
+    vector_clear(&v, NULL, NULL);
+}
+
+Test(vector_stream, roundtrip_records) {
+    struct vector v;
+    fill_triples(&v, LENGTH);
+
+    check_roundtrip(&v, VECTOR_STREAM_RAW);
+    check_roundtrip(&v, VECTOR_STREAM_LZ);
+
+    vector_clear(&v, NULL, NULL);
+}
+
+Test(vector_stream, roundtrip_extremes) {
+    struct vector v32;
+    struct vector v64;
+    vector_init(&v32, sizeof(uint32_t));
+    vector_init(&v64, sizeof(uint64_t));
+
+    // Large jumps in both directions
+    for (size_t i = 0; i < 1000; ++i) {
+        uint32_t x32 = i % 3 ? UINT32_MAX - i : i;
+        uint64_t x64 = i % 3 ? UINT64_MAX - i : i;
+        vector_push_back(&v32, &x32);
+        vector_push_back(&v64, &x64);
+    }
+
+    for (size_t i = 0; i < ARR_SIZE(codecs); ++i) {
+        check_roundtrip(&v32, codecs[i]);
+        check_roundtrip(&v64, codecs[i]);
+    }
+
+    vector_clear(&v32, NULL, NULL);
+    vector_clear(&v64, NULL, NULL);
+}
+
+Test(vector_stream, roundtrip_empty) {
+    struct vector v;
+    vector_init(&v, sizeof(uint32_t));
+
+    for (size_t i = 0; i < ARR_SIZE(codecs); ++i)
+        check_roundtrip(&v, codecs[i]);
+}
+
+Test(vector_stream, roundtrip_large_elements) {
+    struct vector v;
+    char elem[VECTOR_STREAM_CHUNK_BYTES + 100];
+    vector_init(&v, sizeof(elem));
+
+    for (size_t i = 0; i < 3; ++i) {
+        memset(elem, 'a' + i, sizeof(elem));
+        vector_push_back(&v, elem);
+    }
+
+    check_roundtrip(&v, VECTOR_STREAM_RAW);
+    check_roundtrip(&v, VECTOR_STREAM_LZ);
+
+    vector_clear(&v, NULL, NULL);
+}
+
+Test(vector_stream, compression) {
+    struct vector sorted;
+    struct vector random;
+    struct vector triples;
+    fill_sorted_u64(&sorted, LENGTH);
+    fill_random_u32(&random, LENGTH);
+    fill_triples(&triples, LENGTH);
+    FILE *file = tmpfile();
+
+    long raw = write_stream(file, &sorted, VECTOR_STREAM_RAW);
+    cr_assert_gt(raw, LENGTH * sizeof(uint64_t));
+    // Differences take 7 bits
+    long delta = write_stream(file, &sorted, VECTOR_STREAM_DELTA);
+    cr_assert_lt(delta, raw / 8);
+
+    // Incompressible chunks are stored as is
+    raw = write_stream(file, &random, VECTOR_STREAM_RAW);
+    cr_assert_eq(write_stream(file, &random, VECTOR_STREAM_LZ), raw);
+    cr_assert_eq(write_stream(file, &random, VECTOR_STREAM_DELTA), raw);
+
+    raw = write_stream(file, &triples, VECTOR_STREAM_RAW);
+    cr_assert_lt(write_stream(file, &triples, VECTOR_STREAM_LZ), raw / 2);
+
+    vector_clear(&sorted, NULL, NULL);
+    vector_clear(&random, NULL, NULL);
+    vector_clear(&triples, NULL, NULL);
+    fclose(file);
+}
+
+Test(vector_stream, pieces) {
+    struct vector_stream_writer w;
+    struct vector_stream_reader r;
+    struct vector v;
+    struct vector res;
+    FILE *file = tmpfile();
+    fill_sorted_u64(&v, LENGTH);
+
+    // Writes of any length, mixing partial and full chunks
+    cr_assert(vector_stream_writer_init(&w, file, v.size, VECTOR_STREAM_DELTA));
+    size_t lengths[] = { 1, 0, 100, VECTOR_STREAM_CHUNK_BYTES, 3, 77777 };
+    size_t done = 0;
+    for (size_t i = 0; done < LENGTH; i = (i + 1) % ARR_SIZE(lengths)) {
+        size_t n = lengths[i] < LENGTH - done ? lengths[i] : LENGTH - done;
+        cr_assert(vector_stream_write(&w, vector_at(&v, done), n));
+        done += n;
+    }
+    cr_assert(vector_stream_writer_finish(&w));
+    rewind(file);
+
+    // Chunks are read one at a time
+    cr_assert(vector_stream_reader_init(&r, file));
+    vector_init(&res, v.size);
+    size_t chunks = 0;
+    size_t prev = 0;
+    while (vector_stream_read_chunk(&r, &res)) {
+        cr_assert_leq(res.nmemb - prev,
+                VECTOR_STREAM_CHUNK_BYTES / sizeof(uint64_t));
+        prev = res.nmemb;
+        ++chunks;
+    }
+    cr_assert(vector_stream_reader_end(&r));
+    cr_assert_eq(chunks, (LENGTH * sizeof(uint64_t)
+                + VECTOR_STREAM_CHUNK_BYTES - 1) / VECTOR_STREAM_CHUNK_BYTES);
+    assert_same(&res, &v);
+
+    vector_stream_reader_clear(&r);
+    vector_clear(&res, NULL, NULL);
+    vector_clear(&v, NULL, NULL);
+    fclose(file);
+}
+
+Test(vector_stream, wrong_size) {
+    struct vector_stream_reader r;
+    struct vector v;
+    struct vector res;
+    FILE *file = tmpfile();
+    fill_random_u32(&v, 10);
+    write_stream(file, &v, VECTOR_STREAM_RAW);
+
+    cr_assert(vector_stream_reader_init(&r, file));
+    vector_init(&res, sizeof(uint64_t));
+    cr_assert_not(vector_stream_read_vector(&r, &res));
+    cr_assert_eq(res.nmemb, 0);
+
+    vector_stream_reader_clear(&r);
+    vector_clear(&v, NULL, NULL);
+    fclose(file);
+}
+
+// Flips a byte in a stream of sorted elements, `offset` bytes from the end
+static void check_corrupted(enum vector_stream_codec codec, long offset) {
+    struct vector_stream_reader r;
+    struct vector v;
+    struct vector res;
+    FILE *file = tmpfile();
+    fill_sorted_u64(&v, LENGTH);
+    long len = write_stream(file, &v, codec);
+
+    cr_assert_eq(fseek(file, len - offset, SEEK_SET), 0);
+    int byte = fgetc(file);
+    cr_assert_eq(fseek(file, len - offset, SEEK_SET), 0);
+    fputc(byte ^ 0x10, file);
+    rewind(file);
+
+    cr_assert(vector_stream_reader_init(&r, file));
+    vector_init(&res, v.size);
+    cr_assert_not(vector_stream_read_vector(&r, &res));
+    cr_assert_not(vector_stream_reader_end(&r));
+    cr_assert_leq(res.nmemb, v.nmemb);
+    // Stays invalid
+    cr_assert_not(vector_stream_read_chunk(&r, &res));
+
+    vector_stream_reader_clear(&r);
+    vector_clear(&res, NULL, NULL);
+    vector_clear(&v, NULL, NULL);
+    fclose(file);
+}
+
+Test(vector_stream, corrupted) {
+    for (size_t i = 0; i < ARR_SIZE(codecs); ++i) {
+        // Payload of the last chunk, and total number of elements
+        check_corrupted(codecs[i], 100);
+        check_corrupted(codecs[i], 3);
+    }
+}
+
+Test(vector_stream, corrupted_header) {
+    struct vector_stream_reader r;
+    struct vector v;
+    FILE *file = tmpfile();
+    fill_random_u32(&v, 10);
+    write_stream(file, &v, VECTOR_STREAM_RAW);
+
+    fputc('X', file);
+    rewind(file);
+    cr_assert_not(vector_stream_reader_init(&r, file));
+
+    rewind(file);
+    cr_assert_not(vector_stream_reader_init(&r, file));
+
+    vector_clear(&v, NULL, NULL);
+    fclose(file);
+}
+
+Test(vector_stream, truncated) {
+    struct vector_stream_reader r;
+    struct vector v;
+    struct vector res;
+    FILE *file = tmpfile();
+    fill_sorted_u64(&v, LENGTH);
+
+    // Never finished
+    struct vector_stream_writer w;
+    cr_assert(vector_stream_writer_init(&w, file, v.size, VECTOR_STREAM_LZ));
+    cr_assert(vector_stream_write_vector(&w, &v));
+    fflush(file);
+    rewind(file);
+
+    cr_assert(vector_stream_reader_init(&r, file));
+    vector_init(&res, v.size);
+    cr_assert_not(vector_stream_read_vector(&r, &res));
+    cr_assert_not(vector_stream_reader_end(&r));
+
+    vector_stream_reader_clear(&r);
+    vector_clear(&res, NULL, NULL);
+    vector_clear(&v, NULL, NULL);
+    free(w.pending);
+    free(w.encoded);
+    fclose(file);
+}